@@ -0,0 +1,120 @@
+// btree_map against std::map with random uint64 keys: bulk construction
+// and one-by-one inserts, random point lookups, a full in-order scan and
+// bytes per entry. Checks both trees' contents and every lookup against
+// std::map first. The default 10M entries need about 1 GB.
+//
+//   g++ -std=c++20 -O2 -Iinclude bench/btree_bench.cpp -o btree_bench && ./btree_bench [n]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "mo/btree.hpp"
+
+namespace {
+
+constexpr std::size_t queries = 1'000'000;
+
+template <typename F>
+double best_seconds(F&& f) {
+    double best = 1e9;
+    for (int round = 0; round < 5; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+template <typename F>
+double once_seconds(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "wrong result: %s\n", what);
+        std::exit(1);
+    }
+}
+
+template <typename Map>
+std::uint64_t sum_found(const Map& map, const std::vector<std::uint64_t>& probes) {
+    std::uint64_t sum = 0;
+    for (const std::uint64_t k : probes) {
+        const auto it = map.find(k);
+        if (it != map.end()) sum += it->second;
+    }
+    return sum;
+}
+
+template <typename Map>
+std::uint64_t scan(const Map& map) {
+    std::uint64_t sum = 0;
+    for (const auto& [k, v] : map) sum += k ^ v;
+    return sum;
+}
+
+template <typename Tree>
+bool same_contents(const Tree& tree, const std::map<std::uint64_t, std::uint64_t>& model) {
+    if (tree.size() != model.size()) return false;
+    auto m = model.begin();
+    for (const auto& [k, v] : tree) {
+        if (k != m->first || v != m->second) return false;
+        ++m;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    std::mt19937_64 rng(48);
+    std::vector<std::uint64_t> keys(n), values(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        keys[i] = rng();
+        values[i] = i;
+    }
+    std::vector<std::uint64_t> probes(queries);
+    for (std::uint64_t& p : probes) p = keys[rng() % n];
+
+    std::map<std::uint64_t, std::uint64_t> model;
+    mo::btree_map<std::uint64_t, std::uint64_t> bulk, inserted;
+    const double model_s = once_seconds([&] {
+        for (std::size_t i = 0; i < n; ++i) model.emplace(keys[i], values[i]);
+    });
+    const double bulk_s = once_seconds([&] { bulk = mo::btree_map<std::uint64_t, std::uint64_t>(keys, values); });
+    const double insert_s = once_seconds([&] {
+        for (std::size_t i = 0; i < n; ++i) inserted.try_emplace(keys[i], values[i]);
+    });
+    require(same_contents(bulk, model) && same_contents(inserted, model), "contents");
+    for (const std::uint64_t p : probes)
+        require(bulk.at(p) == model.at(p) && inserted.at(p) == model.at(p), "lookup");
+
+    std::printf("%zu random uint64 -> uint64, %zu random hits, best of 5 (builds run once)\n", n, queries);
+    std::printf("  build: std::map inserts %.2f s, btree bulk %.2f s, btree inserts %.2f s\n", model_s, bulk_s,
+                insert_s);
+    std::uint64_t a = 0, b = 0, c = 0;
+    const double model_find = best_seconds([&] { a = sum_found(model, probes); });
+    const double bulk_find = best_seconds([&] { b = sum_found(bulk, probes); });
+    const double insert_find = best_seconds([&] { c = sum_found(inserted, probes); });
+    require(a == b && a == c, "lookup sums");
+    std::printf("  lookup: std::map %.0f ns, btree bulk %.0f ns, btree after inserts %.0f ns\n",
+                model_find * 1e9 / queries, bulk_find * 1e9 / queries, insert_find * 1e9 / queries);
+    const double model_scan = best_seconds([&] { a = scan(model); });
+    const double bulk_scan = best_seconds([&] { b = scan(bulk); });
+    require(a == b, "scan sums");
+    std::printf("  full scan: std::map %.1f ms, btree %.1f ms\n", model_scan * 1e3, bulk_scan * 1e3);
+    constexpr std::size_t map_node = 32 + 16;  // libstdc++: colour and three links, then the pair; before malloc's own
+    std::printf("  memory: btree bulk %.1f B/entry (height %zu), after inserts %.1f B/entry, std::map %zu B/entry\n",
+                double(bulk.memory_bytes()) / double(n), bulk.height(), double(inserted.memory_bytes()) / double(n),
+                map_node);
+}
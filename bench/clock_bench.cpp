@@ -0,0 +1,114 @@
+// Cost of now() for tsc_clock, steady_clock, coarse_clock and cached_clock,
+// and how far tsc_clock strays from steady_clock across its once-a-second
+// re-anchoring. Checks first that tsc_clock never goes back, on several
+// threads at once.
+//
+//   g++ -std=c++20 -O2 -Iinclude bench/clock_bench.cpp -o clock_bench -pthread && ./clock_bench [seconds]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mo/clock.hpp"
+
+namespace {
+
+constexpr int calls = 5'000'000;
+
+template <typename F>
+double best_seconds(F&& f) {
+    double best = 1e9;
+    for (int round = 0; round < 5; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "wrong result: %s\n", what);
+        std::exit(1);
+    }
+}
+
+std::int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void check_monotonic(double seconds) {
+    std::vector<std::thread> threads;
+    bool ok[3] = {true, true, true};
+    for (bool& result : ok) {
+        threads.emplace_back([&result, seconds] {
+            const auto stop = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+            auto last = mo::tsc_clock::now();
+            while (std::chrono::steady_clock::now() < stop) {
+                for (int i = 0; i < 1000; ++i) {
+                    const auto t = mo::tsc_clock::now();
+                    result &= t >= last;
+                    last = t;
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    require(ok[0] && ok[1] && ok[2], "tsc_clock went back");
+}
+
+/// tsc_clock minus the midpoint of two steady_clock reads around it,
+/// sampled for `seconds`. Returns the median and the largest magnitude.
+std::pair<std::int64_t, std::int64_t> offsets(double seconds) {
+    std::vector<std::int64_t> out;
+    const std::int64_t stop = steady_ns() + static_cast<std::int64_t>(seconds * 1e9);
+    for (;;) {
+        const std::int64_t a = steady_ns();
+        const std::int64_t t = mo::tsc_clock::now().time_since_epoch().count();
+        const std::int64_t b = steady_ns();
+        if (a > stop) break;
+        if (b - a < 200) out.push_back(t - (a + b) / 2);  // skip pairs split by a preemption
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    require(!out.empty(), "offset samples");
+    std::int64_t worst = 0;
+    for (const std::int64_t o : out) worst = std::max(worst, o < 0 ? -o : o);
+    std::nth_element(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(out.size() / 2), out.end());
+    return {out[out.size() / 2], worst};
+}
+
+template <typename Now>
+void time_now(const char* name, Now now) {
+    std::int64_t sink = 0;
+    const double s = best_seconds([&] {
+        for (int i = 0; i < calls; ++i) sink += static_cast<std::int64_t>(now());
+    });
+    std::printf("  %-24s %6.1f ns/call  (%d)\n", name, s * 1e9 / calls, sink != 0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const double seconds = argc > 1 ? std::strtod(argv[1], nullptr) : 3.5;
+    mo::tsc_clock::calibrate();
+    std::printf("tsc_clock precise=%d, hardware threads %u\n", mo::tsc_clock::precise(),
+                std::thread::hardware_concurrency());
+    check_monotonic(1.5);
+
+    mo::cached_clock cached;
+    time_now("tsc_clock::now", [] { return mo::tsc_clock::now().time_since_epoch().count(); });
+    time_now("tsc_clock::ticks", [] { return mo::tsc_clock::ticks(); });
+    time_now("steady_clock::now", [] { return std::chrono::steady_clock::now().time_since_epoch().count(); });
+    time_now("coarse_clock::now", [] { return mo::coarse_clock::now().time_since_epoch().count(); });
+    time_now("cached_clock::now", [&] { return cached.now().time_since_epoch().count(); });
+
+    const auto [median, worst] = offsets(seconds);
+    std::printf("  tsc_clock - steady_clock over %.1f s: median %lld ns, max |offset| %lld ns\n", seconds,
+                static_cast<long long>(median), static_cast<long long>(worst));
+}
@@ -0,0 +1,177 @@
+// LZ4 block and frame throughput of compress.hpp on log-like, random and
+// all-zero data, in 64 KiB blocks. Built with -DMO_BENCH_LIBLZ4 and linked
+// against liblz4, it also times the reference library on the same blocks and
+// cross-decodes each codec's output with the other.
+//
+//   g++ -std=c++20 -O2 -Iinclude bench/compress_bench.cpp -o compress_bench
+//   g++ -std=c++20 -O2 -DMO_BENCH_LIBLZ4 -Iinclude bench/compress_bench.cpp -o compress_bench -l:liblz4.so.1
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mo/compress.hpp"
+
+#ifdef MO_BENCH_LIBLZ4
+#if __has_include(<lz4.h>)
+#include <lz4.h>
+#else
+// The stable liblz4 entry points, for systems with the library but no headers.
+extern "C" int LZ4_compress_fast(const char* src, char* dst, int src_size, int dst_capacity, int acceleration);
+extern "C" int LZ4_decompress_safe(const char* src, char* dst, int compressed_size, int dst_capacity);
+#endif
+#endif
+
+namespace {
+
+constexpr std::size_t block = 64 << 10;
+
+std::string log_lines(std::size_t size) {
+    static const char* const words[] = {"INFO",    "ERROR",         "GET",      "request",     "/api/v1/users",
+                                        "tenant=", "latency_ms=",   "timeout",  "200",         "  "};
+    std::mt19937 rng(7);
+    std::string out;
+    char stamp[64];
+    for (unsigned line = 0; out.size() < size; ++line) {
+        std::snprintf(stamp, sizeof stamp, "2026-10-16T12:%02u:%02u.%03uZ", line / 60000 % 60, line / 1000 % 60,
+                      line % 1000);
+        out += stamp;
+        for (unsigned w = 0, n = 5 + rng() % 5; w < n; ++w) (out += ' ') += words[rng() % std::size(words)];
+        out += " id=" + std::to_string(rng() % 1000000000) + '\n';
+    }
+    out.resize(size);
+    return out;
+}
+
+std::string random_bytes(std::size_t size) {
+    std::mt19937_64 rng(11);
+    std::string out(size, '\0');
+    for (char& c : out) c = static_cast<char>(rng());
+    return out;
+}
+
+template <typename F>
+double best_seconds(F&& f) {
+    double best = 1e9;
+    for (int round = 0; round < 5; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "wrong result: %s\n", what);
+        std::exit(1);
+    }
+}
+
+struct codec {
+    const char* name;
+    std::size_t (*compress)(const char* src, std::size_t size, char* dst, std::size_t capacity);
+    std::size_t (*decompress)(const char* src, std::size_t size, char* dst, std::size_t capacity);
+};
+
+const codec mo_codec{
+    "mo",
+    [](const char* src, std::size_t size, char* dst, std::size_t capacity) {
+        return mo::lz4_compress_block(src, size, dst, capacity);
+    },
+    [](const char* src, std::size_t size, char* dst, std::size_t capacity) {
+        return mo::lz4_decompress_block(src, size, dst, capacity);
+    },
+};
+
+#ifdef MO_BENCH_LIBLZ4
+const codec reference_codec{
+    "liblz4",
+    [](const char* src, std::size_t size, char* dst, std::size_t capacity) {
+        const int n = LZ4_compress_fast(src, dst, static_cast<int>(size), static_cast<int>(capacity), 1);
+        return static_cast<std::size_t>(std::max(n, 0));
+    },
+    [](const char* src, std::size_t size, char* dst, std::size_t capacity) {
+        const int n = LZ4_decompress_safe(src, dst, static_cast<int>(size), static_cast<int>(capacity));
+        require(n >= 0, "liblz4 rejected a block");
+        return static_cast<std::size_t>(n);
+    },
+};
+#endif
+
+std::vector<std::string> compress_blocks(const codec& c, const std::string& data) {
+    std::vector<std::string> blocks;
+    for (std::size_t at = 0; at < data.size(); at += block) {
+        const std::size_t n = std::min(block, data.size() - at);
+        std::string out(mo::lz4_block_bound(n), '\0');
+        out.resize(c.compress(data.data() + at, n, out.data(), out.size()));
+        require(!out.empty(), "block did not fit its bound");
+        blocks.push_back(std::move(out));
+    }
+    return blocks;
+}
+
+/// Decodes `blocks` with `c` and checks the result against `data`.
+void verify(const codec& c, const std::vector<std::string>& blocks, const std::string& data, const char* what) {
+    std::string out(block, '\0');
+    std::size_t at = 0;
+    for (const std::string& b : blocks) {
+        const std::size_t n = c.decompress(b.data(), b.size(), out.data(), out.size());
+        require(data.compare(at, n, out, 0, n) == 0, what);
+        at += n;
+    }
+    require(at == data.size(), what);
+}
+
+void run(const codec& c, const char* input, const std::string& data) {
+    std::vector<std::string> blocks;
+    const double compress_s = best_seconds([&] { blocks = compress_blocks(c, data); });
+    std::size_t packed = 0;
+    for (const std::string& b : blocks) packed += b.size();
+    std::string out(block, '\0');
+    const double decompress_s = best_seconds([&] {
+        for (const std::string& b : blocks) c.decompress(b.data(), b.size(), out.data(), out.size());
+    });
+    std::printf("%-7s %-7s ratio %7.3f  compress %6.0f MB/s  decompress %6.0f MB/s\n", input, c.name,
+                double(data.size()) / double(packed), double(data.size()) / compress_s / 1e6,
+                double(data.size()) / decompress_s / 1e6);
+}
+
+}  // namespace
+
+int main() {
+    const std::size_t size = 8 << 20;
+    const std::pair<const char*, std::string> inputs[] = {
+        {"logs", log_lines(size)}, {"random", random_bytes(size)}, {"zeros", std::string(size, '\0')}};
+
+    for (const auto& [name, data] : inputs) {
+        const std::vector<std::string> ours = compress_blocks(mo_codec, data);
+        verify(mo_codec, ours, data, "mo round trip");
+        require(mo::lz4_decompress(mo::lz4_compress(data)) == data, "mo frame round trip");
+#ifdef MO_BENCH_LIBLZ4
+        verify(reference_codec, ours, data, "liblz4 decoding mo blocks");
+        verify(mo_codec, compress_blocks(reference_codec, data), data, "mo decoding liblz4 blocks");
+#endif
+    }
+
+    std::printf("64 KiB independent blocks, best of 5\n");
+    for (const auto& [name, data] : inputs) {
+        run(mo_codec, name, data);
+#ifdef MO_BENCH_LIBLZ4
+        run(reference_codec, name, data);
+#endif
+    }
+
+    const std::string& logs = inputs[0].second;
+    std::string frame;
+    const double frame_compress = best_seconds([&] { frame = mo::lz4_compress(logs); });
+    const double frame_decompress =
+        best_seconds([&] { require(mo::lz4_decompress(frame).size() == logs.size(), "frame"); });
+    std::printf("logs    frame with content checksum: compress %6.0f MB/s  decompress %6.0f MB/s\n",
+                double(logs.size()) / frame_compress / 1e6, double(logs.size()) / frame_decompress / 1e6);
+}
@@ -0,0 +1,145 @@
+// concurrent_map against std::unordered_map behind a std::shared_mutex:
+// random reads and 1% or 10% overwrites of 1M keys with 64-byte values,
+// from 1 and 8 threads, then 4M inserts into an empty map, which grows it
+// incrementally. Readers check that no value is ever seen half-written, and
+// the maps' contents are checked afterwards. Reported as wall time over all
+// operations; on one core the threads only time-slice.
+//
+//   g++ -std=c++20 -O2 -Iinclude bench/concurrent_map_bench.cpp -o concurrent_map_bench -pthread
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "mo/concurrent_map.hpp"
+
+namespace {
+
+constexpr std::uint64_t keys = 1'000'000;
+constexpr std::uint64_t ops_per_thread = 2'000'000;
+
+/// Eight words that all hold the same version, so a torn copy shows.
+struct value {
+    std::array<std::uint64_t, 8> words{};
+
+    static value make(std::uint64_t key, std::uint64_t version) {
+        value v;
+        v.words.fill(key * 1'000'003 + version);
+        return v;
+    }
+
+    bool consistent(std::uint64_t key) const {
+        for (const std::uint64_t w : words)
+            if (w != words[0]) return false;
+        return (words[0] - key * 1'000'003) < (std::uint64_t{1} << 40);
+    }
+};
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "wrong result: %s\n", what);
+        std::exit(1);
+    }
+}
+
+class locked_map {
+public:
+    std::optional<value> get(std::uint64_t key) const {
+        std::shared_lock lock(mutex_);
+        const auto it = map_.find(key);
+        if (it == map_.end()) return std::nullopt;
+        return it->second;
+    }
+
+    void insert_or_assign(std::uint64_t key, const value& v) {
+        std::unique_lock lock(mutex_);
+        map_.insert_or_assign(key, v);
+    }
+
+    std::size_t size() const {
+        std::shared_lock lock(mutex_);
+        return map_.size();
+    }
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::uint64_t, value> map_;
+};
+
+/// ns per operation over all threads, after checking every read and the
+/// final contents.
+template <typename Map>
+double run(Map& map, unsigned threads, unsigned write_percent) {
+    std::atomic<bool> torn{false};
+    std::vector<std::thread> pool;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            std::mt19937_64 rng(t + 1);
+            bool ok = true;
+            for (std::uint64_t i = 0; i < ops_per_thread; ++i) {
+                const std::uint64_t r = rng();
+                const std::uint64_t key = r % keys;
+                if ((r >> 32) % 100 < write_percent) {
+                    map.insert_or_assign(key, value::make(key, i));
+                } else {
+                    const std::optional<value> v = map.get(key);
+                    ok &= v.has_value() && v->consistent(key);
+                }
+            }
+            if (!ok) torn = true;
+        });
+    }
+    for (std::thread& t : pool) t.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    require(!torn, "every read found a whole value");
+    require(map.size() == keys, "size");
+    for (std::uint64_t k = 0; k < keys; k += 997) require(map.get(k)->consistent(k), "final value");
+    return seconds * 1e9 / double(threads * ops_per_thread);
+}
+
+template <typename Map>
+void fill(Map& map) {
+    for (std::uint64_t k = 0; k < keys; ++k) map.insert_or_assign(k, value::make(k, 0));
+}
+
+}  // namespace
+
+int main() {
+    std::printf("%llu keys, %zu-byte values, %llu ops per thread, hardware threads %u\n",
+                static_cast<unsigned long long>(keys), sizeof(value), static_cast<unsigned long long>(ops_per_thread),
+                std::thread::hardware_concurrency());
+    for (const unsigned threads : {1u, 8u}) {
+        for (const unsigned writes : {1u, 10u}) {
+            locked_map locked;
+            mo::concurrent_map<std::uint64_t, value> lock_free(keys);
+            fill(locked);
+            fill(lock_free);
+            const double locked_ns = run(locked, threads, writes);
+            const double lock_free_ns = run(lock_free, threads, writes);
+            std::printf("  %u threads, %2u%% writes: unordered_map+shared_mutex %4.0f ns/op, "
+                        "concurrent_map %4.0f ns/op\n",
+                        threads, writes, locked_ns, lock_free_ns);
+        }
+    }
+
+    constexpr std::uint64_t inserts = 4'000'000;
+    mo::concurrent_map<std::uint64_t, std::uint64_t> growing;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t k = 0; k < inserts; ++k) growing.try_emplace(k * 0x9E3779B97F4A7C15ull, k);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    require(growing.size() == inserts, "growing size");
+    for (std::uint64_t k = 0; k < inserts; k += 101) require(growing.get(k * 0x9E3779B97F4A7C15ull) == k, "grown");
+    std::printf("  %llu inserts from empty: %.0f ns/insert, %zu buckets\n", static_cast<unsigned long long>(inserts),
+                seconds * 1e9 / inserts, growing.bucket_count());
+}
@@ -0,0 +1,144 @@
+// walk_directory against std::filesystem::recursive_directory_iterator over
+// a tree (default /usr), and read_files against one std::ifstream per file
+// over the regular files found. Checks first that both walks see the same
+// paths with the same types and that both readers return the same bytes.
+// Times are best of 5 with a warm page cache.
+//
+//   g++ -std=c++20 -O2 -Iinclude bench/dir_walk_bench.cpp -o dir_walk_bench -pthread && ./dir_walk_bench [root]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mo/dir_walk.hpp"
+
+namespace {
+
+template <typename F>
+double best_seconds(F&& f) {
+    double best = 1e9;
+    for (int round = 0; round < 5; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "wrong result: %s\n", what);
+        std::exit(1);
+    }
+}
+
+namespace fs = std::filesystem;
+
+using listing = std::vector<std::pair<std::string, bool>>;  // path, is a regular file
+
+listing with_std(const std::string& root) {
+    listing out;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+         it != end; it.increment(ec)) {
+        if (ec) continue;
+        out.emplace_back(it->path().string(), it->symlink_status(ec).type() == fs::file_type::regular);
+    }
+    return out;
+}
+
+listing with_mo(const std::string& root) {
+    listing out;
+    std::mutex mutex;
+    mo::walk_directory(root, [&](const mo::dir_entry& e) {
+        std::lock_guard lock(mutex);
+        out.emplace_back(std::string(e.path), e.type == mo::entry_type::regular);
+    });
+    return out;
+}
+
+/// Sum of sizes and an order-independent checksum of the contents.
+struct digest {
+    std::atomic<std::uint64_t> bytes{0}, sum{0};
+
+    void add(std::size_t index, std::string_view contents) {
+        std::uint64_t h = 0xcbf29ce484222325ull ^ index;
+        for (const char c : contents) h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        bytes += contents.size();
+        sum += h;
+    }
+};
+
+/// The usual way: one stream per file, sized from its length.
+template <typename F>
+void read_with_ifstream(const std::vector<std::string>& files, F&& on_file) {
+    std::string contents;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        std::ifstream in(files[i], std::ios::binary | std::ios::ate);
+        contents.resize(static_cast<std::size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+        on_file(i, std::string_view(contents).substr(0, static_cast<std::size_t>(in.gcount())));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::string root = argc > 1 ? argv[1] : "/usr";
+    listing expected = with_std(root), found = with_mo(root);
+    std::sort(expected.begin(), expected.end());
+    std::sort(found.begin(), found.end());
+    require(found == expected, "walk_directory sees what recursive_directory_iterator sees");
+
+    std::printf("%s: %zu entries, hardware threads %u, best of 5\n", root.c_str(), found.size(),
+                std::thread::hardware_concurrency());
+    std::size_t n = 0;
+    const double std_s = best_seconds([&] { n = with_std(root).size(); });
+    const double mo_s = best_seconds([&] {
+        std::atomic<std::size_t> count{0};
+        mo::walk_directory(root, [&](const mo::dir_entry&) { count.fetch_add(1, std::memory_order_relaxed); });
+        n = count;
+    });
+    require(n == found.size(), "entry count");
+    std::printf("  walk: recursive_directory_iterator %.0f ms, walk_directory %.0f ms\n", std_s * 1e3, mo_s * 1e3);
+
+    // Regular files up to 1 MiB, so a few big ones do not dominate.
+    std::vector<std::string> files;
+    for (const auto& [path, regular] : found) {
+        std::error_code ec;
+        if (regular && fs::file_size(path, ec) <= (1u << 20) && !ec) files.push_back(path);
+    }
+    digest reference, ours;
+    read_with_ifstream(files, [&](std::size_t i, std::string_view contents) { reference.add(i, contents); });
+    mo::read_files(files, [&](std::size_t i, std::string_view contents) { ours.add(i, contents); });
+    require(ours.bytes == reference.bytes && ours.sum == reference.sum, "read_files contents");
+
+    std::uint64_t bytes = 0;
+    const double ifstream_s = best_seconds([&] {
+        std::uint64_t total = 0;
+        read_with_ifstream(files, [&](std::size_t, std::string_view contents) { total += contents.size(); });
+        bytes = total;
+    });
+    require(bytes == reference.bytes, "ifstream size");
+    const double read_s = best_seconds([&] {
+        std::atomic<std::uint64_t> total{0};
+        mo::read_files(files, [&](std::size_t, std::string_view contents) { total += contents.size(); });
+        bytes = total;
+    });
+    require(bytes == reference.bytes, "read_files size");
+    std::printf("  read %zu files (%.0f MB): ifstream %.0f ms, read_files %.0f ms\n", files.size(), double(bytes) / 1e6,
+                ifstream_s * 1e3, read_s * 1e3);
+}
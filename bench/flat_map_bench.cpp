@@ -0,0 +1,97 @@
+// Random point lookups of uint32 keys: flat_map in the sorted and Eytzinger
+// layouts against std::map, for tables of 1K, 64K and 1M entries, plus
+// build time. Checks every query's answer against std::map first.
+//
+//   g++ -std=c++20 -O2 -Iinclude bench/flat_map_bench.cpp -o flat_map_bench && ./flat_map_bench
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "mo/flat_map.hpp"
+
+namespace {
+
+constexpr std::size_t queries = 1'000'000;
+
+template <typename F>
+double best_seconds(F&& f) {
+    double best = 1e9;
+    for (int round = 0; round < 5; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "wrong result: %s\n", what);
+        std::exit(1);
+    }
+}
+
+template <typename Map>
+std::uint64_t sum_found(const Map& map, const std::vector<std::uint32_t>& probes) {
+    std::uint64_t sum = 0;
+    for (const std::uint32_t k : probes) {
+        const auto it = map.find(k);
+        if (it != map.end()) sum += it->second;
+    }
+    return sum;
+}
+
+void run(std::size_t n, std::mt19937& rng) {
+    std::vector<std::uint32_t> keys(n), values(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        keys[i] = static_cast<std::uint32_t>(rng());
+        values[i] = static_cast<std::uint32_t>(i);
+    }
+    // Half the queries hit, half are random misses.
+    std::vector<std::uint32_t> probes(queries);
+    for (std::size_t i = 0; i < queries; ++i) probes[i] = i % 2 ? keys[rng() % n] : static_cast<std::uint32_t>(rng());
+
+    std::map<std::uint32_t, std::uint32_t> tree;
+    using sorted_map = mo::flat_map<std::uint32_t, std::uint32_t>;
+    using eytzinger_map =
+        mo::flat_map<std::uint32_t, std::uint32_t, std::less<std::uint32_t>, mo::flat_layout::eytzinger>;
+    sorted_map sorted;
+    eytzinger_map eytzinger;
+    const double build_tree = best_seconds([&] {
+        tree.clear();
+        for (std::size_t i = 0; i < n; ++i) tree.emplace(keys[i], values[i]);
+    });
+    const double build_sorted = best_seconds([&] { sorted = sorted_map(keys, values); });
+    const double build_eytzinger = best_seconds([&] { eytzinger = eytzinger_map(keys, values); });
+    require(sorted.size() == tree.size() && eytzinger.size() == tree.size(), "sizes");
+    for (const std::uint32_t k : probes) {
+        const auto t = tree.find(k);
+        const std::uint32_t* s = sorted.get(k);
+        const std::uint32_t* e = eytzinger.get(k);
+        require(t == tree.end() ? !s && !e : s && e && *s == t->second && *e == t->second, "lookup");
+    }
+
+    std::uint64_t a = 0, b = 0, c = 0;
+    const double tree_s = best_seconds([&] { a = sum_found(tree, probes); });
+    const double sorted_s = best_seconds([&] { b = sum_found(sorted, probes); });
+    const double eytzinger_s = best_seconds([&] { c = sum_found(eytzinger, probes); });
+    require(a == b && a == c, "sums");
+    std::printf("  n=%8zu  lookup ns: std::map %6.1f  sorted %6.1f  eytzinger %6.1f"
+                "  | build ms: std::map %7.1f  sorted %6.1f  eytzinger %6.1f\n",
+                n, tree_s * 1e9 / queries, sorted_s * 1e9 / queries, eytzinger_s * 1e9 / queries, build_tree * 1e3,
+                build_sorted * 1e3, build_eytzinger * 1e3);
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng(47);
+    std::printf("uint32 keys and values, %zu queries (half misses), best of 5\n", queries);
+    for (const std::size_t n : {std::size_t{1'000}, std::size_t{64'000}, std::size_t{1'000'000}}) run(n, rng);
+}
@@ -0,0 +1,124 @@
+// futex_mutex against std::mutex, uncontended and with several threads, and
+// mo::counting_semaphore against std::counting_semaphore for an uncontended
+// acquire+release and a two-thread ping-pong. Checks first that the mutex
+// loses no increments and the semaphores no permits. An idle thread runs
+// throughout, so the library takes its multi-threaded paths.
+//
+//   g++ -std=c++20 -O2 -Iinclude bench/futex_bench.cpp -o futex_bench -pthread && ./futex_bench [threads]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+#include "mo/futex.hpp"
+
+namespace {
+
+constexpr int ops = 10'000'000;
+constexpr int rounds = 100'000;
+
+template <typename F>
+double best_seconds(F&& f) {
+    double best = 1e9;
+    for (int round = 0; round < 5; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "wrong result: %s\n", what);
+        std::exit(1);
+    }
+}
+
+/// `threads` threads each add `per_thread` to one counter under `m`.
+template <typename Mutex>
+std::uint64_t hammer(Mutex& m, unsigned threads, int per_thread) {
+    std::uint64_t counter = 0;
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back([&] {
+            for (int i = 0; i < per_thread; ++i) {
+                std::lock_guard lock(m);
+                ++counter;
+            }
+        });
+    }
+    for (std::thread& t : pool) t.join();
+    return counter;
+}
+
+/// Two threads hand one permit back and forth `rounds` times.
+template <typename Sem>
+int ping_pong(Sem& ping, Sem& pong) {
+    int returned = 0;
+    std::thread other([&] {
+        for (int i = 0; i < rounds; ++i) {
+            ping.acquire();
+            pong.release();
+        }
+    });
+    for (int i = 0; i < rounds; ++i) {
+        ping.release();
+        pong.acquire();
+        ++returned;
+    }
+    other.join();
+    return returned;
+}
+
+template <typename Mutex>
+void time_mutex(const char* name, unsigned threads) {
+    Mutex m;
+    require(hammer(m, threads, 200'000) == threads * 200'000ull, name);
+    const double alone = best_seconds([&] {
+        for (int i = 0; i < ops; ++i) {
+            m.lock();
+            m.unlock();
+        }
+    });
+    const double shared = best_seconds([&] { hammer(m, threads, ops / static_cast<int>(threads)); });
+    std::printf("  %-24s %2zu B  uncontended %5.1f ns/lock+unlock  %u threads %5.1f ns/op\n", name, sizeof(Mutex),
+                alone * 1e9 / ops, threads, shared * 1e9 / ops);
+}
+
+template <typename Sem>
+void time_semaphore(const char* name) {
+    Sem sem(0), ping(0), pong(0);
+    require(ping_pong(ping, pong) == rounds && !ping.try_acquire() && !pong.try_acquire(), name);
+    const double alone = best_seconds([&] {
+        for (int i = 0; i < ops; ++i) {
+            sem.release();
+            sem.acquire();
+        }
+    });
+    require(!sem.try_acquire(), name);
+    const double trip = best_seconds([&] { ping_pong(ping, pong); });
+    std::printf("  %-24s %2zu B  release+acquire %5.1f ns  ping-pong %5.2f us/round trip\n", name, sizeof(Sem),
+                alone * 1e9 / ops, trip * 1e6 / rounds);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const unsigned threads = argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 4;
+    mo::one_shot_event stop;
+    std::thread idle([&] { stop.wait(); });
+    std::printf("hardware threads: %u, best of 5\n", std::thread::hardware_concurrency());
+    time_mutex<std::mutex>("std::mutex", threads);
+    time_mutex<mo::futex_mutex>("mo::futex_mutex", threads);
+    time_semaphore<std::counting_semaphore<>>("std::counting_semaphore");
+    time_semaphore<mo::counting_semaphore>("mo::counting_semaphore");
+    stop.set();
+    idle.join();
+}
@@ -0,0 +1,103 @@
+// Intersecting a short sorted id list with a long one: std::set_intersection
+// over raw arrays against intersect_sorted (which gallops) and against
+// intersect with the long list held as a packed_list, which decodes only the
+// blocks that can match. Also the packed size and full decode speed. Checks
+// all intersections against std::set_intersection first.
+//
+//   g++ -std=c++20 -O2 -Iinclude bench/int_codec_bench.cpp -o int_codec_bench && ./int_codec_bench [ids]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "mo/int_codec.hpp"
+
+namespace {
+
+template <typename F>
+double best_seconds(F&& f) {
+    double best = 1e9;
+    for (int round = 0; round < 5; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "wrong result: %s\n", what);
+        std::exit(1);
+    }
+}
+
+/// Posting-list-like ids: strictly increasing, gaps of 1-15.
+std::vector<std::uint64_t> posting_ids(std::mt19937_64& rng, std::size_t n) {
+    std::vector<std::uint64_t> out(n);
+    std::uint64_t v = 0;
+    for (std::uint64_t& x : out) x = v += 1 + rng() % 15;
+    return out;
+}
+
+/// `n` distinct sorted values in [0, range).
+std::vector<std::uint64_t> probe(std::mt19937_64& rng, std::size_t n, std::uint64_t range) {
+    std::vector<std::uint64_t> out(n);
+    for (std::uint64_t& x : out) x = rng() % range;
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+std::vector<std::uint64_t> merge(const std::vector<std::uint64_t>& a, const std::vector<std::uint64_t>& b) {
+    std::vector<std::uint64_t> out;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+    return out;
+}
+
+std::vector<std::uint64_t> gallop(const std::vector<std::uint64_t>& a, const std::vector<std::uint64_t>& b) {
+    std::vector<std::uint64_t> out(std::min(a.size(), b.size()));
+    out.resize(mo::intersect_sorted(std::span<const std::uint64_t>(a), std::span<const std::uint64_t>(b),
+                                    out.data()));
+    return out;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    std::mt19937_64 rng(41);
+    const std::vector<std::uint64_t> ids = posting_ids(rng, n);
+    const mo::packed_list<std::uint64_t> packed{std::span<const std::uint64_t>(ids)};
+    require(packed.decode() == ids, "packed_list round trip");
+
+    std::printf("%zu sorted ids (gaps 1-15), best of 5\n", n);
+    std::printf("  raw %.1f MB, packed_list %.2f B/id (%.1fx smaller)\n", double(n * 8) / 1e6,
+                double(packed.memory_bytes()) / double(n), double(n * 8) / double(packed.memory_bytes()));
+    std::vector<std::uint64_t> decoded(n);
+    const double decode_s = best_seconds([&] { packed.decode(decoded.data()); });
+    require(decoded == ids, "decode");
+    std::printf("  decode packed_list %.0f M ids/s\n", double(n) / decode_s / 1e6);
+
+    for (const std::size_t short_size : {std::size_t{2'000}, std::size_t{20'000}, n / 4}) {
+        const std::vector<std::uint64_t> few = probe(rng, short_size, ids.back() + 1);
+        const std::vector<std::uint64_t> expected = merge(few, ids);
+        require(gallop(few, ids) == expected, "intersect_sorted");
+        require(mo::intersect(std::span<const std::uint64_t>(few), packed) == expected, "intersect packed");
+
+        std::size_t hits = 0;
+        const double merge_s = best_seconds([&] { hits = merge(few, ids).size(); });
+        const double gallop_s = best_seconds([&] { hits = gallop(few, ids).size(); });
+        const double packed_s =
+            best_seconds([&] { hits = mo::intersect(std::span<const std::uint64_t>(few), packed).size(); });
+        std::printf("  %zu x %zu (%zu hits): std::set_intersection %.3f ms, intersect_sorted %.3f ms, "
+                    "packed_list %.3f ms\n",
+                    few.size(), n, hits, merge_s * 1e3, gallop_s * 1e3, packed_s * 1e3);
+    }
+}
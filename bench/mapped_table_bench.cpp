@@ -0,0 +1,153 @@
+// Startup and point lookups of a 2M-entry mapped_table against the usual
+// alternative, parsing a text file into a std::unordered_map at startup.
+// Lookups run cold (file pages evicted with POSIX_FADV_DONTNEED before the
+// open) and warm, through the hash index and through fence keys only.
+// Checks every looked-up value against the map first.
+//
+//   g++ -std=c++20 -O2 -Iinclude bench/mapped_table_bench.cpp -o mapped_table_bench && ./mapped_table_bench [dir] [n]
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mo/mapped_table.hpp"
+
+namespace {
+
+constexpr std::size_t lookups = 1'000'000;
+
+template <typename F>
+double best_seconds(F&& f) {
+    double best = 1e9;
+    for (int round = 0; round < 5; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+template <typename F>
+double once_seconds(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "wrong result: %s\n", what);
+        std::exit(1);
+    }
+}
+
+std::string key(std::uint64_t i) {
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "user:%016llx", static_cast<unsigned long long>(i * 0x9E3779B97F4A7C15ull));
+    return buf;
+}
+
+std::string value(std::uint64_t i) { return "{\"id\":" + std::to_string(i) + ",\"tier\":\"gold\",\"n\":7}"; }
+
+void evict(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    require(fd >= 0, "open for eviction");
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+std::unordered_map<std::string, std::string> parse_text(const std::string& path) {
+    std::unordered_map<std::string, std::string> map;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line);) {
+        const std::size_t tab = line.find('\t');
+        map.emplace(line.substr(0, tab), line.substr(tab + 1));
+    }
+    return map;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : ".";
+    const std::uint64_t n = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2'000'000;
+    dir += "/mo_table_bench.XXXXXX";
+    require(::mkdtemp(dir.data()) != nullptr, "mkdtemp");
+
+    std::vector<std::string> keys(n);
+    for (std::uint64_t i = 0; i < n; ++i) keys[i] = key(i);
+    std::vector<std::uint64_t> order(n);
+    for (std::uint64_t i = 0; i < n; ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](std::uint64_t a, std::uint64_t b) { return keys[a] < keys[b]; });
+
+    const std::string text = dir + "/table.txt", hashed = dir + "/hash.tbl", fenced = dir + "/fence.tbl";
+    {
+        std::ofstream out(text);
+        for (const std::uint64_t i : order) out << keys[i] << '\t' << value(i) << '\n';
+    }
+    const double build_s = once_seconds([&] {
+        for (const bool hash : {true, false}) {
+            mo::mapped_table_builder builder(hash ? hashed : fenced, {1024, hash});
+            for (const std::uint64_t i : order) builder.add(keys[i], value(i));
+            builder.finish();
+        }
+    });
+
+    std::mt19937_64 rng(43);
+    std::vector<std::uint64_t> probes(lookups);
+    for (std::uint64_t& p : probes) p = rng() % n;
+
+    std::unordered_map<std::string, std::string> map;
+    evict(text);
+    const double parse_s = once_seconds([&] { map = parse_text(text); });
+    require(map.size() == n, "parsed entries");
+    mo::mapped_table table;
+    const double open_s = best_seconds([&] { table = mo::mapped_table(hashed); });
+    const mo::mapped_table fence_only(fenced);
+    for (const std::uint64_t p : probes) {
+        const std::string& expected = map.at(keys[p]);
+        require(table.find(keys[p]) == expected && fence_only.find(keys[p]) == expected, "lookup value");
+    }
+    require(!table.contains("user:") && !fence_only.contains("user:~"), "absent keys");
+
+    std::printf("%llu entries, %.0f MB table file, built both tables in %.0f ms\n", static_cast<unsigned long long>(n),
+                double(table.file_size()) / 1e6, build_s * 1e3);
+    std::printf("  startup: parse text into unordered_map %.0f ms, open mapped_table %.3f ms\n", parse_s * 1e3,
+                open_s * 1e3);
+
+    std::size_t hits = 0;
+    const auto run = [&](const auto& find) {
+        return once_seconds([&] {
+                   for (const std::uint64_t p : probes) hits += find(keys[p]);
+               }) *
+               1e9 / lookups;
+    };
+    const auto map_find = [&](const std::string& k) { return map.find(k) != map.end(); };
+    const auto table_find = [&](const std::string& k) { return table.find(k).has_value(); };
+    const auto fence_find = [&](const std::string& k) { return fence_only.find(k).has_value(); };
+
+    evict(hashed);
+    evict(fenced);
+    table = mo::mapped_table(hashed);
+    const mo::mapped_table cold_fence(fenced);
+    const double cold_map = run(map_find), cold_hash = run(table_find);
+    const double cold_fence_ns = run([&](const std::string& k) { return cold_fence.find(k).has_value(); });
+    std::printf("  lookups, table cold: unordered_map %.0f ns, mapped_table hash %.0f ns, fence-only %.0f ns\n",
+                cold_map, cold_hash, cold_fence_ns);
+    std::printf("  lookups, warm:       unordered_map %.0f ns, mapped_table hash %.0f ns, fence-only %.0f ns\n",
+                run(map_find), run(table_find), run(fence_find));
+    require(hits == 6 * lookups, "lookup hits");
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,109 @@
+// mo::counter::inc against a shared std::atomic fetch_add, from one thread
+// and from several, plus histogram::observe. Checks the summed totals first.
+// On a single core the threads only time-slice, so this shows the
+// uncontended cost; the sharding pays off once threads run on separate
+// cores and stop bouncing one cache line.
+//
+//   g++ -std=c++20 -O2 -Iinclude bench/metrics_bench.cpp -o metrics_bench -pthread && ./metrics_bench [threads]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "mo/metrics.hpp"
+
+namespace {
+
+constexpr std::uint64_t ops = 20'000'000;
+
+template <typename F>
+double best_seconds(F&& f) {
+    double best = 1e9;
+    for (int round = 0; round < 5; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "wrong result: %s\n", what);
+        std::exit(1);
+    }
+}
+
+/// Runs `f(ops_per_thread)` on `threads` threads at once.
+template <typename F>
+void on_threads(unsigned threads, std::uint64_t ops_per_thread, F f) {
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) pool.emplace_back([&] { f(ops_per_thread); });
+    for (std::thread& t : pool) t.join();
+}
+
+void check_correctness() {
+    mo::counter c;
+    on_threads(8, 100'000, [&](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i) c.inc();
+    });
+    c.inc(5);
+    require(c.value() == 800'005, "counter total");
+
+    mo::histogram h(mo::linear_buckets(0, 10, 10));
+    on_threads(4, 1000, [&](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i) h.observe(static_cast<double>(i % 100));
+    });
+    const auto s = h.read();
+    require(s.count == 4000 && s.cumulative.front() == 40 && s.sum == 4 * 10 * 4950.0, "histogram totals");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const unsigned threads = argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 4;
+    check_correctness();
+    std::printf("hardware threads: %u, best of 5\n", std::thread::hardware_concurrency());
+
+    std::atomic<std::uint64_t> atomic{0};
+    mo::counter counter;
+    mo::histogram histogram(mo::exponential_buckets(1, 2, 16));
+    const double atomic_s = best_seconds([&] {
+        for (std::uint64_t i = 0; i < ops; ++i) atomic.fetch_add(1, std::memory_order_relaxed);
+    });
+    const double counter_s = best_seconds([&] {
+        for (std::uint64_t i = 0; i < ops; ++i) counter.inc();
+    });
+    const double histogram_s = best_seconds([&] {
+        for (std::uint64_t i = 0; i < ops; ++i) histogram.observe(static_cast<double>(i & 0xffff));
+    });
+    require(atomic.load() == 5 * ops && counter.value() == 5 * ops, "single-thread totals");
+    std::printf("  1 thread   std::atomic fetch_add  %6.2f ns/op\n", atomic_s * 1e9 / ops);
+    std::printf("  1 thread   mo::counter::inc       %6.2f ns/op\n", counter_s * 1e9 / ops);
+    std::printf("  1 thread   histogram::observe     %6.2f ns/op\n", histogram_s * 1e9 / ops);
+
+    // Wall time per increment of each thread: flat as threads are added means
+    // no contention.
+    const std::uint64_t per_thread = ops / threads;
+    atomic = 0;
+    mo::counter shared;
+    const double atomic_t = best_seconds([&] {
+        on_threads(threads, per_thread, [&](std::uint64_t n) {
+            for (std::uint64_t i = 0; i < n; ++i) atomic.fetch_add(1, std::memory_order_relaxed);
+        });
+    });
+    const double counter_t = best_seconds([&] {
+        on_threads(threads, per_thread, [&](std::uint64_t n) {
+            for (std::uint64_t i = 0; i < n; ++i) shared.inc();
+        });
+    });
+    require(atomic.load() == 5 * threads * per_thread && shared.value() == 5 * threads * per_thread,
+            "multi-thread totals");
+    std::printf("  %u threads  std::atomic fetch_add  %6.2f ns/op\n", threads, atomic_t * 1e9 / double(per_thread));
+    std::printf("  %u threads  mo::counter::inc       %6.2f ns/op\n", threads, counter_t * 1e9 / double(per_thread));
+}
@@ -0,0 +1,110 @@
+// radix_sort, string_radix_sort, sample_sort and parallel_radix_sort against
+// std::sort on uniform random keys. Checks results against std::sort first.
+//
+//   g++ -std=c++20 -O2 -Iinclude bench/sort_bench.cpp -o sort_bench -pthread && ./sort_bench [keys]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mo/sort.hpp"
+
+namespace {
+
+template <typename F>
+double time_ms(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "wrong result: %s\n", what);
+        std::exit(1);
+    }
+}
+
+void check_correctness(mo::thread_pool& pool, std::mt19937_64& rng) {
+    std::vector<int> ints(100000);
+    for (int& x : ints) x = static_cast<int>(rng());
+    std::vector<int> expected = ints;
+    std::sort(expected.begin(), expected.end());
+    mo::radix_sort(std::span(ints));
+    require(ints == expected, "radix_sort int");
+
+    std::vector<double> doubles(100000);
+    std::normal_distribution<double> normal;
+    for (double& x : doubles) x = normal(rng);
+    std::vector<double> expected_doubles = doubles;
+    std::sort(expected_doubles.begin(), expected_doubles.end());
+    mo::radix_sort(std::span(doubles));
+    require(doubles == expected_doubles, "radix_sort double");
+
+    std::vector<std::string> strings(100000);
+    for (std::string& s : strings) s = "SYM" + std::to_string(rng() % 5000) + "-" + std::to_string(rng() % 7);
+    std::vector<std::string> expected_strings = strings;
+    std::sort(expected_strings.begin(), expected_strings.end());
+    mo::string_radix_sort(std::span(strings));
+    require(strings == expected_strings, "string_radix_sort");
+
+    std::vector<std::pair<std::int64_t, int>> pairs(1000000);
+    for (int i = 0; i < static_cast<int>(pairs.size()); ++i) pairs[i] = {std::int64_t(rng() % 10000) - 5000, i};
+    std::vector<std::pair<std::int64_t, int>> expected_pairs = pairs;
+    std::sort(expected_pairs.begin(), expected_pairs.end());  // index breaks ties: stable order
+    mo::parallel_radix_sort(pool, std::span(pairs), [](const auto& p) { return p.first; });
+    require(pairs == expected_pairs, "parallel_radix_sort stability");
+
+    std::vector<std::uint64_t> keys(1000000);
+    for (std::uint64_t& x : keys) x = rng() % 1000;
+    std::vector<std::uint64_t> expected_keys = keys;
+    std::sort(expected_keys.begin(), expected_keys.end());
+    mo::sample_sort(pool, std::span(keys));
+    require(keys == expected_keys, "sample_sort");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20'000'000;
+    std::mt19937_64 rng(42);
+    mo::thread_pool pool(std::thread::hardware_concurrency());
+    check_correctness(pool, rng);
+
+    std::printf("hardware threads: %u, pool workers: %zu, N=%zu uint64 keys (uniform random)\n",
+                std::thread::hardware_concurrency(), pool.size(), n);
+    std::vector<std::uint64_t> base(n);
+    for (std::uint64_t& x : base) x = rng();
+    const auto run = [&](const char* name, auto sort) {
+        std::vector<std::uint64_t> v = base;
+        const double ms = time_ms([&] { sort(v); });
+        require(std::is_sorted(v.begin(), v.end()), name);
+        std::printf("  %-28s %9.1f ms  %7.1f Mkeys/s\n", name, ms, double(n) / ms / 1e3);
+    };
+    run("std::sort", [](auto& v) { std::sort(v.begin(), v.end()); });
+    run("mo::radix_sort", [](auto& v) { mo::radix_sort(std::span(v)); });
+    run("mo::sample_sort", [&](auto& v) { mo::sample_sort(pool, std::span(v)); });
+    run("mo::parallel_radix_sort", [&](auto& v) { mo::parallel_radix_sort(pool, std::span(v)); });
+
+    std::vector<std::string> strings(n / 10);
+    for (std::string& s : strings) {
+        char buf[17];
+        std::snprintf(buf, sizeof buf, "%016llx", static_cast<unsigned long long>(rng()));
+        s = buf;
+    }
+    const auto run_strings = [&](const char* name, auto sort) {
+        std::vector<std::string> v = strings;
+        const double ms = time_ms([&] { sort(v); });
+        require(std::is_sorted(v.begin(), v.end()), name);
+        std::printf("  %-28s %9.1f ms  (%zu 16-byte string keys)\n", name, ms, v.size());
+    };
+    run_strings("std::sort strings", [](auto& v) { std::sort(v.begin(), v.end()); });
+    run_strings("mo::string_radix_sort", [](auto& v) { mo::string_radix_sort(std::span(v)); });
+}
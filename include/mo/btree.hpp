@@ -0,0 +1,831 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MO_BTREE_HAVE_X86 1
+#endif
+
+#include "mo/cpu_features.hpp"
+#include "mo/flat_map.hpp"
+
+namespace mo {
+
+namespace detail::btree {
+
+/// Bytes of keys per node: four cache lines, which a linear vector scan
+/// covers in eight AVX2 compares, while the tree stays shallow (32-64
+/// children per inner node for 8- and 4-byte keys).
+inline constexpr std::size_t node_key_bytes = 256;
+
+template <typename Key>
+inline constexpr std::size_t node_capacity = std::max<std::size_t>(8, node_key_bytes / sizeof(Key));
+
+/// Enough for any tree that fits in memory: inner nodes keep at least
+/// three children even with the smallest capacity.
+inline constexpr std::size_t max_height = 48;
+
+struct node {
+    std::uint32_t count = 0;
+};
+
+template <typename Key, typename T>
+struct alignas(64) leaf : node {
+    static constexpr std::size_t capacity = node_capacity<Key>;
+    Key keys[capacity];
+    T values[capacity];
+    leaf* prev = nullptr;
+    leaf* next = nullptr;
+};
+
+template <typename Key>
+struct alignas(64) inner : node {
+    static constexpr std::size_t capacity = node_capacity<Key>;
+    Key keys[capacity];  // keys[i] is the smallest key under children[i + 1]
+    node* children[capacity + 1];
+};
+
+/// 4- and 8-byte integers under their natural order are searched with
+/// vector compares instead of a binary search.
+template <typename Key, typename Compare, typename K>
+inline constexpr bool simd_search =
+    std::is_integral_v<Key> && !std::is_same_v<Key, bool> && (sizeof(Key) == 4 || sizeof(Key) == 8) &&
+    std::is_same_v<K, Key> && (std::is_same_v<Compare, std::less<Key>> || std::is_same_v<Compare, std::less<>>);
+
+#ifdef MO_BTREE_HAVE_X86
+/// Number of the first `n` keys that sort before `x`: keys `< x`, or
+/// `<= x` when `Upper`. Reads whole vectors, so the node's capacity must be
+/// a multiple of the lane count.
+template <bool Upper, typename Key>
+__attribute__((target("avx2"))) std::size_t rank_avx2(const Key* keys, std::size_t n, Key x) noexcept {
+    constexpr std::size_t lanes = 32 / sizeof(Key);
+    constexpr unsigned full = (1u << lanes) - 1;
+    // AVX2 only compares signed lanes: flip the sign bit of unsigned keys.
+    using S = std::make_signed_t<Key>;
+    constexpr S bias = std::is_unsigned_v<Key> ? static_cast<S>(Key{1} << (sizeof(Key) * 8 - 1)) : S{0};
+    const S biased = static_cast<S>(static_cast<S>(x) ^ bias);
+    __m256i flip, xv;
+    if constexpr (sizeof(Key) == 4) {
+        flip = _mm256_set1_epi32(bias);
+        xv = _mm256_set1_epi32(biased);
+    } else {
+        flip = _mm256_set1_epi64x(bias);
+        xv = _mm256_set1_epi64x(biased);
+    }
+    std::size_t rank = 0;
+    for (std::size_t i = 0; i < n; i += lanes) {
+        const __m256i kv = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), flip);
+        unsigned before;
+        if constexpr (sizeof(Key) == 4) {
+            const __m256i m = Upper ? _mm256_cmpgt_epi32(kv, xv) : _mm256_cmpgt_epi32(xv, kv);
+            before = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+        } else {
+            const __m256i m = Upper ? _mm256_cmpgt_epi64(kv, xv) : _mm256_cmpgt_epi64(xv, kv);
+            before = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(m)));
+        }
+        if constexpr (Upper) before = ~before & full;  // not greater
+        if (n - i < lanes) before &= (1u << (n - i)) - 1;
+        rank += static_cast<std::size_t>(std::popcount(before));
+        if (before != full) break;  // sorted: nothing further sorts before `x`
+    }
+    return rank;
+}
+#endif
+
+/// Index of the first of the `n` keys not before `x`: `lower_bound`, or
+/// `upper_bound` when `Upper`.
+template <bool Upper, typename Key, typename K, typename Compare>
+std::size_t rank(const Key* keys, std::size_t n, const K& x, const Compare& comp) {
+#ifdef MO_BTREE_HAVE_X86
+    if constexpr (simd_search<Key, Compare, K>) {
+        static_assert(node_capacity<Key> % (32 / sizeof(Key)) == 0);
+        if (cpu().avx2) return rank_avx2<Upper>(keys, n, x);
+    }
+#endif
+    if constexpr (Upper)
+        return static_cast<std::size_t>(std::upper_bound(keys, keys + n, x, comp) - keys);
+    else
+        return static_cast<std::size_t>(std::lower_bound(keys, keys + n, x, comp) - keys);
+}
+
+}  // namespace detail::btree
+
+/// Ordered map for tens of millions of entries: a B+tree whose nodes hold
+/// 256 bytes of keys in one array, values in another, and whose leaves are
+/// linked for range scans. Compared with `std::map` (a 48-byte heap node
+/// per entry, one cache miss per level of a deep tree), an 8-byte key and
+/// value cost about 20 bytes and a lookup touches three or four nodes.
+/// Integer keys are searched within a node by AVX2 compares.
+///
+/// Build large maps with the bulk constructors, which sort once and fill
+/// the leaves bottom-up. Keys must be copyable; keys and values
+/// default-constructible and move-assignable (nodes hold fixed arrays).
+/// Any insert or erase invalidates iterators.
+template <typename Key, typename T, typename Compare = std::less<Key>>
+class btree_map {
+    using node = detail::btree::node;
+    using leaf_node = detail::btree::leaf<Key, T>;
+    using inner_node = detail::btree::inner<Key>;
+
+    // A node is split when an insert fills it to capacity, so at rest it
+    // holds at most capacity - 1 keys. Below the minimum it borrows from or
+    // merges with a sibling; the bounds keep any merge within capacity - 1.
+    static constexpr std::size_t leaf_capacity = leaf_node::capacity;
+    static constexpr std::size_t inner_capacity = inner_node::capacity;
+    static constexpr std::size_t leaf_min = leaf_capacity / 2;
+    static constexpr std::size_t inner_min = (inner_capacity - 1) / 2;
+
+    template <bool Const>
+    class basic_iterator {
+        using mapped_ref = std::conditional_t<Const, const T&, T&>;
+
+    public:
+        using iterator_concept = std::bidirectional_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<Key, T>;
+        using reference = std::pair<const Key&, mapped_ref>;
+        using difference_type = std::ptrdiff_t;
+
+        struct pointer {
+            reference ref;
+            const reference* operator->() const noexcept { return &ref; }
+        };
+
+        basic_iterator() = default;
+        basic_iterator(const btree_map* tree, leaf_node* leaf, std::size_t pos) noexcept
+            : tree_(tree), leaf_(leaf), pos_(pos) {}
+        operator basic_iterator<true>() const noexcept
+            requires(!Const)
+        {
+            return {tree_, leaf_, pos_};
+        }
+
+        reference operator*() const noexcept { return {leaf_->keys[pos_], leaf_->values[pos_]}; }
+        pointer operator->() const noexcept { return {**this}; }
+
+        basic_iterator& operator++() noexcept {
+            if (++pos_ == leaf_->count) {
+                leaf_ = leaf_->next;
+                pos_ = 0;
+            }
+            return *this;
+        }
+        basic_iterator operator++(int) noexcept {
+            basic_iterator old = *this;
+            ++*this;
+            return old;
+        }
+        basic_iterator& operator--() noexcept {
+            if (!leaf_ || pos_ == 0) {
+                leaf_ = leaf_ ? leaf_->prev : tree_->last_;
+                pos_ = leaf_->count;
+            }
+            --pos_;
+            return *this;
+        }
+        basic_iterator operator--(int) noexcept {
+            basic_iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept {
+            return a.leaf_ == b.leaf_ && a.pos_ == b.pos_;
+        }
+
+    private:
+        friend class btree_map;
+        const btree_map* tree_ = nullptr;
+        leaf_node* leaf_ = nullptr;  // null at the end
+        std::size_t pos_ = 0;
+    };
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using size_type = std::size_t;
+    using key_compare = Compare;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    btree_map() = default;
+    explicit btree_map(const Compare& comp) : comp_(comp) {}
+
+    /// Parallel arrays in any order; of duplicate keys the first wins.
+    btree_map(std::vector<Key> keys, std::vector<T> values, const Compare& comp = Compare()) : comp_(comp) {
+        if (keys.size() != values.size()) throw std::invalid_argument("btree_map: key and value counts differ");
+        detail::flat::sort_unique(keys, &values, comp_);
+        bulk_load(keys, values);
+    }
+
+    btree_map(sorted_unique_t, std::vector<Key> keys, std::vector<T> values, const Compare& comp = Compare())
+        : comp_(comp) {
+        if (keys.size() != values.size()) throw std::invalid_argument("btree_map: key and value counts differ");
+        detail::flat::check_sorted_unique(keys, comp_);
+        bulk_load(keys, values);
+    }
+
+    template <std::input_iterator It>
+    btree_map(It first, It last, const Compare& comp = Compare()) : comp_(comp) {
+        std::vector<Key> keys;
+        std::vector<T> values;
+        for (; first != last; ++first) {
+            auto&& [k, v] = *first;
+            keys.push_back(k);
+            values.push_back(v);
+        }
+        detail::flat::sort_unique(keys, &values, comp_);
+        bulk_load(keys, values);
+    }
+
+    btree_map(std::initializer_list<value_type> init, const Compare& comp = Compare())
+        : btree_map(init.begin(), init.end(), comp) {}
+
+    btree_map(const btree_map& other) : comp_(other.comp_) {
+        std::vector<Key> keys;
+        std::vector<T> values;
+        keys.reserve(other.size());
+        values.reserve(other.size());
+        for (leaf_node* l = other.first_; l; l = l->next) {
+            keys.insert(keys.end(), l->keys, l->keys + l->count);
+            values.insert(values.end(), l->values, l->values + l->count);
+        }
+        bulk_load(keys, values);
+    }
+
+    btree_map(btree_map&& other) noexcept
+        : root_(std::exchange(other.root_, nullptr)),
+          first_(std::exchange(other.first_, nullptr)),
+          last_(std::exchange(other.last_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          height_(std::exchange(other.height_, 0)),
+          leaves_(std::exchange(other.leaves_, 0)),
+          inners_(std::exchange(other.inners_, 0)),
+          comp_(other.comp_) {}
+
+    btree_map& operator=(btree_map other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~btree_map() { clear(); }
+
+    void swap(btree_map& other) noexcept {
+        std::swap(root_, other.root_);
+        std::swap(first_, other.first_);
+        std::swap(last_, other.last_);
+        std::swap(size_, other.size_);
+        std::swap(height_, other.height_);
+        std::swap(leaves_, other.leaves_);
+        std::swap(inners_, other.inners_);
+        std::swap(comp_, other.comp_);
+    }
+
+    iterator begin() noexcept { return {this, first_, 0}; }
+    const_iterator begin() const noexcept { return {this, first_, 0}; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    iterator end() noexcept { return {this, nullptr, 0}; }
+    const_iterator end() const noexcept { return {this, nullptr, 0}; }
+    const_iterator cend() const noexcept { return end(); }
+
+    bool empty() const noexcept { return size_ == 0; }
+    std::size_t size() const noexcept { return size_; }
+    key_compare key_comp() const { return comp_; }
+
+    /// Levels of inner nodes above the leaves.
+    std::size_t height() const noexcept { return height_; }
+
+    /// Bytes held in nodes.
+    std::size_t memory_bytes() const noexcept { return leaves_ * sizeof(leaf_node) + inners_ * sizeof(inner_node); }
+
+    iterator find(const Key& key) { return to_mutable(std::as_const(*this).find(key)); }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    iterator find(const K& key) {
+        return to_mutable(std::as_const(*this).find(key));
+    }
+    const_iterator find(const Key& key) const { return find_impl(key); }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const_iterator find(const K& key) const {
+        return find_impl(key);
+    }
+
+    bool contains(const Key& key) const { return find(key) != end(); }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    bool contains(const K& key) const {
+        return find(key) != end();
+    }
+
+    std::size_t count(const Key& key) const { return contains(key) ? 1 : 0; }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    std::size_t count(const K& key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    /// Pointer to the value for `key`, or null.
+    const T* get(const Key& key) const {
+        const const_iterator it = find(key);
+        return it != end() ? &it.leaf_->values[it.pos_] : nullptr;
+    }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const T* get(const K& key) const {
+        const const_iterator it = find(key);
+        return it != end() ? &it.leaf_->values[it.pos_] : nullptr;
+    }
+    T* get(const Key& key) { return const_cast<T*>(std::as_const(*this).get(key)); }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    T* get(const K& key) {
+        return const_cast<T*>(std::as_const(*this).get(key));
+    }
+
+    const T& at(const Key& key) const {
+        if (const T* v = get(key)) return *v;
+        throw std::out_of_range("btree_map::at: key not found");
+    }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const T& at(const K& key) const {
+        if (const T* v = get(key)) return *v;
+        throw std::out_of_range("btree_map::at: key not found");
+    }
+    T& at(const Key& key) {
+        if (T* v = get(key)) return *v;
+        throw std::out_of_range("btree_map::at: key not found");
+    }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    T& at(const K& key) {
+        if (T* v = get(key)) return *v;
+        throw std::out_of_range("btree_map::at: key not found");
+    }
+
+    iterator lower_bound(const Key& key) { return to_mutable(std::as_const(*this).lower_bound(key)); }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    iterator lower_bound(const K& key) {
+        return to_mutable(std::as_const(*this).lower_bound(key));
+    }
+    const_iterator lower_bound(const Key& key) const { return bound<false>(key); }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const_iterator lower_bound(const K& key) const {
+        return bound<false>(key);
+    }
+    iterator upper_bound(const Key& key) { return to_mutable(std::as_const(*this).upper_bound(key)); }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    iterator upper_bound(const K& key) {
+        return to_mutable(std::as_const(*this).upper_bound(key));
+    }
+    const_iterator upper_bound(const Key& key) const { return bound<true>(key); }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const_iterator upper_bound(const K& key) const {
+        return bound<true>(key);
+    }
+
+    /// Entries with keys in [lo, hi), in order.
+    std::ranges::subrange<const_iterator> range(const Key& lo, const Key& hi) const {
+        if (!comp_(lo, hi)) return {end(), end()};
+        return {lower_bound(lo), lower_bound(hi)};
+    }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    std::ranges::subrange<const_iterator> range(const K& lo, const K& hi) const {
+        if (!comp_(lo, hi)) return {end(), end()};
+        return {lower_bound(lo), lower_bound(hi)};
+    }
+
+    T& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        return insert_impl(key, [&] { return T(std::forward<Args>(args)...); }, false);
+    }
+
+    std::pair<iterator, bool> insert(value_type entry) {
+        return insert_impl(entry.first, [&] { return std::move(entry.second); }, false);
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value) {
+        return insert_impl(key, [&] { return T(std::forward<V>(value)); }, true);
+    }
+
+    std::size_t erase(const Key& key) { return erase_impl(key); }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    std::size_t erase(const K& key) {
+        return erase_impl(key);
+    }
+
+    /// Returns the iterator following the erased element.
+    iterator erase(const_iterator it) {
+        leaf_node* l = it.leaf_;
+        const bool last_in_leaf = it.pos_ + 1 == l->count;
+        if (last_in_leaf && !l->next) {
+            erase(Key(l->keys[it.pos_]));
+            return end();
+        }
+        // Rebalancing may move the successor to another node: find it again.
+        Key next = last_in_leaf ? l->next->keys[0] : l->keys[it.pos_ + 1];
+        erase(Key(l->keys[it.pos_]));
+        return find(next);
+    }
+
+    iterator erase(iterator it) { return erase(const_iterator(it)); }
+
+    void clear() noexcept {
+        if (root_) destroy(root_, height_);
+        root_ = nullptr;
+        first_ = last_ = nullptr;
+        size_ = height_ = leaves_ = inners_ = 0;
+    }
+
+private:
+    using path_type = std::array<std::pair<inner_node*, std::size_t>, detail::btree::max_height>;
+
+    iterator to_mutable(const_iterator it) noexcept { return {this, it.leaf_, it.pos_}; }
+
+    template <typename K>
+    leaf_node* find_leaf(const K& key) const {
+        node* n = root_;
+        if (!n) return nullptr;
+        for (std::size_t h = height_; h > 0; --h) {
+            auto* in = static_cast<inner_node*>(n);
+            n = in->children[detail::btree::rank<true>(in->keys, in->count, key, comp_)];
+        }
+        return static_cast<leaf_node*>(n);
+    }
+
+    /// `find_leaf` that records each inner node and the child taken.
+    template <typename K>
+    leaf_node* descend(const K& key, path_type& path) const {
+        node* n = root_;
+        if (!n) return nullptr;
+        for (std::size_t h = 0; h < height_; ++h) {
+            auto* in = static_cast<inner_node*>(n);
+            const std::size_t c = detail::btree::rank<true>(in->keys, in->count, key, comp_);
+            path[h] = {in, c};
+            n = in->children[c];
+        }
+        return static_cast<leaf_node*>(n);
+    }
+
+    template <typename K>
+    const_iterator find_impl(const K& key) const {
+        leaf_node* l = find_leaf(key);
+        if (!l) return end();
+        const std::size_t i = detail::btree::rank<false>(l->keys, l->count, key, comp_);
+        return i < l->count && !comp_(key, l->keys[i]) ? const_iterator(this, l, i) : end();
+    }
+
+    template <typename K>
+    std::size_t erase_impl(const K& key) {
+        path_type path;
+        leaf_node* l = descend(key, path);
+        if (!l) return 0;
+        const std::size_t i = detail::btree::rank<false>(l->keys, l->count, key, comp_);
+        if (i == l->count || comp_(key, l->keys[i])) return 0;
+        remove_at(l, i, path);
+        return 1;
+    }
+
+    template <bool Upper, typename K>
+    const_iterator bound(const K& key) const {
+        leaf_node* l = find_leaf(key);
+        if (!l) return end();
+        const std::size_t i = detail::btree::rank<Upper>(l->keys, l->count, key, comp_);
+        if (i < l->count) return {this, l, i};
+        return {this, l->next, 0};  // every key here sorts before `key`
+    }
+
+    template <typename MakeValue>
+    std::pair<iterator, bool> insert_impl(const Key& key, MakeValue&& make_value, bool assign) {
+        path_type path;
+        leaf_node* l = descend(key, path);
+        const std::size_t i = l ? detail::btree::rank<false>(l->keys, l->count, key, comp_) : 0;
+        if (l && i < l->count && !comp_(key, l->keys[i])) {
+            if (assign) l->values[i] = make_value();
+            return {iterator(this, l, i), false};
+        }
+
+        // Copy the key, build the value and allocate every node a split will
+        // need before touching the tree, so a throwing constructor or a failed
+        // allocation leaves it as it was.
+        Key k = key;
+        T value = make_value();
+        const bool splits = l && l->count + 1 == leaf_capacity;
+        spare_nodes spare;
+        Key sep;
+        if (splits) {
+            spare.leaf = std::make_unique<leaf_node>();
+            std::size_t depth = height_;
+            while (depth > 0 && path[depth - 1].first->count + 1 == inner_capacity) {
+                spare.inners[spare.inner_count++] = std::make_unique<inner_node>();
+                --depth;
+            }
+            if (depth == 0) spare.inners[spare.inner_count++] = std::make_unique<inner_node>();  // new root
+            // The right half's first key once `k` is in place.
+            constexpr std::size_t keep = leaf_capacity / 2;
+            sep = i == keep ? k : l->keys[i < keep ? keep - 1 : keep];
+        }
+        if (!l) {
+            l = new leaf_node();
+            ++leaves_;
+            root_ = first_ = last_ = l;
+        }
+        std::move_backward(l->keys + i, l->keys + l->count, l->keys + l->count + 1);
+        std::move_backward(l->values + i, l->values + l->count, l->values + l->count + 1);
+        l->keys[i] = std::move(k);
+        l->values[i] = std::move(value);
+        ++l->count;
+        ++size_;
+        if (!splits) return {iterator(this, l, i), true};
+
+        leaf_node* r = split_leaf(l, spare.leaf.release());
+        insert_separator(path, height_, std::move(sep), r, spare);
+        if (i < l->count) return {iterator(this, l, i), true};
+        return {iterator(this, r, i - l->count), true};
+    }
+
+    /// Nodes allocated up front for one insert's splits.
+    struct spare_nodes {
+        std::unique_ptr<leaf_node> leaf;
+        std::array<std::unique_ptr<inner_node>, detail::btree::max_height + 1> inners;
+        std::size_t inner_count = 0;
+
+        inner_node* take_inner() noexcept { return inners[--inner_count].release(); }
+    };
+
+    /// Moves the upper half of full leaf `l` into the empty leaf `r`.
+    leaf_node* split_leaf(leaf_node* l, leaf_node* r) {
+        ++leaves_;
+        const std::size_t keep = leaf_capacity / 2;
+        std::move(l->keys + keep, l->keys + l->count, r->keys);
+        std::move(l->values + keep, l->values + l->count, r->values);
+        r->count = static_cast<std::uint32_t>(l->count - keep);
+        l->count = static_cast<std::uint32_t>(keep);
+        r->prev = l;
+        r->next = l->next;
+        (l->next ? l->next->prev : last_) = r;
+        l->next = r;
+        return r;
+    }
+
+    /// Adds `right`, whose smallest key is `sep`, after the child taken at
+    /// depth `depth - 1`, splitting full inner nodes up to the root with
+    /// nodes from `spare`.
+    void insert_separator(path_type& path, std::size_t depth, Key sep, node* right, spare_nodes& spare) {
+        while (depth > 0) {
+            auto [p, c] = path[--depth];
+            std::move_backward(p->keys + c, p->keys + p->count, p->keys + p->count + 1);
+            std::move_backward(p->children + c + 1, p->children + p->count + 1, p->children + p->count + 2);
+            p->keys[c] = std::move(sep);
+            p->children[c + 1] = right;
+            if (++p->count < inner_capacity) return;
+
+            inner_node* q = spare.take_inner();
+            ++inners_;
+            const std::size_t mid = inner_capacity / 2;
+            sep = std::move(p->keys[mid]);
+            std::move(p->keys + mid + 1, p->keys + p->count, q->keys);
+            std::copy(p->children + mid + 1, p->children + p->count + 1, q->children);
+            q->count = static_cast<std::uint32_t>(p->count - mid - 1);
+            p->count = static_cast<std::uint32_t>(mid);
+            right = q;
+        }
+        inner_node* root = spare.take_inner();
+        ++inners_;
+        root->keys[0] = std::move(sep);
+        root->children[0] = root_;
+        root->children[1] = right;
+        root->count = 1;
+        root_ = root;
+        ++height_;
+    }
+
+    void remove_at(leaf_node* l, std::size_t i, path_type& path) {
+        std::move(l->keys + i + 1, l->keys + l->count, l->keys + i);
+        std::move(l->values + i + 1, l->values + l->count, l->values + i);
+        --l->count;
+        l->keys[l->count] = Key();
+        l->values[l->count] = T();  // release what the value held
+        --size_;
+
+        if (height_ == 0) {
+            if (l->count == 0) clear();
+            return;
+        }
+        if (l->count >= leaf_min) return;
+
+        auto [p, c] = path[height_ - 1];
+        auto* left = c > 0 ? static_cast<leaf_node*>(p->children[c - 1]) : nullptr;
+        auto* right = c < p->count ? static_cast<leaf_node*>(p->children[c + 1]) : nullptr;
+        if (left && left->count > leaf_min) {
+            std::move_backward(l->keys, l->keys + l->count, l->keys + l->count + 1);
+            std::move_backward(l->values, l->values + l->count, l->values + l->count + 1);
+            l->keys[0] = std::move(left->keys[left->count - 1]);
+            l->values[0] = std::move(left->values[left->count - 1]);
+            --left->count;
+            ++l->count;
+            p->keys[c - 1] = l->keys[0];
+            return;
+        }
+        if (right && right->count > leaf_min) {
+            l->keys[l->count] = std::move(right->keys[0]);
+            l->values[l->count] = std::move(right->values[0]);
+            ++l->count;
+            std::move(right->keys + 1, right->keys + right->count, right->keys);
+            std::move(right->values + 1, right->values + right->count, right->values);
+            --right->count;
+            p->keys[c] = right->keys[0];
+            return;
+        }
+        if (left) {
+            merge_leaves(left, l);
+            remove_separator(p, c - 1);
+        } else {
+            merge_leaves(l, right);
+            remove_separator(p, c);
+        }
+        rebalance_inner(path, height_ - 1);
+    }
+
+    /// Appends `r` to `l` and frees it.
+    void merge_leaves(leaf_node* l, leaf_node* r) {
+        std::move(r->keys, r->keys + r->count, l->keys + l->count);
+        std::move(r->values, r->values + r->count, l->values + l->count);
+        l->count += r->count;
+        l->next = r->next;
+        (r->next ? r->next->prev : last_) = l;
+        delete r;
+        --leaves_;
+    }
+
+    /// Drops `keys[k]` and `children[k + 1]`.
+    static void remove_separator(inner_node* p, std::size_t k) {
+        std::move(p->keys + k + 1, p->keys + p->count, p->keys + k);
+        std::copy(p->children + k + 2, p->children + p->count + 1, p->children + k + 1);
+        --p->count;
+        p->keys[p->count] = Key();
+    }
+
+    /// Restores the minimum fill of `path[depth].first` after it lost a child.
+    void rebalance_inner(path_type& path, std::size_t depth) {
+        for (;;) {
+            inner_node* n = path[depth].first;
+            if (depth == 0) {
+                if (n->count == 0) {
+                    root_ = n->children[0];
+                    delete n;
+                    --inners_;
+                    --height_;
+                }
+                return;
+            }
+            if (n->count >= inner_min) return;
+
+            auto [p, c] = path[depth - 1];
+            auto* left = c > 0 ? static_cast<inner_node*>(p->children[c - 1]) : nullptr;
+            auto* right = c < p->count ? static_cast<inner_node*>(p->children[c + 1]) : nullptr;
+            if (left && left->count > inner_min) {
+                std::move_backward(n->keys, n->keys + n->count, n->keys + n->count + 1);
+                std::copy_backward(n->children, n->children + n->count + 1, n->children + n->count + 2);
+                n->keys[0] = std::move(p->keys[c - 1]);
+                n->children[0] = left->children[left->count];
+                p->keys[c - 1] = std::move(left->keys[left->count - 1]);
+                --left->count;
+                ++n->count;
+                return;
+            }
+            if (right && right->count > inner_min) {
+                n->keys[n->count] = std::move(p->keys[c]);
+                n->children[n->count + 1] = right->children[0];
+                ++n->count;
+                p->keys[c] = std::move(right->keys[0]);
+                std::move(right->keys + 1, right->keys + right->count, right->keys);
+                std::copy(right->children + 1, right->children + right->count + 1, right->children);
+                --right->count;
+                return;
+            }
+            if (left) {
+                merge_inner(left, std::move(p->keys[c - 1]), n);
+                remove_separator(p, c - 1);
+            } else {
+                merge_inner(n, std::move(p->keys[c]), right);
+                remove_separator(p, c);
+            }
+            --depth;
+        }
+    }
+
+    void merge_inner(inner_node* l, Key sep, inner_node* r) {
+        l->keys[l->count] = std::move(sep);
+        std::move(r->keys, r->keys + r->count, l->keys + l->count + 1);
+        std::copy(r->children, r->children + r->count + 1, l->children + l->count + 1);
+        l->count += r->count + 1;
+        delete r;
+        --inners_;
+    }
+
+    /// Builds the tree bottom-up from sorted, unique entries: leaves filled
+    /// to capacity - 1 and spread evenly, then each inner level over the
+    /// one below.
+    void bulk_load(std::vector<Key>& keys, std::vector<T>& values) {
+        const std::size_t n = keys.size();
+        if (n == 0) return;
+        std::vector<node*> level;
+        std::vector<const Key*> low;  // smallest key under each node of `level`
+
+        const std::size_t leaf_count = (n + leaf_capacity - 2) / (leaf_capacity - 1);
+        level.reserve(leaf_count);
+        low.reserve(leaf_count);
+        leaf_node* prev = nullptr;
+        for (std::size_t j = 0, at = 0; j < leaf_count; ++j) {
+            const std::size_t take = n / leaf_count + (j < n % leaf_count);
+            auto* l = new leaf_node();
+            ++leaves_;
+            std::move(keys.begin() + static_cast<std::ptrdiff_t>(at),
+                      keys.begin() + static_cast<std::ptrdiff_t>(at + take), l->keys);
+            std::move(values.begin() + static_cast<std::ptrdiff_t>(at),
+                      values.begin() + static_cast<std::ptrdiff_t>(at + take), l->values);
+            l->count = static_cast<std::uint32_t>(take);
+            l->prev = prev;
+            (prev ? prev->next : first_) = l;
+            prev = l;
+            level.push_back(l);
+            low.push_back(&l->keys[0]);
+            at += take;
+        }
+        last_ = prev;
+        size_ = n;
+
+        while (level.size() > 1) {
+            const std::size_t m = level.size();
+            const std::size_t groups = (m + inner_capacity - 1) / inner_capacity;
+            std::vector<node*> up;
+            std::vector<const Key*> up_low;
+            up.reserve(groups);
+            up_low.reserve(groups);
+            for (std::size_t g = 0, at = 0; g < groups; ++g) {
+                const std::size_t take = m / groups + (g < m % groups);
+                auto* in = new inner_node();
+                ++inners_;
+                for (std::size_t c = 0; c < take; ++c) {
+                    in->children[c] = level[at + c];
+                    if (c > 0) in->keys[c - 1] = *low[at + c];
+                }
+                in->count = static_cast<std::uint32_t>(take - 1);
+                up.push_back(in);
+                up_low.push_back(low[at]);
+                at += take;
+            }
+            level = std::move(up);
+            low = std::move(up_low);
+            ++height_;
+        }
+        root_ = level[0];
+    }
+
+    static void destroy(node* n, std::size_t height) noexcept {
+        if (height == 0) {
+            delete static_cast<leaf_node*>(n);
+            return;
+        }
+        auto* in = static_cast<inner_node*>(n);
+        for (std::size_t c = 0; c <= in->count; ++c) destroy(in->children[c], height - 1);
+        delete in;
+    }
+
+    node* root_ = nullptr;
+    leaf_node* first_ = nullptr;
+    leaf_node* last_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t height_ = 0;
+    std::size_t leaves_ = 0;
+    std::size_t inners_ = 0;
+    [[no_unique_address]] Compare comp_;
+};
+
+}  // namespace mo
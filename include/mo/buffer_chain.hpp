@@ -0,0 +1,346 @@
+#pragma once
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mo {
+
+namespace detail {
+
+/// Reference-counted storage shared by every segment that points into it.
+struct buffer_block {
+    std::atomic<std::uint32_t> refs{1};
+    void (*destroy)(buffer_block*) noexcept;
+    std::byte* base;
+    std::size_t capacity;
+
+    void retain() noexcept { refs.fetch_add(1, std::memory_order_relaxed); }
+    void release() noexcept {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) destroy(this);
+    }
+    bool unique() const noexcept { return refs.load(std::memory_order_acquire) == 1; }
+    std::byte* end() const noexcept { return base + capacity; }
+};
+
+/// Header and payload in one allocation.
+inline buffer_block* allocate_block(std::size_t capacity) {
+    void* raw = ::operator new(sizeof(buffer_block) + capacity);
+    auto* block = new (raw) buffer_block{};
+    block->destroy = [](buffer_block* b) noexcept {
+        b->~buffer_block();
+        ::operator delete(b);
+    };
+    block->base = reinterpret_cast<std::byte*>(block + 1);
+    block->capacity = capacity;
+    return block;
+}
+
+struct string_block : buffer_block {
+    std::string str;
+};
+
+}  // namespace detail
+
+/// Chain of reference-counted byte segments for assembling messages without
+/// copying.
+///
+/// Payloads built with spare headroom can have protocol headers `prepend`ed
+/// in place; chains are spliced with `append(buffer_chain&&)`, cut with
+/// `split`, and handed to `writev`/`sendmsg` through `fill_iovecs`. Copying a
+/// chain (`clone`) shares the underlying storage. Segments are only written
+/// in place while their storage has a single owner, so shared data is never
+/// modified. Storage refcounts are atomic; a single chain is not thread-safe.
+class buffer_chain {
+public:
+    struct segment {
+        detail::buffer_block* block;  // null for unowned (`wrap`) data
+        std::byte* data;
+        std::size_t size;
+
+        std::span<const std::byte> bytes() const noexcept { return {data, size}; }
+    };
+
+    static constexpr std::size_t default_block_size = 4096;
+
+    buffer_chain() noexcept = default;
+
+    /// Empty chain whose first block has `capacity` bytes of tail room after
+    /// `headroom` bytes reserved for later `prepend`s.
+    static buffer_chain create(std::size_t capacity, std::size_t headroom = 0) {
+        buffer_chain chain;
+        detail::buffer_block* block = detail::allocate_block(headroom + capacity);
+        chain.segments_.push_back({block, block->base + headroom, 0});
+        return chain;
+    }
+
+    /// Copies `bytes` into a new chain.
+    static buffer_chain copy_of(std::span<const std::byte> bytes, std::size_t headroom = 0) {
+        buffer_chain chain = create(bytes.size(), headroom);
+        chain.append(bytes);
+        return chain;
+    }
+
+    /// Takes ownership of a string's buffer without copying it.
+    static buffer_chain from_string(std::string&& str) {
+        buffer_chain chain;
+        auto* block = new detail::string_block{};
+        block->destroy = [](detail::buffer_block* b) noexcept { delete static_cast<detail::string_block*>(b); };
+        block->str = std::move(str);
+        block->base = reinterpret_cast<std::byte*>(block->str.data());
+        block->capacity = block->str.size();
+        if (block->capacity == 0) {
+            block->release();
+            return chain;
+        }
+        chain.segments_.push_back({block, block->base, block->capacity});
+        chain.size_ = block->capacity;
+        return chain;
+    }
+
+    /// References caller-owned memory, which must outlive every chain that
+    /// ends up sharing it. Never written through.
+    static buffer_chain wrap(std::span<const std::byte> bytes) {
+        buffer_chain chain;
+        if (!bytes.empty()) chain.segments_.push_back({nullptr, const_cast<std::byte*>(bytes.data()), bytes.size()});
+        chain.size_ = bytes.size();
+        return chain;
+    }
+
+    buffer_chain(buffer_chain&& other) noexcept : segments_(std::move(other.segments_)), size_(other.size_) {
+        other.segments_.clear();
+        other.size_ = 0;
+    }
+    buffer_chain& operator=(buffer_chain&& other) noexcept {
+        if (this != &other) {
+            clear();
+            segments_ = std::move(other.segments_);
+            size_ = std::exchange(other.size_, 0);
+            other.segments_.clear();
+        }
+        return *this;
+    }
+    buffer_chain(const buffer_chain&) = delete;
+    buffer_chain& operator=(const buffer_chain&) = delete;
+    ~buffer_chain() { clear(); }
+
+    /// Shallow copy sharing the same storage.
+    buffer_chain clone() const {
+        buffer_chain copy;
+        copy.segments_ = segments_;
+        copy.size_ = size_;
+        for (const segment& s : segments_)
+            if (s.block) s.block->retain();
+        return copy;
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::size_t segment_count() const noexcept { return segments_.size(); }
+    std::span<const segment> segments() const noexcept { return segments_; }
+
+    void clear() noexcept {
+        for (const segment& s : segments_)
+            if (s.block) s.block->release();
+        segments_.clear();
+        size_ = 0;
+    }
+
+    /// Bytes that can be prepended in place.
+    std::size_t headroom() const noexcept {
+        if (segments_.empty()) return 0;
+        const segment& s = segments_.front();
+        return writable(s) ? static_cast<std::size_t>(s.data - s.block->base) : 0;
+    }
+
+    /// Bytes that can be appended in place.
+    std::size_t tailroom() const noexcept {
+        if (segments_.empty()) return 0;
+        const segment& s = segments_.back();
+        return writable(s) ? static_cast<std::size_t>(s.block->end() - (s.data + s.size)) : 0;
+    }
+
+    /// Copies `bytes` in front of the chain, into headroom when available.
+    void prepend(std::span<const std::byte> bytes) {
+        if (bytes.empty()) return;
+        if (headroom() < bytes.size()) {
+            detail::buffer_block* block = detail::allocate_block(std::max(bytes.size(), std::size_t{64}));
+            segments_.insert(segments_.begin(), {block, block->end(), 0});
+        }
+        segment& s = segments_.front();
+        s.data -= bytes.size();
+        s.size += bytes.size();
+        std::memcpy(s.data, bytes.data(), bytes.size());
+        size_ += bytes.size();
+    }
+
+    /// Copies `bytes` onto the end of the chain, filling tailroom first.
+    void append(std::span<const std::byte> bytes) {
+        while (!bytes.empty()) {
+            std::span<std::byte> room = writable_tail(bytes.size());
+            const std::size_t n = std::min(room.size(), bytes.size());
+            std::memcpy(room.data(), bytes.data(), n);
+            commit(n);
+            bytes = bytes.subspan(n);
+        }
+    }
+
+    /// Splices `other`'s segments onto the end of this chain without copying.
+    void append(buffer_chain&& other) {
+        if (segments_.empty()) {
+            *this = std::move(other);
+            return;
+        }
+        // Drop an empty trailing segment (e.g. from `create`) so it does not
+        // end up as a zero-length iovec in the middle of the chain.
+        if (segments_.back().size == 0) {
+            if (segments_.back().block) segments_.back().block->release();
+            segments_.pop_back();
+        }
+        segments_.insert(segments_.end(), other.segments_.begin(), other.segments_.end());
+        size_ += other.size_;
+        other.segments_.clear();
+        other.size_ = 0;
+    }
+
+    /// Contiguous space for writing at least one byte at the end of the chain,
+    /// e.g. as a `recv` target. Allocates a block of `max(hint, default_block_size)`
+    /// when there is no tailroom. Follow with `commit`.
+    std::span<std::byte> writable_tail(std::size_t hint = default_block_size) {
+        if (tailroom() == 0) {
+            detail::buffer_block* block = detail::allocate_block(std::max(hint, default_block_size));
+            if (!segments_.empty() && segments_.back().size == 0) {
+                if (segments_.back().block) segments_.back().block->release();
+                segments_.back() = {block, block->base, 0};
+            } else {
+                segments_.push_back({block, block->base, 0});
+            }
+        }
+        segment& s = segments_.back();
+        return {s.data + s.size, static_cast<std::size_t>(s.block->end() - (s.data + s.size))};
+    }
+
+    /// Marks `n` bytes written into `writable_tail()` as part of the chain.
+    void commit(std::size_t n) noexcept {
+        segments_.back().size += n;
+        size_ += n;
+    }
+
+    /// Removes `n` bytes from the front, e.g. after a partial `writev`.
+    void trim_front(std::size_t n) noexcept {
+        n = std::min(n, size_);
+        size_ -= n;
+        auto it = segments_.begin();
+        while (n > 0 && n >= it->size) {
+            n -= it->size;
+            if (it->block) it->block->release();
+            ++it;
+        }
+        segments_.erase(segments_.begin(), it);
+        if (n > 0) {
+            segments_.front().data += n;
+            segments_.front().size -= n;
+        }
+    }
+
+    /// Removes `n` bytes from the back.
+    void trim_back(std::size_t n) noexcept {
+        n = std::min(n, size_);
+        size_ -= n;
+        while (n > 0 && n >= segments_.back().size) {
+            n -= segments_.back().size;
+            if (segments_.back().block) segments_.back().block->release();
+            segments_.pop_back();
+        }
+        if (n > 0) segments_.back().size -= n;
+    }
+
+    /// Detaches and returns the first `n` bytes. A segment straddling the cut
+    /// is shared between both chains rather than copied.
+    buffer_chain split(std::size_t n) {
+        n = std::min(n, size_);
+        buffer_chain head;
+        std::size_t taken = 0;
+        auto it = segments_.begin();
+        while (taken < n && taken + it->size <= n) {
+            taken += it->size;
+            ++it;
+        }
+        head.segments_.assign(segments_.begin(), it);
+        segments_.erase(segments_.begin(), it);
+        if (taken < n) {
+            segment& s = segments_.front();
+            const std::size_t cut = n - taken;
+            if (s.block) s.block->retain();
+            head.segments_.push_back({s.block, s.data, cut});
+            s.data += cut;
+            s.size -= cut;
+        }
+        head.size_ = n;
+        size_ -= n;
+        return head;
+    }
+
+    /// Returns the contents as one contiguous span, copying into a single new
+    /// block only when the chain currently spans several segments.
+    std::span<const std::byte> coalesce() {
+        if (segments_.size() > 1) {
+            const std::size_t room = headroom();
+            detail::buffer_block* block = detail::allocate_block(room + size_);
+            std::byte* out = block->base + room;
+            for (const segment& s : segments_) {
+                std::memcpy(out, s.data, s.size);
+                out += s.size;
+            }
+            const std::size_t total = size_;
+            clear();
+            segments_.push_back({block, block->base + room, total});
+            size_ = total;
+        }
+        if (segments_.empty()) return {};
+        return segments_.front().bytes();
+    }
+
+    /// Copies up to `out.size()` bytes from the front into `out`; returns the count.
+    std::size_t copy_to(std::span<std::byte> out) const noexcept {
+        std::size_t copied = 0;
+        for (const segment& s : segments_) {
+            if (copied == out.size()) break;
+            const std::size_t n = std::min(s.size, out.size() - copied);
+            std::memcpy(out.data() + copied, s.data, n);
+            copied += n;
+        }
+        return copied;
+    }
+
+    /// Fills `out` with the non-empty segments in order for `writev`/`sendmsg`
+    /// and returns how many entries were used. When the chain has more
+    /// segments than `out` holds, write, `trim_front` what was sent and call
+    /// again.
+    std::size_t fill_iovecs(std::span<iovec> out) const noexcept {
+        std::size_t used = 0;
+        for (const segment& s : segments_) {
+            if (used == out.size()) break;
+            if (s.size == 0) continue;
+            out[used++] = iovec{s.data, s.size};
+        }
+        return used;
+    }
+
+private:
+    static bool writable(const segment& s) noexcept { return s.block && s.block->unique(); }
+
+    std::vector<segment> segments_;
+    std::size_t size_ = 0;
+};
+
+}  // namespace mo
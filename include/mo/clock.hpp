@@ -0,0 +1,285 @@
+#pragma once
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "mo/cpu_features.hpp"
+
+namespace mo {
+
+/// `CLOCK_MONOTONIC_COARSE`: the timestamp of the last kernel tick, read
+/// from the vDSO without touching the TSC. Resolution is the tick (1-4 ms),
+/// which is plenty for timeouts and rate limits. Same epoch as
+/// `std::chrono::steady_clock` on Linux.
+struct coarse_clock {
+    using rep = std::int64_t;
+    using period = std::nano;
+    using duration = std::chrono::nanoseconds;
+    using time_point = std::chrono::time_point<coarse_clock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept {
+        timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return time_point(duration(std::int64_t{ts.tv_sec} * 1'000'000'000 + ts.tv_nsec));
+    }
+
+    static duration resolution() noexcept {
+        timespec ts;
+        ::clock_getres(CLOCK_MONOTONIC_COARSE, &ts);
+        return duration(std::int64_t{ts.tv_sec} * 1'000'000'000 + ts.tv_nsec);
+    }
+};
+
+namespace detail::clock {
+
+inline std::int64_t monotonic_ns() noexcept {
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return std::int64_t{ts.tv_sec} * 1'000'000'000 + ts.tv_nsec;
+}
+
+inline std::uint64_t rdtsc() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(monotonic_ns());
+#endif
+}
+
+/// Tightest of `tries` TSC reads bracketing a CLOCK_MONOTONIC read, so a
+/// preemption between the reads cannot skew the pair.
+inline void sample(std::uint64_t& ticks, std::int64_t& ns, int tries = 16) noexcept {
+    std::uint64_t best = ~std::uint64_t{0};
+    for (int i = 0; i < tries; ++i) {
+        const std::uint64_t t0 = rdtsc();
+        const std::int64_t n = monotonic_ns();
+        const std::uint64_t t1 = rdtsc();
+        if (t1 - t0 < best) best = t1 - t0, ticks = t0 + (t1 - t0) / 2, ns = n;
+    }
+}
+
+__extension__ typedef unsigned __int128 wide;
+
+/// TSC-to-nanosecond mapping, measured against CLOCK_MONOTONIC and
+/// re-anchored to it every `resync_ns` so the TSC's frequency error cannot
+/// accumulate.
+///
+/// The mapping is `base_ns + (ticks - base_ticks) * slope`. A resync
+/// samples the monotonic clock and continues from where the mapping
+/// stands: if it is behind, it steps forward; if it is ahead, the slope is
+/// lowered (by at most 0.1%) so it converges over the next period instead
+/// of going back. Readers take the anchor under a seqlock.
+class tsc_calibration {
+public:
+    static constexpr std::int64_t resync_ns = 1'000'000'000;
+
+    tsc_calibration() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        if (!cpu().invariant_tsc) return;
+        std::uint64_t t0 = 0, t1 = 0;
+        std::int64_t n0 = 0, n1 = 0;
+        sample(t0, n0);
+        while (monotonic_ns() - n0 < 20'000'000) {
+        }
+        sample(t1, n1);
+        if (t1 <= t0) return;
+        const auto rate = static_cast<std::uint64_t>((wide(n1 - n0) << 32) / (t1 - t0));
+        if (rate == 0) return;
+        usable_ = true;
+        publish(t1, n1, rate, rate);
+        sync_ticks_ = t1;
+        sync_ns_ = n1;
+#endif
+    }
+
+    tsc_calibration(const tsc_calibration&) = delete;
+    tsc_calibration& operator=(const tsc_calibration&) = delete;
+
+    bool usable() const noexcept { return usable_; }
+
+    /// Measured nanoseconds per tick, 32.32 fixed point.
+    std::uint64_t rate_q32() const noexcept { return rate_q32_.load(std::memory_order_relaxed); }
+
+    std::int64_t now_ns() noexcept {
+        for (;;) {
+            const std::uint32_t seq = seq_.load(std::memory_order_acquire);
+            const std::uint64_t base_ticks = base_ticks_.load(std::memory_order_relaxed);
+            const std::int64_t base_ns = base_ns_.load(std::memory_order_relaxed);
+            const std::uint64_t slope = slope_q32_.load(std::memory_order_relaxed);
+            const std::uint64_t t = rdtsc();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((seq & 1) || seq_.load(std::memory_order_relaxed) != seq) continue;
+            // TSCs of different cores may disagree by a few ticks; never let
+            // the difference wrap below the base.
+            const std::uint64_t delta = t > base_ticks ? t - base_ticks : 0;
+            if (delta > resync_ticks_.load(std::memory_order_relaxed)) [[unlikely]] {
+                if (resync()) continue;
+            }
+            return base_ns + static_cast<std::int64_t>((wide{delta} * slope) >> 32);
+        }
+    }
+
+private:
+    /// Re-anchors the mapping; returns false if another thread is at it.
+    bool resync() noexcept {
+        if (resyncing_.exchange(true, std::memory_order_acquire)) return false;
+        seq_.fetch_add(1, std::memory_order_relaxed);  // odd: readers retry
+        std::atomic_thread_fence(std::memory_order_release);
+        std::uint64_t t = 0;
+        std::int64_t n = 0;
+        sample(t, n, 4);
+        const std::uint64_t base_ticks = base_ticks_.load(std::memory_order_relaxed);
+        const std::uint64_t delta = t > base_ticks ? t - base_ticks : 0;
+        const std::uint64_t old_slope = slope_q32_.load(std::memory_order_relaxed);
+        const std::int64_t mapped =
+            base_ns_.load(std::memory_order_relaxed) + static_cast<std::int64_t>((wide{delta} * old_slope) >> 32);
+        std::uint64_t rate = rate_q32();
+        if (t > sync_ticks_ && n > sync_ns_)
+            rate = static_cast<std::uint64_t>((wide(n - sync_ns_) << 32) / (t - sync_ticks_));
+        std::uint64_t slope = rate;
+        if (mapped > n) {
+            // Ahead: aim to meet the monotonic clock at the next resync.
+            const auto period_ticks = static_cast<std::uint64_t>((wide(resync_ns) << 32) / rate);
+            slope = static_cast<std::uint64_t>((wide(n + resync_ns - mapped) << 32) / period_ticks);
+            slope = std::max(slope, rate - rate / 1000);
+        }
+        publish(t, std::max(mapped, n), slope, rate);
+        sync_ticks_ = t;
+        sync_ns_ = n;
+        seq_.fetch_add(1, std::memory_order_release);
+        resyncing_.store(false, std::memory_order_release);
+        return true;
+    }
+
+    void publish(std::uint64_t ticks, std::int64_t ns, std::uint64_t slope, std::uint64_t rate) noexcept {
+        base_ticks_.store(ticks, std::memory_order_relaxed);
+        base_ns_.store(ns, std::memory_order_relaxed);
+        slope_q32_.store(slope, std::memory_order_relaxed);
+        rate_q32_.store(rate, std::memory_order_relaxed);
+        resync_ticks_.store(static_cast<std::uint64_t>((wide(resync_ns) << 32) / rate), std::memory_order_relaxed);
+    }
+
+    bool usable_ = false;
+    std::atomic<std::uint32_t> seq_{0};
+    std::atomic<std::uint64_t> base_ticks_{0};
+    std::atomic<std::int64_t> base_ns_{0};
+    std::atomic<std::uint64_t> slope_q32_{0};
+    std::atomic<std::uint64_t> rate_q32_{0};
+    std::atomic<std::uint64_t> resync_ticks_{~std::uint64_t{0}};
+    std::atomic<bool> resyncing_{false};
+    std::uint64_t sync_ticks_ = 0;  // last monotonic sample, owned by the resyncing thread
+    std::int64_t sync_ns_ = 0;
+};
+
+inline tsc_calibration& calibration() noexcept {
+    static tsc_calibration c;
+    return c;
+}
+
+}  // namespace detail::clock
+
+/// Clock on the CPU's invariant timestamp counter: `now()` is one `rdtsc`
+/// and a multiply, several times cheaper than `steady_clock::now()` under
+/// virtualization or with the hpet clocksource.
+///
+/// The tick rate is calibrated against CLOCK_MONOTONIC on first use (about
+/// 20 ms; call `calibrate()` at startup to move that off the hot path).
+/// After that, the first `now()` each second re-anchors the clock to
+/// CLOCK_MONOTONIC (a few hundred ns, once), slewing rather than stepping
+/// back, so `now()` stays monotonic and within the TSC's frequency error
+/// over one second (well under 10 us in practice) of `steady_clock`. Without
+/// an invariant TSC, or off x86, it falls back to CLOCK_MONOTONIC;
+/// `precise()` tells which. For intervals measured in cycles, `ticks()` and
+/// `to_duration()` skip the conversion until needed.
+struct tsc_clock {
+    using rep = std::int64_t;
+    using period = std::nano;
+    using duration = std::chrono::nanoseconds;
+    using time_point = std::chrono::time_point<tsc_clock>;
+    static constexpr bool is_steady = true;
+
+    static void calibrate() noexcept { detail::clock::calibration(); }
+    static bool precise() noexcept { return detail::clock::calibration().usable(); }
+
+    static std::uint64_t ticks() noexcept { return detail::clock::rdtsc(); }
+
+    static duration to_duration(std::uint64_t tick_count) noexcept {
+        const auto& c = detail::clock::calibration();
+        if (!c.usable()) return duration(static_cast<rep>(tick_count));
+        return duration(static_cast<rep>((detail::clock::wide{tick_count} * c.rate_q32()) >> 32));
+    }
+
+    /// Ticks in `d`, e.g. to compare against a `ticks()` difference.
+    static std::uint64_t to_ticks(duration d) noexcept {
+        const auto& c = detail::clock::calibration();
+        if (!c.usable()) return static_cast<std::uint64_t>(d.count());
+        return static_cast<std::uint64_t>(static_cast<double>(d.count()) * 4294967296.0 /
+                                          static_cast<double>(c.rate_q32()));
+    }
+
+    static time_point now() noexcept {
+        auto& c = detail::clock::calibration();
+        if (!c.usable()) return time_point(duration(detail::clock::monotonic_ns()));
+        return time_point(duration(c.now_ns()));
+    }
+};
+
+/// A timestamp refreshed by a background thread every `interval`; `now()` is
+/// a single relaxed load, for code that reads the time per request or per
+/// message and tolerates being `interval` behind. Timestamps never go back.
+///
+/// Each instance owns its thread, so share one (e.g. a function-local
+/// static) rather than creating one per component.
+class cached_clock {
+public:
+    using rep = std::int64_t;
+    using period = std::nano;
+    using duration = std::chrono::nanoseconds;
+    using time_point = std::chrono::time_point<cached_clock>;
+    static constexpr bool is_steady = true;
+
+    explicit cached_clock(duration interval = std::chrono::milliseconds(1))
+        : interval_(interval), now_(detail::clock::monotonic_ns()), thread_([this] { run(); }) {}
+
+    ~cached_clock() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    cached_clock(const cached_clock&) = delete;
+    cached_clock& operator=(const cached_clock&) = delete;
+
+    time_point now() const noexcept { return time_point(duration(now_.load(std::memory_order_relaxed))); }
+
+private:
+    void run() {
+        std::unique_lock lock(mutex_);
+        while (!wake_.wait_for(lock, interval_, [this] { return stopping_; }))
+            now_.store(detail::clock::monotonic_ns(), std::memory_order_relaxed);
+    }
+
+    duration interval_;
+    alignas(64) std::atomic<std::int64_t> now_;  // alone on its line: readers never see the mutex traffic
+    alignas(64) std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+}  // namespace mo
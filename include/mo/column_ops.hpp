@@ -0,0 +1,725 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+#include "mo/cpu_features.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MO_COLUMN_HAVE_X86 1
+#endif
+
+namespace mo {
+
+/// Element types the column kernels are instantiated for.
+template <typename T>
+concept column_value = std::same_as<T, std::int32_t> || std::same_as<T, std::int64_t> || std::same_as<T, float> ||
+                       std::same_as<T, double>;
+
+/// Result of `column_sum`: integers are summed in 64 bits (wrapping on
+/// overflow), floating-point values in double precision.
+template <column_value T>
+using column_sum_t = std::conditional_t<std::is_integral_v<T>, std::int64_t, double>;
+
+enum class compare_op { eq, ne, lt, le, gt, ge };
+
+namespace detail::colops {
+
+inline bool valid_at(const std::uint64_t* valid, std::size_t i) noexcept {
+    return (valid[i >> 6] >> (i & 63)) & 1;
+}
+
+template <compare_op Op, typename T>
+constexpr bool compare(T a, T b) noexcept {
+    if constexpr (Op == compare_op::eq) return a == b;
+    else if constexpr (Op == compare_op::ne) return a != b;
+    else if constexpr (Op == compare_op::lt) return a < b;
+    else if constexpr (Op == compare_op::le) return a <= b;
+    else if constexpr (Op == compare_op::gt) return a > b;
+    else return a >= b;
+}
+
+// Integer sums wrap instead of overflowing.
+template <typename S, typename T>
+constexpr S add(S s, T v) noexcept {
+    if constexpr (std::is_integral_v<S>)
+        return static_cast<S>(static_cast<std::uint64_t>(s) + static_cast<std::uint64_t>(static_cast<S>(v)));
+    else
+        return s + v;
+}
+
+template <typename T>
+constexpr T min_identity() noexcept {
+    if constexpr (std::is_floating_point_v<T>) return std::numeric_limits<T>::infinity();
+    else return std::numeric_limits<T>::max();
+}
+
+template <typename T>
+constexpr T max_identity() noexcept {
+    if constexpr (std::is_floating_point_v<T>) return -std::numeric_limits<T>::infinity();
+    else return std::numeric_limits<T>::lowest();
+}
+
+// Kernels shared by every ISA, written against an `O` traits type:
+//
+//   vec load(const T*), set1(T), select(bits, v, fill), vmin(vec, vec), vmax,
+//   void store(T*, vec), template <compare_op> unsigned cmp(vec, vec);
+//   acc acc_zero(), acc_add(acc, vec), void acc_store(column_sum_t<T>*, acc);
+//   lanes, acc_lanes.
+//
+// Each ISA namespace stamps them out under its own target attribute, since
+// GCC will not inline target-specific intrinsics into a generic template.
+// Blocks are 2 * lanes wide (at most 32 rows), so a block's validity bits
+// never straddle two bitmap words. Tails run scalar.
+#define MO_COLUMN_KERNELS(TARGET)                                                                       \
+    template <typename O, bool Max, typename V>                                                         \
+    TARGET V pick(V a, V b) {                                                                           \
+        if constexpr (Max)                                                                              \
+            return O::vmax(a, b);                                                                       \
+        else                                                                                            \
+            return O::vmin(a, b);                                                                       \
+    }                                                                                                   \
+                                                                                                        \
+    template <typename O, typename T>                                                                   \
+    TARGET column_sum_t<T> sum(const T* p, std::size_t n, const std::uint64_t* valid) {                 \
+        constexpr std::size_t L = O::lanes;                                                             \
+        auto a0 = O::acc_zero(), a1 = O::acc_zero();                                                    \
+        std::size_t i = 0;                                                                              \
+        if (!valid) {                                                                                   \
+            for (; i + 2 * L <= n; i += 2 * L) {                                                        \
+                a0 = O::acc_add(a0, O::load(p + i));                                                    \
+                a1 = O::acc_add(a1, O::load(p + i + L));                                                \
+            }                                                                                           \
+        } else {                                                                                        \
+            const auto zero = O::set1(T{});                                                             \
+            for (; i + 2 * L <= n; i += 2 * L) {                                                        \
+                const auto bits = static_cast<unsigned>(valid[i >> 6] >> (i & 63));                     \
+                a0 = O::acc_add(a0, O::select(bits, O::load(p + i), zero));                             \
+                a1 = O::acc_add(a1, O::select(bits >> L, O::load(p + i + L), zero));                    \
+            }                                                                                           \
+        }                                                                                               \
+        column_sum_t<T> lanes0[O::acc_lanes], lanes1[O::acc_lanes];                                     \
+        O::acc_store(lanes0, a0);                                                                       \
+        O::acc_store(lanes1, a1);                                                                       \
+        column_sum_t<T> s{};                                                                            \
+        for (std::size_t k = 0; k < O::acc_lanes; ++k) s = add(add(s, lanes0[k]), lanes1[k]);           \
+        for (; i < n; ++i)                                                                              \
+            if (!valid || valid_at(valid, i)) s = add(s, p[i]);                                         \
+        return s;                                                                                       \
+    }                                                                                                   \
+                                                                                                        \
+    template <typename O, bool Max, typename T>                                                         \
+    TARGET T extreme(const T* p, std::size_t n, const std::uint64_t* valid) {                           \
+        constexpr std::size_t L = O::lanes;                                                             \
+        const T identity = Max ? max_identity<T>() : min_identity<T>();                                 \
+        const auto fill = O::set1(identity);                                                            \
+        auto m0 = fill, m1 = fill;                                                                      \
+        std::size_t i = 0;                                                                              \
+        if (!valid) {                                                                                   \
+            for (; i + 2 * L <= n; i += 2 * L) {                                                        \
+                m0 = pick<O, Max>(m0, O::load(p + i));                                                  \
+                m1 = pick<O, Max>(m1, O::load(p + i + L));                                              \
+            }                                                                                           \
+        } else {                                                                                        \
+            for (; i + 2 * L <= n; i += 2 * L) {                                                        \
+                const auto bits = static_cast<unsigned>(valid[i >> 6] >> (i & 63));                     \
+                m0 = pick<O, Max>(m0, O::select(bits, O::load(p + i), fill));                           \
+                m1 = pick<O, Max>(m1, O::select(bits >> L, O::load(p + i + L), fill));                  \
+            }                                                                                           \
+        }                                                                                               \
+        T lanes[L];                                                                                     \
+        O::store(lanes, pick<O, Max>(m0, m1));                                                          \
+        T r = identity;                                                                                 \
+        for (T v : lanes) r = Max ? std::max(r, v) : std::min(r, v);                                    \
+        for (; i < n; ++i)                                                                              \
+            if (!valid || valid_at(valid, i)) r = Max ? std::max(r, p[i]) : std::min(r, p[i]);          \
+        return r;                                                                                       \
+    }                                                                                                   \
+                                                                                                        \
+    template <typename O, compare_op Op, typename T>                                                    \
+    TARGET void filter(const T* p, std::size_t n, T x, std::uint64_t* out) {                            \
+        constexpr std::size_t L = O::lanes;                                                             \
+        const auto xv = O::set1(x);                                                                     \
+        std::size_t w = 0;                                                                              \
+        for (; (w + 1) * 64 <= n; ++w) {                                                                \
+            std::uint64_t bits = 0;                                                                     \
+            for (std::size_t k = 0; k < 64; k += L)                                                     \
+                bits |= std::uint64_t{O::template cmp<Op>(O::load(p + w * 64 + k), xv)} << k;           \
+            out[w] = bits;                                                                              \
+        }                                                                                               \
+        if (w * 64 < n) {                                                                               \
+            std::uint64_t bits = 0;                                                                     \
+            for (std::size_t i = w * 64; i < n; ++i)                                                    \
+                bits |= std::uint64_t{compare<Op>(p[i], x)} << (i & 63);                                \
+            out[w] = bits;                                                                              \
+        }                                                                                               \
+    }
+
+namespace scalar {
+
+template <typename T>
+column_sum_t<T> sum(const T* p, std::size_t n, const std::uint64_t* valid) noexcept {
+    column_sum_t<T> s{};
+    for (std::size_t i = 0; i < n; ++i)
+        if (!valid || valid_at(valid, i)) s = add(s, p[i]);
+    return s;
+}
+
+template <bool Max, typename T>
+T extreme(const T* p, std::size_t n, const std::uint64_t* valid) noexcept {
+    T r = Max ? max_identity<T>() : min_identity<T>();
+    for (std::size_t i = 0; i < n; ++i)
+        if (!valid || valid_at(valid, i)) r = Max ? std::max(r, p[i]) : std::min(r, p[i]);
+    return r;
+}
+
+template <compare_op Op, typename T>
+void filter(const T* p, std::size_t n, T x, std::uint64_t* out) noexcept {
+    for (std::size_t w = 0; w * 64 < n; ++w) {
+        std::uint64_t bits = 0;
+        const std::size_t end = std::min(n, w * 64 + 64);
+        for (std::size_t i = w * 64; i < end; ++i) bits |= std::uint64_t{compare<Op>(p[i], x)} << (i & 63);
+        out[w] = bits;
+    }
+}
+
+}  // namespace scalar
+
+#ifdef MO_COLUMN_HAVE_X86
+#define MO_TARGET_AVX2 __attribute__((target("avx2"), always_inline))
+#define MO_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl"), always_inline))
+
+namespace avx2 {
+
+// Lane masks from validity bits: lane k is all ones when bit k is set.
+MO_TARGET_AVX2 inline __m256i expand32(unsigned bits) noexcept {
+    const __m256i sel = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), sel), sel);
+}
+
+MO_TARGET_AVX2 inline __m256i expand64(unsigned bits) noexcept {
+    const __m256i sel = _mm256_setr_epi64x(1, 2, 4, 8);
+    return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(bits), sel), sel);
+}
+
+template <compare_op Op>
+inline constexpr int float_predicate = Op == compare_op::eq   ? _CMP_EQ_OQ
+                                       : Op == compare_op::ne ? _CMP_NEQ_UQ
+                                       : Op == compare_op::lt ? _CMP_LT_OQ
+                                       : Op == compare_op::le ? _CMP_LE_OQ
+                                       : Op == compare_op::gt ? _CMP_GT_OQ
+                                                              : _CMP_GE_OQ;
+
+template <typename T>
+struct ops;
+
+template <>
+struct ops<std::int32_t> {
+    using T = std::int32_t;
+    using vec = __m256i;
+    using acc = __m256i;
+    static constexpr std::size_t lanes = 8, acc_lanes = 4;
+    MO_TARGET_AVX2 static vec load(const T* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const vec*>(p)); }
+    MO_TARGET_AVX2 static void store(T* p, vec v) noexcept { _mm256_storeu_si256(reinterpret_cast<vec*>(p), v); }
+    MO_TARGET_AVX2 static vec set1(T x) noexcept { return _mm256_set1_epi32(x); }
+    MO_TARGET_AVX2 static vec select(unsigned bits, vec v, vec fill) noexcept {
+        return _mm256_blendv_epi8(fill, v, expand32(bits));
+    }
+    MO_TARGET_AVX2 static vec vmin(vec a, vec b) noexcept { return _mm256_min_epi32(a, b); }
+    MO_TARGET_AVX2 static vec vmax(vec a, vec b) noexcept { return _mm256_max_epi32(a, b); }
+    MO_TARGET_AVX2 static acc acc_zero() noexcept { return _mm256_setzero_si256(); }
+    MO_TARGET_AVX2 static acc acc_add(acc a, vec v) noexcept {
+        a = _mm256_add_epi64(a, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        return _mm256_add_epi64(a, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    MO_TARGET_AVX2 static void acc_store(std::int64_t* p, acc a) noexcept {
+        _mm256_storeu_si256(reinterpret_cast<acc*>(p), a);
+    }
+    MO_TARGET_AVX2 static unsigned mask(vec m) noexcept {
+        return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+    }
+    template <compare_op Op>
+    MO_TARGET_AVX2 static unsigned cmp(vec v, vec x) noexcept {
+        // Integer compares are exact, so the negated forms come from eq/gt.
+        if constexpr (Op == compare_op::eq) return mask(_mm256_cmpeq_epi32(v, x));
+        else if constexpr (Op == compare_op::ne) return ~mask(_mm256_cmpeq_epi32(v, x)) & 0xFFu;
+        else if constexpr (Op == compare_op::lt) return mask(_mm256_cmpgt_epi32(x, v));
+        else if constexpr (Op == compare_op::le) return ~mask(_mm256_cmpgt_epi32(v, x)) & 0xFFu;
+        else if constexpr (Op == compare_op::gt) return mask(_mm256_cmpgt_epi32(v, x));
+        else return ~mask(_mm256_cmpgt_epi32(x, v)) & 0xFFu;
+    }
+};
+
+template <>
+struct ops<std::int64_t> {
+    using T = std::int64_t;
+    using vec = __m256i;
+    using acc = __m256i;
+    static constexpr std::size_t lanes = 4, acc_lanes = 4;
+    MO_TARGET_AVX2 static vec load(const T* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const vec*>(p)); }
+    MO_TARGET_AVX2 static void store(T* p, vec v) noexcept { _mm256_storeu_si256(reinterpret_cast<vec*>(p), v); }
+    MO_TARGET_AVX2 static vec set1(T x) noexcept { return _mm256_set1_epi64x(x); }
+    MO_TARGET_AVX2 static vec select(unsigned bits, vec v, vec fill) noexcept {
+        return _mm256_blendv_epi8(fill, v, expand64(bits));
+    }
+    // AVX2 has no 64-bit min/max; blend on a signed compare instead.
+    MO_TARGET_AVX2 static vec vmin(vec a, vec b) noexcept { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+    MO_TARGET_AVX2 static vec vmax(vec a, vec b) noexcept { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+    MO_TARGET_AVX2 static acc acc_zero() noexcept { return _mm256_setzero_si256(); }
+    MO_TARGET_AVX2 static acc acc_add(acc a, vec v) noexcept { return _mm256_add_epi64(a, v); }
+    MO_TARGET_AVX2 static void acc_store(std::int64_t* p, acc a) noexcept {
+        _mm256_storeu_si256(reinterpret_cast<acc*>(p), a);
+    }
+    MO_TARGET_AVX2 static unsigned mask(vec m) noexcept {
+        return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(m)));
+    }
+    template <compare_op Op>
+    MO_TARGET_AVX2 static unsigned cmp(vec v, vec x) noexcept {
+        if constexpr (Op == compare_op::eq) return mask(_mm256_cmpeq_epi64(v, x));
+        else if constexpr (Op == compare_op::ne) return ~mask(_mm256_cmpeq_epi64(v, x)) & 0xFu;
+        else if constexpr (Op == compare_op::lt) return mask(_mm256_cmpgt_epi64(x, v));
+        else if constexpr (Op == compare_op::le) return ~mask(_mm256_cmpgt_epi64(v, x)) & 0xFu;
+        else if constexpr (Op == compare_op::gt) return mask(_mm256_cmpgt_epi64(v, x));
+        else return ~mask(_mm256_cmpgt_epi64(x, v)) & 0xFu;
+    }
+};
+
+template <>
+struct ops<float> {
+    using T = float;
+    using vec = __m256;
+    using acc = __m256d;
+    static constexpr std::size_t lanes = 8, acc_lanes = 4;
+    MO_TARGET_AVX2 static vec load(const T* p) noexcept { return _mm256_loadu_ps(p); }
+    MO_TARGET_AVX2 static void store(T* p, vec v) noexcept { _mm256_storeu_ps(p, v); }
+    MO_TARGET_AVX2 static vec set1(T x) noexcept { return _mm256_set1_ps(x); }
+    MO_TARGET_AVX2 static vec select(unsigned bits, vec v, vec fill) noexcept {
+        return _mm256_blendv_ps(fill, v, _mm256_castsi256_ps(expand32(bits)));
+    }
+    MO_TARGET_AVX2 static vec vmin(vec a, vec b) noexcept { return _mm256_min_ps(a, b); }
+    MO_TARGET_AVX2 static vec vmax(vec a, vec b) noexcept { return _mm256_max_ps(a, b); }
+    MO_TARGET_AVX2 static acc acc_zero() noexcept { return _mm256_setzero_pd(); }
+    MO_TARGET_AVX2 static acc acc_add(acc a, vec v) noexcept {
+        a = _mm256_add_pd(a, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+        return _mm256_add_pd(a, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    }
+    MO_TARGET_AVX2 static void acc_store(double* p, acc a) noexcept { _mm256_storeu_pd(p, a); }
+    template <compare_op Op>
+    MO_TARGET_AVX2 static unsigned cmp(vec v, vec x) noexcept {
+        return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(v, x, float_predicate<Op>)));
+    }
+};
+
+template <>
+struct ops<double> {
+    using T = double;
+    using vec = __m256d;
+    using acc = __m256d;
+    static constexpr std::size_t lanes = 4, acc_lanes = 4;
+    MO_TARGET_AVX2 static vec load(const T* p) noexcept { return _mm256_loadu_pd(p); }
+    MO_TARGET_AVX2 static void store(T* p, vec v) noexcept { _mm256_storeu_pd(p, v); }
+    MO_TARGET_AVX2 static vec set1(T x) noexcept { return _mm256_set1_pd(x); }
+    MO_TARGET_AVX2 static vec select(unsigned bits, vec v, vec fill) noexcept {
+        return _mm256_blendv_pd(fill, v, _mm256_castsi256_pd(expand64(bits)));
+    }
+    MO_TARGET_AVX2 static vec vmin(vec a, vec b) noexcept { return _mm256_min_pd(a, b); }
+    MO_TARGET_AVX2 static vec vmax(vec a, vec b) noexcept { return _mm256_max_pd(a, b); }
+    MO_TARGET_AVX2 static acc acc_zero() noexcept { return _mm256_setzero_pd(); }
+    MO_TARGET_AVX2 static acc acc_add(acc a, vec v) noexcept { return _mm256_add_pd(a, v); }
+    MO_TARGET_AVX2 static void acc_store(double* p, acc a) noexcept { _mm256_storeu_pd(p, a); }
+    template <compare_op Op>
+    MO_TARGET_AVX2 static unsigned cmp(vec v, vec x) noexcept {
+        return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(v, x, float_predicate<Op>)));
+    }
+};
+
+MO_COLUMN_KERNELS(__attribute__((target("avx2"))))
+
+}  // namespace avx2
+
+// GCC 12 reports uninitialised reads inside many AVX-512 intrinsics (their
+// `_mm512_undefined_*` pass-through operands) once they are inlined.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+
+namespace avx512 {
+
+template <compare_op Op>
+inline constexpr int int_predicate = Op == compare_op::eq   ? _MM_CMPINT_EQ
+                                     : Op == compare_op::ne ? _MM_CMPINT_NE
+                                     : Op == compare_op::lt ? _MM_CMPINT_LT
+                                     : Op == compare_op::le ? _MM_CMPINT_LE
+                                     : Op == compare_op::gt ? _MM_CMPINT_NLE
+                                                            : _MM_CMPINT_NLT;
+
+using avx2::float_predicate;
+
+template <typename T>
+struct ops;
+
+template <>
+struct ops<std::int32_t> {
+    using T = std::int32_t;
+    using vec = __m512i;
+    using acc = __m512i;
+    static constexpr std::size_t lanes = 16, acc_lanes = 8;
+    MO_TARGET_AVX512 static vec load(const T* p) noexcept { return _mm512_loadu_si512(p); }
+    MO_TARGET_AVX512 static void store(T* p, vec v) noexcept { _mm512_storeu_si512(p, v); }
+    MO_TARGET_AVX512 static vec set1(T x) noexcept { return _mm512_set1_epi32(x); }
+    MO_TARGET_AVX512 static vec select(unsigned bits, vec v, vec fill) noexcept {
+        return _mm512_mask_blend_epi32(static_cast<__mmask16>(bits), fill, v);
+    }
+    MO_TARGET_AVX512 static vec vmin(vec a, vec b) noexcept { return _mm512_min_epi32(a, b); }
+    MO_TARGET_AVX512 static vec vmax(vec a, vec b) noexcept { return _mm512_max_epi32(a, b); }
+    MO_TARGET_AVX512 static acc acc_zero() noexcept { return _mm512_setzero_si512(); }
+    MO_TARGET_AVX512 static acc acc_add(acc a, vec v) noexcept {
+        // Sign-extend the even and odd 32-bit lanes in place; both halves of
+        // every 64-bit lane are summed, which is all a total needs.
+        a = _mm512_add_epi64(a, _mm512_srai_epi64(_mm512_slli_epi64(v, 32), 32));
+        return _mm512_add_epi64(a, _mm512_srai_epi64(v, 32));
+    }
+    MO_TARGET_AVX512 static void acc_store(std::int64_t* p, acc a) noexcept { _mm512_storeu_si512(p, a); }
+    template <compare_op Op>
+    MO_TARGET_AVX512 static unsigned cmp(vec v, vec x) noexcept {
+        return _mm512_cmp_epi32_mask(v, x, int_predicate<Op>);
+    }
+};
+
+template <>
+struct ops<std::int64_t> {
+    using T = std::int64_t;
+    using vec = __m512i;
+    using acc = __m512i;
+    static constexpr std::size_t lanes = 8, acc_lanes = 8;
+    MO_TARGET_AVX512 static vec load(const T* p) noexcept { return _mm512_loadu_si512(p); }
+    MO_TARGET_AVX512 static void store(T* p, vec v) noexcept { _mm512_storeu_si512(p, v); }
+    MO_TARGET_AVX512 static vec set1(T x) noexcept { return _mm512_set1_epi64(x); }
+    MO_TARGET_AVX512 static vec select(unsigned bits, vec v, vec fill) noexcept {
+        return _mm512_mask_blend_epi64(static_cast<__mmask8>(bits), fill, v);
+    }
+    MO_TARGET_AVX512 static vec vmin(vec a, vec b) noexcept { return _mm512_min_epi64(a, b); }
+    MO_TARGET_AVX512 static vec vmax(vec a, vec b) noexcept { return _mm512_max_epi64(a, b); }
+    MO_TARGET_AVX512 static acc acc_zero() noexcept { return _mm512_setzero_si512(); }
+    MO_TARGET_AVX512 static acc acc_add(acc a, vec v) noexcept { return _mm512_add_epi64(a, v); }
+    MO_TARGET_AVX512 static void acc_store(std::int64_t* p, acc a) noexcept { _mm512_storeu_si512(p, a); }
+    template <compare_op Op>
+    MO_TARGET_AVX512 static unsigned cmp(vec v, vec x) noexcept {
+        return _mm512_cmp_epi64_mask(v, x, int_predicate<Op>);
+    }
+};
+
+template <>
+struct ops<float> {
+    using T = float;
+    using vec = __m512;
+    using acc = __m512d;
+    static constexpr std::size_t lanes = 16, acc_lanes = 8;
+    MO_TARGET_AVX512 static vec load(const T* p) noexcept { return _mm512_loadu_ps(p); }
+    MO_TARGET_AVX512 static void store(T* p, vec v) noexcept { _mm512_storeu_ps(p, v); }
+    MO_TARGET_AVX512 static vec set1(T x) noexcept { return _mm512_set1_ps(x); }
+    MO_TARGET_AVX512 static vec select(unsigned bits, vec v, vec fill) noexcept {
+        return _mm512_mask_blend_ps(static_cast<__mmask16>(bits), fill, v);
+    }
+    MO_TARGET_AVX512 static vec vmin(vec a, vec b) noexcept { return _mm512_min_ps(a, b); }
+    MO_TARGET_AVX512 static vec vmax(vec a, vec b) noexcept { return _mm512_max_ps(a, b); }
+    MO_TARGET_AVX512 static acc acc_zero() noexcept { return _mm512_setzero_pd(); }
+    MO_TARGET_AVX512 static acc acc_add(acc a, vec v) noexcept {
+        // The upper eight floats via a 64-bit lane extract, which needs only AVX-512F.
+        const __m256 hi = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+        a = _mm512_add_pd(a, _mm512_cvtps_pd(_mm512_castps512_ps256(v)));
+        return _mm512_add_pd(a, _mm512_cvtps_pd(hi));
+    }
+    MO_TARGET_AVX512 static void acc_store(double* p, acc a) noexcept { _mm512_storeu_pd(p, a); }
+    template <compare_op Op>
+    MO_TARGET_AVX512 static unsigned cmp(vec v, vec x) noexcept {
+        return _mm512_cmp_ps_mask(v, x, float_predicate<Op>);
+    }
+};
+
+template <>
+struct ops<double> {
+    using T = double;
+    using vec = __m512d;
+    using acc = __m512d;
+    static constexpr std::size_t lanes = 8, acc_lanes = 8;
+    MO_TARGET_AVX512 static vec load(const T* p) noexcept { return _mm512_loadu_pd(p); }
+    MO_TARGET_AVX512 static void store(T* p, vec v) noexcept { _mm512_storeu_pd(p, v); }
+    MO_TARGET_AVX512 static vec set1(T x) noexcept { return _mm512_set1_pd(x); }
+    MO_TARGET_AVX512 static vec select(unsigned bits, vec v, vec fill) noexcept {
+        return _mm512_mask_blend_pd(static_cast<__mmask8>(bits), fill, v);
+    }
+    MO_TARGET_AVX512 static vec vmin(vec a, vec b) noexcept { return _mm512_min_pd(a, b); }
+    MO_TARGET_AVX512 static vec vmax(vec a, vec b) noexcept { return _mm512_max_pd(a, b); }
+    MO_TARGET_AVX512 static acc acc_zero() noexcept { return _mm512_setzero_pd(); }
+    MO_TARGET_AVX512 static acc acc_add(acc a, vec v) noexcept { return _mm512_add_pd(a, v); }
+    MO_TARGET_AVX512 static void acc_store(double* p, acc a) noexcept { _mm512_storeu_pd(p, a); }
+    template <compare_op Op>
+    MO_TARGET_AVX512 static unsigned cmp(vec v, vec x) noexcept {
+        return _mm512_cmp_pd_mask(v, x, float_predicate<Op>);
+    }
+};
+
+MO_COLUMN_KERNELS(__attribute__((target("avx512f,avx512bw,avx512vl"))))
+
+// Writes the positions of set bits with a compressing store, 16 at a time.
+__attribute__((target("avx512f,avx512bw,avx512vl"))) inline std::size_t
+mask_to_selection(const std::uint64_t* mask, std::size_t n, std::uint32_t* out) noexcept {
+    std::size_t k = 0;
+    const __m512i step = _mm512_set1_epi32(16);
+    for (std::size_t w = 0; w * 64 < n; ++w) {
+        std::uint64_t bits = mask[w];
+        if (n - w * 64 < 64) bits &= (std::uint64_t{1} << (n - w * 64)) - 1;
+        __m512i idx = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(w * 64)),
+                                       _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        for (; bits; bits >>= 16, idx = _mm512_add_epi32(idx, step)) {
+            const auto m = static_cast<__mmask16>(bits);
+            _mm512_mask_compressstoreu_epi32(out + k, m, idx);
+            k += static_cast<std::size_t>(std::popcount(static_cast<unsigned>(m)));
+        }
+    }
+    return k;
+}
+
+}  // namespace avx512
+
+#pragma GCC diagnostic pop
+
+#undef MO_TARGET_AVX2
+#undef MO_TARGET_AVX512
+#endif  // MO_COLUMN_HAVE_X86
+
+#undef MO_COLUMN_KERNELS
+
+enum class simd_level { scalar, avx2, avx512 };
+
+inline simd_level best_simd() noexcept {
+    static const simd_level level = [] {
+        const cpu_features& f = cpu();
+        if (f.avx512f && f.avx512bw && f.avx512vl) return simd_level::avx512;
+        if (f.avx2) return simd_level::avx2;
+        return simd_level::scalar;
+    }();
+    return level;
+}
+
+template <typename T>
+column_sum_t<T> sum(const T* p, std::size_t n, const std::uint64_t* valid) noexcept {
+#ifdef MO_COLUMN_HAVE_X86
+    switch (best_simd()) {
+    case simd_level::avx512: return avx512::sum<avx512::ops<T>>(p, n, valid);
+    case simd_level::avx2: return avx2::sum<avx2::ops<T>>(p, n, valid);
+    case simd_level::scalar: break;
+    }
+#endif
+    return scalar::sum(p, n, valid);
+}
+
+template <bool Max, typename T>
+T extreme(const T* p, std::size_t n, const std::uint64_t* valid) noexcept {
+#ifdef MO_COLUMN_HAVE_X86
+    switch (best_simd()) {
+    case simd_level::avx512: return avx512::extreme<avx512::ops<T>, Max>(p, n, valid);
+    case simd_level::avx2: return avx2::extreme<avx2::ops<T>, Max>(p, n, valid);
+    case simd_level::scalar: break;
+    }
+#endif
+    return scalar::extreme<Max>(p, n, valid);
+}
+
+template <compare_op Op, typename T>
+void filter(const T* p, std::size_t n, T x, std::uint64_t* out) noexcept {
+#ifdef MO_COLUMN_HAVE_X86
+    switch (best_simd()) {
+    case simd_level::avx512: return avx512::filter<avx512::ops<T>, Op>(p, n, x, out);
+    case simd_level::avx2: return avx2::filter<avx2::ops<T>, Op>(p, n, x, out);
+    case simd_level::scalar: break;
+    }
+#endif
+    scalar::filter<Op>(p, n, x, out);
+}
+
+inline std::size_t count_bits(const std::uint64_t* bits, std::size_t n) noexcept {
+    std::size_t c = 0;
+    for (std::size_t w = 0; w < n / 64; ++w) c += static_cast<std::size_t>(std::popcount(bits[w]));
+    if (n % 64) c += static_cast<std::size_t>(std::popcount(bits[n / 64] & ((std::uint64_t{1} << (n % 64)) - 1)));
+    return c;
+}
+
+// Selection vectors are gathered into a small buffer and reduced with the
+// dense kernel, which keeps the arithmetic vectorised without hardware
+// gathers.
+inline constexpr std::size_t gather_chunk = 256;
+
+template <typename T, typename Reduce>
+void for_each_gathered(const T* p, std::span<const std::uint32_t> sel, Reduce reduce) {
+    T buf[gather_chunk];
+    for (std::size_t i = 0; i < sel.size(); i += gather_chunk) {
+        const std::size_t m = std::min(gather_chunk, sel.size() - i);
+        for (std::size_t k = 0; k < m; ++k) buf[k] = p[sel[i + k]];
+        reduce(buf, m);
+    }
+}
+
+}  // namespace detail::colops
+
+// Column kernels over contiguous values, dispatched at run time to AVX-512,
+// AVX2 or scalar code (see `cpu_features.hpp`).
+//
+// A validity bitmap marks non-null rows: bit `i % 64` of word `i / 64` is set
+// when row `i` holds a value (the Arrow layout); it must cover every row. A
+// selection vector lists row indices to include. Floating-point sums are
+// reassociated across lanes, so they may differ from a sequential loop in the
+// last bits; min/max of inputs containing NaN are unspecified.
+
+template <typename T>
+    requires column_value<std::remove_const_t<T>>
+auto column_sum(std::span<T> values) noexcept {
+    return detail::colops::sum(values.data(), values.size(), nullptr);
+}
+
+template <typename T>
+    requires column_value<std::remove_const_t<T>>
+auto column_sum(std::span<T> values, std::span<const std::uint64_t> valid) noexcept {
+    return detail::colops::sum(values.data(), values.size(), valid.data());
+}
+
+template <typename T>
+    requires column_value<std::remove_const_t<T>>
+auto column_sum(std::span<T> values, std::span<const std::uint32_t> selection) noexcept {
+    using U = std::remove_const_t<T>;
+    column_sum_t<U> s{};
+    detail::colops::for_each_gathered<U>(values.data(), selection, [&](const U* p, std::size_t n) {
+        s = detail::colops::add(s, detail::colops::sum(p, n, nullptr));
+    });
+    return s;
+}
+
+namespace detail::colops {
+
+template <bool Max, typename T>
+std::optional<T> extreme_of(const T* p, std::size_t n, const std::uint64_t* valid) noexcept {
+    if ((valid ? count_bits(valid, n) : n) == 0) return std::nullopt;
+    return extreme<Max>(p, n, valid);
+}
+
+template <bool Max, typename T>
+std::optional<T> extreme_of(const T* p, std::span<const std::uint32_t> selection) noexcept {
+    if (selection.empty()) return std::nullopt;
+    T r = Max ? max_identity<T>() : min_identity<T>();
+    for_each_gathered<T>(p, selection, [&](const T* chunk, std::size_t n) {
+        const T v = extreme<Max>(chunk, n, nullptr);
+        r = Max ? std::max(r, v) : std::min(r, v);
+    });
+    return r;
+}
+
+}  // namespace detail::colops
+
+/// Smallest value, or nothing when no row is included.
+template <typename T>
+    requires column_value<std::remove_const_t<T>>
+auto column_min(std::span<T> values) noexcept {
+    return detail::colops::extreme_of<false>(values.data(), values.size(), nullptr);
+}
+
+template <typename T>
+    requires column_value<std::remove_const_t<T>>
+auto column_min(std::span<T> values, std::span<const std::uint64_t> valid) noexcept {
+    return detail::colops::extreme_of<false>(values.data(), values.size(), valid.data());
+}
+
+template <typename T>
+    requires column_value<std::remove_const_t<T>>
+auto column_min(std::span<T> values, std::span<const std::uint32_t> selection) noexcept {
+    return detail::colops::extreme_of<false, std::remove_const_t<T>>(values.data(), selection);
+}
+
+/// Largest value, or nothing when no row is included.
+template <typename T>
+    requires column_value<std::remove_const_t<T>>
+auto column_max(std::span<T> values) noexcept {
+    return detail::colops::extreme_of<true>(values.data(), values.size(), nullptr);
+}
+
+template <typename T>
+    requires column_value<std::remove_const_t<T>>
+auto column_max(std::span<T> values, std::span<const std::uint64_t> valid) noexcept {
+    return detail::colops::extreme_of<true>(values.data(), values.size(), valid.data());
+}
+
+template <typename T>
+    requires column_value<std::remove_const_t<T>>
+auto column_max(std::span<T> values, std::span<const std::uint32_t> selection) noexcept {
+    return detail::colops::extreme_of<true, std::remove_const_t<T>>(values.data(), selection);
+}
+
+/// Number of non-null rows among the first `rows`.
+inline std::size_t count_valid(std::span<const std::uint64_t> valid, std::size_t rows) noexcept {
+    return detail::colops::count_bits(valid.data(), rows);
+}
+
+/// Number of selected rows that are non-null.
+inline std::size_t count_valid(std::span<const std::uint64_t> valid,
+                               std::span<const std::uint32_t> selection) noexcept {
+    std::size_t c = 0;
+    for (std::uint32_t i : selection) c += detail::colops::valid_at(valid.data(), i);
+    return c;
+}
+
+/// Sets bit `i` of `out` when `values[i] <op> x` holds. `out` needs
+/// `(values.size() + 63) / 64` words; bits past the last row are cleared.
+template <typename T>
+    requires column_value<std::remove_const_t<T>>
+void filter_mask(std::span<T> values, compare_op op, std::type_identity_t<std::remove_const_t<T>> x,
+                 std::span<std::uint64_t> out) noexcept {
+    const auto* p = values.data();
+    const std::size_t n = values.size();
+    using detail::colops::filter;
+    switch (op) {
+    case compare_op::eq: return filter<compare_op::eq>(p, n, x, out.data());
+    case compare_op::ne: return filter<compare_op::ne>(p, n, x, out.data());
+    case compare_op::lt: return filter<compare_op::lt>(p, n, x, out.data());
+    case compare_op::le: return filter<compare_op::le>(p, n, x, out.data());
+    case compare_op::gt: return filter<compare_op::gt>(p, n, x, out.data());
+    case compare_op::ge: return filter<compare_op::ge>(p, n, x, out.data());
+    }
+}
+
+/// As above, with null rows never matching.
+template <typename T>
+    requires column_value<std::remove_const_t<T>>
+void filter_mask(std::span<T> values, std::span<const std::uint64_t> valid, compare_op op,
+                 std::type_identity_t<std::remove_const_t<T>> x, std::span<std::uint64_t> out) noexcept {
+    filter_mask(values, op, x, out);
+    for (std::size_t w = 0; w * 64 < values.size(); ++w) out[w] &= valid[w];
+}
+
+/// Writes the indices of the set bits among the first `rows` bits of `mask`
+/// to `out`, in ascending order, and returns how many were written. `out`
+/// must have room for every set bit.
+inline std::size_t mask_to_selection(std::span<const std::uint64_t> mask, std::size_t rows,
+                                     std::span<std::uint32_t> out) noexcept {
+#ifdef MO_COLUMN_HAVE_X86
+    if (detail::colops::best_simd() == detail::colops::simd_level::avx512)
+        return detail::colops::avx512::mask_to_selection(mask.data(), rows, out.data());
+#endif
+    std::size_t k = 0;
+    for (std::size_t w = 0; w * 64 < rows; ++w) {
+        std::uint64_t bits = mask[w];
+        if (rows - w * 64 < 64) bits &= (std::uint64_t{1} << (rows - w * 64)) - 1;
+        for (; bits; bits &= bits - 1)
+            out[k++] = static_cast<std::uint32_t>(w * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
+    }
+    return k;
+}
+
+}  // namespace mo
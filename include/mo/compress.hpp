@@ -0,0 +1,639 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace mo {
+
+/// Thrown on corrupt, truncated or unsupported compressed input.
+class compress_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+namespace detail::lz4 {
+
+inline std::uint32_t load32(const char* p) noexcept {
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline std::uint64_t load64(const char* p) noexcept {
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline void store16(char* p, std::uint16_t v) noexcept { std::memcpy(p, &v, 2); }
+inline void store32(char* p, std::uint32_t v) noexcept { std::memcpy(p, &v, 4); }
+
+inline std::uint32_t rotl(std::uint32_t v, int r) noexcept { return std::rotl(v, r); }
+
+inline constexpr std::uint32_t prime1 = 2654435761u;
+inline constexpr std::uint32_t prime2 = 2246822519u;
+inline constexpr std::uint32_t prime3 = 3266489917u;
+inline constexpr std::uint32_t prime4 = 668265263u;
+inline constexpr std::uint32_t prime5 = 374761393u;
+
+inline std::uint32_t xxh_round(std::uint32_t acc, std::uint32_t input) noexcept {
+    return rotl(acc + input * prime2, 13) * prime1;
+}
+
+inline constexpr std::size_t min_match = 4;
+inline constexpr std::size_t last_literals = 5;  // a block always ends with this many literals
+inline constexpr std::size_t mf_limit = 12;      // no match may start in the last 12 bytes
+inline constexpr std::size_t max_distance = 65535;
+inline constexpr std::size_t max_input = 0x7E000000;
+inline constexpr std::size_t small_input = 65536 + mf_limit - 1;  // stored positions stay below 2^16
+inline constexpr int hash_log = 12;                               // 16 KiB table of 32-bit positions
+inline constexpr int skip_trigger = 6;  // search step grows by 1 every 2^6 misses
+
+template <int HashLog>
+std::uint32_t hash(std::uint32_t sequence) noexcept {
+    return (sequence * prime1) >> (32 - HashLog);
+}
+
+/// Bytes equal at `a` and `b`, at most up to `limit` (exclusive) from `a`.
+inline std::size_t common_length(const char* a, const char* b, const char* limit) noexcept {
+    const char* start = a;
+    while (a + 8 <= limit) {
+        const std::uint64_t diff = load64(a) ^ load64(b);
+        if (diff) return static_cast<std::size_t>(a - start + std::countr_zero(diff) / 8);
+        a += 8;
+        b += 8;
+    }
+    while (a < limit && *a == *b) ++a, ++b;
+    return static_cast<std::size_t>(a - start);
+}
+
+inline char* write_length(char* op, std::size_t extra) noexcept {
+    for (; extra >= 255; extra -= 255) *op++ = static_cast<char>(255);
+    *op++ = static_cast<char>(extra);
+    return op;
+}
+
+}  // namespace detail::lz4
+
+/// Incremental xxHash32, the checksum of the LZ4 frame format: fast enough
+/// (several GB/s) not to show next to the codec, and catches corruption
+/// that the codec itself would decode silently.
+class xxh32_state {
+public:
+    explicit xxh32_state(std::uint32_t seed = 0) noexcept
+        : v_{seed + detail::lz4::prime1 + detail::lz4::prime2, seed + detail::lz4::prime2, seed,
+             seed - detail::lz4::prime1},
+          seed_(seed) {}
+
+    void update(const void* data, std::size_t size) noexcept {
+        using namespace detail::lz4;
+        const char* p = static_cast<const char*>(data);
+        const char* end = p + size;
+        total_ += size;
+        if (buffered_ + size < 16) {
+            std::memcpy(buf_ + buffered_, p, size);
+            buffered_ += size;
+            return;
+        }
+        if (buffered_) {
+            const std::size_t fill = 16 - buffered_;
+            std::memcpy(buf_ + buffered_, p, fill);
+            p += fill;
+            consume(buf_);
+            buffered_ = 0;
+        }
+        // Lanes in locals: stores through `char*` could alias members, which
+        // would force a reload of every lane each round.
+        std::uint32_t v0 = v_[0], v1 = v_[1], v2 = v_[2], v3 = v_[3];
+        for (; p + 16 <= end; p += 16) {
+            v0 = xxh_round(v0, load32(p));
+            v1 = xxh_round(v1, load32(p + 4));
+            v2 = xxh_round(v2, load32(p + 8));
+            v3 = xxh_round(v3, load32(p + 12));
+        }
+        v_[0] = v0, v_[1] = v1, v_[2] = v2, v_[3] = v3;
+        buffered_ = static_cast<std::size_t>(end - p);
+        std::memcpy(buf_, p, buffered_);
+    }
+
+    std::uint32_t digest() const noexcept {
+        using namespace detail::lz4;
+        std::uint32_t h = total_ >= 16 ? rotl(v_[0], 1) + rotl(v_[1], 7) + rotl(v_[2], 12) + rotl(v_[3], 18)
+                                       : seed_ + prime5;
+        h += static_cast<std::uint32_t>(total_);
+        const char* p = buf_;
+        const char* end = buf_ + buffered_;
+        for (; p + 4 <= end; p += 4) h = rotl(h + load32(p) * prime3, 17) * prime4;
+        for (; p < end; ++p) h = rotl(h + static_cast<unsigned char>(*p) * prime5, 11) * prime1;
+        h ^= h >> 15;
+        h *= prime2;
+        h ^= h >> 13;
+        h *= prime3;
+        h ^= h >> 16;
+        return h;
+    }
+
+private:
+    void consume(const char* p) noexcept {
+        for (int i = 0; i < 4; ++i) v_[i] = detail::lz4::xxh_round(v_[i], detail::lz4::load32(p + 4 * i));
+    }
+
+    std::uint32_t v_[4];
+    std::uint32_t seed_;
+    std::uint64_t total_ = 0;
+    char buf_[16];
+    std::size_t buffered_ = 0;
+};
+
+inline std::uint32_t xxh32(const void* data, std::size_t size, std::uint32_t seed = 0) noexcept {
+    xxh32_state state(seed);
+    state.update(data, size);
+    return state.digest();
+}
+
+/// Worst-case compressed size of `size` input bytes.
+constexpr std::size_t lz4_block_bound(std::size_t size) noexcept { return size + size / 255 + 16; }
+
+namespace detail::lz4 {
+
+template <typename Pos, int HashLog>
+std::size_t compress(const char* src, std::size_t size, char* dst, std::size_t capacity, int acceleration) noexcept {
+    const char* const base = src;
+    const char* const end = src + size;
+    const char* anchor = src;
+    char* op = dst;
+    char* const oend = dst + capacity;
+
+    // Emits literals [anchor, ip) and the token; returns the token or null.
+    auto literals = [&](const char* ip) -> char* {
+        const std::size_t n = static_cast<std::size_t>(ip - anchor);
+        if (static_cast<std::size_t>(oend - op) < 1 + n + n / 255 + 1 + 2 + last_literals) return nullptr;
+        char* token = op++;
+        if (n >= 15) {
+            *token = static_cast<char>(15 << 4);
+            op = write_length(op, n - 15);
+        } else {
+            *token = static_cast<char>(n << 4);
+        }
+        std::memcpy(op, anchor, n);
+        op += n;
+        return token;
+    };
+
+    if (size >= mf_limit + 1) {
+        Pos table[1 << HashLog] = {};
+        const char* const mflimit = end - mf_limit;           // last position a match may start
+        const char* const match_limit = end - last_literals;  // matches stop here
+        const std::uint32_t step_base = static_cast<std::uint32_t>(std::max(acceleration, 1)) << skip_trigger;
+
+        const char* ip = src + 1;
+        for (;;) {
+            // Search forward, skipping faster the longer nothing matches.
+            const char* match;
+            std::uint32_t attempts = step_base;
+            for (const char* next = ip;;) {
+                ip = next;
+                next += attempts++ >> skip_trigger;
+                if (next > mflimit) goto last;
+                const std::uint32_t h = hash<HashLog>(load32(ip));
+                match = base + table[h];
+                table[h] = static_cast<Pos>(ip - base);
+                if (static_cast<std::size_t>(ip - match) <= max_distance && load32(match) == load32(ip)) break;
+            }
+            // Extend backwards over bytes the search stepped past.
+            while (ip > anchor && match > base && ip[-1] == match[-1]) --ip, --match;
+
+            char* token = literals(ip);
+            if (!token) return 0;
+            for (;;) {
+                store16(op, static_cast<std::uint16_t>(ip - match));
+                op += 2;
+                const std::size_t len = min_match + common_length(ip + min_match, match + min_match, match_limit);
+                ip += len;
+                if (len - min_match >= 15) {
+                    *token = static_cast<char>(*token | 15);
+                    if (static_cast<std::size_t>(oend - op) < (len - min_match) / 255 + 1 + 1 + last_literals)
+                        return 0;
+                    op = write_length(op, len - min_match - 15);
+                } else {
+                    *token = static_cast<char>(*token | static_cast<char>(len - min_match));
+                }
+                anchor = ip;
+                if (ip > mflimit) goto last;
+                table[hash<HashLog>(load32(ip - 2))] = static_cast<Pos>(ip - 2 - base);
+                // A match right here needs no literals: chain it directly.
+                const std::uint32_t h = hash<HashLog>(load32(ip));
+                match = base + table[h];
+                table[h] = static_cast<Pos>(ip - base);
+                if (static_cast<std::size_t>(ip - match) > max_distance || load32(match) != load32(ip)) break;
+                if (oend - op < 1 + 2 + 1 + static_cast<std::ptrdiff_t>(last_literals)) return 0;
+                token = op++;
+                *token = 0;
+            }
+            ++ip;
+        }
+    }
+last:
+    if (!literals(end)) return 0;
+    return static_cast<std::size_t>(op - dst);
+}
+
+}  // namespace detail::lz4
+
+/// Compresses `src` into the LZ4 block format (readable by any LZ4
+/// decoder) with a single-probe hash table, as LZ4's fast mode does.
+/// `acceleration` > 1 skips ahead faster on incompressible data, trading
+/// ratio for speed. Returns the compressed size, or 0 if it would exceed
+/// `capacity` or the input is over ~2 GB; `lz4_block_bound` always fits.
+inline std::size_t lz4_compress_block(const char* src, std::size_t size, char* dst, std::size_t capacity,
+                                      int acceleration = 1) noexcept {
+    using namespace detail::lz4;
+    if (size > max_input) return 0;
+    // Up to 64 KiB, positions fit in 16 bits and the same table memory holds
+    // twice the entries, which finds more matches.
+    if (size < small_input) return compress<std::uint16_t, hash_log + 1>(src, size, dst, capacity, acceleration);
+    return compress<std::uint32_t, hash_log>(src, size, dst, capacity, acceleration);
+}
+
+/// Decodes an LZ4 block into `dst` and returns the decoded size. Every
+/// length and offset is bounds-checked, so corrupt or hostile input throws
+/// `compress_error` and never reads or writes outside the two buffers,
+/// though bytes of `dst` past the returned size may be overwritten. The
+/// `prefix` bytes right before `dst` are earlier output that matches may
+/// refer to, as the blocks of a linked frame do.
+inline std::size_t lz4_decompress_block(const char* src, std::size_t size, char* dst, std::size_t capacity,
+                                        std::size_t prefix = 0) {
+    using namespace detail::lz4;
+    const char* ip = src;
+    const char* const iend = src + size;
+    char* op = dst;
+    char* const oend = dst + capacity;
+
+    auto read_length = [&](std::size_t n) {
+        for (unsigned char b = 255; b == 255;) {
+            if (ip == iend) throw compress_error("lz4: truncated length");
+            b = static_cast<unsigned char>(*ip++);
+            n += b;
+        }
+        return n;
+    };
+
+    for (;;) {
+        if (ip == iend) throw compress_error("lz4: truncated block");
+        const auto token = static_cast<unsigned char>(*ip++);
+
+        std::size_t n = token >> 4;
+        if (n == 15) n = read_length(n);
+        if (n > static_cast<std::size_t>(iend - ip) || n > static_cast<std::size_t>(oend - op))
+            throw compress_error("lz4: literals out of bounds");
+        if (n <= 16 && iend - ip >= 16 && oend - op >= 16) {
+            std::memcpy(op, ip, 16);  // fixed size: one vector move
+        } else {
+            std::memcpy(op, ip, n);
+        }
+        ip += n;
+        op += n;
+        if (ip == iend) break;  // the last sequence has no match
+
+        if (iend - ip < 2) throw compress_error("lz4: truncated offset");
+        const std::size_t offset =
+            static_cast<unsigned char>(ip[0]) | static_cast<std::size_t>(static_cast<unsigned char>(ip[1])) << 8;
+        ip += 2;
+        if (offset == 0 || offset > static_cast<std::size_t>(op - dst) + prefix)
+            throw compress_error("lz4: bad match offset");
+
+        std::size_t len = token & 15;
+        if (len == 15) len = read_length(len);
+        len += min_match;
+        if (len > static_cast<std::size_t>(oend - op)) throw compress_error("lz4: match out of bounds");
+
+        const char* match = op - offset;
+        char* const mend = op + len;
+        if (offset >= 16 && oend - mend >= 16) {
+            // No overlap within a 16-byte step: copy in whole chunks.
+            for (; op < mend; op += 16, match += 16) std::memcpy(op, match, 16);
+        } else if (offset >= 8 && oend - mend >= 8) {
+            for (; op < mend; op += 8, match += 8) std::memcpy(op, match, 8);
+        } else if (offset == 1) {
+            std::memset(op, *match, len);
+        } else {
+            // Overlapping copy repeats the last `offset` bytes.
+            for (; op < mend; ++op, ++match) *op = *match;
+        }
+        op = mend;
+    }
+    return static_cast<std::size_t>(op - dst);
+}
+
+struct lz4_frame_options {
+    /// Maximum uncompressed block: 64 KiB, 256 KiB, 1 MiB or 4 MiB. Larger
+    /// blocks compress slightly better; smaller ones bound reader memory and
+    /// latency.
+    std::size_t block_size = std::size_t{64} << 10;
+    bool block_checksums = false;
+    bool content_checksum = true;
+    int acceleration = 1;
+    /// Total bytes that will be written, stored in the header so readers
+    /// can size their output once; 0 leaves it out. `finish` throws if the
+    /// writer saw a different amount.
+    std::uint64_t content_size = 0;
+};
+
+namespace detail::lz4 {
+
+inline constexpr std::uint32_t frame_magic = 0x184D2204;
+inline constexpr std::uint32_t uncompressed_bit = 0x80000000u;
+
+inline int block_size_id(std::size_t size) {
+    for (int id = 4; id <= 7; ++id)
+        if (size == std::size_t{1} << (8 + 2 * id)) return id;
+    throw std::invalid_argument("lz4 block size must be 64 KiB, 256 KiB, 1 MiB or 4 MiB");
+}
+
+}  // namespace detail::lz4
+
+/// Streaming compressor producing the LZ4 frame format (the `.lz4` file
+/// format, readable by the `lz4` tool and every LZ4 library), appended to a
+/// caller-owned string as in `binary_writer`.
+///
+/// Data is cut into independent blocks of `block_size`; blocks that do not
+/// shrink are stored raw, so incompressible input costs ~0.4% overhead.
+/// `flush` emits a partial block, e.g. at the end of each replication batch;
+/// `finish` ends the frame with the content checksum.
+class lz4_frame_writer {
+public:
+    explicit lz4_frame_writer(std::string& out, const lz4_frame_options& options = {})
+        : out_(out), options_(options) {
+        const int id = detail::lz4::block_size_id(options.block_size);
+        char header[15];
+        std::size_t size = 6;
+        detail::lz4::store32(header, detail::lz4::frame_magic);
+        header[4] = static_cast<char>(0x40 | 0x20 | (options.block_checksums ? 0x10 : 0) |
+                                      (options.content_size ? 0x08 : 0) |
+                                      (options.content_checksum ? 0x04 : 0));  // version 01, independent blocks
+        header[5] = static_cast<char>(id << 4);
+        if (options.content_size) {
+            detail::lz4::store32(header + 6, static_cast<std::uint32_t>(options.content_size));
+            detail::lz4::store32(header + 10, static_cast<std::uint32_t>(options.content_size >> 32));
+            size += 8;
+        }
+        header[size] = static_cast<char>((xxh32(header + 4, size - 4) >> 8) & 0xFF);
+        out_.append(header, size + 1);
+        pending_.reserve(options.block_size);
+    }
+
+    void write(std::string_view data) {
+        written_ += data.size();
+        if (options_.content_checksum) checksum_.update(data.data(), data.size());
+        if (!pending_.empty()) {
+            const std::size_t take = std::min(data.size(), options_.block_size - pending_.size());
+            pending_.append(data.data(), take);
+            data.remove_prefix(take);
+            if (pending_.size() < options_.block_size) return;
+            emit(pending_.data(), pending_.size());
+            pending_.clear();
+        }
+        // Whole blocks straight from the caller's buffer, without copying.
+        for (; data.size() >= options_.block_size; data.remove_prefix(options_.block_size))
+            emit(data.data(), options_.block_size);
+        pending_.append(data);
+    }
+
+    /// Emits buffered data as a (short) block, so everything written so far
+    /// can be decoded from `out`.
+    void flush() {
+        if (pending_.empty()) return;
+        emit(pending_.data(), pending_.size());
+        pending_.clear();
+    }
+
+    /// Flushes, then writes the end mark and content checksum. The writer
+    /// must not be used afterwards.
+    void finish() {
+        if (options_.content_size && written_ != options_.content_size)
+            throw compress_error("lz4: content size does not match the bytes written");
+        flush();
+        char tail[8];
+        detail::lz4::store32(tail, 0);
+        detail::lz4::store32(tail + 4, checksum_.digest());
+        out_.append(tail, options_.content_checksum ? 8 : 4);
+    }
+
+private:
+    void emit(const char* data, std::size_t size) {
+        const std::size_t start = out_.size();
+        out_.resize(start + 4 + size + 4);
+        char* block = out_.data() + start + 4;
+        // Only worth keeping if smaller than the raw bytes.
+        std::size_t n = lz4_compress_block(data, size, block, size - 1, options_.acceleration);
+        std::uint32_t header = static_cast<std::uint32_t>(n);
+        if (n == 0) {
+            std::memcpy(block, data, size);
+            n = size;
+            header = static_cast<std::uint32_t>(size) | detail::lz4::uncompressed_bit;
+        }
+        detail::lz4::store32(out_.data() + start, header);
+        if (options_.block_checksums) detail::lz4::store32(block + n, xxh32(block, n));
+        out_.resize(start + 4 + n + (options_.block_checksums ? 4 : 0));
+    }
+
+    std::string& out_;
+    lz4_frame_options options_;
+    std::uint64_t written_ = 0;
+    std::string pending_;
+    xxh32_state checksum_;
+};
+
+/// Streaming decoder for LZ4 frames: `feed` chunks as they arrive (from a
+/// socket or file reads, any sizes) and decoded data is appended to `out`
+/// block by block. Handles independent and linked blocks, verifies header,
+/// block and content checksums when the frame has them, and skips
+/// skippable frames, which count as frames of their own that produce no
+/// output. Dictionaries are not supported. Throws `compress_error`.
+class lz4_frame_reader {
+public:
+    explicit lz4_frame_reader(std::string& out) : out_(out) {}
+
+    /// Consumes bytes of `chunk` and returns how many: all of them unless
+    /// the frame ended inside it, in which case the rest belongs to
+    /// whatever follows the frame.
+    std::size_t feed(std::string_view chunk) {
+        if (done_) return 0;
+        if (pending_.empty()) {
+            const std::size_t used = parse(chunk.data(), chunk.size());
+            if (!done_) pending_.assign(chunk.data() + used, chunk.size() - used);
+            return done_ ? used : chunk.size();
+        }
+        const std::size_t before = pending_.size();
+        pending_.append(chunk);
+        const std::size_t used = parse(pending_.data(), pending_.size());
+        if (done_) {
+            pending_.clear();
+            return used - before;
+        }
+        pending_.erase(0, used);
+        return chunk.size();
+    }
+
+    /// True once a frame has been read: its end mark and content checksum,
+    /// or all of a skippable frame.
+    bool done() const noexcept { return done_; }
+
+private:
+    enum class state { magic, header, block, checksum };
+
+    // Handles as many complete units as `n` bytes hold; returns bytes used.
+    std::size_t parse(const char* p, std::size_t n) {
+        using namespace detail::lz4;
+        std::size_t used = 0;
+        while (!done_) {
+            const char* q = p + used;
+            const std::size_t avail = n - used;
+            std::size_t step = 0;
+            switch (state_) {
+            case state::magic: {
+                if (avail < 4) return used;
+                const std::uint32_t magic = load32(q);
+                if ((magic & 0xFFFFFFF0u) == 0x184D2A50u) {
+                    if (avail < 8) return used;
+                    const std::size_t skip = 8 + std::size_t{load32(q + 4)};
+                    if (avail < skip) return used;
+                    step = skip;
+                    done_ = true;  // a frame of its own, so input may end here
+                } else if (magic == frame_magic) {
+                    step = 4;
+                    state_ = state::header;
+                } else {
+                    throw compress_error("lz4: bad frame magic");
+                }
+                break;
+            }
+            case state::header: {
+                if (avail < 2) return used;
+                const auto flg = static_cast<unsigned char>(q[0]), bd = static_cast<unsigned char>(q[1]);
+                if ((flg >> 6) != 1) throw compress_error("lz4: unsupported frame version");
+                if (flg & 0x01) throw compress_error("lz4: dictionaries are not supported");
+                const std::size_t size = 3 + ((flg & 0x08) ? 8 : 0);
+                if (avail < size) return used;
+                if (static_cast<unsigned char>(q[size - 1]) != ((xxh32(q, size - 1) >> 8) & 0xFF))
+                    throw compress_error("lz4: header checksum mismatch");
+                const int id = (bd >> 4) & 7;
+                if (id < 4) throw compress_error("lz4: bad block size");
+                block_max_ = std::size_t{1} << (8 + 2 * id);
+                linked_ = !(flg & 0x20);
+                window_.clear();
+                block_checksums_ = flg & 0x10;
+                content_checksum_ = flg & 0x04;
+                checksum_ = xxh32_state();
+                decoded_ = 0;
+                content_size_ = 0;
+                if (flg & 0x08) {
+                    content_size_ = load32(q + 2) | std::uint64_t{load32(q + 6)} << 32;
+                    // A hint only, from unverified input: bounded so a forged
+                    // header cannot make us commit absurd amounts of memory.
+                    out_.reserve(out_.size() + std::min<std::uint64_t>(content_size_, std::uint64_t{1} << 28));
+                }
+                step = size;
+                state_ = state::block;
+                break;
+            }
+            case state::block: {
+                if (avail < 4) return used;
+                const std::uint32_t header = load32(q);
+                if (header == 0) {
+                    step = 4;
+                    state_ = state::checksum;
+                    break;
+                }
+                const std::size_t size = header & ~uncompressed_bit;
+                if (size > block_max_) throw compress_error("lz4: block larger than declared maximum");
+                const std::size_t total = 4 + size + (block_checksums_ ? 4 : 0);
+                if (avail < total) return used;
+                const char* data = q + 4;
+                if (block_checksums_ && load32(data + size) != xxh32(data, size))
+                    throw compress_error("lz4: block checksum mismatch");
+                const std::size_t start = out_.size();
+                if (header & uncompressed_bit) {
+                    out_.append(data, size);
+                    if (linked_) window_.append(data, size);
+                } else if (linked_) {
+                    // Matches may reach 64 KiB back into earlier blocks, which
+                    // the caller may have drained from `out`: decode behind a
+                    // private copy of that history.
+                    const std::size_t history = window_.size();
+                    window_.resize(history + block_max_);
+                    const std::size_t decoded =
+                        lz4_decompress_block(data, size, window_.data() + history, block_max_, history);
+                    window_.resize(history + decoded);
+                    out_.append(window_, history, decoded);
+                } else {
+                    scratch_.resize(block_max_);
+                    out_.append(scratch_, 0, lz4_decompress_block(data, size, scratch_.data(), block_max_));
+                }
+                if (window_.size() > max_distance + 1) window_.erase(0, window_.size() - max_distance - 1);
+                decoded_ += out_.size() - start;
+                if (content_checksum_) checksum_.update(out_.data() + start, out_.size() - start);
+                step = total;
+                break;
+            }
+            case state::checksum: {
+                if (content_size_ && decoded_ != content_size_) throw compress_error("lz4: content size mismatch");
+                if (content_checksum_) {
+                    if (avail < 4) return used;
+                    if (load32(q) != checksum_.digest()) throw compress_error("lz4: content checksum mismatch");
+                    step = 4;
+                }
+                done_ = true;
+                break;
+            }
+            }
+            used += step;
+        }
+        return used;
+    }
+
+    std::string& out_;
+    std::string pending_;
+    state state_ = state::magic;
+    std::size_t block_max_ = 0;
+    bool linked_ = false;
+    bool block_checksums_ = false;
+    bool content_checksum_ = false;
+    bool done_ = false;
+    std::uint64_t content_size_ = 0;  // from the header, 0 if absent
+    std::uint64_t decoded_ = 0;
+    std::string window_;  // last 64 KiB of output, for linked blocks
+    std::string scratch_;
+    xxh32_state checksum_;
+};
+
+/// One LZ4 frame holding `data`, with its size in the header.
+inline std::string lz4_compress(std::string_view data, lz4_frame_options options = {}) {
+    std::string out;
+    out.reserve(lz4_block_bound(data.size()) + 32);
+    options.content_size = data.size();
+    lz4_frame_writer writer(out, options);
+    writer.write(data);
+    writer.finish();
+    return out;
+}
+
+/// Decodes one or more concatenated LZ4 frames. Throws `compress_error`,
+/// also when the input ends inside a frame.
+inline std::string lz4_decompress(std::string_view frames) {
+    std::string out;
+    while (!frames.empty()) {
+        lz4_frame_reader reader(out);
+        frames.remove_prefix(reader.feed(frames));
+        if (!reader.done()) throw compress_error("lz4: truncated frame");
+    }
+    return out;
+}
+
+}  // namespace mo
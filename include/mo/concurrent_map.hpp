@@ -0,0 +1,543 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mo/futex.hpp"
+
+namespace mo {
+
+namespace detail::ebr {
+
+/// Epoch-based reclamation. Readers pin the global epoch around each access
+/// instead of taking locks; a retired object is freed once the epoch has
+/// advanced twice, since every reader that could still see it has unpinned
+/// by then. The epoch only advances when no pinned reader lags behind.
+
+inline constexpr std::uint64_t idle = ~std::uint64_t{0};
+
+struct retired {
+    void* object;
+    void (*free)(void*);
+    std::uint64_t epoch;
+};
+
+struct alignas(64) record {
+    std::atomic<std::uint64_t> epoch{idle};  // pinned epoch, or `idle`
+    std::atomic<bool> in_use{true};
+    record* next = nullptr;
+    // Owner thread only.
+    unsigned depth = 0;
+    std::vector<retired> limbo;
+};
+
+class domain {
+public:
+    static domain& instance() {
+        static domain d;
+        return d;
+    }
+
+    ~domain() {
+        for (retired& r : orphans_) r.free(r.object);
+        for (record* r = records_.load(); r;) {
+            for (retired& x : r->limbo) x.free(x.object);
+            delete std::exchange(r, r->next);
+        }
+    }
+
+    record* acquire() {
+        for (record* r = records_.load(std::memory_order_acquire); r; r = r->next) {
+            bool free = false;
+            if (!r->in_use.load(std::memory_order_relaxed) &&
+                r->in_use.compare_exchange_strong(free, true, std::memory_order_acquire))
+                return r;
+        }
+        auto* r = new record();
+        r->next = records_.load(std::memory_order_relaxed);
+        while (!records_.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        return r;
+    }
+
+    /// Hands the objects a thread never got to free to whoever collects next.
+    void release(record* r) {
+        r->epoch.store(idle, std::memory_order_release);
+        if (!r->limbo.empty()) {
+            std::lock_guard lock(orphans_lock_);
+            orphans_.insert(orphans_.end(), r->limbo.begin(), r->limbo.end());
+            r->limbo.clear();
+        }
+        r->in_use.store(false, std::memory_order_release);
+    }
+
+    void pin(record& r) noexcept {
+        if (r.depth++ != 0) return;
+        r.epoch.store(epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        // Announce before reading any shared pointer; pairs with the fence
+        // in `try_advance`.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void unpin(record& r) noexcept {
+        if (--r.depth == 0) r.epoch.store(idle, std::memory_order_release);
+    }
+
+    /// Queues `object` for `free` once no reader can still hold it. Call
+    /// after unlinking it. Returns the epoch it was retired in: every reader
+    /// that could have seen it has unpinned once `reached(epoch + 2)`.
+    std::uint64_t retire(record& r, void* object, void (*free)(void*)) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::uint64_t e = epoch_.load(std::memory_order_relaxed);
+        r.limbo.push_back({object, free, e});
+        if (r.limbo.size() >= collect_threshold) collect(r);
+        return e;
+    }
+
+    /// Whether the epoch has reached `target`, advancing it if no pinned
+    /// reader lags behind. Never waits.
+    bool reached(std::uint64_t target) noexcept {
+        if (epoch_.load(std::memory_order_acquire) < target) try_advance();
+        return epoch_.load(std::memory_order_acquire) >= target;
+    }
+
+private:
+    static constexpr std::size_t collect_threshold = 128;
+
+    bool try_advance() noexcept {
+        std::uint64_t e = epoch_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (record* r = records_.load(std::memory_order_acquire); r; r = r->next) {
+            const std::uint64_t pinned = r->epoch.load(std::memory_order_acquire);
+            if (pinned != idle && pinned != e) return false;
+        }
+        return epoch_.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+    }
+
+    void collect(record& r) {
+        try_advance();
+        const std::uint64_t now = epoch_.load(std::memory_order_acquire);
+        const auto expired = [now](const retired& x) { return x.epoch + 2 <= now; };
+        const auto keep = std::partition(r.limbo.begin(), r.limbo.end(), [&](const retired& x) { return !expired(x); });
+        for (auto it = keep; it != r.limbo.end(); ++it) it->free(it->object);
+        r.limbo.erase(keep, r.limbo.end());
+
+        if (orphans_lock_.try_lock()) {
+            std::lock_guard lock(orphans_lock_, std::adopt_lock);
+            const auto kept = std::partition(orphans_.begin(), orphans_.end(), [&](const retired& x) { return !expired(x); });
+            for (auto it = kept; it != orphans_.end(); ++it) it->free(it->object);
+            orphans_.erase(kept, orphans_.end());
+        }
+    }
+
+    alignas(64) std::atomic<std::uint64_t> epoch_{0};
+    std::atomic<record*> records_{nullptr};
+    futex_mutex orphans_lock_;
+    std::vector<retired> orphans_;
+};
+
+struct thread_record {
+    record* r = domain::instance().acquire();
+    ~thread_record() { domain::instance().release(r); }
+};
+
+inline record& local() {
+    thread_local thread_record handle;
+    return *handle.r;
+}
+
+class guard {
+public:
+    guard() : r_(local()) { domain::instance().pin(r_); }
+    ~guard() { domain::instance().unpin(r_); }
+    guard(const guard&) = delete;
+    guard& operator=(const guard&) = delete;
+
+private:
+    record& r_;
+};
+
+template <typename T>
+std::uint64_t retire(T* object) {
+    return domain::instance().retire(local(), object, [](void* p) { delete static_cast<T*>(p); });
+}
+
+}  // namespace detail::ebr
+
+namespace detail::concurrent {
+
+/// Spreads the low-entropy output of `std::hash` for integers over the
+/// bits the bucket and stripe indexes use.
+inline std::uint64_t mix(std::uint64_t h) noexcept {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    return h;
+}
+
+}  // namespace detail::concurrent
+
+/// Hash map for read-heavy shared tables (sessions, connections, caches)
+/// where a `std::unordered_map` behind a `shared_mutex` turns every lookup
+/// into a write to the lock's cache line.
+///
+/// Lookups take no lock and write no shared memory: they pin a reclamation
+/// epoch (a store to a thread-local slot) and walk an immutable chain.
+/// Writers lock one of a fixed set of stripes chosen by hash, so writes to
+/// different keys rarely contend. Values are never modified in place: an
+/// update links a new node and retires the old one, freed once no reader
+/// can still see it.
+///
+/// Growing is incremental. When a stripe passes the load factor, a table of
+/// twice the size is allocated and each writer moves its own bucket and a
+/// couple of others before returning; readers follow a moved bucket into
+/// the new table. Every node carries two links so it can be threaded into
+/// the new table without disturbing readers still walking the old one.
+///
+/// Once every bucket has moved, the old table is retired like a node. The
+/// next resize waits until no reader can still be walking it, since it
+/// reuses the links the old table was threaded through; until then the map
+/// keeps working with longer chains.
+///
+/// `visit` and `for_each` run their callback with the epoch pinned. No
+/// writer ever waits for one, but keep them short: memory retired
+/// meanwhile, by any map, is not freed until they return, and maps that
+/// have just grown cannot grow again.
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class concurrent_map {
+    struct node {
+        template <typename... Args>
+        node(std::uint64_t h, const Key& k, Args&&... args) : hash(h), key(k), value(std::forward<Args>(args)...) {}
+
+        std::atomic<node*> next[2]{};  // link in a table of either parity
+        const std::uint64_t hash;
+        const Key key;
+        const T value;
+    };
+
+    struct table {
+        explicit table(std::size_t n, unsigned p) : mask(n - 1), parity(p), buckets(new std::atomic<node*>[n]()) {}
+
+        std::size_t size() const noexcept { return mask + 1; }
+
+        const std::size_t mask;
+        const unsigned parity;  // which of `node::next` this table links through
+        std::unique_ptr<std::atomic<node*>[]> buckets;
+        std::atomic<table*> next{nullptr};  // set while resizing into it
+        std::atomic<std::size_t> cursor{0};  // next bucket offered to helpers
+        std::atomic<std::size_t> moved{0};
+    };
+
+    struct alignas(64) stripe {
+        futex_mutex lock;
+        std::atomic<std::size_t> count{0};  // written under `lock`, read by `size`
+
+        void add(std::ptrdiff_t n) noexcept {
+            count.store(count.load(std::memory_order_relaxed) + static_cast<std::size_t>(n), std::memory_order_relaxed);
+        }
+    };
+
+public:
+    explicit concurrent_map(std::size_t initial_capacity = 0, const Hash& hash = Hash(),
+                            const KeyEqual& equal = KeyEqual())
+        : stripe_count_(std::min<std::size_t>(1024, std::bit_ceil(std::max(16u, 4 * std::thread::hardware_concurrency())))),
+          stripes_(new stripe[stripe_count_]),
+          hash_(hash),
+          equal_(equal) {
+        table_.store(new table(std::bit_ceil(std::max(initial_capacity, stripe_count_)), 0), std::memory_order_release);
+    }
+
+    concurrent_map(const concurrent_map&) = delete;
+    concurrent_map& operator=(const concurrent_map&) = delete;
+
+    /// Not concurrent with other calls on this map.
+    ~concurrent_map() {
+        table* t = table_.load(std::memory_order_relaxed);
+        table* nt = t->next.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < t->size(); ++i) {
+            node* n = t->buckets[i].load(std::memory_order_relaxed);
+            if (n != moved_mark()) free_chain(n, t->parity);
+        }
+        if (nt) {
+            for (std::size_t i = 0; i < nt->size(); ++i) free_chain(nt->buckets[i].load(std::memory_order_relaxed), nt->parity);
+            delete nt;
+        }
+        delete t;
+    }
+
+    /// Calls `f(const T&)` on the value for `key` without locking or copying;
+    /// returns whether the key was present.
+    template <typename F>
+    bool visit(const Key& key, F&& f) const {
+        detail::ebr::guard pin;
+        if (const node* n = lookup(key, hash_of(key))) {
+            std::forward<F>(f)(n->value);
+            return true;
+        }
+        return false;
+    }
+
+    std::optional<T> get(const Key& key) const {
+        detail::ebr::guard pin;
+        if (const node* n = lookup(key, hash_of(key))) return n->value;
+        return std::nullopt;
+    }
+
+    bool contains(const Key& key) const {
+        detail::ebr::guard pin;
+        return lookup(key, hash_of(key)) != nullptr;
+    }
+
+    /// Inserts unless `key` is present; returns whether it inserted.
+    template <typename... Args>
+    bool try_emplace(const Key& key, Args&&... args) {
+        const std::uint64_t h = hash_of(key);
+        return write(h, [&](table* t, stripe& s) {
+            std::atomic<node*>& head = t->buckets[h & t->mask];
+            if (find_in(head, t->parity, key, h).second) return false;
+            node* n = new node(h, key, std::forward<Args>(args)...);
+            n->next[t->parity].store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            head.store(n, std::memory_order_release);
+            s.add(1);
+            return true;
+        });
+    }
+
+    /// Returns true if `key` was inserted, false if its value was replaced.
+    template <typename V>
+    bool insert_or_assign(const Key& key, V&& value) {
+        return upsert(key, [&](const T*) { return T(std::forward<V>(value)); });
+    }
+
+    /// Replaces the value for `key` with `f(const T& old)`; returns false,
+    /// without calling `f`, if the key is absent. Runs under the stripe lock.
+    template <typename F>
+    bool update(const Key& key, F&& f) {
+        const std::uint64_t h = hash_of(key);
+        return write(h, [&](table* t, stripe&) {
+            auto [link, old] = find_in(t->buckets[h & t->mask], t->parity, key, h);
+            if (!old) return false;
+            replace(link, old, new node(h, key, f(old->value)), t->parity);
+            return true;
+        });
+    }
+
+    bool erase(const Key& key) {
+        const std::uint64_t h = hash_of(key);
+        return write(h, [&](table* t, stripe& s) {
+            auto [link, old] = find_in(t->buckets[h & t->mask], t->parity, key, h);
+            if (!old) return false;
+            link->store(old->next[t->parity].load(std::memory_order_relaxed), std::memory_order_release);
+            detail::ebr::retire(old);
+            s.add(-1);
+            return true;
+        });
+    }
+
+    /// Calls `f(const Key&, const T&)` on every entry. Weakly consistent:
+    /// sees each entry present throughout the call exactly once, and
+    /// concurrent changes maybe.
+    template <typename F>
+    void for_each(F&& f) const {
+        detail::ebr::guard pin;
+        const table* t = table_.load(std::memory_order_acquire);
+        const auto walk = [&](node* n, unsigned parity) {
+            for (; n; n = n->next[parity].load(std::memory_order_acquire)) f(n->key, n->value);
+        };
+        for (std::size_t i = 0; i < t->size(); ++i) {
+            node* head = t->buckets[i].load(std::memory_order_acquire);
+            if (head != moved_mark()) {
+                walk(head, t->parity);
+            } else {
+                // Set before the first bucket moved; a resize may have started since.
+                const table* nt = t->next.load(std::memory_order_acquire);
+                walk(nt->buckets[i].load(std::memory_order_acquire), nt->parity);
+                walk(nt->buckets[i + t->size()].load(std::memory_order_acquire), nt->parity);
+            }
+        }
+    }
+
+    /// Entry count; exact only when no writer is running.
+    std::size_t size() const noexcept {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < stripe_count_; ++i) n += stripes_[i].count.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    std::size_t bucket_count() const noexcept {
+        const table* t = table_.load(std::memory_order_acquire);
+        const table* nt = t->next.load(std::memory_order_acquire);
+        return (nt ? nt : t)->size();
+    }
+
+private:
+    static node* moved_mark() noexcept { return reinterpret_cast<node*>(std::uintptr_t{1}); }
+
+    std::uint64_t hash_of(const Key& key) const { return detail::concurrent::mix(hash_(key)); }
+
+    stripe& stripe_for(std::uint64_t h) const noexcept { return stripes_[h & (stripe_count_ - 1)]; }
+
+    const node* lookup(const Key& key, std::uint64_t h) const {
+        const table* t = table_.load(std::memory_order_acquire);
+        for (;;) {
+            node* n = t->buckets[h & t->mask].load(std::memory_order_acquire);
+            if (n == moved_mark()) {
+                t = t->next.load(std::memory_order_acquire);
+                continue;
+            }
+            for (; n; n = n->next[t->parity].load(std::memory_order_acquire)) {
+                if (n->hash == h && equal_(n->key, key)) return n;
+            }
+            return nullptr;
+        }
+    }
+
+    /// The link pointing at the node for `key` (or the chain's last link)
+    /// and that node, or null. Caller holds the stripe lock.
+    std::pair<std::atomic<node*>*, node*> find_in(std::atomic<node*>& head, unsigned parity, const Key& key,
+                                                   std::uint64_t h) const {
+        std::atomic<node*>* link = &head;
+        for (node* n = link->load(std::memory_order_relaxed); n; n = link->load(std::memory_order_relaxed)) {
+            if (n->hash == h && equal_(n->key, key)) return {link, n};
+            link = &n->next[parity];
+        }
+        return {link, nullptr};
+    }
+
+    static void replace(std::atomic<node*>* link, node* old, node* fresh, unsigned parity) {
+        fresh->next[parity].store(old->next[parity].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        link->store(fresh, std::memory_order_release);
+        detail::ebr::retire(old);
+    }
+
+    template <typename MakeValue>
+    bool upsert(const Key& key, MakeValue&& make_value) {
+        const std::uint64_t h = hash_of(key);
+        return write(h, [&](table* t, stripe& s) {
+            std::atomic<node*>& head = t->buckets[h & t->mask];
+            auto [link, old] = find_in(head, t->parity, key, h);
+            node* fresh = new node(h, key, make_value(old ? &old->value : nullptr));
+            if (old) {
+                replace(link, old, fresh, t->parity);
+                return false;
+            }
+            fresh->next[t->parity].store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            head.store(fresh, std::memory_order_release);
+            s.add(1);
+            return true;
+        });
+    }
+
+    /// Runs `op(table, stripe)` under the stripe lock for `h`, on the newest
+    /// table after moving the key's bucket into it; then helps any resize.
+    template <typename Op>
+    bool write(std::uint64_t h, Op&& op) {
+        stripe& s = stripe_for(h);
+        bool result;
+        bool grow;
+        {
+            detail::ebr::guard pin;
+            std::lock_guard lock(s.lock);
+            table* t = table_.load(std::memory_order_acquire);
+            if (table* nt = t->next.load(std::memory_order_acquire)) {
+                move_bucket(t, nt, h & t->mask);
+                t = nt;
+            }
+            result = op(t, s);
+            grow = s.count.load(std::memory_order_relaxed) > t->size() / stripe_count_;
+        }
+        if (resizing_.load(std::memory_order_acquire))
+            help_resize();
+        else if (grow)
+            start_resize();
+        return result;
+    }
+
+    void start_resize() {
+        if (resizing_.exchange(true, std::memory_order_acq_rel)) return;
+        table* t = table_.load(std::memory_order_acquire);
+        t->next.store(new table(t->size() * 2, t->parity ^ 1), std::memory_order_release);
+    }
+
+    /// Moves a couple of buckets; the thread that moves the last one
+    /// retires the old table. Once no reader can still be walking it, ends
+    /// the resize.
+    void help_resize() {
+        constexpr std::size_t buckets_per_write = 2;
+        {
+            detail::ebr::guard pin;
+            table* t = table_.load(std::memory_order_acquire);
+            table* nt = t->next.load(std::memory_order_acquire);
+            for (std::size_t k = 0; nt && k < buckets_per_write; ++k) {
+                const std::size_t i = t->cursor.fetch_add(1, std::memory_order_relaxed);
+                if (i >= t->size()) break;
+                std::lock_guard lock(stripe_for(i).lock);
+                move_bucket(t, nt, i);
+            }
+        }
+        if (finish_ready_.load(std::memory_order_acquire) && finish_ready_.exchange(false, std::memory_order_acq_rel))
+            finish_resize();
+        std::uint64_t grace = grace_end_.load(std::memory_order_acquire);
+        if (grace != no_grace && detail::ebr::domain::instance().reached(grace) &&
+            grace_end_.compare_exchange_strong(grace, no_grace, std::memory_order_acq_rel))
+            resizing_.store(false, std::memory_order_release);
+    }
+
+    /// Splits old bucket `i` into new buckets `i` and `i + old size` by
+    /// linking its nodes through the new table's `next`; readers of the old
+    /// chain are undisturbed. Caller holds the bucket's stripe lock.
+    void move_bucket(table* t, table* nt, std::size_t i) {
+        node* n = t->buckets[i].load(std::memory_order_relaxed);
+        if (n == moved_mark()) return;
+        const std::size_t high_bit = t->size();
+        node* lo = nullptr;
+        node* hi = nullptr;
+        for (; n; n = n->next[t->parity].load(std::memory_order_relaxed)) {
+            node*& chain = (n->hash & high_bit) ? hi : lo;
+            n->next[nt->parity].store(chain, std::memory_order_relaxed);
+            chain = n;
+        }
+        nt->buckets[i].store(lo, std::memory_order_release);
+        nt->buckets[i + high_bit].store(hi, std::memory_order_release);
+        t->buckets[i].store(moved_mark(), std::memory_order_release);
+        if (t->moved.fetch_add(1, std::memory_order_acq_rel) + 1 == t->size())
+            finish_ready_.store(true, std::memory_order_release);
+    }
+
+    void finish_resize() {
+        table* t = table_.load(std::memory_order_acquire);
+        table_.store(t->next.load(std::memory_order_acquire), std::memory_order_release);
+        // Readers may still be walking the old table, and the next resize
+        // reuses the links it was threaded through: `resizing_` stays set
+        // until they are gone.
+        grace_end_.store(detail::ebr::retire(t) + 2, std::memory_order_release);
+    }
+
+    static void free_chain(node* n, unsigned parity) {
+        while (n) delete std::exchange(n, n->next[parity].load(std::memory_order_relaxed));
+    }
+
+    alignas(64) std::atomic<table*> table_{nullptr};
+    std::atomic<bool> resizing_{false};
+    std::atomic<bool> finish_ready_{false};
+    static constexpr std::uint64_t no_grace = ~std::uint64_t{0};
+    std::atomic<std::uint64_t> grace_end_{no_grace};  // epoch at which the old table's readers are gone
+    const std::size_t stripe_count_;
+    std::unique_ptr<stripe[]> stripes_;
+    [[no_unique_address]] Hash hash_;
+    [[no_unique_address]] KeyEqual equal_;
+};
+
+}  // namespace mo
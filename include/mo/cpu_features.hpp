@@ -0,0 +1,45 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace mo {
+
+/// Instruction-set extensions available on the running CPU.
+///
+/// Kernels compiled with `__attribute__((target(...)))` check these once and
+/// pick an implementation at run time, so a binary built for baseline x86-64
+/// still uses AVX2/AVX-512 where the hardware has them.
+struct cpu_features {
+    bool ssse3 = false;
+    bool sse42 = false;
+    bool avx2 = false;
+    bool bmi2 = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+    bool invariant_tsc = false;  // TSC ticks at a constant rate, also in deep C-states
+};
+
+inline const cpu_features& cpu() noexcept {
+    static const cpu_features features = [] {
+        cpu_features f;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        f.ssse3 = __builtin_cpu_supports("ssse3");
+        f.sse42 = __builtin_cpu_supports("sse4.2");
+        f.avx2 = __builtin_cpu_supports("avx2");
+        f.bmi2 = __builtin_cpu_supports("bmi2");
+        f.avx512f = __builtin_cpu_supports("avx512f");
+        f.avx512bw = __builtin_cpu_supports("avx512bw");
+        f.avx512vl = __builtin_cpu_supports("avx512vl");
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) f.invariant_tsc = (edx >> 8) & 1;
+#endif
+        return f;
+    }();
+    return features;
+}
+
+}  // namespace mo
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <span>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace mo {
+
+/// One hardware thread the process may run on.
+struct logical_cpu {
+    int id = 0;       // kernel CPU number, as used in affinity masks
+    int core = 0;     // physical core, numbered densely across packages
+    int package = 0;  // socket (physical_package_id)
+    int node = 0;     // NUMA node
+    int smt = 0;      // position among the core's usable hardware threads
+};
+
+enum class cache_type { data, instruction, unified };
+
+/// One cache instance and the CPUs sharing it.
+struct cpu_cache {
+    int level = 0;
+    cache_type type = cache_type::unified;
+    std::size_t size = 0;
+    std::size_t line_size = 0;
+    std::vector<int> cpus;
+};
+
+/// Orders in which `cpu_topology::plan` hands out CPUs.
+enum class pin_policy {
+    physical_cores,  // one hardware thread per core; SMT siblings only once every core is taken
+    compact,         // fill a core's hardware threads, then the next core: threads share caches
+    scatter,         // round-robin over NUMA nodes, then cores: spreads memory bandwidth
+};
+
+namespace detail::topology {
+
+inline std::string read_line(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+inline int read_int(const std::string& path, int fallback) {
+    const std::string s = read_line(path);
+    if (s.empty()) return fallback;
+    try {
+        return std::stoi(s);
+    } catch (const std::exception&) {
+        return fallback;
+    }
+}
+
+/// Parses the kernel's CPU list format, e.g. "0-3,8,10-11".
+inline std::vector<int> parse_list(const std::string& s) {
+    std::vector<int> out;
+    for (std::size_t pos = 0; pos < s.size();) {
+        std::size_t end = s.find(',', pos);
+        if (end == std::string::npos) end = s.size();
+        const std::string item = s.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty()) continue;
+        const std::size_t dash = item.find('-');
+        const int lo = std::stoi(item.substr(0, dash));
+        const int hi = dash == std::string::npos ? lo : std::stoi(item.substr(dash + 1));
+        for (int c = lo; c <= hi; ++c) out.push_back(c);
+    }
+    return out;
+}
+
+/// "48K", "2048K", "32M" as bytes.
+inline std::size_t parse_size(const std::string& s) {
+    if (s.empty()) return 0;
+    std::size_t digits = 0;
+    const std::size_t n = std::stoull(s, &digits);
+    switch (digits < s.size() ? s[digits] : '\0') {
+    case 'K': return n << 10;
+    case 'M': return n << 20;
+    case 'G': return n << 30;
+    default: return n;
+    }
+}
+
+/// CPUs in the calling thread's affinity mask (cgroup and taskset limits).
+inline std::vector<int> allowed_cpus() {
+    for (int count = CPU_SETSIZE;; count *= 2) {
+        cpu_set_t* set = CPU_ALLOC(count);
+        const std::size_t bytes = CPU_ALLOC_SIZE(count);
+        CPU_ZERO_S(bytes, set);
+        if (::sched_getaffinity(0, bytes, set) == 0) {
+            std::vector<int> out;
+            for (int c = 0; c < count; ++c)
+                if (CPU_ISSET_S(c, bytes, set)) out.push_back(c);
+            CPU_FREE(set);
+            return out;
+        }
+        const int error = errno;
+        CPU_FREE(set);
+        if (error != EINVAL || count >= (1 << 20))
+            throw std::system_error(error, std::system_category(), "sched_getaffinity");
+    }
+}
+
+}  // namespace detail::topology
+
+/// Cores, SMT siblings, caches and NUMA nodes of the machine, as read from
+/// sysfs and limited to the CPUs this process may run on.
+///
+/// `plan` turns a `pin_policy` into a CPU per thread and `pin_threads` applies
+/// it, so latency-sensitive threads stop being migrated by the scheduler:
+///
+///     auto topo = mo::cpu_topology::detect();
+///     mo::pin_threads(pool.threads(), mo::pin_policy::physical_cores, topo);
+///
+/// Without sysfs every CPU is reported as its own core on node 0.
+class cpu_topology {
+public:
+    /// Reads `<sysfs>/cpu` and `<sysfs>/node`. Throws `std::system_error`
+    /// only if the affinity mask cannot be read.
+    static cpu_topology detect(const std::string& sysfs = "/sys/devices/system") {
+        using namespace detail::topology;
+        cpu_topology t;
+        std::vector<int> online = parse_list(read_line(sysfs + "/cpu/online"));
+        std::vector<int> allowed = allowed_cpus();
+        if (online.empty()) online = allowed;
+        std::vector<int> usable;
+        std::set_intersection(online.begin(), online.end(), allowed.begin(), allowed.end(),
+                              std::back_inserter(usable));
+
+        std::map<int, int> node_of;
+        for (int node : parse_list(read_line(sysfs + "/node/online")))
+            for (int c : parse_list(read_line(sysfs + "/node/node" + std::to_string(node) + "/cpulist")))
+                node_of[c] = node;
+
+        std::map<std::pair<int, int>, int> core_index;  // (package, core_id) -> dense core
+        std::map<int, int> threads_on_core;
+        for (int id : usable) {
+            const std::string dir = sysfs + "/cpu/cpu" + std::to_string(id);
+            logical_cpu c;
+            c.id = id;
+            c.package = std::max(0, read_int(dir + "/topology/physical_package_id", 0));
+            const int core_id = read_int(dir + "/topology/core_id", id);
+            c.core = core_index.try_emplace({c.package, core_id}, static_cast<int>(core_index.size())).first->second;
+            c.smt = threads_on_core[c.core]++;
+            const auto node = node_of.find(id);
+            c.node = node == node_of.end() ? 0 : node->second;
+            t.cpus_.push_back(c);
+
+            for (int index = 0;; ++index) {
+                const std::string cache = dir + "/cache/index" + std::to_string(index);
+                const int level = read_int(cache + "/level", -1);
+                if (level < 0) break;
+                cpu_cache k;
+                k.level = level;
+                const std::string type = read_line(cache + "/type");
+                k.type = type == "Data" ? cache_type::data
+                         : type == "Instruction" ? cache_type::instruction
+                                                 : cache_type::unified;
+                k.size = parse_size(read_line(cache + "/size"));
+                k.line_size = static_cast<std::size_t>(std::max(0, read_int(cache + "/coherency_line_size", 0)));
+                k.cpus = parse_list(read_line(cache + "/shared_cpu_list"));
+                // Every sharing CPU lists the same instance; keep the first.
+                const bool seen = std::any_of(t.caches_.begin(), t.caches_.end(), [&](const cpu_cache& o) {
+                    return o.level == k.level && o.type == k.type && o.cpus == k.cpus;
+                });
+                if (!seen) t.caches_.push_back(std::move(k));
+            }
+        }
+        t.cores_ = core_index.size();
+        return t;
+    }
+
+    /// Usable CPUs in ascending id order.
+    const std::vector<logical_cpu>& cpus() const noexcept { return cpus_; }
+    const std::vector<cpu_cache>& caches() const noexcept { return caches_; }
+
+    std::size_t core_count() const noexcept { return cores_; }
+    std::size_t package_count() const { return distinct(&logical_cpu::package); }
+    std::size_t node_count() const { return distinct(&logical_cpu::node); }
+
+    /// Usable hardware threads on the same core as `cpu`, itself included.
+    std::vector<int> siblings(int cpu) const {
+        std::vector<int> out;
+        if (const logical_cpu* c = find(cpu))
+            for (const logical_cpu& o : cpus_)
+                if (o.core == c->core) out.push_back(o.id);
+        return out;
+    }
+
+    /// The cache of `level` and `type` that `cpu` uses, or null.
+    const cpu_cache* cache(int cpu, int level, cache_type type = cache_type::unified) const noexcept {
+        for (const cpu_cache& k : caches_)
+            if (k.level == level && k.type == type && std::find(k.cpus.begin(), k.cpus.end(), cpu) != k.cpus.end())
+                return &k;
+        return nullptr;
+    }
+
+    /// CPU ids for `count` threads under `policy`. With more threads than
+    /// usable CPUs the order repeats, oversubscribing from the start.
+    std::vector<int> plan(pin_policy policy, std::size_t count) const {
+        std::vector<logical_cpu> order = cpus_;
+        if (order.empty()) return {};
+        // Rank of each core within its node, for scatter.
+        std::map<int, int> rank, seen_per_node;
+        for (const logical_cpu& c : cpus_)
+            if (c.smt == 0) rank[c.core] = seen_per_node[c.node]++;
+
+        auto key = [&](const logical_cpu& c) {
+            switch (policy) {
+            case pin_policy::physical_cores: return std::tuple(c.smt, c.node, c.package, c.core);
+            case pin_policy::compact: return std::tuple(c.node, c.package, c.core, c.smt);
+            case pin_policy::scatter: break;
+            }
+            return std::tuple(c.smt, rank[c.core], c.node, c.package);
+        };
+        std::stable_sort(order.begin(), order.end(),
+                         [&](const logical_cpu& a, const logical_cpu& b) { return key(a) < key(b); });
+
+        std::vector<int> out(count);
+        for (std::size_t i = 0; i < count; ++i) out[i] = order[i % order.size()].id;
+        return out;
+    }
+
+private:
+    const logical_cpu* find(int cpu) const noexcept {
+        for (const logical_cpu& c : cpus_)
+            if (c.id == cpu) return &c;
+        return nullptr;
+    }
+
+    std::size_t distinct(int logical_cpu::*field) const {
+        std::vector<int> values;
+        for (const logical_cpu& c : cpus_) values.push_back(c.*field);
+        std::sort(values.begin(), values.end());
+        return static_cast<std::size_t>(std::unique(values.begin(), values.end()) - values.begin());
+    }
+
+    std::vector<logical_cpu> cpus_;
+    std::vector<cpu_cache> caches_;
+    std::size_t cores_ = 0;
+};
+
+/// Restricts `thread` to the given CPUs. Throws `std::system_error`.
+inline void pin_thread(std::thread::native_handle_type thread, std::span<const int> cpus) {
+    const int max = cpus.empty() ? 0 : *std::max_element(cpus.begin(), cpus.end());
+    cpu_set_t* set = CPU_ALLOC(max + 1);
+    const std::size_t bytes = CPU_ALLOC_SIZE(max + 1);
+    CPU_ZERO_S(bytes, set);
+    for (int c : cpus) CPU_SET_S(c, bytes, set);
+    const int error = ::pthread_setaffinity_np(thread, bytes, set);
+    CPU_FREE(set);
+    if (error != 0) throw std::system_error(error, std::system_category(), "pthread_setaffinity_np");
+}
+
+inline void pin_thread(std::thread& thread, int cpu) {
+    pin_thread(thread.native_handle(), std::span<const int>(&cpu, 1));
+}
+
+inline void pin_this_thread(int cpu) { pin_thread(::pthread_self(), std::span<const int>(&cpu, 1)); }
+
+/// Pins each of `threads` to one CPU chosen by `topology.plan(policy, ...)`
+/// and returns the CPUs in thread order.
+inline std::vector<int> pin_threads(std::span<std::thread> threads, pin_policy policy,
+                                    const cpu_topology& topology) {
+    std::vector<int> cpus = topology.plan(policy, threads.size());
+    for (std::size_t i = 0; i < cpus.size(); ++i) pin_thread(threads[i], cpus[i]);
+    return cpus;
+}
+
+inline std::vector<int> pin_threads(std::span<std::thread> threads, pin_policy policy) {
+    return pin_threads(threads, policy, cpu_topology::detect());
+}
+
+}  // namespace mo
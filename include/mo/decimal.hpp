@@ -0,0 +1,310 @@
+#pragma once
+
+#include <cmath>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace mo {
+
+/// Thrown on overflow, division by zero and malformed decimal text.
+class decimal_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/// How results with more fractional digits than the scale are rounded.
+enum class rounding {
+    half_even,  // to nearest, ties to even (banker's rounding)
+    half_up,    // to nearest, ties away from zero
+    down,       // toward zero
+};
+
+namespace detail::decimal {
+
+inline constexpr std::uint64_t pow10[] = {
+    1ull,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+    10000000000ull,
+    100000000000ull,
+    1000000000000ull,
+    10000000000000ull,
+    100000000000000ull,
+    1000000000000000ull,
+    10000000000000000ull,
+    100000000000000000ull,
+    1000000000000000000ull,
+};
+
+__extension__ typedef __int128 wide;
+
+constexpr bool fits(wide v) noexcept {
+    return v >= std::numeric_limits<std::int64_t>::min() && v <= std::numeric_limits<std::int64_t>::max();
+}
+
+template <typename I>
+constexpr I divide_as(I n, I d, rounding mode) noexcept {
+    I q = n / d;
+    const I r = n % d;
+    if (r == 0 || mode == rounding::down) return q;
+    // Compare |r| with d - |r| rather than 2|r| with d, which overflows for |r| > max/2.
+    const I r_abs = r < 0 ? -r : r;
+    const I rest = d - r_abs;
+    if (r_abs > rest || (r_abs == rest && (mode == rounding::half_up || (q & 1) != 0))) q += n < 0 ? -1 : 1;
+    return q;
+}
+
+/// n / d rounded per `mode`; `d` must be positive. Stays in 64 bits when the
+/// operands allow, since 128-bit division is a library call.
+constexpr wide divide(wide n, wide d, rounding mode) noexcept {
+    if (fits(n) && fits(d))
+        return divide_as<std::int64_t>(static_cast<std::int64_t>(n), static_cast<std::int64_t>(d), mode);
+    return divide_as<wide>(n, d, mode);
+}
+
+constexpr std::int64_t narrow(wide v) {
+    if (!fits(v)) throw decimal_error("decimal overflow");
+    return static_cast<std::int64_t>(v);
+}
+
+}  // namespace detail::decimal
+
+/// Fixed-point decimal: a signed 64-bit count of units of 10^-Scale.
+///
+/// `decimal64<4>` holds prices to a hundredth of a cent with about 18
+/// significant digits. Arithmetic is exact or rounded by a stated rule, never
+/// binary floating point; every operation that can overflow checks and
+/// throws `decimal_error`. Products and quotients go through a 128-bit
+/// intermediate and round half-even unless a `rounding` is given.
+template <unsigned Scale>
+class decimal64 {
+    static_assert(Scale <= 18, "decimal64 supports at most 18 fractional digits");
+    using wide = detail::decimal::wide;
+
+public:
+    using rep = std::int64_t;
+    static constexpr unsigned scale = Scale;
+    static constexpr rep unit = static_cast<rep>(detail::decimal::pow10[Scale]);
+
+    constexpr decimal64() noexcept = default;
+
+    /// Exact conversion from an integer.
+    template <std::integral I>
+    constexpr explicit decimal64(I value) : raw_(detail::decimal::narrow(wide{value} * unit)) {}
+
+    static constexpr decimal64 from_raw(rep raw) noexcept {
+        decimal64 d;
+        d.raw_ = raw;
+        return d;
+    }
+
+    /// Nearest decimal to `value`, ties away from zero. Throws on NaN,
+    /// infinity or overflow.
+    static decimal64 from_double(double value) {
+        if (!std::isfinite(value)) throw decimal_error("decimal overflow");
+        // |value| is m * 2^e with a 53-bit integer m, so |value| * unit is the
+        // exact 128-bit m * unit shifted by e. Rounding `value * unit` in
+        // double first would decide ties on an already-rounded product.
+        int e;
+        const double fraction = std::frexp(std::fabs(value), &e);
+        const wide n = static_cast<wide>(std::ldexp(fraction, 53)) * unit;  // below 2^113
+        e -= 53;
+        constexpr wide limit = wide{1} << 63;
+        wide magnitude;
+        if (e >= 0)
+            magnitude = n != 0 && (e >= 63 || n >= (limit >> e)) ? limit : n << e;
+        else
+            magnitude = -e > 114 ? 0 : (n + (wide{1} << (-e - 1))) >> -e;  // half away from zero
+        if (magnitude >= limit) throw decimal_error("decimal overflow");
+        return from_raw(value < 0 ? -static_cast<rep>(magnitude) : static_cast<rep>(magnitude));
+    }
+
+    constexpr rep raw() const noexcept { return raw_; }
+    double to_double() const noexcept { return static_cast<double>(raw_) / static_cast<double>(unit); }
+
+    /// Integer part, truncated toward zero.
+    constexpr rep integer_part() const noexcept { return raw_ / unit; }
+
+    /// The same value at another scale, rounded when digits are dropped.
+    template <unsigned To>
+    constexpr decimal64<To> rescale(rounding mode = rounding::half_even) const {
+        if constexpr (To >= Scale)
+            return decimal64<To>::from_raw(
+                detail::decimal::narrow(wide{raw_} * static_cast<wide>(detail::decimal::pow10[To - Scale])));
+        else
+            return decimal64<To>::from_raw(static_cast<rep>(
+                detail::decimal::divide(raw_, static_cast<wide>(detail::decimal::pow10[Scale - To]), mode)));
+    }
+
+    friend constexpr auto operator<=>(decimal64, decimal64) noexcept = default;
+
+    constexpr decimal64 operator-() const {
+        if (raw_ == std::numeric_limits<rep>::min()) throw decimal_error("decimal overflow");
+        return from_raw(-raw_);
+    }
+    constexpr decimal64 operator+() const noexcept { return *this; }
+
+    friend constexpr decimal64 operator+(decimal64 a, decimal64 b) {
+        rep r;
+        if (__builtin_add_overflow(a.raw_, b.raw_, &r)) throw decimal_error("decimal overflow");
+        return from_raw(r);
+    }
+
+    friend constexpr decimal64 operator-(decimal64 a, decimal64 b) {
+        rep r;
+        if (__builtin_sub_overflow(a.raw_, b.raw_, &r)) throw decimal_error("decimal overflow");
+        return from_raw(r);
+    }
+
+    friend constexpr decimal64 operator*(decimal64 a, decimal64 b) { return multiply(a, b); }
+    friend constexpr decimal64 operator/(decimal64 a, decimal64 b) { return divide(a, b); }
+
+    template <std::integral I>
+    friend constexpr decimal64 operator*(decimal64 a, I n) {
+        rep r;
+        if (__builtin_mul_overflow(a.raw_, n, &r)) throw decimal_error("decimal overflow");
+        return from_raw(r);
+    }
+    template <std::integral I>
+    friend constexpr decimal64 operator*(I n, decimal64 a) {
+        return a * n;
+    }
+    template <std::integral I>
+    friend constexpr decimal64 operator/(decimal64 a, I n) {
+        return divide(a, n);
+    }
+
+    constexpr decimal64& operator+=(decimal64 b) { return *this = *this + b; }
+    constexpr decimal64& operator-=(decimal64 b) { return *this = *this - b; }
+    constexpr decimal64& operator*=(decimal64 b) { return *this = *this * b; }
+    constexpr decimal64& operator/=(decimal64 b) { return *this = *this / b; }
+    template <std::integral I>
+    constexpr decimal64& operator*=(I n) {
+        return *this = *this * n;
+    }
+    template <std::integral I>
+    constexpr decimal64& operator/=(I n) {
+        return *this = *this / n;
+    }
+
+    friend constexpr decimal64 multiply(decimal64 a, decimal64 b, rounding mode = rounding::half_even) {
+        return from_raw(
+            detail::decimal::narrow(detail::decimal::divide(wide{a.raw_} * b.raw_, wide{unit}, mode)));
+    }
+
+    friend constexpr decimal64 divide(decimal64 a, decimal64 b, rounding mode = rounding::half_even) {
+        return quotient(wide{a.raw_} * unit, b.raw_, mode);
+    }
+
+    template <std::integral I>
+    friend constexpr decimal64 divide(decimal64 a, I n, rounding mode = rounding::half_even) {
+        return quotient(wide{a.raw_}, static_cast<wide>(n), mode);
+    }
+
+    /// Parses `[+-]digits[.digits]` (either side of the point may be empty,
+    /// not both). Extra fractional digits are rounded per `mode`. Returns
+    /// nothing on malformed input or overflow.
+    static constexpr std::optional<decimal64> try_parse(std::string_view s,
+                                                        rounding mode = rounding::half_even) noexcept {
+        std::size_t i = 0;
+        const bool negative = i < s.size() && s[i] == '-';
+        if (i < s.size() && (s[i] == '-' || s[i] == '+')) ++i;
+
+        // The magnitude only grows digit by digit, so it is rejected as soon
+        // as it passes 2^63 and otherwise stays exact in 64 bits. The first
+        // 18 digits cannot get there and skip the check.
+        constexpr std::uint64_t limit = std::uint64_t{1} << 63;
+        std::uint64_t mantissa = 0;
+        std::size_t used = 0;
+        const auto append = [&](char c) {
+            const auto d = static_cast<std::uint64_t>(c - '0');
+            if (++used > 18 && mantissa > (limit - d) / 10) return false;
+            mantissa = mantissa * 10 + d;
+            return true;
+        };
+
+        std::size_t digits = 0, fraction = 0;
+        for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i, ++digits)
+            if (!append(s[i])) return std::nullopt;
+        int round_digit = -1;  // first dropped digit
+        bool sticky = false;   // any nonzero dropped digit after it
+        if (i < s.size() && s[i] == '.') {
+            for (++i; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i, ++digits) {
+                if (fraction < Scale) {
+                    if (!append(s[i])) return std::nullopt;
+                    ++fraction;
+                } else if (round_digit < 0) {
+                    round_digit = s[i] - '0';
+                } else {
+                    sticky |= s[i] != '0';
+                }
+            }
+        }
+        if (i != s.size() || digits == 0) return std::nullopt;
+
+        if (__builtin_mul_overflow(mantissa, detail::decimal::pow10[Scale - fraction], &mantissa))
+            return std::nullopt;
+        if (round_digit > 0 && mode != rounding::down) {
+            const bool up = round_digit > 5 || (round_digit == 5 && (sticky || mode == rounding::half_up ||
+                                                                     (mantissa & 1) != 0));
+            mantissa += up;
+        }
+        if (mantissa > limit - !negative) return std::nullopt;
+        return from_raw(static_cast<rep>(negative ? 0 - mantissa : mantissa));
+    }
+
+    static constexpr decimal64 parse(std::string_view s, rounding mode = rounding::half_even) {
+        if (auto d = try_parse(s, mode)) return *d;
+        throw decimal_error("invalid decimal: " + std::string(s));
+    }
+
+    /// Longest text `to_chars` produces: sign, 19 digits, point.
+    static constexpr std::size_t max_chars = 21;
+
+    /// Writes the value with exactly `Scale` fractional digits (no exponent)
+    /// to `out`, which needs `max_chars` bytes, and returns the end.
+    constexpr char* to_chars(char* out) const noexcept {
+        char buf[max_chars];
+        char* p = buf + max_chars;
+        std::uint64_t u = raw_ < 0 ? 0 - static_cast<std::uint64_t>(raw_) : static_cast<std::uint64_t>(raw_);
+        for (unsigned k = 0; k < Scale; ++k, u /= 10) *--p = static_cast<char>('0' + u % 10);
+        if constexpr (Scale > 0) *--p = '.';
+        do {
+            *--p = static_cast<char>('0' + u % 10);
+            u /= 10;
+        } while (u);
+        if (raw_ < 0) *--p = '-';
+        for (; p != buf + max_chars; ++p) *out++ = *p;
+        return out;
+    }
+
+    std::string to_string() const {
+        char buf[max_chars];
+        return std::string(buf, to_chars(buf));
+    }
+
+private:
+    static constexpr decimal64 quotient(wide n, wide d, rounding mode) {
+        if (d == 0) throw decimal_error("decimal division by zero");
+        if (d < 0) n = -n, d = -d;
+        return from_raw(detail::decimal::narrow(detail::decimal::divide(n, d, mode)));
+    }
+
+    rep raw_ = 0;
+};
+
+}  // namespace mo
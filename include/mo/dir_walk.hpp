@@ -0,0 +1,376 @@
+#pragma once
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mo {
+
+enum class entry_type : std::uint8_t { unknown, regular, directory, symlink, other };
+
+/// One entry found by `walk_directory`; the views are valid during the
+/// visitor call only.
+struct dir_entry {
+    std::string_view path;  // root-relative path joined onto the root, e.g. "src/mo/json.hpp"
+    std::string_view name;  // last component of `path`
+    entry_type type = entry_type::unknown;
+    std::uint64_t inode = 0;
+    int depth = 1;  // children of the root are at depth 1
+};
+
+/// Called with the path and error of a directory or file that could not be
+/// opened or read; the walk or read skips it and goes on.
+using fs_error_handler = std::function<void(std::string_view path, std::error_code error)>;
+
+struct walk_options {
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    int max_depth = -1;            // deepest entries reported (0: none, 1: the root's children); -1 for no limit
+    bool include_hidden = true;    // entries whose name starts with '.'
+    bool follow_symlinks = false;  // descend into symlinked directories, each directory once
+    fs_error_handler on_error;     // default: skip silently
+};
+
+struct read_options {
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t batch = 16;  // files each thread opens and starts reading ahead at once
+    fs_error_handler on_error;
+};
+
+namespace detail::walk {
+
+// Records getdents64 fills the buffer with (struct linux_dirent64): u64
+// inode, s64 offset, u16 record length, u8 type, NUL-terminated name.
+inline constexpr std::size_t dirent_reclen = 16, dirent_type = 18, dirent_name = 19;
+
+inline entry_type from_dtype(unsigned char t) noexcept {
+    switch (t) {
+    case DT_REG: return entry_type::regular;
+    case DT_DIR: return entry_type::directory;
+    case DT_LNK: return entry_type::symlink;
+    case DT_UNKNOWN: return entry_type::unknown;
+    default: return entry_type::other;
+    }
+}
+
+inline entry_type from_mode(mode_t m) noexcept {
+    if (S_ISREG(m)) return entry_type::regular;
+    if (S_ISDIR(m)) return entry_type::directory;
+    if (S_ISLNK(m)) return entry_type::symlink;
+    return entry_type::other;
+}
+
+inline void report(const fs_error_handler& handler, std::string_view path, int error) {
+    if (handler) handler(path, std::error_code(error, std::system_category()));
+}
+
+template <typename F>
+bool visit(F& visitor, const dir_entry& e) {
+    if constexpr (std::is_void_v<std::invoke_result_t<F&, const dir_entry&>>) {
+        visitor(e);
+        return true;
+    } else {
+        return static_cast<bool>(visitor(e));
+    }
+}
+
+/// Shared state of one walk: a LIFO of directories still to read, so
+/// threads go depth-first and the pending set stays small.
+struct walk_state {
+    struct pending {
+        std::string path;
+        int depth;
+    };
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<pending> stack;
+    std::size_t busy = 0;  // threads reading a directory, which may push more
+    bool stopped = false;
+    std::exception_ptr error;
+    std::set<std::pair<dev_t, ino_t>> seen;  // directories entered, when following symlinks
+
+    bool pop(pending& out) {
+        std::unique_lock lock(mutex);
+        ready.wait(lock, [&] { return stopped || !stack.empty() || busy == 0; });
+        if (stopped || stack.empty()) return false;
+        out = std::move(stack.back());
+        stack.pop_back();
+        ++busy;
+        return true;
+    }
+
+    void finish(std::vector<pending>& found) {
+        {
+            std::lock_guard lock(mutex);
+            for (pending& p : found) stack.push_back(std::move(p));
+            --busy;
+        }
+        found.clear();
+        ready.notify_all();
+    }
+
+    void fail(std::exception_ptr e) {
+        {
+            std::lock_guard lock(mutex);
+            if (!error) error = std::move(e);
+            stopped = true;
+            --busy;
+        }
+        ready.notify_all();
+    }
+
+    bool first_visit(int fd) {
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) return true;
+        std::lock_guard lock(mutex);
+        return seen.insert({st.st_dev, st.st_ino}).second;
+    }
+};
+
+/// Closes a directory fd however `read_dir` leaves, visitor exceptions included.
+struct fd_closer {
+    int fd;
+    ~fd_closer() { ::close(fd); }
+};
+
+template <typename F>
+void read_dir(walk_state& state, const walk_state::pending& dir, const walk_options& options, F& visitor,
+              std::vector<char>& buf, std::vector<walk_state::pending>& found) {
+    if (options.max_depth >= 0 && dir.depth >= options.max_depth) return;  // its entries would be too deep
+    const int fd = ::open(dir.path.empty() ? "." : dir.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return report(options.on_error, dir.path, errno);
+    const fd_closer closer{fd};
+    if (options.follow_symlinks && !state.first_visit(fd)) return;
+    std::string path = dir.path;
+    if (!path.empty() && path.back() != '/') path += '/';
+    const std::size_t prefix = path.size();
+    const bool descend = options.max_depth < 0 || dir.depth + 1 < options.max_depth;  // children of found dirs still in range
+    for (;;) {
+        const long n = ::syscall(SYS_getdents64, fd, buf.data(), buf.size());
+        if (n < 0) {
+            report(options.on_error, dir.path, errno);
+            break;
+        }
+        if (n == 0) break;
+        for (long off = 0; off < n;) {
+            const char* d = buf.data() + off;
+            std::uint64_t inode;
+            unsigned short reclen;
+            std::memcpy(&inode, d, 8);
+            std::memcpy(&reclen, d + dirent_reclen, 2);
+            off += reclen;
+            const char* cname = d + dirent_name;
+            const std::string_view name = cname;
+            if (name == "." || name == ".." || (!options.include_hidden && name[0] == '.')) continue;
+            entry_type type = from_dtype(static_cast<unsigned char>(d[dirent_type]));
+            const bool follow = options.follow_symlinks && type == entry_type::symlink;
+            if (type == entry_type::unknown || follow) {
+                // Filesystems without d_type (and symlinks we may follow) need a stat.
+                struct stat st {};
+                if (::fstatat(fd, cname, &st, follow ? 0 : AT_SYMLINK_NOFOLLOW) == 0) type = from_mode(st.st_mode);
+            }
+            path.resize(prefix);
+            path += name;
+            dir_entry e{path, std::string_view(path).substr(prefix), type, inode, dir.depth + 1};
+            if (visit(visitor, e) && type == entry_type::directory && descend)
+                found.push_back({path, dir.depth + 1});
+        }
+    }
+}
+
+template <typename F>
+void walk_worker(walk_state& state, const walk_options& options, F& visitor) {
+    // Large enough for a few hundred entries per syscall.
+    std::vector<char> buf(64 * 1024);
+    std::vector<walk_state::pending> found;
+    walk_state::pending dir;
+    while (state.pop(dir)) {
+        try {
+            read_dir(state, dir, options, visitor, buf, found);
+        } catch (...) {
+            state.fail(std::current_exception());
+            return;
+        }
+        state.finish(found);
+    }
+}
+
+/// Grow-only read buffer: unlike std::string, growing does not zero it.
+struct read_buffer {
+    std::unique_ptr<char[]> data;
+    std::size_t capacity = 0;
+
+    void reserve(std::size_t n) {
+        if (n <= capacity) return;
+        capacity = std::max(n, capacity * 2);
+        data = std::make_unique_for_overwrite<char[]>(capacity);
+    }
+};
+
+/// Reads all of `fd` into `buf` and returns the size, or -errno.
+inline long long read_all(int fd, std::size_t size_hint, read_buffer& buf) {
+    buf.reserve(std::max<std::size_t>(size_hint + 1, 4096));
+    std::size_t done = 0;
+    for (;;) {
+        if (done == buf.capacity) {
+            // File grew, or reports no size (procfs): grow keeping what was read.
+            auto bigger = std::make_unique_for_overwrite<char[]>(buf.capacity * 2);
+            std::memcpy(bigger.get(), buf.data.get(), done);
+            buf.data = std::move(bigger);
+            buf.capacity *= 2;
+        }
+        const ssize_t n = ::read(fd, buf.data.get() + done, buf.capacity - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        if (n == 0) return static_cast<long long>(done);
+        done += static_cast<std::size_t>(n);
+    }
+}
+
+}  // namespace detail::walk
+
+/// Walks the tree under `root` with `options.threads` threads (the caller
+/// among them), calling `visitor(const dir_entry&)` for every entry but
+/// the root. The visitor runs concurrently on several threads and must be
+/// thread-safe; for a directory, returning false skips its contents
+/// (a void visitor descends everywhere). Order is unspecified.
+///
+/// Directories are read with getdents64 into a 64 KiB buffer, a few
+/// hundred entries per syscall, and the entry type comes from the
+/// directory itself, so unlike `recursive_directory_iterator` the walk
+/// costs no stat per entry (except on filesystems that do not report
+/// types). Unreadable directories go to `options.on_error`; an exception
+/// from the visitor stops the walk and is rethrown here.
+template <typename F>
+void walk_directory(const std::string& root, F&& visitor, const walk_options& options = {}) {
+    detail::walk::walk_state state;
+    state.stack.push_back({root, 0});
+    std::vector<std::thread> helpers;
+    const std::size_t threads = std::max<std::size_t>(options.threads, 1);
+    helpers.reserve(threads - 1);
+    for (std::size_t i = 1; i < threads; ++i)
+        helpers.emplace_back([&] { detail::walk::walk_worker(state, options, visitor); });
+    detail::walk::walk_worker(state, options, visitor);
+    for (std::thread& t : helpers) t.join();
+    if (state.error) std::rethrow_exception(state.error);
+}
+
+/// Every entry under `root` that `keep` accepts (default: regular files),
+/// sorted by path.
+inline std::vector<std::string> list_files(
+    const std::string& root, const walk_options& options = {},
+    const std::function<bool(const dir_entry&)>& keep = [](const dir_entry& e) {
+        return e.type == entry_type::regular;
+    }) {
+    std::mutex mutex;
+    std::vector<std::string> out;
+    walk_directory(
+        root,
+        [&](const dir_entry& e) {
+            if (keep(e)) {
+                std::lock_guard lock(mutex);
+                out.emplace_back(e.path);
+            }
+        },
+        options);
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+/// Reads each file of `paths` whole and calls `on_file(index, contents)`,
+/// concurrently from `options.threads` threads; `contents` is valid during
+/// the call only.
+///
+/// Each thread takes `options.batch` files at a time, opens them all and
+/// starts kernel readahead on every one before reading the first, so the
+/// device sees a queue of requests instead of one synchronous read per
+/// file. Files are read into a reused per-thread buffer, without the
+/// allocation and locale overhead of `std::ifstream`. Files that cannot be
+/// opened or read go to `options.on_error`; an exception from `on_file`
+/// stops the remaining work and is rethrown here.
+template <typename F>
+void read_files(std::span<const std::string> paths, F&& on_file, const read_options& options = {}) {
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> stopped{false};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    const std::size_t batch = std::max<std::size_t>(options.batch, 1);
+
+    auto work = [&] {
+        detail::walk::read_buffer buf;
+        std::vector<std::pair<int, std::size_t>> open;  // fd, size
+        try {
+            while (!stopped.load(std::memory_order_relaxed)) {
+                const std::size_t first = next.fetch_add(batch, std::memory_order_relaxed);
+                if (first >= paths.size()) break;
+                const std::size_t last = std::min(first + batch, paths.size());
+                open.clear();
+                for (std::size_t i = first; i < last; ++i) {
+                    const int fd = ::open(paths[i].c_str(), O_RDONLY | O_CLOEXEC);
+                    std::size_t size = 0;
+                    if (fd < 0) {
+                        detail::walk::report(options.on_error, paths[i], errno);
+                    } else {
+                        struct stat st {};
+                        if (::fstat(fd, &st) == 0) size = static_cast<std::size_t>(st.st_size);
+                        if (size) ::readahead(fd, 0, size);
+                    }
+                    open.emplace_back(fd, size);
+                }
+                for (std::size_t i = first; i < last; ++i) {
+                    const auto [fd, size] = open[i - first];
+                    if (fd < 0) continue;
+                    const long long n = detail::walk::read_all(fd, size, buf);
+                    ::close(fd);
+                    open[i - first].first = -1;
+                    if (n < 0) {
+                        detail::walk::report(options.on_error, paths[i], static_cast<int>(-n));
+                        continue;
+                    }
+                    on_file(i, std::string_view(buf.data.get(), static_cast<std::size_t>(n)));
+                }
+            }
+        } catch (...) {
+            for (const auto& [fd, size] : open)
+                if (fd >= 0) ::close(fd);
+            stopped.store(true, std::memory_order_relaxed);
+            std::lock_guard lock(error_mutex);
+            if (!error) error = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    const std::size_t threads = std::clamp<std::size_t>(options.threads, 1, std::max<std::size_t>(paths.size(), 1));
+    helpers.reserve(threads - 1);
+    for (std::size_t i = 1; i < threads; ++i) helpers.emplace_back(work);
+    work();
+    for (std::thread& t : helpers) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
+}  // namespace mo
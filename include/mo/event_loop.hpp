@@ -0,0 +1,932 @@
+#pragma once
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mo/function.hpp"
+
+namespace mo {
+
+/// Result of one operation delivered by an `event_loop`.
+struct completion {
+    /// Bytes transferred, accepted fd or poll revents on success; `-errno` on failure.
+    int result;
+    /// Received payload. Points into a loop-owned buffer that is recycled as
+    /// soon as the handler returns: consume or copy it, never keep the span.
+    std::span<const std::byte> data;
+    /// True while the operation stays armed and will complete again.
+    bool more;
+};
+
+/// Move-only, so handlers may own their buffers or connection state; small
+/// captures are stored without allocating.
+using completion_handler = unique_function<void(const completion&)>;
+using op_id = std::uint64_t;
+
+struct event_loop_options {
+    unsigned queue_depth = 256;
+    /// Receive buffers shared by all `recv` operations; must be a power of two.
+    unsigned buffer_count = 256;
+    unsigned buffer_size = 16 * 1024;
+};
+
+enum class event_backend { automatic, epoll, io_uring };
+
+/// Completion-based socket event loop.
+///
+/// Every operation reports through its handler from inside `run_once()`,
+/// never inline from the call that started it. `accept`, `recv` and `poll`
+/// are multishot: they stay armed (`completion::more`) until they fail, the
+/// peer closes (`recv` result 0) or they are cancelled. A failed `accept`
+/// (including per-connection errors such as `ECONNABORTED` or `EMFILE`) is
+/// final; call `accept` again to keep listening. After `cancel()` the
+/// handler runs exactly once more with `more == false` (normally
+/// `-ECANCELED`), at which point any buffer passed to `send` may be released.
+///
+/// Each fd may carry at most one of `accept`/`recv`/`poll` at a time (another
+/// fails with `-EBUSY`) plus any number of queued sends, which complete in
+/// submission order. Sends never
+/// raise `SIGPIPE`: writing to a closed peer fails with `-EPIPE`. fds handed to
+/// the loop are switched to non-blocking mode. Not thread-safe.
+class event_loop {
+public:
+    virtual ~event_loop() = default;
+
+    virtual event_backend backend() const noexcept = 0;
+
+    /// Accepts connections on a listening socket; each result is a new
+    /// non-blocking, close-on-exec fd.
+    virtual op_id accept(int listen_fd, completion_handler handler) = 0;
+    /// Receives into loop-owned buffers until EOF or error.
+    virtual op_id recv(int fd, completion_handler handler) = 0;
+    /// Sends all of `data`, which must stay alive until the final completion.
+    virtual op_id send(int fd, std::span<const std::byte> data, completion_handler handler) = 0;
+    /// Sends `len` bytes at `offset` of a buffer registered with `register_buffers`.
+    virtual op_id send_fixed(int fd, unsigned buf_index, std::size_t offset, std::size_t len,
+                             completion_handler handler) = 0;
+    /// Reports readiness (`EPOLLIN`, `EPOLLOUT`, ...) without performing I/O.
+    virtual op_id poll(int fd, std::uint32_t events, completion_handler handler) = 0;
+    virtual void cancel(op_id id) = 0;
+
+    /// Pins user buffers for `send_fixed`, replacing any earlier set. Must not
+    /// be called while `send_fixed` operations are in flight.
+    virtual void register_buffers(std::span<const iovec> buffers) = 0;
+
+    /// Submits queued work, waits up to `timeout_ms` (-1 = forever) for at
+    /// least one completion, dispatches everything available and returns the
+    /// number of handler invocations.
+    virtual std::size_t run_once(int timeout_ms = -1) = 0;
+};
+
+namespace detail {
+
+enum class op_kind : std::uint8_t { accept, recv, send, send_fixed, poll };
+
+/// Slot map from `op_id` to operation state. Ids carry a generation so a
+/// stale id (e.g. a late completion after reuse) never matches a new op.
+/// Slots live in a deque so references survive inserts made by handlers.
+template <typename Op>
+class op_table {
+public:
+    op_id insert(Op op) {
+        std::uint32_t index;
+        if (free_.empty()) {
+            index = static_cast<std::uint32_t>(slots_.size());
+            slots_.emplace_back();
+        } else {
+            index = free_.back();
+            free_.pop_back();
+        }
+        slot& s = slots_[index];
+        s.op = std::move(op);
+        s.live = true;
+        return (static_cast<op_id>(s.generation) << 32) | index;
+    }
+
+    Op* find(op_id id) noexcept {
+        const auto index = static_cast<std::uint32_t>(id);
+        if (index >= slots_.size()) return nullptr;
+        slot& s = slots_[index];
+        return s.live && s.generation == static_cast<std::uint32_t>(id >> 32) ? &s.op : nullptr;
+    }
+
+    /// Removes the op and returns its handler so it can be invoked after the
+    /// slot is gone (the handler may then start new operations freely).
+    completion_handler erase(op_id id) {
+        slot& s = slots_[static_cast<std::uint32_t>(id)];
+        completion_handler handler = std::move(s.op.handler);
+        s.op = Op{};
+        s.live = false;
+        ++s.generation;
+        free_.push_back(static_cast<std::uint32_t>(id));
+        return handler;
+    }
+
+private:
+    struct slot {
+        Op op{};
+        std::uint32_t generation = 1;
+        bool live = false;
+    };
+
+    std::deque<slot> slots_;
+    std::vector<std::uint32_t> free_;
+};
+
+inline void set_nonblocking(int fd) {
+    const int flags = ::fcntl(fd, F_GETFL);
+    if (flags >= 0 && !(flags & O_NONBLOCK)) ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+}  // namespace detail
+
+/// Readiness-based backend: performs the I/O itself when epoll reports the fd ready.
+class epoll_loop final : public event_loop {
+public:
+    explicit epoll_loop(const event_loop_options& options = {})
+        : epfd_(::epoll_create1(EPOLL_CLOEXEC)),
+          events_(options.queue_depth),
+          buffer_(options.buffer_size) {
+        if (epfd_ < 0) throw std::system_error(errno, std::system_category(), "epoll_create1");
+    }
+    ~epoll_loop() override { ::close(epfd_); }
+
+    epoll_loop(const epoll_loop&) = delete;
+    epoll_loop& operator=(const epoll_loop&) = delete;
+
+    event_backend backend() const noexcept override { return event_backend::epoll; }
+
+    op_id accept(int listen_fd, completion_handler handler) override {
+        return add_reader(listen_fd, {detail::op_kind::accept, listen_fd, std::move(handler), {}, 0, EPOLLIN});
+    }
+
+    op_id recv(int fd, completion_handler handler) override {
+        return add_reader(fd, {detail::op_kind::recv, fd, std::move(handler), {}, 0, EPOLLIN | EPOLLRDHUP});
+    }
+
+    op_id poll(int fd, std::uint32_t events, completion_handler handler) override {
+        return add_reader(fd, {detail::op_kind::poll, fd, std::move(handler), {}, 0, events});
+    }
+
+    op_id send(int fd, std::span<const std::byte> data, completion_handler handler) override {
+        detail::set_nonblocking(fd);
+        const op_id id = ops_.insert({detail::op_kind::send, fd, std::move(handler), data, 0, 0});
+        auto it = fds_.find(fd);
+        if (it == fds_.end() || it->second.writers.empty()) {
+            // Fast path: most sends fit in the socket buffer right away.
+            if (auto done = try_send(*ops_.find(id))) {
+                defer(id, *done);
+                return id;
+            }
+        }
+        fds_[fd].writers.push_back(id);
+        if (int err = update_interest(fd)) fail_writers(fd, err);
+        return id;
+    }
+
+    op_id send_fixed(int fd, unsigned buf_index, std::size_t offset, std::size_t len,
+                     completion_handler handler) override {
+        if (buf_index >= registered_.size() || offset + len > registered_[buf_index].iov_len) {
+            const op_id id = ops_.insert({detail::op_kind::send_fixed, fd, std::move(handler), {}, 0, 0});
+            defer(id, -EINVAL);
+            return id;
+        }
+        const auto* base = static_cast<const std::byte*>(registered_[buf_index].iov_base);
+        return send(fd, {base + offset, len}, std::move(handler));
+    }
+
+    void cancel(op_id id) override {
+        op* o = ops_.find(id);
+        if (!o || o->cancelled) return;
+        o->cancelled = true;
+        detach(id, *o);
+        defer(id, -ECANCELED);
+    }
+
+    void register_buffers(std::span<const iovec> buffers) override {
+        registered_.assign(buffers.begin(), buffers.end());
+    }
+
+    std::size_t run_once(int timeout_ms = -1) override {
+        const int wait_ms = deferred_.empty() ? timeout_ms : 0;
+        int ready = ::epoll_wait(epfd_, events_.data(), static_cast<int>(events_.size()), wait_ms);
+        if (ready < 0) {
+            if (errno != EINTR) throw std::system_error(errno, std::system_category(), "epoll_wait");
+            ready = 0;
+        }
+        std::size_t dispatched = run_deferred();
+        for (int i = 0; i < ready; ++i) dispatched += on_event(events_[i].data.fd, events_[i].events);
+        return dispatched;
+    }
+
+private:
+    struct op {
+        detail::op_kind kind;
+        int fd;
+        completion_handler handler;
+        std::span<const std::byte> data;
+        std::size_t done;
+        std::uint32_t events;
+        bool cancelled = false;
+    };
+
+    struct fd_state {
+        op_id reader = 0;
+        std::deque<op_id> writers;
+        std::uint32_t armed = 0;
+    };
+
+    struct deferred_completion {
+        op_id id;
+        int result;
+    };
+
+    op_id add_reader(int fd, op o) {
+        detail::set_nonblocking(fd);
+        const op_id id = ops_.insert(std::move(o));
+        fd_state& st = fds_[fd];
+        if (st.reader) {
+            defer(id, -EBUSY);
+            return id;
+        }
+        st.reader = id;
+        if (int err = update_interest(fd)) {
+            fds_[fd].reader = 0;
+            update_interest(fd);
+            defer(id, -err);
+        }
+        return id;
+    }
+
+    /// Brings the epoll registration for `fd` in line with its pending ops.
+    /// Returns 0 or the errno from epoll_ctl.
+    int update_interest(int fd) {
+        auto it = fds_.find(fd);
+        if (it == fds_.end()) return 0;
+        fd_state& st = it->second;
+        std::uint32_t want = st.writers.empty() ? 0u : std::uint32_t{EPOLLOUT};
+        if (st.reader) want |= ops_.find(st.reader)->events;
+        int err = 0;
+        if (want != st.armed) {
+            epoll_event ev{};
+            ev.events = want;
+            ev.data.fd = fd;
+            const int ctl = st.armed == 0 ? EPOLL_CTL_ADD : want == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+            if (::epoll_ctl(epfd_, ctl, fd, &ev) == 0)
+                st.armed = want;
+            else
+                err = errno;
+        }
+        if (st.armed == 0 && !st.reader && st.writers.empty()) fds_.erase(it);
+        return err;
+    }
+
+    void detach(op_id id, const op& o) {
+        auto it = fds_.find(o.fd);
+        if (it == fds_.end()) return;
+        fd_state& st = it->second;
+        if (st.reader == id) {
+            st.reader = 0;
+        } else {
+            for (auto w = st.writers.begin(); w != st.writers.end(); ++w) {
+                if (*w == id) {
+                    st.writers.erase(w);
+                    break;
+                }
+            }
+        }
+        update_interest(o.fd);
+    }
+
+    void defer(op_id id, int result) { deferred_.push_back({id, result}); }
+
+    std::size_t run_deferred() {
+        std::vector<deferred_completion> batch;
+        batch.swap(deferred_);
+        for (const deferred_completion& d : batch) {
+            if (ops_.find(d.id)) ops_.erase(d.id)(completion{d.result, {}, false});
+        }
+        return batch.size();
+    }
+
+    /// Completes a multishot op for good and detaches it from its fd.
+    void finish(op_id id, int result) {
+        detach(id, *ops_.find(id));
+        ops_.erase(id)(completion{result, {}, false});
+    }
+
+    std::optional<int> try_send(op& o) {
+        while (o.done < o.data.size()) {
+            const ssize_t n = ::send(o.fd, o.data.data() + o.done, o.data.size() - o.done, MSG_NOSIGNAL);
+            if (n >= 0) {
+                o.done += static_cast<std::size_t>(n);
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return std::nullopt;
+            } else if (errno != EINTR) {
+                return -errno;
+            }
+        }
+        return static_cast<int>(o.done);
+    }
+
+    void fail_writers(int fd, int err) {
+        auto it = fds_.find(fd);
+        if (it == fds_.end()) return;
+        std::deque<op_id> writers;
+        writers.swap(it->second.writers);
+        update_interest(fd);
+        for (op_id id : writers) defer(id, -err);
+    }
+
+    std::size_t flush_writers(int fd) {
+        std::size_t dispatched = 0;
+        for (;;) {
+            auto it = fds_.find(fd);
+            if (it == fds_.end() || it->second.writers.empty()) break;
+            const op_id id = it->second.writers.front();
+            auto done = try_send(*ops_.find(id));
+            if (!done) break;
+            it->second.writers.pop_front();
+            update_interest(fd);
+            ops_.erase(id)(completion{*done, {}, false});
+            ++dispatched;
+        }
+        return dispatched;
+    }
+
+    std::size_t on_event(int fd, std::uint32_t revents) {
+        std::size_t dispatched = 0;
+        if (revents & (EPOLLOUT | EPOLLERR | EPOLLHUP)) dispatched += flush_writers(fd);
+
+        auto it = fds_.find(fd);
+        if (it == fds_.end() || !it->second.reader) return dispatched;
+        const op_id id = it->second.reader;
+        op* o = ops_.find(id);
+        if (!(revents & (o->events | EPOLLERR | EPOLLHUP))) return dispatched;
+        switch (o->kind) {
+        case detail::op_kind::accept:
+            // Drain the backlog; the handler may cancel us between accepts.
+            while (ops_.find(id) && !ops_.find(id)->cancelled) {
+                const int client = ::accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (client < 0 && errno == EINTR) continue;
+                if (client < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                ++dispatched;
+                if (client < 0) {
+                    finish(id, -errno);
+                    break;
+                }
+                ops_.find(id)->handler(completion{client, {}, true});
+            }
+            break;
+        case detail::op_kind::recv: {
+            const ssize_t n = ::recv(fd, buffer_.data(), buffer_.size(), 0);
+            if (n > 0) {
+                o->handler(completion{static_cast<int>(n), {buffer_.data(), static_cast<std::size_t>(n)}, true});
+            } else if (n == 0) {
+                finish(id, 0);
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                break;
+            } else {
+                finish(id, -errno);
+            }
+            ++dispatched;
+            break;
+        }
+        case detail::op_kind::poll:
+            o->handler(completion{static_cast<int>(revents & (o->events | EPOLLERR | EPOLLHUP)), {}, true});
+            ++dispatched;
+            break;
+        default:
+            break;
+        }
+        return dispatched;
+    }
+
+    int epfd_;
+    std::vector<epoll_event> events_;
+    std::vector<std::byte> buffer_;
+    detail::op_table<op> ops_;
+    std::unordered_map<int, fd_state> fds_;
+    std::vector<deferred_completion> deferred_;
+    std::vector<iovec> registered_;
+};
+
+/// Completion-based backend on io_uring, driven through the raw syscalls.
+///
+/// Submissions are batched and flushed in one `io_uring_enter` per
+/// `run_once()`. `recv` uses multishot receive into a provided-buffer ring,
+/// so the kernel picks a buffer only when data arrives and no per-socket
+/// buffer is reserved; `accept` and `poll` are multishot as well. `send_fixed`
+/// is a zero-copy send from the registered buffer (Linux 6.0+; older kernels
+/// get a plain copying send of the same bytes) and completes once the kernel
+/// has released the buffer. Requires Linux 5.19 or newer; the constructor
+/// throws `std::system_error` when the kernel lacks a feature.
+class uring_loop final : public event_loop {
+public:
+    explicit uring_loop(const event_loop_options& options = {})
+        : buffer_count_(options.buffer_count), buffer_size_(options.buffer_size) {
+        if (buffer_count_ == 0 || (buffer_count_ & (buffer_count_ - 1)) || buffer_count_ > 32768)
+            throw std::system_error(EINVAL, std::system_category(), "buffer_count must be a power of two");
+        setup_ring(options.queue_depth);
+        try {
+            setup_buffer_ring();
+            send_zc_ = supports(IORING_OP_SEND_ZC);
+        } catch (...) {
+            teardown();
+            throw;
+        }
+    }
+    ~uring_loop() override { teardown(); }
+
+    uring_loop(const uring_loop&) = delete;
+    uring_loop& operator=(const uring_loop&) = delete;
+
+    event_backend backend() const noexcept override { return event_backend::io_uring; }
+
+    op_id accept(int listen_fd, completion_handler handler) override {
+        return add_reader(make_op(detail::op_kind::accept, listen_fd, std::move(handler)));
+    }
+
+    op_id recv(int fd, completion_handler handler) override {
+        return add_reader(make_op(detail::op_kind::recv, fd, std::move(handler)));
+    }
+
+    op_id poll(int fd, std::uint32_t events, completion_handler handler) override {
+        op o = make_op(detail::op_kind::poll, fd, std::move(handler));
+        o.events = events;
+        return add_reader(std::move(o));
+    }
+
+    op_id send(int fd, std::span<const std::byte> data, completion_handler handler) override {
+        detail::set_nonblocking(fd);
+        op o = make_op(detail::op_kind::send, fd, std::move(handler));
+        o.data = data;
+        return start(std::move(o));
+    }
+
+    op_id send_fixed(int fd, unsigned buf_index, std::size_t offset, std::size_t len,
+                     completion_handler handler) override {
+        op o = make_op(detail::op_kind::send_fixed, fd, std::move(handler));
+        if (buf_index >= registered_.size() || offset + len > registered_[buf_index].iov_len) {
+            const op_id id = ops_.insert(std::move(o));
+            nop(id, -EINVAL);
+            return id;
+        }
+        detail::set_nonblocking(fd);
+        o.data = {static_cast<const std::byte*>(registered_[buf_index].iov_base) + offset, len};
+        o.buf_index = static_cast<std::uint16_t>(buf_index);
+        return start(std::move(o));
+    }
+
+    void cancel(op_id id) override {
+        op* o = ops_.find(id);
+        if (!o || o->cancelled) return;
+        o->cancelled = true;
+        io_uring_sqe* sqe = next_sqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = id;
+        sqe->user_data = internal_tag;
+    }
+
+    void register_buffers(std::span<const iovec> buffers) override {
+        if (!registered_.empty()) sys_register(IORING_UNREGISTER_BUFFERS, nullptr, 0);
+        registered_.clear();
+        if (buffers.empty()) return;
+        if (sys_register(IORING_REGISTER_BUFFERS, buffers.data(), static_cast<unsigned>(buffers.size())) < 0)
+            throw std::system_error(errno, std::system_category(), "IORING_REGISTER_BUFFERS");
+        registered_.assign(buffers.begin(), buffers.end());
+    }
+
+    std::size_t run_once(int timeout_ms = -1) override {
+        const bool have_cqes = cq_ready() != 0;
+        enter(have_cqes ? 0 : timeout_ms);
+        std::size_t dispatched = 0;
+        std::uint32_t head = *cq_head_;
+        while (head != std::atomic_ref(*cq_tail_).load(std::memory_order_acquire)) {
+            const io_uring_cqe cqe = cqes_[head & cq_mask_];
+            std::atomic_ref(*cq_head_).store(++head, std::memory_order_release);
+            dispatched += dispatch(cqe);
+        }
+        return dispatched;
+    }
+
+private:
+    struct op {
+        detail::op_kind kind{};
+        int fd = -1;
+        completion_handler handler;
+        std::span<const std::byte> data;
+        std::size_t done = 0;
+        int zc_result = 0;  // result of a zero-copy send awaiting its notification
+        std::uint32_t events = 0;
+        std::uint16_t buf_index = 0;
+        bool cancelled = false;
+    };
+
+    static op make_op(detail::op_kind kind, int fd, completion_handler handler) {
+        op o;
+        o.kind = kind;
+        o.fd = fd;
+        o.handler = std::move(handler);
+        return o;
+    }
+
+    static constexpr std::uint64_t internal_tag = ~std::uint64_t{0};
+    static constexpr std::uint16_t buffer_group = 0;
+
+    static int sys_setup(unsigned entries, io_uring_params* p) {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+    }
+
+    int sys_register(unsigned opcode, const void* arg, unsigned nr) {
+        return static_cast<int>(::syscall(__NR_io_uring_register, ring_fd_, opcode, arg, nr));
+    }
+
+    void setup_ring(unsigned depth) {
+        io_uring_params p{};
+        p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+        p.cq_entries = depth * 4;  // multishot ops can post many CQEs per SQE
+        ring_fd_ = sys_setup(depth, &p);
+        if (ring_fd_ < 0 && errno == EINVAL) {
+            p = io_uring_params{};
+            ring_fd_ = sys_setup(depth, &p);
+        }
+        if (ring_fd_ < 0) throw std::system_error(errno, std::system_category(), "io_uring_setup");
+        if (!(p.features & IORING_FEAT_EXT_ARG) || !(p.features & IORING_FEAT_NODROP)) {
+            ::close(ring_fd_);
+            ring_fd_ = -1;
+            throw std::system_error(ENOSYS, std::system_category(), "io_uring too old");
+        }
+
+        sq_ring_size_ = p.sq_off.array + p.sq_entries * sizeof(std::uint32_t);
+        cq_ring_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        single_mmap_ = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap_) sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+        sq_ring_ = map_ring(sq_ring_size_, IORING_OFF_SQ_RING);
+        cq_ring_ = single_mmap_ ? sq_ring_ : map_ring(cq_ring_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map_ring(sqes_size_, IORING_OFF_SQES));
+
+        auto* sq = static_cast<std::byte*>(sq_ring_);
+        sq_head_ = reinterpret_cast<std::uint32_t*>(sq + p.sq_off.head);
+        sq_ktail_ = reinterpret_cast<std::uint32_t*>(sq + p.sq_off.tail);
+        sq_flags_ = reinterpret_cast<std::uint32_t*>(sq + p.sq_off.flags);
+        sq_mask_ = *reinterpret_cast<std::uint32_t*>(sq + p.sq_off.ring_mask);
+        sq_entries_ = p.sq_entries;
+        sq_tail_ = *sq_ktail_;
+        auto* array = reinterpret_cast<std::uint32_t*>(sq + p.sq_off.array);
+        for (std::uint32_t i = 0; i < sq_entries_; ++i) array[i] = i;
+
+        auto* cq = static_cast<std::byte*>(cq_ring_);
+        cq_head_ = reinterpret_cast<std::uint32_t*>(cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<std::uint32_t*>(cq + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<std::uint32_t*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+    }
+
+    bool supports(unsigned opcode) {
+        // io_uring_probe ends in a flexible array; lay the ops out by hand.
+        alignas(io_uring_probe) std::byte buf[sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op)]{};
+        if (sys_register(IORING_REGISTER_PROBE, buf, 256) < 0) return false;
+        const auto* probe = reinterpret_cast<const io_uring_probe*>(buf);
+        const auto* ops = reinterpret_cast<const io_uring_probe_op*>(buf + sizeof(io_uring_probe));
+        return opcode <= probe->last_op && (ops[opcode].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    void* map_ring(std::size_t size, std::uint64_t offset) {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                         static_cast<off_t>(offset));
+        if (p == MAP_FAILED) {
+            const int err = errno;
+            teardown();
+            throw std::system_error(err, std::system_category(), "mmap io_uring");
+        }
+        return p;
+    }
+
+    void setup_buffer_ring() {
+        buf_ring_size_ = buffer_count_ * sizeof(io_uring_buf);
+        void* ring = ::mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ring == MAP_FAILED) throw std::system_error(errno, std::system_category(), "mmap buffer ring");
+        buf_ring_ = static_cast<io_uring_buf_ring*>(ring);
+
+        buffers_size_ = std::size_t{buffer_count_} * buffer_size_;
+        void* pool = ::mmap(nullptr, buffers_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pool == MAP_FAILED) throw std::system_error(errno, std::system_category(), "mmap buffers");
+        buffers_ = static_cast<std::byte*>(pool);
+
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<std::uint64_t>(buf_ring_);
+        reg.ring_entries = buffer_count_;
+        reg.bgid = buffer_group;
+        if (sys_register(IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+            throw std::system_error(errno, std::system_category(), "IORING_REGISTER_PBUF_RING");
+
+        for (unsigned bid = 0; bid < buffer_count_; ++bid) add_buffer(static_cast<std::uint16_t>(bid));
+        publish_buffers();
+    }
+
+    void add_buffer(std::uint16_t bid) noexcept {
+        // Index through io_uring_buf directly: under C++ the header's
+        // __DECLARE_FLEX_ARRAY places `bufs` past an empty struct, not at 0.
+        io_uring_buf& b = reinterpret_cast<io_uring_buf*>(buf_ring_)[buf_tail_ & (buffer_count_ - 1)];
+        b.addr = reinterpret_cast<std::uint64_t>(buffers_ + std::size_t{bid} * buffer_size_);
+        b.len = buffer_size_;
+        b.bid = bid;
+        ++buf_tail_;
+    }
+
+    void publish_buffers() noexcept {
+        std::atomic_ref(buf_ring_->tail).store(buf_tail_, std::memory_order_release);
+    }
+
+    void teardown() noexcept {
+        if (buffers_) ::munmap(buffers_, buffers_size_);
+        if (buf_ring_) ::munmap(buf_ring_, buf_ring_size_);
+        if (sqes_) ::munmap(sqes_, sqes_size_);
+        if (cq_ring_ && cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_ring_size_);
+        if (sq_ring_) ::munmap(sq_ring_, sq_ring_size_);
+        if (ring_fd_ >= 0) ::close(ring_fd_);
+        buffers_ = nullptr;
+        buf_ring_ = nullptr;
+        sqes_ = nullptr;
+        cq_ring_ = sq_ring_ = nullptr;
+        ring_fd_ = -1;
+    }
+
+    std::uint32_t cq_ready() const noexcept {
+        return std::atomic_ref(*cq_tail_).load(std::memory_order_acquire) - *cq_head_;
+    }
+
+    io_uring_sqe* next_sqe() {
+        if (sq_tail_ - std::atomic_ref(*sq_head_).load(std::memory_order_acquire) >= sq_entries_) enter(0);
+        io_uring_sqe* sqe = &sqes_[sq_tail_ & sq_mask_];
+        std::memset(sqe, 0, sizeof *sqe);
+        std::atomic_ref(*sq_ktail_).store(++sq_tail_, std::memory_order_release);
+        return sqe;
+    }
+
+    /// Flushes the submission queue and, when `timeout_ms` is non-zero, waits
+    /// for a completion. Always passes GETEVENTS so deferred task work runs.
+    void enter(int timeout_ms) {
+        const std::uint32_t to_submit = sq_tail_ - std::atomic_ref(*sq_head_).load(std::memory_order_acquire);
+        const bool need_taskrun = std::atomic_ref(*sq_flags_).load(std::memory_order_relaxed) & IORING_SQ_TASKRUN;
+        if (to_submit == 0 && timeout_ms == 0 && !need_taskrun) return;
+
+        __kernel_timespec ts{};
+        io_uring_getevents_arg arg{};
+        arg.sigmask_sz = _NSIG / 8;
+        if (timeout_ms > 0) {
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+        }
+        if (timeout_ms >= 0) arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+        const unsigned wait = timeout_ms != 0 ? 1 : 0;
+        const long rc = ::syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait,
+                                  IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof arg);
+        if (rc < 0 && errno != ETIME && errno != EINTR && errno != EBUSY && errno != EAGAIN)
+            throw std::system_error(errno, std::system_category(), "io_uring_enter");
+    }
+
+    op_id start(op o) {
+        const op_id id = ops_.insert(std::move(o));
+        arm(id, *ops_.find(id));
+        return id;
+    }
+
+    /// Starts an `accept`, `recv` or `poll`, or fails it with `-EBUSY` if
+    /// its fd already carries one, as in `epoll_loop`.
+    op_id add_reader(op o) {
+        detail::set_nonblocking(o.fd);
+        const int fd = o.fd;
+        if (readers_.contains(fd)) {
+            const op_id id = ops_.insert(std::move(o));
+            nop(id, -EBUSY);
+            return id;
+        }
+        const op_id id = start(std::move(o));
+        readers_[fd] = id;
+        return id;
+    }
+
+    void arm(op_id id, const op& o) {
+        io_uring_sqe* sqe = next_sqe();
+        sqe->fd = o.fd;
+        sqe->user_data = id;
+        switch (o.kind) {
+        case detail::op_kind::accept:
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+            sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+            break;
+        case detail::op_kind::recv:
+            sqe->opcode = IORING_OP_RECV;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = buffer_group;
+            break;
+        case detail::op_kind::poll:
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->len = IORING_POLL_ADD_MULTI;
+            sqe->poll32_events = o.events;
+            break;
+        case detail::op_kind::send:
+            sqe->opcode = IORING_OP_SEND;
+            sqe->addr = reinterpret_cast<std::uint64_t>(o.data.data() + o.done);
+            sqe->len = static_cast<std::uint32_t>(o.data.size() - o.done);
+            sqe->msg_flags = MSG_NOSIGNAL;
+            break;
+        case detail::op_kind::send_fixed:
+            // A socket send rather than WRITE_FIXED, which cannot take MSG_NOSIGNAL.
+            sqe->addr = reinterpret_cast<std::uint64_t>(o.data.data() + o.done);
+            sqe->len = static_cast<std::uint32_t>(o.data.size() - o.done);
+            sqe->msg_flags = MSG_NOSIGNAL;
+            if (send_zc_) {
+                sqe->opcode = IORING_OP_SEND_ZC;
+                sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+                sqe->buf_index = o.buf_index;
+            } else {
+                sqe->opcode = IORING_OP_SEND;
+            }
+            break;
+        }
+    }
+
+    /// Posts a completion for `id` through the ring so it is reported from
+    /// `run_once()` like any other result.
+    void nop(op_id id, int result) {
+        pending_results_.push_back({id, result});
+        io_uring_sqe* sqe = next_sqe();
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = internal_tag;
+    }
+
+    std::size_t finish(op_id id, int result) {
+        // Free the fd first: the handler may start its next reader.
+        if (auto it = readers_.find(ops_.find(id)->fd); it != readers_.end() && it->second == id) readers_.erase(it);
+        ops_.erase(id)(completion{result, {}, false});
+        return 1;
+    }
+
+    std::size_t dispatch(const io_uring_cqe& cqe) {
+        if (cqe.user_data == internal_tag) {
+            std::size_t dispatched = 0;
+            std::vector<std::pair<op_id, int>> results;
+            results.swap(pending_results_);
+            for (auto [id, result] : results) dispatched += finish(id, result);
+            return dispatched;
+        }
+
+        const bool more = cqe.flags & IORING_CQE_F_MORE;
+        std::span<const std::byte> data;
+        int bid = -1;
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            bid = static_cast<int>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (cqe.res > 0) data = {buffers_ + std::size_t(bid) * buffer_size_, static_cast<std::size_t>(cqe.res)};
+        }
+        struct recycle_guard {
+            uring_loop* loop;
+            int bid;
+            ~recycle_guard() {
+                if (bid >= 0) {
+                    loop->add_buffer(static_cast<std::uint16_t>(bid));
+                    loop->publish_buffers();
+                }
+            }
+        } recycle{this, bid};
+
+        const op_id id = cqe.user_data;
+        op* o = ops_.find(id);
+        if (!o) return 0;
+        int res = cqe.res;
+        if (o->kind == detail::op_kind::send_fixed && send_zc_) {
+            // SEND_ZC posts its result flagged MORE, then a NOTIF once the
+            // kernel is done with the buffer; act on the result only then.
+            if (!(cqe.flags & IORING_CQE_F_NOTIF)) {
+                o->zc_result = res;
+                if (more) return 0;
+            }
+            res = o->zc_result;
+        }
+        if (o->cancelled) {
+            if (more) return 0;
+            if (o->kind == detail::op_kind::send || o->kind == detail::op_kind::send_fixed)
+                return finish(id, res < 0 ? res : static_cast<int>(o->done + res));
+            return finish(id, -ECANCELED);
+        }
+
+        switch (o->kind) {
+        case detail::op_kind::send:
+        case detail::op_kind::send_fixed:
+            if (res < 0) return finish(id, res);
+            o->done += static_cast<std::size_t>(res);
+            if (res > 0 && o->done < o->data.size()) {
+                arm(id, *o);  // short write: send the rest
+                return 0;
+            }
+            return finish(id, static_cast<int>(o->done));
+        case detail::op_kind::recv:
+            if (cqe.res == -ENOBUFS) {
+                // Every provided buffer is in use; multishot stops. Buffers go
+                // back to the ring after each handler, so re-arm straight away.
+                arm(id, *o);
+                return 0;
+            }
+            if (cqe.res <= 0) return finish(id, cqe.res);
+            break;
+        case detail::op_kind::poll:
+        case detail::op_kind::accept:
+            if (cqe.res < 0) return finish(id, cqe.res);
+            break;
+        }
+
+        // Multishot delivery. The kernel may end a multishot op on its own
+        // (e.g. CQ pressure); re-arm so callers see one continuous stream.
+        o->handler(completion{cqe.res, data, true});
+        if (!more) {
+            if (op* again = ops_.find(id); again && !again->cancelled) arm(id, *again);
+        }
+        return 1;
+    }
+
+    int ring_fd_ = -1;
+    bool single_mmap_ = false;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    std::size_t sq_ring_size_ = 0;
+    std::size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    std::size_t sqes_size_ = 0;
+
+    std::uint32_t* sq_head_ = nullptr;
+    std::uint32_t* sq_ktail_ = nullptr;
+    std::uint32_t* sq_flags_ = nullptr;
+    std::uint32_t sq_mask_ = 0;
+    std::uint32_t sq_entries_ = 0;
+    std::uint32_t sq_tail_ = 0;
+
+    std::uint32_t* cq_head_ = nullptr;
+    std::uint32_t* cq_tail_ = nullptr;
+    std::uint32_t cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    unsigned buffer_count_;
+    unsigned buffer_size_;
+    io_uring_buf_ring* buf_ring_ = nullptr;
+    std::size_t buf_ring_size_ = 0;
+    std::byte* buffers_ = nullptr;
+    std::size_t buffers_size_ = 0;
+    std::uint16_t buf_tail_ = 0;
+
+    bool send_zc_ = false;
+    detail::op_table<op> ops_;
+    std::unordered_map<int, op_id> readers_;  // the accept, recv or poll on each fd
+    std::vector<std::pair<op_id, int>> pending_results_;
+    std::vector<iovec> registered_;
+};
+
+/// Creates an event loop, preferring io_uring and falling back to epoll when
+/// io_uring is unavailable (old kernel, seccomp, `io_uring_disabled` sysctl).
+inline std::unique_ptr<event_loop> make_event_loop(const event_loop_options& options = {},
+                                                   event_backend backend = event_backend::automatic) {
+    switch (backend) {
+    case event_backend::epoll:
+        return std::make_unique<epoll_loop>(options);
+    case event_backend::io_uring:
+        return std::make_unique<uring_loop>(options);
+    case event_backend::automatic:
+        break;
+    }
+    try {
+        return std::make_unique<uring_loop>(options);
+    } catch (const std::system_error&) {
+        return std::make_unique<epoll_loop>(options);
+    }
+}
+
+}  // namespace mo
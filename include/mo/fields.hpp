@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/// Declares a type's fields, in order, for code that walks structs field by
+/// field (`serialize.hpp`, `soa.hpp`). Use inside the class body; required
+/// for non-aggregates, aggregates with C-array members and aggregates with
+/// more than 24 members, optional otherwise:
+///
+///     struct order { std::uint64_t id; std::string_view symbol; double px;
+///                    MO_FIELDS(id, symbol, px) };
+#define MO_FIELDS(...)                                                  \
+    auto mo_fields() { return std::tie(__VA_ARGS__); }                  \
+    auto mo_fields() const { return std::tie(__VA_ARGS__); }
+
+namespace mo {
+
+namespace detail::fields {
+
+template <typename T>
+concept has_fields = requires(T& t) { t.mo_fields(); };
+
+// Aggregate introspection: count members by probing brace-initialisation
+// with placeholders, then bind them with structured bindings.
+struct any_field {
+    template <typename T>
+    operator T() const;  // never defined, only used in unevaluated context
+};
+
+template <typename T, std::size_t... I>
+constexpr bool brace_constructible(std::index_sequence<I...>) {
+    return requires { T{(static_cast<void>(I), any_field{})...}; };
+}
+
+template <typename T, std::size_t N = 24>
+constexpr std::size_t field_count() {
+    if constexpr (N == 0)
+        return 0;
+    else if constexpr (brace_constructible<T>(std::make_index_sequence<N>{}))
+        return N;
+    else
+        return field_count<T, N - 1>();
+}
+
+template <typename T>
+auto tie_aggregate(T& obj) {
+    constexpr std::size_t n = field_count<std::remove_const_t<T>>();
+    static_assert(n > 0, "type is not an aggregate with named fields; add MO_FIELDS");
+    // clang-format off
+    if constexpr (n == 1) { auto& [a] = obj; return std::tie(a); }
+    else if constexpr (n == 2) { auto& [a, b] = obj; return std::tie(a, b); }
+    else if constexpr (n == 3) { auto& [a, b, c] = obj; return std::tie(a, b, c); }
+    else if constexpr (n == 4) { auto& [a, b, c, d] = obj; return std::tie(a, b, c, d); }
+    else if constexpr (n == 5) { auto& [a, b, c, d, e] = obj; return std::tie(a, b, c, d, e); }
+    else if constexpr (n == 6) { auto& [a, b, c, d, e, f] = obj; return std::tie(a, b, c, d, e, f); }
+    else if constexpr (n == 7) { auto& [a, b, c, d, e, f, g] = obj; return std::tie(a, b, c, d, e, f, g); }
+    else if constexpr (n == 8) { auto& [a, b, c, d, e, f, g, h] = obj; return std::tie(a, b, c, d, e, f, g, h); }
+    else if constexpr (n == 9) { auto& [a, b, c, d, e, f, g, h, i] = obj; return std::tie(a, b, c, d, e, f, g, h, i); }
+    else if constexpr (n == 10) { auto& [a, b, c, d, e, f, g, h, i, j] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j); }
+    else if constexpr (n == 11) { auto& [a, b, c, d, e, f, g, h, i, j, k] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k); }
+    else if constexpr (n == 12) { auto& [a, b, c, d, e, f, g, h, i, j, k, l] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l); }
+    else if constexpr (n == 13) { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m); }
+    else if constexpr (n == 14) { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o); }
+    else if constexpr (n == 15) { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p); }
+    else if constexpr (n == 16) { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q); }
+    else if constexpr (n == 17) { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r); }
+    else if constexpr (n == 18) { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s); }
+    else if constexpr (n == 19) { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t); }
+    else if constexpr (n == 20) { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u); }
+    else if constexpr (n == 21) { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u, v] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u, v); }
+    else if constexpr (n == 22) { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u, v, w] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u, v, w); }
+    else if constexpr (n == 23) { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u, v, w, x] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u, v, w, x); }
+    else { auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u, v, w, x, y] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u, v, w, x, y); }
+    // clang-format on
+}
+
+// Instantiate the widest branch so a broken binding list cannot go unnoticed.
+struct widest_aggregate {
+    int m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22;
+    double m23;
+};
+static_assert(std::tuple_size_v<decltype(tie_aggregate(std::declval<widest_aggregate&>()))> == 24);
+static_assert(std::is_same_v<std::tuple_element_t<23, decltype(tie_aggregate(std::declval<widest_aggregate&>()))>,
+                             double&>);
+
+/// References to every field of `v`, as a `std::tuple` of lvalue references.
+template <typename T>
+auto fields_of(T& v) {
+    if constexpr (has_fields<T>)
+        return v.mo_fields();
+    else
+        return tie_aggregate(v);
+}
+
+template <typename Tuple>
+struct decayed;
+template <typename... Fs>
+struct decayed<std::tuple<Fs...>> {
+    using type = std::tuple<std::remove_cvref_t<Fs>...>;
+};
+
+/// `std::tuple` of the decayed field types of `T`.
+template <typename T>
+using field_types = typename decayed<decltype(fields_of(std::declval<T&>()))>::type;
+
+}  // namespace detail::fields
+
+}  // namespace mo
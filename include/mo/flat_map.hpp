@@ -0,0 +1,716 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mo {
+
+/// How a `flat_map` or `flat_set` orders its arrays.
+enum class flat_layout {
+    /// Key order: branch-free binary search, cheapest inserts and erases.
+    sorted,
+    /// Eytzinger (BFS) order: the implicit binary tree's top levels share
+    /// a few cache lines and each step's children are prefetched, so
+    /// lookups in maps larger than L1 miss far less. Iteration still
+    /// visits keys in order; inserts and erases rebuild the arrays.
+    eytzinger,
+};
+
+/// Tag for constructors whose input is already sorted and free of duplicates.
+struct sorted_unique_t {
+    explicit sorted_unique_t() = default;
+};
+inline constexpr sorted_unique_t sorted_unique{};
+
+namespace detail::flat {
+
+/// Lookups by a type other than the key need a transparent comparator, as
+/// in the standard containers; the `const Key&` overloads take the rest,
+/// converting the argument once.
+template <typename Compare>
+concept transparent = requires { typename Compare::is_transparent; };
+
+template <flat_layout Layout>
+struct layout;
+
+template <>
+struct layout<flat_layout::sorted> {
+    static std::size_t first(std::size_t) noexcept { return 0; }
+    static std::size_t next(std::size_t p, std::size_t) noexcept { return p + 1; }
+    static std::size_t prev(std::size_t p, std::size_t) noexcept { return p - 1; }
+    static std::size_t position_of(std::size_t rank, std::size_t) noexcept { return rank; }
+    static std::size_t rank_of(std::size_t p, std::size_t) noexcept { return p; }
+
+    template <typename V>
+    static void to_storage(std::vector<V>&) {}
+    template <typename V>
+    static void to_sorted(std::vector<V>&) {}
+
+    /// First position whose key fails `before` (keys before it pass), or `n`.
+    template <typename Key, typename Before>
+    static std::size_t partition_point(const Key* keys, std::size_t n, Before before) {
+        const Key* base = keys;
+        while (n > 1) {
+            const std::size_t half = n / 2;
+            base += static_cast<std::size_t>(before(base[half - 1])) * half;  // no branch to mispredict
+            n -= half;
+        }
+        return static_cast<std::size_t>(base - keys) + (n == 1 && before(*base));
+    }
+};
+
+/// Positions 0..n-1 hold tree nodes 1..n: node k's children are 2k and
+/// 2k+1, and position n stands for the end.
+template <>
+struct layout<flat_layout::eytzinger> {
+    static std::size_t first(std::size_t n) noexcept {
+        std::size_t k = 1;
+        while (2 * k <= n) k *= 2;
+        return k <= n ? k - 1 : n;
+    }
+
+    static std::size_t next(std::size_t p, std::size_t n) noexcept {
+        std::size_t k = p + 1;
+        if (2 * k + 1 <= n) {
+            k = 2 * k + 1;
+            while (2 * k <= n) k *= 2;
+            return k - 1;
+        }
+        while (k & 1) k >>= 1;  // climb while a right child
+        k >>= 1;
+        return k != 0 ? k - 1 : n;
+    }
+
+    static std::size_t prev(std::size_t p, std::size_t n) noexcept {
+        std::size_t k = p + 1;
+        if (p == n) {  // end: the rightmost node
+            k = 1;
+            while (2 * k + 1 <= n) k = 2 * k + 1;
+            return k - 1;
+        }
+        if (2 * k <= n) {
+            k = 2 * k;
+            while (2 * k + 1 <= n) k = 2 * k + 1;
+            return k - 1;
+        }
+        while (k != 0 && !(k & 1)) k >>= 1;  // climb while a left child
+        k >>= 1;
+        return k - 1;
+    }
+
+    static std::size_t position_of(std::size_t rank, std::size_t n) noexcept {
+        std::size_t p = first(n);
+        while (rank-- != 0) p = next(p, n);
+        return p;
+    }
+
+    static std::size_t rank_of(std::size_t p, std::size_t n) noexcept {
+        std::size_t rank = 0;
+        for (std::size_t q = first(n); q != p; q = next(q, n)) ++rank;
+        return rank;
+    }
+
+    /// Reorders an array in key order into tree order.
+    template <typename V>
+    static void to_storage(std::vector<V>& v) {
+        const std::size_t n = v.size();
+        std::vector<std::size_t> rank(n);
+        std::size_t r = 0;
+        for (std::size_t p = first(n); p != n; p = next(p, n)) rank[p] = r++;
+        std::vector<V> out;
+        out.reserve(n);
+        for (std::size_t p = 0; p < n; ++p) out.push_back(std::move(v[rank[p]]));
+        v = std::move(out);
+    }
+
+    template <typename V>
+    static void to_sorted(std::vector<V>& v) {
+        const std::size_t n = v.size();
+        std::vector<V> out;
+        out.reserve(n);
+        for (std::size_t p = first(n); p != n; p = next(p, n)) out.push_back(std::move(v[p]));
+        v = std::move(out);
+    }
+
+    template <typename Key, typename Before>
+    static std::size_t partition_point(const Key* keys, std::size_t n, Before before) {
+        // Node k's descendants `ahead` levels' worth of fan-out down, nodes
+        // ahead*k .. ahead*k+ahead-1, fill one cache line: fetching it now
+        // hides the miss behind the comparisons in between.
+        constexpr std::size_t ahead = sizeof(Key) <= 16 ? 64 / sizeof(Key) : 0;
+        std::size_t k = 1;
+        while (k <= n) {
+            if constexpr (ahead != 0) {
+                if (ahead * k <= n) __builtin_prefetch(keys + ahead * k - 1);
+            }
+            k = 2 * k + static_cast<std::size_t>(before(keys[k - 1]));
+        }
+        // Undo the trailing right turns plus the last left turn.
+        k >>= std::countr_one(k) + 1;
+        return k != 0 ? k - 1 : n;
+    }
+};
+
+/// Sorts `keys` (and `values` alongside, if not null) and drops later
+/// duplicates, so the first occurrence of each key wins like `insert`.
+template <typename Key, typename T, typename Compare>
+void sort_unique(std::vector<Key>& keys, std::vector<T>* values, const Compare& comp) {
+    const std::size_t n = keys.size();
+    if (n < 2) return;
+    bool sorted = true;
+    for (std::size_t i = 1; i < n && sorted; ++i) sorted = comp(keys[i - 1], keys[i]);
+    if (sorted) return;
+
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return comp(keys[a], keys[b]); });
+    std::size_t unique = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (unique == 0 || comp(keys[order[unique - 1]], keys[order[i]])) order[unique++] = order[i];
+    }
+    order.resize(unique);
+
+    std::vector<Key> k;
+    k.reserve(unique);
+    for (std::size_t i : order) k.push_back(std::move(keys[i]));
+    keys = std::move(k);
+    if (values) {
+        std::vector<T> v;
+        v.reserve(unique);
+        for (std::size_t i : order) v.push_back(std::move((*values)[i]));
+        *values = std::move(v);
+    }
+}
+
+template <typename Key, typename Compare>
+void check_sorted_unique(const std::vector<Key>& keys, const Compare& comp) {
+    for (std::size_t i = 1; i < keys.size(); ++i) {
+        if (!comp(keys[i - 1], keys[i])) throw std::invalid_argument("flat container: keys not sorted and unique");
+    }
+}
+
+}  // namespace detail::flat
+
+/// Sorted associative container over two contiguous arrays, keys and
+/// values, for small-to-medium read-mostly maps (configuration, symbol
+/// tables, routing): lookups touch only the key array, a fraction of the
+/// cache lines `std::map` chases through, and there is no per-node
+/// allocation.
+///
+/// Build in bulk: the constructors sort and deduplicate once. `insert`,
+/// `try_emplace` and `erase` are O(n) moves, fine for occasional updates.
+/// Iterators yield `std::pair<const Key&, T&>` in key order and are
+/// invalidated by every insert and erase.
+template <typename Key, typename T, typename Compare = std::less<Key>, flat_layout Layout = flat_layout::sorted>
+class flat_map {
+    using order = detail::flat::layout<Layout>;
+
+    template <bool Const>
+    class basic_iterator {
+        using mapped_ref = std::conditional_t<Const, const T&, T&>;
+        using map_ptr = std::conditional_t<Const, const flat_map*, flat_map*>;
+
+    public:
+        using iterator_concept = std::bidirectional_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<Key, T>;
+        using reference = std::pair<const Key&, mapped_ref>;
+        using difference_type = std::ptrdiff_t;
+
+        struct pointer {
+            reference ref;
+            const reference* operator->() const noexcept { return &ref; }
+        };
+
+        basic_iterator() = default;
+        basic_iterator(map_ptr map, std::size_t pos) noexcept : map_(map), pos_(pos) {}
+        operator basic_iterator<true>() const noexcept
+            requires(!Const)
+        {
+            return {map_, pos_};
+        }
+
+        reference operator*() const noexcept { return {map_->keys_[pos_], map_->values_[pos_]}; }
+        pointer operator->() const noexcept { return {**this}; }
+
+        basic_iterator& operator++() noexcept {
+            pos_ = order::next(pos_, map_->size());
+            return *this;
+        }
+        basic_iterator operator++(int) noexcept {
+            basic_iterator old = *this;
+            ++*this;
+            return old;
+        }
+        basic_iterator& operator--() noexcept {
+            pos_ = order::prev(pos_, map_->size());
+            return *this;
+        }
+        basic_iterator operator--(int) noexcept {
+            basic_iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept {
+            return a.pos_ == b.pos_;
+        }
+
+    private:
+        friend class flat_map;
+        map_ptr map_ = nullptr;
+        std::size_t pos_ = 0;
+    };
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using size_type = std::size_t;
+    using key_compare = Compare;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    flat_map() = default;
+    explicit flat_map(const Compare& comp) : comp_(comp) {}
+
+    /// Parallel arrays in any order; of duplicate keys the first wins.
+    flat_map(std::vector<Key> keys, std::vector<T> values, const Compare& comp = Compare())
+        : keys_(std::move(keys)), values_(std::move(values)), comp_(comp) {
+        if (keys_.size() != values_.size()) throw std::invalid_argument("flat_map: key and value counts differ");
+        detail::flat::sort_unique(keys_, &values_, comp_);
+        to_storage();
+    }
+
+    flat_map(sorted_unique_t, std::vector<Key> keys, std::vector<T> values, const Compare& comp = Compare())
+        : keys_(std::move(keys)), values_(std::move(values)), comp_(comp) {
+        if (keys_.size() != values_.size()) throw std::invalid_argument("flat_map: key and value counts differ");
+        detail::flat::check_sorted_unique(keys_, comp_);
+        to_storage();
+    }
+
+    template <std::input_iterator It>
+    flat_map(It first, It last, const Compare& comp = Compare()) : comp_(comp) {
+        if constexpr (std::forward_iterator<It>) {
+            const auto n = static_cast<std::size_t>(std::distance(first, last));
+            keys_.reserve(n);
+            values_.reserve(n);
+        }
+        for (; first != last; ++first) {
+            auto&& [k, v] = *first;
+            keys_.push_back(k);
+            values_.push_back(v);
+        }
+        detail::flat::sort_unique(keys_, &values_, comp_);
+        to_storage();
+    }
+
+    flat_map(std::initializer_list<value_type> init, const Compare& comp = Compare())
+        : flat_map(init.begin(), init.end(), comp) {}
+
+    iterator begin() noexcept { return {this, order::first(size())}; }
+    const_iterator begin() const noexcept { return {this, order::first(size())}; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    iterator end() noexcept { return {this, size()}; }
+    const_iterator end() const noexcept { return {this, size()}; }
+    const_iterator cend() const noexcept { return end(); }
+
+    bool empty() const noexcept { return keys_.empty(); }
+    std::size_t size() const noexcept { return keys_.size(); }
+    key_compare key_comp() const { return comp_; }
+
+    /// The arrays in storage order: key order for `flat_layout::sorted`.
+    const std::vector<Key>& keys() const noexcept { return keys_; }
+    const std::vector<T>& values() const noexcept { return values_; }
+
+    iterator find(const Key& key) { return {this, find_pos(key)}; }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    iterator find(const K& key) {
+        return {this, find_pos(key)};
+    }
+    const_iterator find(const Key& key) const { return {this, find_pos(key)}; }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const_iterator find(const K& key) const {
+        return {this, find_pos(key)};
+    }
+
+    bool contains(const Key& key) const { return find_pos(key) != size(); }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    bool contains(const K& key) const {
+        return find_pos(key) != size();
+    }
+
+    std::size_t count(const Key& key) const { return contains(key) ? 1 : 0; }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    std::size_t count(const K& key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    /// Pointer to the value for `key`, or null: one lookup, no iterator.
+    const T* get(const Key& key) const {
+        const std::size_t p = find_pos(key);
+        return p != size() ? &values_[p] : nullptr;
+    }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const T* get(const K& key) const {
+        const std::size_t p = find_pos(key);
+        return p != size() ? &values_[p] : nullptr;
+    }
+    T* get(const Key& key) {
+        const std::size_t p = find_pos(key);
+        return p != size() ? &values_[p] : nullptr;
+    }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    T* get(const K& key) {
+        const std::size_t p = find_pos(key);
+        return p != size() ? &values_[p] : nullptr;
+    }
+
+    const T& at(const Key& key) const {
+        if (const T* v = get(key)) return *v;
+        throw std::out_of_range("flat_map::at: key not found");
+    }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const T& at(const K& key) const {
+        if (const T* v = get(key)) return *v;
+        throw std::out_of_range("flat_map::at: key not found");
+    }
+    T& at(const Key& key) {
+        if (T* v = get(key)) return *v;
+        throw std::out_of_range("flat_map::at: key not found");
+    }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    T& at(const K& key) {
+        if (T* v = get(key)) return *v;
+        throw std::out_of_range("flat_map::at: key not found");
+    }
+
+    iterator lower_bound(const Key& key) { return {this, lower_pos(key)}; }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    iterator lower_bound(const K& key) {
+        return {this, lower_pos(key)};
+    }
+    const_iterator lower_bound(const Key& key) const { return {this, lower_pos(key)}; }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const_iterator lower_bound(const K& key) const {
+        return {this, lower_pos(key)};
+    }
+    iterator upper_bound(const Key& key) { return {this, upper_pos(key)}; }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    iterator upper_bound(const K& key) {
+        return {this, upper_pos(key)};
+    }
+    const_iterator upper_bound(const Key& key) const { return {this, upper_pos(key)}; }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const_iterator upper_bound(const K& key) const {
+        return {this, upper_pos(key)};
+    }
+
+    T& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        const std::size_t p = lower_pos(key);
+        if (p != size() && !comp_(key, keys_[p])) return {{this, p}, false};
+        return {insert_at(p, Key(key), T(std::forward<Args>(args)...)), true};
+    }
+
+    std::pair<iterator, bool> insert(value_type entry) {
+        const std::size_t p = lower_pos(entry.first);
+        if (p != size() && !comp_(entry.first, keys_[p])) return {{this, p}, false};
+        return {insert_at(p, std::move(entry.first), std::move(entry.second)), true};
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value) {
+        const std::size_t p = lower_pos(key);
+        if (p != size() && !comp_(key, keys_[p])) {
+            values_[p] = std::forward<V>(value);
+            return {{this, p}, false};
+        }
+        return {insert_at(p, Key(key), T(std::forward<V>(value))), true};
+    }
+
+    /// Returns the iterator following the erased element.
+    iterator erase(const_iterator it) {
+        const std::size_t rank = order::rank_of(it.pos_, size());
+        order::to_sorted(keys_);
+        order::to_sorted(values_);
+        keys_.erase(keys_.begin() + static_cast<std::ptrdiff_t>(rank));
+        values_.erase(values_.begin() + static_cast<std::ptrdiff_t>(rank));
+        to_storage();
+        return {this, rank < size() ? order::position_of(rank, size()) : size()};
+    }
+
+    iterator erase(iterator it) { return erase(const_iterator(it)); }
+
+    std::size_t erase(const Key& key) {
+        const std::size_t p = find_pos(key);
+        if (p == size()) return 0;
+        erase(const_iterator(this, p));
+        return 1;
+    }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    std::size_t erase(const K& key) {
+        const std::size_t p = find_pos(key);
+        if (p == size()) return 0;
+        erase(const_iterator(this, p));
+        return 1;
+    }
+
+    void clear() noexcept {
+        keys_.clear();
+        values_.clear();
+    }
+
+    void reserve(std::size_t n) {
+        keys_.reserve(n);
+        values_.reserve(n);
+    }
+
+private:
+    template <typename K>
+    std::size_t lower_pos(const K& key) const {
+        return order::partition_point(keys_.data(), size(), [&](const Key& k) { return comp_(k, key); });
+    }
+
+    template <typename K>
+    std::size_t upper_pos(const K& key) const {
+        return order::partition_point(keys_.data(), size(), [&](const Key& k) { return !comp_(key, k); });
+    }
+
+    template <typename K>
+    std::size_t find_pos(const K& key) const {
+        const std::size_t p = lower_pos(key);
+        return p != size() && !comp_(key, keys_[p]) ? p : size();
+    }
+
+    iterator insert_at(std::size_t pos, Key&& key, T&& value) {
+        if constexpr (Layout == flat_layout::sorted) {
+            keys_.insert(keys_.begin() + static_cast<std::ptrdiff_t>(pos), std::move(key));
+            values_.insert(values_.begin() + static_cast<std::ptrdiff_t>(pos), std::move(value));
+            return {this, pos};
+        } else {
+            const std::size_t rank = pos != size() ? order::rank_of(pos, size()) : size();
+            order::to_sorted(keys_);
+            order::to_sorted(values_);
+            keys_.insert(keys_.begin() + static_cast<std::ptrdiff_t>(rank), std::move(key));
+            values_.insert(values_.begin() + static_cast<std::ptrdiff_t>(rank), std::move(value));
+            to_storage();
+            return {this, order::position_of(rank, size())};
+        }
+    }
+
+    void to_storage() {
+        order::to_storage(keys_);
+        order::to_storage(values_);
+    }
+
+    std::vector<Key> keys_;
+    std::vector<T> values_;
+    [[no_unique_address]] Compare comp_;
+};
+
+/// `flat_map` without values: a sorted array of unique keys.
+template <typename Key, typename Compare = std::less<Key>, flat_layout Layout = flat_layout::sorted>
+class flat_set {
+    using order = detail::flat::layout<Layout>;
+
+public:
+    class const_iterator {
+    public:
+        using iterator_concept = std::bidirectional_iterator_tag;
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Key;
+        using reference = const Key&;
+        using pointer = const Key*;
+        using difference_type = std::ptrdiff_t;
+
+        const_iterator() = default;
+        const_iterator(const flat_set* set, std::size_t pos) noexcept : set_(set), pos_(pos) {}
+
+        const Key& operator*() const noexcept { return set_->keys_[pos_]; }
+        const Key* operator->() const noexcept { return &set_->keys_[pos_]; }
+
+        const_iterator& operator++() noexcept {
+            pos_ = order::next(pos_, set_->size());
+            return *this;
+        }
+        const_iterator operator++(int) noexcept {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+        const_iterator& operator--() noexcept {
+            pos_ = order::prev(pos_, set_->size());
+            return *this;
+        }
+        const_iterator operator--(int) noexcept {
+            const_iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(const const_iterator& a, const const_iterator& b) noexcept {
+            return a.pos_ == b.pos_;
+        }
+
+    private:
+        friend class flat_set;
+        const flat_set* set_ = nullptr;
+        std::size_t pos_ = 0;
+    };
+
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = std::size_t;
+    using key_compare = Compare;
+    using iterator = const_iterator;
+
+    flat_set() = default;
+    explicit flat_set(const Compare& comp) : comp_(comp) {}
+
+    /// Keys in any order, duplicates allowed.
+    explicit flat_set(std::vector<Key> keys, const Compare& comp = Compare()) : keys_(std::move(keys)), comp_(comp) {
+        detail::flat::sort_unique(keys_, static_cast<std::vector<Key>*>(nullptr), comp_);
+        order::to_storage(keys_);
+    }
+
+    flat_set(sorted_unique_t, std::vector<Key> keys, const Compare& comp = Compare())
+        : keys_(std::move(keys)), comp_(comp) {
+        detail::flat::check_sorted_unique(keys_, comp_);
+        order::to_storage(keys_);
+    }
+
+    template <std::input_iterator It>
+    flat_set(It first, It last, const Compare& comp = Compare()) : flat_set(std::vector<Key>(first, last), comp) {}
+
+    flat_set(std::initializer_list<Key> init, const Compare& comp = Compare())
+        : flat_set(std::vector<Key>(init), comp) {}
+
+    const_iterator begin() const noexcept { return {this, order::first(size())}; }
+    const_iterator end() const noexcept { return {this, size()}; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    bool empty() const noexcept { return keys_.empty(); }
+    std::size_t size() const noexcept { return keys_.size(); }
+    key_compare key_comp() const { return comp_; }
+
+    /// The keys in storage order: key order for `flat_layout::sorted`.
+    const std::vector<Key>& keys() const noexcept { return keys_; }
+
+    const_iterator find(const Key& key) const { return {this, find_pos(key)}; }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const_iterator find(const K& key) const {
+        return {this, find_pos(key)};
+    }
+
+    bool contains(const Key& key) const { return find_pos(key) != size(); }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    bool contains(const K& key) const {
+        return find_pos(key) != size();
+    }
+
+    std::size_t count(const Key& key) const { return contains(key) ? 1 : 0; }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    std::size_t count(const K& key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    const_iterator lower_bound(const Key& key) const { return {this, lower_pos(key)}; }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const_iterator lower_bound(const K& key) const {
+        return {this, lower_pos(key)};
+    }
+
+    const_iterator upper_bound(const Key& key) const {
+        return {this,
+                order::partition_point(keys_.data(), size(), [&](const Key& k) { return !comp_(key, k); })};
+    }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    const_iterator upper_bound(const K& key) const {
+        return {this,
+                order::partition_point(keys_.data(), size(), [&](const Key& k) { return !comp_(key, k); })};
+    }
+
+    std::pair<const_iterator, bool> insert(Key key) {
+        const std::size_t p = lower_pos(key);
+        if (p != size() && !comp_(key, keys_[p])) return {{this, p}, false};
+        const std::size_t rank = p != size() ? order::rank_of(p, size()) : size();
+        order::to_sorted(keys_);
+        keys_.insert(keys_.begin() + static_cast<std::ptrdiff_t>(rank), std::move(key));
+        order::to_storage(keys_);
+        return {{this, order::position_of(rank, size())}, true};
+    }
+
+    const_iterator erase(const_iterator it) {
+        const std::size_t rank = order::rank_of(it.pos_, size());
+        order::to_sorted(keys_);
+        keys_.erase(keys_.begin() + static_cast<std::ptrdiff_t>(rank));
+        order::to_storage(keys_);
+        return {this, rank < size() ? order::position_of(rank, size()) : size()};
+    }
+
+    std::size_t erase(const Key& key) {
+        const std::size_t p = find_pos(key);
+        if (p == size()) return 0;
+        erase(const_iterator(this, p));
+        return 1;
+    }
+    template <typename K>
+        requires detail::flat::transparent<Compare>
+    std::size_t erase(const K& key) {
+        const std::size_t p = find_pos(key);
+        if (p == size()) return 0;
+        erase(const_iterator(this, p));
+        return 1;
+    }
+
+    void clear() noexcept { keys_.clear(); }
+    void reserve(std::size_t n) { keys_.reserve(n); }
+
+private:
+    template <typename K>
+    std::size_t lower_pos(const K& key) const {
+        return order::partition_point(keys_.data(), size(), [&](const Key& k) { return comp_(k, key); });
+    }
+
+    template <typename K>
+    std::size_t find_pos(const K& key) const {
+        const std::size_t p = lower_pos(key);
+        return p != size() && !comp_(key, keys_[p]) ? p : size();
+    }
+
+    std::vector<Key> keys_;
+    [[no_unique_address]] Compare comp_;
+};
+
+}  // namespace mo
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace mo {
+
+/// Allocation interface used for coroutine frames.
+///
+/// Frames created while a `frame_allocator_scope` is active on the current
+/// thread are carved from that allocator instead of the global heap. The
+/// allocator pointer is stored in front of each frame, so a frame can be
+/// destroyed after the scope has ended (but not after the allocator itself).
+class frame_allocator {
+public:
+    virtual void* allocate(std::size_t size) = 0;
+    virtual void deallocate(void* p, std::size_t size) noexcept = 0;
+
+protected:
+    ~frame_allocator() = default;
+};
+
+namespace detail {
+inline thread_local frame_allocator* current_frame_allocator = nullptr;
+}
+
+/// RAII guard that routes coroutine frame allocations on this thread to `alloc`.
+class frame_allocator_scope {
+public:
+    explicit frame_allocator_scope(frame_allocator& alloc) noexcept
+        : previous_(detail::current_frame_allocator) {
+        detail::current_frame_allocator = &alloc;
+    }
+    ~frame_allocator_scope() { detail::current_frame_allocator = previous_; }
+
+    frame_allocator_scope(const frame_allocator_scope&) = delete;
+    frame_allocator_scope& operator=(const frame_allocator_scope&) = delete;
+
+private:
+    frame_allocator* previous_;
+};
+
+/// Single-threaded arena for coroutine frames.
+///
+/// Frames are bucketed into 64-byte size classes and recycled through
+/// per-class free lists, so a steady-state loop of awaits reuses the same
+/// few blocks and never touches malloc. Requests above `max_pooled_size`
+/// fall through to the global heap.
+class frame_arena final : public frame_allocator {
+public:
+    static constexpr std::size_t granularity = 64;
+    static constexpr std::size_t max_pooled_size = 4096;
+
+    explicit frame_arena(std::size_t block_size = 64 * 1024) : block_size_(block_size) {}
+    ~frame_arena() {
+        for (void* block : blocks_) ::operator delete(block);
+    }
+
+    frame_arena(const frame_arena&) = delete;
+    frame_arena& operator=(const frame_arena&) = delete;
+
+    void* allocate(std::size_t size) override {
+        if (size > max_pooled_size) return ::operator new(size);
+        const std::size_t cls = size_class(size);
+        if (free_node* node = free_[cls]) {
+            free_[cls] = node->next;
+            return node;
+        }
+        const std::size_t bytes = (cls + 1) * granularity;
+        if (static_cast<std::size_t>(end_ - cursor_) < bytes) grow(bytes);
+        void* p = cursor_;
+        cursor_ += bytes;
+        return p;
+    }
+
+    void deallocate(void* p, std::size_t size) noexcept override {
+        if (size > max_pooled_size) {
+            ::operator delete(p);
+            return;
+        }
+        const std::size_t cls = size_class(size);
+        free_[cls] = new (p) free_node{free_[cls]};
+    }
+
+    /// Bytes reserved from the global heap for pooled frames.
+    std::size_t reserved_bytes() const noexcept { return reserved_; }
+
+private:
+    struct free_node {
+        free_node* next;
+    };
+
+    static constexpr std::size_t class_count = max_pooled_size / granularity;
+
+    static std::size_t size_class(std::size_t size) noexcept {
+        return size == 0 ? 0 : (size - 1) / granularity;
+    }
+
+    void grow(std::size_t at_least) {
+        const std::size_t bytes = at_least > block_size_ ? at_least : block_size_;
+        blocks_.reserve(blocks_.size() + 1);
+        auto* block = static_cast<std::byte*>(::operator new(bytes));
+        blocks_.push_back(block);
+        cursor_ = block;
+        end_ = block + bytes;
+        reserved_ += bytes;
+    }
+
+    std::size_t block_size_;
+    std::byte* cursor_ = nullptr;
+    std::byte* end_ = nullptr;
+    std::size_t reserved_ = 0;
+    free_node* free_[class_count] = {};
+    std::vector<void*> blocks_;
+};
+
+namespace detail {
+
+/// Mixin for promise types: allocates the frame from the active
+/// `frame_allocator_scope`, or the global heap when none is set.
+struct frame_allocated {
+    static constexpr std::size_t header_size = alignof(std::max_align_t);
+
+    static void* operator new(std::size_t size) {
+        frame_allocator* alloc = current_frame_allocator;
+        const std::size_t total = size + header_size;
+        void* raw = alloc ? alloc->allocate(total) : ::operator new(total);
+        *static_cast<frame_allocator**>(raw) = alloc;
+        return static_cast<std::byte*>(raw) + header_size;
+    }
+
+    static void operator delete(void* p, std::size_t size) noexcept {
+        void* raw = static_cast<std::byte*>(p) - header_size;
+        frame_allocator* alloc = *static_cast<frame_allocator**>(raw);
+        if (alloc)
+            alloc->deallocate(raw, size + header_size);
+        else
+            ::operator delete(raw);
+    }
+};
+
+}  // namespace detail
+
+}  // namespace mo
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mo {
+
+template <typename Signature, std::size_t Capacity = 48, std::size_t Align = alignof(std::max_align_t)>
+class inplace_function;
+
+template <typename Signature, std::size_t Capacity = 48, std::size_t Align = alignof(std::max_align_t)>
+class unique_function;
+
+namespace detail::function {
+
+template <typename T>
+struct is_wrapper : std::false_type {};
+template <typename S, std::size_t N, std::size_t A>
+struct is_wrapper<inplace_function<S, N, A>> : std::true_type {};
+template <typename S, std::size_t N, std::size_t A>
+struct is_wrapper<unique_function<S, N, A>> : std::true_type {};
+
+template <typename T>
+struct is_std_function : std::false_type {};
+template <typename S>
+struct is_std_function<std::function<S>> : std::true_type {};
+
+/// Per-type operations, one static table per stored callable type. Null
+/// `relocate`/`copy`/`destroy` mean the buffer can be memcpy'd or dropped,
+/// which keeps moving trivially copyable lambdas free of indirect calls.
+template <typename R, typename... Args>
+struct ops {
+    R (*invoke)(void* self, Args&&... args);
+    void (*relocate)(void* dst, void* src) noexcept;  // move-construct into dst, then destroy src
+    void (*copy)(void* dst, const void* src);
+    void (*destroy)(void* self) noexcept;
+};
+
+template <typename R, typename... Args>
+[[noreturn]] R invoke_empty(void*, Args&&...) {
+    throw std::bad_function_call();
+}
+
+template <typename R, typename... Args>
+inline constexpr ops<R, Args...> empty_ops{&invoke_empty<R, Args...>, nullptr, nullptr, nullptr};
+
+template <typename R, typename F, typename... Args>
+R call(F& f, Args&&... args) {
+    if constexpr (std::is_void_v<R>)
+        std::invoke(f, std::forward<Args>(args)...);
+    else
+        return std::invoke(f, std::forward<Args>(args)...);
+}
+
+template <typename T>
+inline constexpr bool trivial = std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>;
+
+/// Callable stored directly in the buffer.
+template <typename F, bool Copyable, typename R, typename... Args>
+inline constexpr ops<R, Args...> inline_ops{
+    [](void* self, Args&&... args) -> R { return call<R>(*static_cast<F*>(self), std::forward<Args>(args)...); },
+    trivial<F> ? nullptr
+               : +[](void* dst, void* src) noexcept {
+                     ::new (dst) F(std::move(*static_cast<F*>(src)));
+                     static_cast<F*>(src)->~F();
+                 },
+    [] {
+        if constexpr (Copyable && !trivial<F>)
+            return +[](void* dst, const void* src) { ::new (dst) F(*static_cast<const F*>(src)); };
+        else
+            return static_cast<void (*)(void*, const void*)>(nullptr);
+    }(),
+    trivial<F> ? nullptr : +[](void* self) noexcept { static_cast<F*>(self)->~F(); },
+};
+
+/// Callable on the heap, the buffer holding only its pointer.
+template <typename F, typename R, typename... Args>
+inline constexpr ops<R, Args...> heap_ops{
+    [](void* self, Args&&... args) -> R { return call<R>(**static_cast<F**>(self), std::forward<Args>(args)...); },
+    nullptr,
+    nullptr,
+    [](void* self) noexcept { delete *static_cast<F**>(self); },
+};
+
+/// Whether `f` is an empty callable that should leave the wrapper empty
+/// rather than be stored and throw when called: a null pointer or an empty
+/// `std::function`, `inplace_function` or `unique_function`.
+template <typename F>
+bool is_null(const F& f) noexcept {
+    if constexpr (std::is_pointer_v<F> || std::is_member_pointer_v<F> || is_std_function<F>::value ||
+                  is_wrapper<F>::value)
+        return !f;
+    else
+        return false;
+}
+
+}  // namespace detail::function
+
+/// Copyable `std::function` replacement that never allocates: the callable
+/// lives in a `Capacity`-byte buffer inside the object, and one that does
+/// not fit (or is over-aligned) is a compile error rather than a silent heap
+/// allocation. The defaults make the whole object one cache line and hold a
+/// lambda capturing up to six pointers.
+///
+/// Calling an empty one throws `std::bad_function_call`, like `std::function`.
+template <typename R, typename... Args, std::size_t Capacity, std::size_t Align>
+class inplace_function<R(Args...), Capacity, Align> {
+    using ops_type = detail::function::ops<R, Args...>;
+
+public:
+    template <typename F>
+    static constexpr bool fits = sizeof(F) <= Capacity && Align % alignof(F) == 0;
+
+    inplace_function() noexcept = default;
+    inplace_function(std::nullptr_t) noexcept {}
+
+    template <typename F, typename D = std::decay_t<F>>
+        requires(!detail::function::is_wrapper<D>::value && std::is_invocable_r_v<R, D&, Args...> &&
+                 std::is_copy_constructible_v<D>)
+    inplace_function(F&& f) {
+        static_assert(fits<D>, "callable too large for inplace_function: raise Capacity or capture less");
+        static_assert(std::is_nothrow_move_constructible_v<D>, "inplace_function needs a nothrow-movable callable");
+        if (detail::function::is_null(f)) return;
+        ::new (static_cast<void*>(buffer_)) D(std::forward<F>(f));
+        ops_ = &detail::function::inline_ops<D, true, R, Args...>;
+    }
+
+    inplace_function(const inplace_function& other) : ops_(other.ops_) {
+        if (ops_->copy)
+            ops_->copy(buffer_, other.buffer_);
+        else
+            std::memcpy(buffer_, other.buffer_, Capacity);
+    }
+
+    inplace_function(inplace_function&& other) noexcept { take(other); }
+
+    inplace_function& operator=(const inplace_function& other) {
+        if (this != &other) *this = inplace_function(other);
+        return *this;
+    }
+
+    inplace_function& operator=(inplace_function&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    inplace_function& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    template <typename F>
+        requires std::is_constructible_v<inplace_function, F>
+    inplace_function& operator=(F&& f) {
+        return *this = inplace_function(std::forward<F>(f));
+    }
+
+    ~inplace_function() { reset(); }
+
+    R operator()(Args... args) const { return ops_->invoke(buffer_, std::forward<Args>(args)...); }
+
+    explicit operator bool() const noexcept { return ops_ != &detail::function::empty_ops<R, Args...>; }
+
+    void swap(inplace_function& other) noexcept { std::swap(*this, other); }
+
+private:
+    void take(inplace_function& other) noexcept {
+        ops_ = std::exchange(other.ops_, &detail::function::empty_ops<R, Args...>);
+        if (ops_->relocate)
+            ops_->relocate(buffer_, other.buffer_);
+        else
+            std::memcpy(buffer_, other.buffer_, Capacity);
+    }
+
+    void reset() noexcept {
+        if (ops_->destroy) ops_->destroy(buffer_);
+        ops_ = &detail::function::empty_ops<R, Args...>;
+    }
+
+    const ops_type* ops_ = &detail::function::empty_ops<R, Args...>;
+    alignas(Align) mutable std::byte buffer_[Capacity];
+};
+
+/// Move-only `std::function` replacement for tasks and callbacks, so
+/// lambdas may own a `unique_ptr`, a promise or a socket. Callables of up to
+/// `Capacity` bytes with a nothrow move constructor are stored inline and
+/// never allocate; larger ones go to the heap. Moving is a memcpy for
+/// trivially copyable captures.
+///
+/// Calling an empty one throws `std::bad_function_call`, like `std::function`.
+template <typename R, typename... Args, std::size_t Capacity, std::size_t Align>
+class unique_function<R(Args...), Capacity, Align> {
+    static_assert(Capacity >= sizeof(void*) && Align >= alignof(void*), "buffer must hold a pointer");
+
+    using ops_type = detail::function::ops<R, Args...>;
+
+public:
+    /// Whether `F` is stored without allocating.
+    template <typename F>
+    static constexpr bool fits =
+        sizeof(F) <= Capacity && Align % alignof(F) == 0 && std::is_nothrow_move_constructible_v<F>;
+
+    unique_function() noexcept = default;
+    unique_function(std::nullptr_t) noexcept {}
+
+    template <typename F, typename D = std::decay_t<F>>
+        requires(!std::is_same_v<D, unique_function> && std::is_invocable_r_v<R, D&, Args...> &&
+                 std::is_constructible_v<D, F>)
+    unique_function(F&& f) {
+        if (detail::function::is_null(f)) return;
+        if constexpr (fits<D>) {
+            ::new (static_cast<void*>(buffer_)) D(std::forward<F>(f));
+            ops_ = &detail::function::inline_ops<D, false, R, Args...>;
+        } else {
+            ::new (static_cast<void*>(buffer_)) D*(new D(std::forward<F>(f)));
+            ops_ = &detail::function::heap_ops<D, R, Args...>;
+        }
+    }
+
+    unique_function(unique_function&& other) noexcept { take(other); }
+
+    unique_function& operator=(unique_function&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    unique_function& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    template <typename F>
+        requires std::is_constructible_v<unique_function, F>
+    unique_function& operator=(F&& f) {
+        return *this = unique_function(std::forward<F>(f));
+    }
+
+    ~unique_function() { reset(); }
+
+    R operator()(Args... args) const { return ops_->invoke(buffer_, std::forward<Args>(args)...); }
+
+    explicit operator bool() const noexcept { return ops_ != &detail::function::empty_ops<R, Args...>; }
+
+    void swap(unique_function& other) noexcept { std::swap(*this, other); }
+
+private:
+    void take(unique_function& other) noexcept {
+        ops_ = std::exchange(other.ops_, &detail::function::empty_ops<R, Args...>);
+        if (ops_->relocate)
+            ops_->relocate(buffer_, other.buffer_);
+        else
+            std::memcpy(buffer_, other.buffer_, Capacity);
+    }
+
+    void reset() noexcept {
+        if (ops_->destroy) ops_->destroy(buffer_);
+        ops_ = &detail::function::empty_ops<R, Args...>;
+    }
+
+    const ops_type* ops_ = &detail::function::empty_ops<R, Args...>;
+    alignas(Align) mutable std::byte buffer_[Capacity];
+};
+
+}  // namespace mo
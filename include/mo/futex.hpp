@@ -0,0 +1,462 @@
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace mo {
+
+namespace detail::futex {
+
+using deadline = std::chrono::steady_clock::time_point;
+
+inline void relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+/// Sleeps while `*word == expected`, until woken or `until` passes (on the
+/// steady_clock epoch, which is CLOCK_MONOTONIC on Linux). Returns false on
+/// timeout; true otherwise, including spurious and value-changed returns, so
+/// callers always recheck their condition.
+inline bool wait(const std::atomic<std::uint32_t>* word, std::uint32_t expected,
+                 deadline until = deadline::max()) {
+    timespec ts;
+    const timespec* timeout = nullptr;
+    if (until != deadline::max()) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(until.time_since_epoch()).count();
+        if (ns <= 0) return false;
+        ts.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+        ts.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+        timeout = &ts;
+    }
+    // FUTEX_WAIT_BITSET takes an absolute deadline, so retries after
+    // spurious wakeups do not stretch the timeout.
+    const long rc = ::syscall(SYS_futex, word, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, expected, timeout, nullptr,
+                              FUTEX_BITSET_MATCH_ANY);
+    if (rc == 0 || errno == EAGAIN || errno == EINTR) return true;
+    if (errno == ETIMEDOUT) return false;
+    throw std::system_error(errno, std::system_category(), "futex wait");
+}
+
+inline void wake(const std::atomic<std::uint32_t>* word, int count) noexcept {
+    ::syscall(SYS_futex, word, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, count, nullptr, nullptr, 0);
+}
+
+inline void wake_all(const std::atomic<std::uint32_t>* word) noexcept { wake(word, INT_MAX); }
+
+template <typename Rep, typename Period>
+deadline after(const std::chrono::duration<Rep, Period>& timeout) {
+    const auto now = deadline::clock::now();
+    if (timeout >= deadline::max() - now) return deadline::max();
+    return now + std::chrono::ceil<deadline::duration>(timeout);
+}
+
+/// Spin iterations before sleeping: ~1.5 us of `pause`, about a futex
+/// round trip. None on a single CPU, where the holder cannot run meanwhile.
+inline int spin_limit() noexcept {
+    static const int limit = std::thread::hardware_concurrency() > 1 ? 100 : 0;
+    return limit;
+}
+
+/// Count and waiter count in one 64-bit word; the kernel sleeps on the
+/// 32-bit count half. Waiters register before sleeping, so `release` only
+/// makes a syscall when someone is actually asleep.
+class semaphore_word {
+public:
+    explicit semaphore_word(std::uint32_t initial) noexcept : word_(initial) {}
+
+    bool try_acquire() noexcept {
+        std::uint64_t s = word_.load(std::memory_order_relaxed);
+        while (count(s) != 0) {
+            if (word_.compare_exchange_weak(s, s - 1, std::memory_order_acquire, std::memory_order_relaxed))
+                return true;
+        }
+        return false;
+    }
+
+    bool acquire(deadline until) {
+        for (int i = 0; i < spin_limit(); ++i) {
+            if (try_acquire()) return true;
+            relax();
+        }
+        std::uint64_t s = word_.fetch_add(one_waiter, std::memory_order_relaxed) + one_waiter;
+        for (;;) {
+            while (count(s) != 0) {
+                if (word_.compare_exchange_weak(s, s - 1 - one_waiter, std::memory_order_acquire,
+                                                std::memory_order_relaxed))
+                    return true;
+            }
+            if (!wait(count_word(), 0, until)) {
+                // Timed out, but a release may still have raced in.
+                s = word_.load(std::memory_order_relaxed);
+                while (count(s) == 0) {
+                    if (word_.compare_exchange_weak(s, s - one_waiter, std::memory_order_relaxed)) return false;
+                }
+                continue;
+            }
+            s = word_.load(std::memory_order_relaxed);
+        }
+    }
+
+    /// Adds `n`, but never above `max`.
+    void release(std::uint32_t n, std::uint32_t max) noexcept {
+        std::uint64_t s = word_.load(std::memory_order_relaxed);
+        std::uint64_t next;
+        do {
+            const std::uint32_t c = count(s);
+            if (c >= max) return;
+            next = s + (n < max - c ? n : max - c);
+        } while (!word_.compare_exchange_weak(s, next, std::memory_order_release, std::memory_order_relaxed));
+        const std::uint64_t waiters = s >> 32;
+        if (waiters != 0) wake(count_word(), static_cast<int>(waiters < n ? waiters : n));
+    }
+
+    std::uint32_t count() const noexcept { return count(word_.load(std::memory_order_relaxed)); }
+
+private:
+    static constexpr std::uint64_t one_waiter = std::uint64_t{1} << 32;
+
+    static std::uint32_t count(std::uint64_t s) noexcept { return static_cast<std::uint32_t>(s); }
+
+    const std::atomic<std::uint32_t>* count_word() const noexcept {
+        static_assert(sizeof(std::atomic<std::uint64_t>) == 8 && std::atomic<std::uint64_t>::is_always_lock_free);
+        constexpr std::size_t low_half = std::endian::native == std::endian::little ? 0 : 4;
+        return reinterpret_cast<const std::atomic<std::uint32_t>*>(reinterpret_cast<const char*>(&word_) + low_half);
+    }
+
+    std::atomic<std::uint64_t> word_;
+};
+
+}  // namespace detail::futex
+
+/// A 4-byte mutex: one compare-and-swap to lock and one exchange to unlock
+/// when uncontended, a short spin when the holder is likely to be running,
+/// and a futex sleep after that. Small enough to embed one in every object
+/// of a large table (glibc's `std::mutex` is 40 bytes). Not recursive, not
+/// fair. Works with `std::lock_guard`, `std::unique_lock` and `std::scoped_lock`.
+class futex_mutex {
+public:
+    constexpr futex_mutex() noexcept = default;
+    futex_mutex(const futex_mutex&) = delete;
+    futex_mutex& operator=(const futex_mutex&) = delete;
+
+    bool try_lock() noexcept {
+        std::uint32_t s = unlocked;
+        return state_.compare_exchange_strong(s, locked, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void lock() {
+        std::uint32_t s = unlocked;
+        if (state_.compare_exchange_strong(s, locked, std::memory_order_acquire, std::memory_order_relaxed)) return;
+        lock_slow(s);
+    }
+
+    void unlock() noexcept {
+        if (state_.exchange(unlocked, std::memory_order_release) == contended) detail::futex::wake(&state_, 1);
+    }
+
+private:
+    static constexpr std::uint32_t unlocked = 0, locked = 1, contended = 2;
+
+    void lock_slow(std::uint32_t s) {
+        // Spin only while nobody sleeps: once there are sleepers the holder
+        // is likely descheduled or slow, and the spinners would only delay them.
+        for (int i = 0; i < detail::futex::spin_limit() && s == locked; ++i) {
+            detail::futex::relax();
+            s = state_.load(std::memory_order_relaxed);
+            if (s == unlocked && state_.compare_exchange_weak(s, locked, std::memory_order_acquire,
+                                                              std::memory_order_relaxed))
+                return;
+        }
+        // From here on take it as `contended`: we cannot know whether other
+        // sleepers remain, so the next unlock must wake.
+        while (state_.exchange(contended, std::memory_order_acquire) != unlocked)
+            detail::futex::wait(&state_, contended);
+    }
+
+    std::atomic<std::uint32_t> state_{unlocked};
+};
+
+/// Set-once flag that threads can wait on: "initialization finished",
+/// "shutdown requested", "result ready". Once set it stays set and every
+/// wait returns immediately. 4 bytes; `set` makes a syscall only if
+/// someone is asleep.
+class one_shot_event {
+public:
+    constexpr one_shot_event() noexcept = default;
+    one_shot_event(const one_shot_event&) = delete;
+    one_shot_event& operator=(const one_shot_event&) = delete;
+
+    void set() noexcept {
+        if (state_.exchange(signaled, std::memory_order_release) == waiting) detail::futex::wake_all(&state_);
+    }
+
+    bool is_set() const noexcept { return state_.load(std::memory_order_acquire) == signaled; }
+
+    void wait() { wait_until(detail::futex::deadline::max()); }
+
+    /// Returns whether the event was set before the timeout.
+    template <typename Rep, typename Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout) {
+        return wait_until(detail::futex::after(timeout));
+    }
+
+    bool wait_until(std::chrono::steady_clock::time_point until) {
+        std::uint32_t s = state_.load(std::memory_order_acquire);
+        for (int i = 0; i < detail::futex::spin_limit() && s == clear; ++i) {
+            detail::futex::relax();
+            s = state_.load(std::memory_order_acquire);
+        }
+        while (s != signaled) {
+            if (s == clear && !state_.compare_exchange_weak(s, waiting, std::memory_order_acquire)) continue;
+            if (!detail::futex::wait(&state_, waiting, until)) return is_set();
+            s = state_.load(std::memory_order_acquire);
+        }
+        return true;
+    }
+
+private:
+    static constexpr std::uint32_t clear = 0, waiting = 1, signaled = 2;
+
+    std::atomic<std::uint32_t> state_{clear};
+};
+
+/// Counting semaphore with a fast path of one compare-and-swap on each
+/// side and a syscall only when a thread has to sleep or be woken. One
+/// 8-byte word: the count and the number of sleepers, so `release` knows
+/// exactly whether anyone needs waking.
+class counting_semaphore {
+public:
+    explicit counting_semaphore(std::uint32_t initial = 0) noexcept : word_(initial) {}
+    counting_semaphore(const counting_semaphore&) = delete;
+    counting_semaphore& operator=(const counting_semaphore&) = delete;
+
+    void acquire() { word_.acquire(detail::futex::deadline::max()); }
+    bool try_acquire() noexcept { return word_.try_acquire(); }
+
+    template <typename Rep, typename Period>
+    bool try_acquire_for(const std::chrono::duration<Rep, Period>& timeout) {
+        return word_.acquire(detail::futex::after(timeout));
+    }
+
+    bool try_acquire_until(std::chrono::steady_clock::time_point until) { return word_.acquire(until); }
+
+    /// Adds `n` to the count, saturating at `UINT32_MAX`.
+    void release(std::uint32_t n = 1) noexcept { word_.release(n, UINT32_MAX); }
+
+    std::uint32_t count() const noexcept { return word_.count(); }
+
+private:
+    detail::futex::semaphore_word word_;
+};
+
+/// Wakes one waiter per `set`: a `set` with nobody waiting is remembered
+/// until the next `wait`, and further `set`s before then are absorbed, like
+/// a binary semaphore. Suited to "there is work, wake a worker" signals.
+class auto_reset_event {
+public:
+    explicit auto_reset_event(bool set = false) noexcept : word_(set ? 1 : 0) {}
+    auto_reset_event(const auto_reset_event&) = delete;
+    auto_reset_event& operator=(const auto_reset_event&) = delete;
+
+    void set() noexcept { word_.release(1, 1); }
+
+    void wait() { word_.acquire(detail::futex::deadline::max()); }
+
+    /// Consumes the signal if it is set, without waiting.
+    bool try_wait() noexcept { return word_.try_acquire(); }
+
+    template <typename Rep, typename Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout) {
+        return word_.acquire(detail::futex::after(timeout));
+    }
+
+    bool wait_until(std::chrono::steady_clock::time_point until) { return word_.acquire(until); }
+
+private:
+    detail::futex::semaphore_word word_;
+};
+
+/// Outcome of an unpark, also passed to the callback of `unpark_one`.
+struct unpark_result {
+    bool unparked = false;   // a thread was taken off the queue
+    bool have_more = false;  // threads remain parked on the same address
+};
+
+namespace detail::parking {
+
+struct waiter {
+    const void* address;
+    waiter* next = nullptr;
+    std::atomic<std::uint32_t> woken{0};
+};
+
+struct alignas(64) bucket {
+    futex_mutex lock;
+    waiter* head = nullptr;
+    waiter* tail = nullptr;
+
+    /// Unlinks the first waiter on `address`; reports whether another remains.
+    waiter* take(const void* address, bool& have_more) noexcept {
+        waiter* prev = nullptr;
+        waiter* w = head;
+        while (w && w->address != address) prev = std::exchange(w, w->next);
+        if (!w) return nullptr;
+        unlink(prev, w);
+        have_more = false;
+        for (waiter* v = prev ? prev->next : head; v; v = v->next) {
+            if (v->address == address) {
+                have_more = true;
+                break;
+            }
+        }
+        return w;
+    }
+
+    bool remove(waiter* target) noexcept {
+        waiter* prev = nullptr;
+        for (waiter* w = head; w; prev = std::exchange(w, w->next)) {
+            if (w == target) {
+                unlink(prev, w);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void unlink(waiter* prev, waiter* w) noexcept {
+        (prev ? prev->next : head) = w->next;
+        if (tail == w) tail = prev;
+    }
+};
+
+inline constexpr std::size_t bucket_count = 256;
+
+inline bucket& bucket_for(const void* address) noexcept {
+    static bucket table[bucket_count];
+    const auto h = reinterpret_cast<std::uintptr_t>(address) * std::uint64_t{0x9E3779B97F4A7C15};
+    return table[h >> (64 - std::countr_zero(bucket_count))];
+}
+
+inline void wake(waiter* w) noexcept {
+    // `w` lives on the parked thread's stack and may be gone as soon as
+    // `woken` is visible; a stray futex wake on a reused address is only a
+    // spurious wakeup, which every futex wait here tolerates.
+    w->woken.store(1, std::memory_order_release);
+    detail::futex::wake(&w->woken, 1);
+}
+
+}  // namespace detail::parking
+
+/// Waiting on arbitrary addresses: wait for a `std::atomic<std::uint64_t>`,
+/// a flag byte or a bit inside a larger word to change, without giving each
+/// object a futex word or a condition variable of its own. Parked threads
+/// queue in a fixed global table of hashed buckets, so the objects being
+/// waited on pay nothing (the WebKit/Rust `parking_lot` design).
+///
+///     // waiter
+///     parking_lot::park(&state, [&] { return state.load() == busy; });
+///     // notifier, after changing `state`
+///     parking_lot::unpark_all(&state);
+///
+/// The validate callback runs under the bucket lock, and the notifier takes
+/// the same lock, so a notify after the state change cannot slip between the
+/// check and the sleep. Like a condition variable, a return from `park` does
+/// not guarantee the condition changed: recheck it.
+struct parking_lot {
+    /// Parks the calling thread on `address` if `validate()` returns true.
+    /// Returns true if unparked, false if `validate` failed or the deadline passed.
+    template <typename Validate>
+    static bool park(const void* address, Validate&& validate,
+                     std::chrono::steady_clock::time_point until = std::chrono::steady_clock::time_point::max()) {
+        detail::parking::bucket& b = detail::parking::bucket_for(address);
+        detail::parking::waiter self{address};
+        {
+            std::lock_guard lock(b.lock);
+            if (!validate()) return false;
+            (b.tail ? b.tail->next : b.head) = &self;
+            b.tail = &self;
+        }
+        while (self.woken.load(std::memory_order_acquire) == 0) {
+            if (detail::futex::wait(&self.woken, 0, until)) continue;
+            {
+                std::lock_guard lock(b.lock);
+                if (b.remove(&self)) return false;
+            }
+            // An unparker dequeued us before we could: wait for its store,
+            // which follows within a few instructions.
+            while (self.woken.load(std::memory_order_acquire) == 0) detail::futex::wait(&self.woken, 0);
+        }
+        return true;
+    }
+
+    template <typename Validate, typename Rep, typename Period>
+    static bool park_for(const void* address, Validate&& validate, const std::chrono::duration<Rep, Period>& timeout) {
+        return park(address, std::forward<Validate>(validate), detail::futex::after(timeout));
+    }
+
+    /// Wakes the longest-parked thread on `address`. `callback(unpark_result)`
+    /// runs under the bucket lock before the wakeup, which lets a lock clear
+    /// its "has parked threads" bit exactly when the last one leaves.
+    template <typename Callback>
+    static unpark_result unpark_one(const void* address, Callback&& callback) {
+        detail::parking::bucket& b = detail::parking::bucket_for(address);
+        unpark_result result;
+        detail::parking::waiter* w;
+        {
+            std::lock_guard lock(b.lock);
+            w = b.take(address, result.have_more);
+            result.unparked = w != nullptr;
+            callback(result);
+        }
+        if (w) detail::parking::wake(w);
+        return result;
+    }
+
+    static unpark_result unpark_one(const void* address) {
+        return unpark_one(address, [](unpark_result) {});
+    }
+
+    /// Wakes every thread parked on `address`; returns how many.
+    static std::size_t unpark_all(const void* address) {
+        detail::parking::bucket& b = detail::parking::bucket_for(address);
+        detail::parking::waiter* first = nullptr;
+        detail::parking::waiter* last = nullptr;
+        std::size_t n = 0;
+        {
+            std::lock_guard lock(b.lock);
+            bool more = true;
+            while (more) {
+                detail::parking::waiter* w = b.take(address, more);
+                if (!w) break;
+                (last ? last->next : first) = w;
+                last = w;
+                w->next = nullptr;
+                ++n;
+            }
+        }
+        while (first) detail::parking::wake(std::exchange(first, first->next));
+        return n;
+    }
+};
+
+}  // namespace mo
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "mo/frame_allocator.hpp"
+
+namespace mo {
+
+/// Synchronous pull-based coroutine yielding a sequence of `T`.
+///
+/// Yielded values are referenced, not copied: the reference returned by the
+/// iterator stays valid until the iterator is advanced. Frames honour
+/// `frame_allocator_scope`.
+template <typename T>
+class [[nodiscard]] generator {
+public:
+    using value_type = std::remove_cvref_t<T>;
+    using reference = std::conditional_t<std::is_reference_v<T>, T, const value_type&>;
+    using pointer = std::add_pointer_t<reference>;
+
+    struct promise_type : detail::frame_allocated {
+        pointer current = nullptr;
+        std::exception_ptr exception;
+
+        generator get_return_object() noexcept {
+            return generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_always final_suspend() const noexcept { return {}; }
+
+        std::suspend_always yield_value(reference value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+        // Allows `co_yield` of temporaries for value generators; the temporary
+        // lives until the coroutine resumes.
+        std::suspend_always yield_value(value_type&& value) noexcept
+            requires(!std::is_reference_v<T>)
+        {
+            current = std::addressof(value);
+            return {};
+        }
+
+        void return_void() const noexcept {}
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+
+        template <typename U>
+        std::suspend_never await_transform(U&&) = delete;
+    };
+
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = generator::value_type;
+        using reference = generator::reference;
+        using pointer = generator::pointer;
+
+        iterator() noexcept = default;
+        explicit iterator(handle_type h) noexcept : h_(h) {}
+
+        reference operator*() const noexcept { return static_cast<reference>(*h_.promise().current); }
+        pointer operator->() const noexcept { return h_.promise().current; }
+
+        iterator& operator++() {
+            h_.resume();
+            if (h_.done()) {
+                auto ex = h_.promise().exception;
+                if (ex) std::rethrow_exception(ex);
+            }
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept {
+            return !it.h_ || it.h_.done();
+        }
+
+    private:
+        handle_type h_;
+    };
+
+    generator() noexcept = default;
+    explicit generator(handle_type h) noexcept : handle_(h) {}
+    generator(generator&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    generator& operator=(generator&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    generator(const generator&) = delete;
+    generator& operator=(const generator&) = delete;
+    ~generator() {
+        if (handle_) handle_.destroy();
+    }
+
+    /// Starts (or continues) the coroutine; a generator may only be iterated once.
+    iterator begin() {
+        if (handle_) {
+            iterator it{handle_};
+            ++it;
+            return it;
+        }
+        return iterator{};
+    }
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+    handle_type handle_;
+};
+
+}  // namespace mo
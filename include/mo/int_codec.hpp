@@ -0,0 +1,424 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "mo/compress.hpp"
+#include "mo/cpu_features.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MO_INT_CODEC_HAVE_X86 1
+#endif
+
+namespace mo {
+
+/// Element types `packed_list` stores: document ids, row ids, timestamps.
+template <typename T>
+concept packed_value = std::same_as<T, std::uint32_t> || std::same_as<T, std::uint64_t>;
+
+namespace detail::intcodec {
+
+inline std::uint64_t load64(const char* p) noexcept {
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline void or64(char* p, std::uint64_t bits) noexcept {
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    v |= bits;
+    std::memcpy(p, &v, 8);
+}
+
+// StreamVByte: a control byte holds four 2-bit codes (value k in bits 2k..2k+1,
+// code = byte length - 1); the data bytes of all values follow the controls.
+
+inline constexpr auto svb_lengths = [] {
+    std::array<std::uint8_t, 256> t{};
+    for (unsigned c = 0; c < 256; ++c)
+        t[c] = static_cast<std::uint8_t>(4 + (c & 3) + ((c >> 2) & 3) + ((c >> 4) & 3) + (c >> 6));
+    return t;
+}();
+
+// pshufb masks spreading one control byte's 4..16 data bytes over four
+// 32-bit lanes; -1 zeroes the byte.
+inline constexpr auto svb_shuffles = [] {
+    std::array<std::array<std::int8_t, 16>, 256> t{};
+    for (unsigned c = 0; c < 256; ++c) {
+        int src = 0;
+        for (unsigned k = 0; k < 4; ++k) {
+            const unsigned len = ((c >> (2 * k)) & 3) + 1;
+            for (unsigned b = 0; b < 4; ++b) t[c][4 * k + b] = static_cast<std::int8_t>(b < len ? src++ : -1);
+        }
+    }
+    return t;
+}();
+
+inline unsigned svb_code(std::uint32_t v) noexcept {
+    return static_cast<unsigned>(v > 0xFF) + (v > 0xFFFF) + (v > 0xFFFFFF);
+}
+
+template <bool Delta>
+std::size_t svb_encode(const std::uint32_t* in, std::size_t n, char* out, std::uint32_t prev) noexcept {
+    char* data = out + (n + 3) / 4;
+    for (std::size_t i = 0; i < n; i += 4) {
+        unsigned control = 0;
+        for (std::size_t k = 0; k < 4 && i + k < n; ++k) {
+            std::uint32_t v = in[i + k];
+            if constexpr (Delta) v -= std::exchange(prev, v);
+            const unsigned code = svb_code(v);
+            control |= code << (2 * k);
+            // All four bytes fit: the bound reserves four per value.
+            std::memcpy(data, &v, 4);
+            data += code + 1;
+        }
+        out[i / 4] = static_cast<char>(control);
+    }
+    return static_cast<std::size_t>(data - out);
+}
+
+/// Data bytes of the first `n` values, from their control bytes.
+inline std::size_t svb_data_length(const std::uint8_t* control, std::size_t n) noexcept {
+    std::size_t len = 0;
+    for (std::size_t c = 0; c < n / 4; ++c) len += svb_lengths[control[c]];
+    for (std::size_t k = 0; k < n % 4; ++k) len += ((control[n / 4] >> (2 * k)) & 3) + 1;
+    return len;
+}
+
+template <bool Delta>
+void svb_decode_scalar(const std::uint8_t* control, const char* data, std::size_t i, std::size_t n,
+                       std::uint32_t* out, std::uint32_t prev) noexcept {
+    for (; i < n; ++i) {
+        const unsigned len = ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        std::uint32_t v = 0;
+        std::memcpy(&v, data, len);
+        data += len;
+        if constexpr (Delta) v = prev += v;
+        out[i] = v;
+    }
+}
+
+#ifdef MO_INT_CODEC_HAVE_X86
+// One pshufb per control byte places four values; the delta variant adds a
+// four-lane prefix sum in two shifted adds. Runs while 16 bytes remain
+// readable and hands the rest to the scalar loop.
+template <bool Delta>
+__attribute__((target("ssse3"))) void svb_decode_ssse3(const std::uint8_t* control, const char* data,
+                                                       const char* end, std::size_t n, std::uint32_t* out,
+                                                       std::uint32_t prev) noexcept {
+    __m128i carry = _mm_set1_epi32(static_cast<int>(prev));
+    std::size_t i = 0;
+    for (; i + 4 <= n && end - data >= 16; i += 4) {
+        const std::uint8_t c = control[i / 4];
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        v = _mm_shuffle_epi8(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(svb_shuffles[c].data())));
+        if constexpr (Delta) {
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, carry);
+            carry = _mm_shuffle_epi32(v, 0xFF);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+        data += svb_lengths[c];
+    }
+    svb_decode_scalar<Delta>(control, data, i, n, out, static_cast<std::uint32_t>(_mm_cvtsi128_si32(carry)));
+}
+#endif
+
+template <bool Delta>
+std::size_t svb_decode(const char* src, std::size_t size, std::uint32_t* out, std::size_t n, std::uint32_t prev) {
+    const std::size_t controls = (n + 3) / 4;
+    if (size < controls) throw compress_error("streamvbyte: truncated control bytes");
+    const auto* control = reinterpret_cast<const std::uint8_t*>(src);
+    const std::size_t data = svb_data_length(control, n);
+    if (size - controls < data) throw compress_error("streamvbyte: truncated data");
+#ifdef MO_INT_CODEC_HAVE_X86
+    if (cpu().ssse3) {
+        svb_decode_ssse3<Delta>(control, src + controls, src + size, n, out, prev);
+        return controls + data;
+    }
+#endif
+    svb_decode_scalar<Delta>(control, src + controls, 0, n, out, prev);
+    return controls + data;
+}
+
+// Bit packing: value i of a run of width W occupies bits [i * W, (i + 1) * W)
+// of the little-endian byte stream. Eight values span exactly W bytes, so
+// unpacking in groups of eight makes every shift and offset a constant.
+
+inline void pack(const std::uint64_t* in, std::size_t n, unsigned width, char* out) noexcept {
+    if (width == 0) return;
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::size_t bit = i * width;
+        const unsigned shift = bit & 7;
+        or64(out + bit / 8, in[i] << shift);
+        if (shift + width > 64) or64(out + bit / 8 + 8, in[i] >> (64 - shift));
+    }
+}
+
+/// Unpacks `n` values rounded up to a multiple of 8: `out` needs that room
+/// and `in` `unpack_slack<T>` readable bytes past the packed data.
+template <typename T, unsigned W>
+void unpack(const char* in, std::size_t n, T* out) noexcept {
+    if constexpr (W == 0) {
+        std::fill_n(out, n, T{0});
+    } else {
+        constexpr std::uint64_t mask = W == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << W) - 1;
+        for (std::size_t g = 0; g < n; g += 8, in += W, out += 8) {
+#pragma GCC unroll 8
+            for (unsigned k = 0; k < 8; ++k) {
+                const unsigned bit = k * W, shift = bit & 7;
+                std::uint64_t v = load64(in + bit / 8) >> shift;
+                if constexpr (W > 57)
+                    if (shift + W > 64) v |= load64(in + bit / 8 + 8) << (64 - shift);
+                out[k] = static_cast<T>(v & mask);
+            }
+        }
+    }
+}
+
+template <typename T>
+inline constexpr std::size_t unpack_slack = std::numeric_limits<T>::digits + 16;
+
+template <typename T>
+using unpack_fn = void (*)(const char*, std::size_t, T*) noexcept;
+
+template <typename T, std::size_t... W>
+constexpr std::array<unpack_fn<T>, sizeof...(W)> make_unpackers(std::index_sequence<W...>) noexcept {
+    return {&unpack<T, W>...};
+}
+
+template <typename T>
+inline constexpr auto unpackers = make_unpackers<T>(std::make_index_sequence<std::numeric_limits<T>::digits + 1>());
+
+/// First position at or after `from` with `a[pos] >= v`, by doubling steps
+/// then binary search: cheap when the answer is near `from`.
+template <typename T>
+std::size_t gallop(const T* a, std::size_t from, std::size_t n, T v) noexcept {
+    std::size_t step = 1, hi = from;
+    while (hi < n && a[hi] < v) from = hi + 1, hi += step, step *= 2;
+    return static_cast<std::size_t>(std::lower_bound(a + from, a + std::min(hi, n), v) - a);
+}
+
+}  // namespace detail::intcodec
+
+/// Worst-case StreamVByte size of `n` 32-bit values.
+constexpr std::size_t streamvbyte_bound(std::size_t n) noexcept { return (n + 3) / 4 + 4 * n; }
+
+/// StreamVByte: each 32-bit value takes 1-4 bytes, with the lengths kept in
+/// a separate control stream so decoding is a table-driven shuffle of four
+/// values at a time (SSSE3 where available) rather than a branch per byte.
+/// Suits values of varying magnitude that bit packing would widen to the
+/// largest. `dst` must hold `streamvbyte_bound(values.size())` bytes;
+/// returns the encoded size.
+inline std::size_t streamvbyte_encode(std::span<const std::uint32_t> values, char* dst) noexcept {
+    return detail::intcodec::svb_encode<false>(values.data(), values.size(), dst, 0);
+}
+
+/// Decodes `values.size()` values and returns the bytes consumed. The count
+/// is not stored; keep it alongside. Throws `compress_error` if `size` is
+/// too short for the lengths the control bytes describe.
+inline std::size_t streamvbyte_decode(const char* src, std::size_t size, std::span<std::uint32_t> values) {
+    return detail::intcodec::svb_decode<false>(src, size, values.data(), values.size(), 0);
+}
+
+/// StreamVByte of the differences between consecutive values (the first
+/// from `prev`): for sorted ids, where the gaps are far smaller than the
+/// values. Unsorted input still round-trips, through wrap-around.
+inline std::size_t streamvbyte_encode_delta(std::span<const std::uint32_t> values, char* dst,
+                                            std::uint32_t prev = 0) noexcept {
+    return detail::intcodec::svb_encode<true>(values.data(), values.size(), dst, prev);
+}
+
+/// Inverse of `streamvbyte_encode_delta`, prefix sums done in SIMD lanes.
+inline std::size_t streamvbyte_decode_delta(const char* src, std::size_t size, std::span<std::uint32_t> values,
+                                            std::uint32_t prev = 0) {
+    return detail::intcodec::svb_decode<true>(src, size, values.data(), values.size(), prev);
+}
+
+/// Intersection of two sorted arrays into `out` (room for the smaller);
+/// returns the count. A value repeated in both is kept as often as the
+/// fewer copies. Merges branch-free when the sizes are close and gallops
+/// the smaller through the larger when they are not.
+template <packed_value T>
+std::size_t intersect_sorted(std::span<const T> a, std::span<const T> b, T* out) noexcept {
+    if (a.size() > b.size()) std::swap(a, b);
+    std::size_t k = 0;
+    if (a.size() * 32 < b.size()) {
+        std::size_t j = 0;
+        for (const T x : a) {
+            j = detail::intcodec::gallop(b.data(), j, b.size(), x);
+            if (j == b.size()) break;
+            out[k] = x;
+            const bool match = b[j] == x;
+            k += match;
+            j += match;  // each copy in `b` pairs with one in `a`, as in the merge
+        }
+        return k;
+    }
+    std::size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        const T x = a[i], y = b[j];
+        out[k] = x;
+        k += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+    return k;
+}
+
+/// Sorted integers (posting lists, row ids, timestamps) compressed to
+/// a few bits per value and still searchable.
+///
+/// Values are split into blocks of 128. A block keeps its first value in an
+/// index and bit-packs the gaps to the next values at the width of its
+/// largest gap, so dense ids take 1-8 bits each instead of 64, and one
+/// outlier only widens its own block. Blocks decode independently at
+/// memory speed, and `contains` and `intersect` use the index to decode only
+/// blocks that can hold a match.
+template <packed_value T>
+class packed_list {
+public:
+    static constexpr std::size_t block_size = 128;
+
+    packed_list() = default;
+
+    /// `values` must be strictly increasing, a set: copies of a value could
+    /// straddle blocks, where `intersect` sees only the last block's.
+    /// Throws `std::invalid_argument`.
+    explicit packed_list(std::span<const T> values) : size_(values.size()) {
+        if (std::adjacent_find(values.begin(), values.end(), std::greater_equal<T>()) != values.end())
+            throw std::invalid_argument("packed_list: values must be strictly increasing");
+        const std::size_t blocks = (size_ + block_size - 1) / block_size;
+        first_.reserve(blocks);
+        offset_.reserve(blocks + 1);
+        std::uint64_t gaps[block_size];
+        for (std::size_t b = 0; b < blocks; ++b) {
+            const T* v = values.data() + b * block_size;
+            const std::size_t n = std::min(block_size, size_ - b * block_size);
+            std::uint64_t widest = 0;
+            for (std::size_t i = 1; i < n; ++i) widest |= gaps[i - 1] = v[i] - v[i - 1];
+            const auto width = static_cast<unsigned>(std::bit_width(widest));
+            first_.push_back(v[0]);
+            offset_.push_back(data_.size());
+            data_.push_back(static_cast<char>(width));
+            const std::size_t at = data_.size();
+            data_.resize(at + ((n - 1) * width + 7) / 8 + 16);  // slack for or64
+            detail::intcodec::pack(gaps, n - 1, width, data_.data() + at);
+            data_.resize(data_.size() - 16);
+        }
+        offset_.push_back(data_.size());
+        data_.resize(data_.size() + detail::intcodec::unpack_slack<T>);
+        data_.shrink_to_fit();
+        if (size_) back_ = values.back();
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::size_t block_count() const noexcept { return first_.size(); }
+
+    /// Bytes held, index included.
+    std::size_t memory_bytes() const noexcept {
+        return data_.size() + first_.size() * sizeof(T) + offset_.size() * sizeof(std::size_t);
+    }
+
+    T front() const noexcept { return first_.front(); }
+    T back() const noexcept { return back_; }
+    T block_front(std::size_t b) const noexcept { return first_[b]; }
+
+    /// Decodes block `b` into `out`, which needs room for `block_size`
+    /// values; returns how many it holds.
+    std::size_t decode_block(std::size_t b, T* out) const noexcept {
+        const std::size_t n = std::min(block_size, size_ - b * block_size);
+        const char* p = data_.data() + offset_[b];
+        T gaps[block_size];
+        detail::intcodec::unpackers<T>[static_cast<unsigned char>(*p)](p + 1, n - 1, gaps);
+        T v = out[0] = first_[b];
+        for (std::size_t i = 1; i < n; ++i) out[i] = v += gaps[i - 1];
+        return n;
+    }
+
+    /// Decodes every value into `out`, which needs room for `size()`.
+    void decode(T* out) const noexcept {
+        for (std::size_t b = 0; b + 1 < block_count(); ++b) decode_block(b, out + b * block_size);
+        if (!empty()) {
+            T last[block_size];
+            const std::size_t b = block_count() - 1;
+            std::copy_n(last, decode_block(b, last), out + b * block_size);
+        }
+    }
+
+    std::vector<T> decode() const {
+        std::vector<T> out(size_);
+        decode(out.data());
+        return out;
+    }
+
+    /// Block that holds `v` if any block does: the last starting at or
+    /// before it.
+    std::size_t find_block(T v) const noexcept {
+        const auto it = std::upper_bound(first_.begin(), first_.end(), v);
+        return it == first_.begin() ? 0 : static_cast<std::size_t>(it - first_.begin()) - 1;
+    }
+
+    /// Decodes at most one block.
+    bool contains(T v) const noexcept {
+        if (empty() || v < first_.front() || v > back_) return false;
+        T block[block_size];
+        const std::size_t n = decode_block(find_block(v), block);
+        return std::binary_search(block, block + n, v);
+    }
+
+private:
+    std::size_t size_ = 0;
+    T back_ = 0;
+    std::vector<T> first_;             // first value of each block
+    std::vector<std::size_t> offset_;  // block start in data_, plus the end
+    std::vector<char> data_;           // per block: width byte, packed gaps; slack for unpack at the end
+};
+
+/// Values of sorted `a` that are in `b` (once each, as `b` is a set),
+/// decoding only the blocks of `b` whose range holds some value of `a`: a
+/// short list against a long one touches a few blocks of the long one.
+template <packed_value T>
+std::vector<T> intersect(std::span<const T> a, const packed_list<T>& b) {
+    using packed = packed_list<T>;
+    std::vector<T> out(std::min(a.size(), b.size()));
+    T block[packed::block_size];
+    std::size_t i = 0, k = 0;
+    while (i < a.size() && a[i] <= b.back()) {
+        // The values of `a` before the next block's first can only be in this one.
+        const std::size_t blk = b.find_block(a[i]);
+        const std::size_t end = blk + 1 == b.block_count()
+                                    ? a.size()
+                                    : detail::intcodec::gallop(a.data(), i, a.size(), b.block_front(blk + 1));
+        const std::size_t n = b.decode_block(blk, block);
+        k += intersect_sorted(a.subspan(i, end - i), std::span<const T>(block, n), out.data() + k);
+        i = end;
+    }
+    out.resize(k);
+    return out;
+}
+
+/// Intersection of two packed lists: the shorter is decoded whole and the
+/// longer block by block as in the overload above.
+template <packed_value T>
+std::vector<T> intersect(const packed_list<T>& a, const packed_list<T>& b) {
+    if (a.size() > b.size()) return intersect(b, a);
+    const std::vector<T> shorter = a.decode();
+    return intersect(std::span<const T>(shorter), b);
+}
+
+}  // namespace mo
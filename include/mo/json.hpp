@@ -0,0 +1,672 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "mo/cpu_features.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MO_JSON_HAVE_AVX2 1
+#endif
+
+namespace mo {
+
+class json_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+enum class json_type { object, array, string, number, boolean, null };
+
+namespace detail::json {
+
+/// Per-64-byte-block character classes, one bit per byte.
+struct block_masks {
+    std::uint64_t op;         // { } [ ] : ,
+    std::uint64_t quote;      // "
+    std::uint64_t backslash;  // '\'
+    std::uint64_t space;      // space, \t, \n, \r
+    std::uint64_t control;    // bytes below 0x20
+    std::uint64_t non_ascii;  // bytes >= 0x80
+};
+
+inline block_masks classify_scalar(const unsigned char* p) noexcept {
+    block_masks m{};
+    for (unsigned i = 0; i < 64; ++i) {
+        const unsigned char c = p[i];
+        const std::uint64_t bit = std::uint64_t{1} << i;
+        switch (c) {
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            m.op |= bit;
+            break;
+        case '"':
+            m.quote |= bit;
+            break;
+        case '\\':
+            m.backslash |= bit;
+            break;
+        case ' ':
+            m.space |= bit;
+            break;
+        case '\t': case '\n': case '\r':
+            m.space |= bit;
+            m.control |= bit;
+            break;
+        default:
+            if (c < 0x20) m.control |= bit;
+            if (c >= 0x80) m.non_ascii |= bit;
+        }
+    }
+    return m;
+}
+
+#ifdef MO_JSON_HAVE_AVX2
+__attribute__((target("avx2"))) inline std::uint64_t eq_mask(__m256i lo, __m256i hi, char c) noexcept {
+    const __m256i v = _mm256_set1_epi8(c);
+    const auto l = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, v)));
+    const auto h = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, v)));
+    return l | (std::uint64_t{h} << 32);
+}
+
+__attribute__((target("avx2"))) inline block_masks classify_avx2(const unsigned char* p) noexcept {
+    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+    // '[' | 0x20 == '{' and ']' | 0x20 == '}', so two compares cover all brackets.
+    const __m256i case20 = _mm256_set1_epi8(0x20);
+    const __m256i lo20 = _mm256_or_si256(lo, case20);
+    const __m256i hi20 = _mm256_or_si256(hi, case20);
+
+    block_masks m;
+    m.op = eq_mask(lo20, hi20, '{') | eq_mask(lo20, hi20, '}') | eq_mask(lo, hi, ':') | eq_mask(lo, hi, ',');
+    m.quote = eq_mask(lo, hi, '"');
+    m.backslash = eq_mask(lo, hi, '\\');
+    m.space = eq_mask(lo, hi, ' ') | eq_mask(lo, hi, '\t') | eq_mask(lo, hi, '\n') | eq_mask(lo, hi, '\r');
+    m.non_ascii = static_cast<std::uint32_t>(_mm256_movemask_epi8(lo)) |
+                  (std::uint64_t{static_cast<std::uint32_t>(_mm256_movemask_epi8(hi))} << 32);
+    // Signed compare: 0x20 > c holds for control bytes and for every byte >= 0x80.
+    const auto cl = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(case20, lo)));
+    const auto ch = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(case20, hi)));
+    m.control = (cl | (std::uint64_t{ch} << 32)) & ~m.non_ascii;
+    return m;
+}
+#endif
+
+/// Validates UTF-8 sequences starting in [p, stop); a sequence may run past
+/// `stop` up to `end`. Returns where validation stopped, or nullptr.
+inline const unsigned char* validate_utf8(const unsigned char* p, const unsigned char* stop,
+                                          const unsigned char* end) noexcept {
+    while (p < stop) {
+        if (stop - p >= 8) {
+            std::uint64_t word;
+            std::memcpy(&word, p, 8);
+            if (!(word & 0x8080808080808080ULL)) {
+                p += 8;
+                continue;
+            }
+        }
+        const unsigned char c = *p;
+        if (c < 0x80) {
+            ++p;
+            continue;
+        }
+        unsigned len;
+        std::uint32_t cp;
+        if ((c & 0xE0) == 0xC0) {
+            len = 2;
+            cp = c & 0x1F;
+        } else if ((c & 0xF0) == 0xE0) {
+            len = 3;
+            cp = c & 0x0F;
+        } else if ((c & 0xF8) == 0xF0) {
+            len = 4;
+            cp = c & 0x07;
+        } else {
+            return nullptr;
+        }
+        if (static_cast<std::size_t>(end - p) < len) return nullptr;
+        for (unsigned i = 1; i < len; ++i) {
+            if ((p[i] & 0xC0) != 0x80) return nullptr;
+            cp = (cp << 6) | (p[i] & 0x3F);
+        }
+        static constexpr std::uint32_t min_cp[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (cp < min_cp[len] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return nullptr;
+        p += len;
+    }
+    return p;
+}
+
+inline std::uint64_t prefix_xor(std::uint64_t x) noexcept {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+struct structural_index {
+    std::unique_ptr<std::uint32_t[]> data;
+    std::size_t count = 0;
+
+    std::size_t size() const noexcept { return count; }
+    std::uint32_t operator[](std::size_t i) const noexcept { return data[i]; }
+    const std::uint32_t* begin() const noexcept { return data.get(); }
+    const std::uint32_t* end() const noexcept { return data.get() + count; }
+};
+
+/// Stage 1: one pass over the input, 64 bytes at a time, recording the
+/// offset of every structural character, opening quote and scalar start
+/// outside strings, and validating UTF-8 and string termination.
+inline structural_index scan_structurals(std::string_view json) {
+    if (json.size() >= UINT32_MAX) throw json_error("document too large");
+    const auto* const begin = reinterpret_cast<const unsigned char*>(json.data());
+    const auto* const end = begin + json.size();
+
+    // Sized for the worst case (every byte structural) but left uninitialised,
+    // so only the pages actually written are ever touched.
+    structural_index index;
+    index.data.reset(new std::uint32_t[json.size() + 64]);
+    std::uint32_t* out = index.data.get();
+
+    const bool use_avx2 =
+#ifdef MO_JSON_HAVE_AVX2
+        cpu().avx2;
+#else
+        false;
+#endif
+
+    std::uint64_t in_string_carry = 0;  // all ones when the previous block ended inside a string
+    std::uint64_t escape_carry = 0;  // 1 when the previous block ended in an unescaped backslash
+    std::uint64_t scalar_carry = 0;
+    const unsigned char* utf8_pos = begin;
+    unsigned char tail[64];
+
+    for (std::size_t offset = 0; offset < json.size(); offset += 64) {
+        const unsigned char* block = begin + offset;
+        const std::size_t avail = json.size() - offset;
+        if (avail < 64) {
+            std::memset(tail, ' ', sizeof tail);
+            std::memcpy(tail, block, avail);
+            block = tail;
+        }
+#ifdef MO_JSON_HAVE_AVX2
+        const block_masks m = use_avx2 ? classify_avx2(block) : classify_scalar(block);
+#else
+        const block_masks m = classify_scalar(block);
+#endif
+
+        if (m.non_ascii && utf8_pos < end) {
+            const unsigned char* stop = begin + offset + (avail < 64 ? avail : 64);
+            if (utf8_pos < stop) {
+                utf8_pos = validate_utf8(std::max(utf8_pos, begin + offset), stop, end);
+                if (!utf8_pos) throw json_error("invalid UTF-8");
+            }
+        }
+
+        // A character is escaped when preceded by an odd-length run of
+        // backslashes. Runs starting on odd and even bits are separated with
+        // one carry-propagating add instead of walking the bits.
+        std::uint64_t quote = m.quote;
+        if (m.backslash || escape_carry) {
+            constexpr std::uint64_t even_bits = 0x5555555555555555ULL;
+            const std::uint64_t backslash = m.backslash & ~escape_carry;
+            const std::uint64_t follows_escape = (backslash << 1) | escape_carry;
+            const std::uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+            std::uint64_t even_starts;
+            escape_carry = __builtin_add_overflow(odd_starts, backslash, &even_starts) ? 1 : 0;
+            const std::uint64_t escaped = (even_bits ^ (even_starts << 1)) & follows_escape;
+            quote &= ~escaped;
+        }
+
+        const std::uint64_t in_string = prefix_xor(quote) ^ in_string_carry;
+        in_string_carry = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+        if (m.control & in_string & ~quote) throw json_error("control character in string");
+
+        const std::uint64_t scalar = ~(m.op | m.space | quote | in_string);
+        const std::uint64_t scalar_start = scalar & ~((scalar << 1) | scalar_carry);
+        scalar_carry = scalar >> 63;
+
+        std::uint64_t structural = (m.op & ~in_string) | (quote & in_string) | scalar_start;
+        if (avail < 64) structural &= (std::uint64_t{1} << avail) - 1;
+        while (structural) {
+            *out++ = static_cast<std::uint32_t>(offset + static_cast<unsigned>(std::countr_zero(structural)));
+            structural &= structural - 1;
+        }
+    }
+    if (in_string_carry) throw json_error("unterminated string");
+    index.count = static_cast<std::size_t>(out - index.data.get());
+    return index;
+}
+
+/// Stage 1 plus a bracket balance check, so later skips can trust depth.
+inline structural_index build_index(std::string_view json) {
+    structural_index index = scan_structurals(json);
+    if (index.size() == 0) throw json_error("empty document");
+    std::string stack;
+    for (std::uint32_t pos : index) {
+        const char c = json[pos];
+        if (c == '{' || c == '[') {
+            stack.push_back(c == '{' ? '}' : ']');
+        } else if (c == '}' || c == ']') {
+            if (stack.empty() || stack.back() != c) throw json_error("mismatched bracket");
+            stack.pop_back();
+        }
+    }
+    if (!stack.empty()) throw json_error("unclosed bracket");
+    return index;
+}
+
+inline void append_utf8(std::string& out, std::uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+inline std::uint32_t parse_hex4(std::string_view s, std::size_t at) {
+    if (at + 4 > s.size()) throw json_error("truncated \\u escape");
+    std::uint32_t v = 0;
+    const auto [ptr, ec] = std::from_chars(s.data() + at, s.data() + at + 4, v, 16);
+    if (ec != std::errc{} || ptr != s.data() + at + 4) throw json_error("bad \\u escape");
+    return v;
+}
+
+inline std::string unescape(std::string_view raw) {
+    std::string out;
+    out.reserve(raw.size());
+    for (std::size_t i = 0; i < raw.size(); ++i) {
+        if (raw[i] != '\\') {
+            out.push_back(raw[i]);
+            continue;
+        }
+        if (++i == raw.size()) throw json_error("truncated escape");
+        switch (raw[i]) {
+        case '"': out.push_back('"'); break;
+        case '\\': out.push_back('\\'); break;
+        case '/': out.push_back('/'); break;
+        case 'b': out.push_back('\b'); break;
+        case 'f': out.push_back('\f'); break;
+        case 'n': out.push_back('\n'); break;
+        case 'r': out.push_back('\r'); break;
+        case 't': out.push_back('\t'); break;
+        case 'u': {
+            std::uint32_t cp = parse_hex4(raw, i + 1);
+            i += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                if (i + 2 >= raw.size() || raw[i + 1] != '\\' || raw[i + 2] != 'u')
+                    throw json_error("unpaired surrogate");
+                const std::uint32_t low = parse_hex4(raw, i + 3);
+                if (low < 0xDC00 || low > 0xDFFF) throw json_error("unpaired surrogate");
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                i += 6;
+            } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                throw json_error("unpaired surrogate");
+            }
+            append_utf8(out, cp);
+            break;
+        }
+        default:
+            throw json_error("invalid escape");
+        }
+    }
+    return out;
+}
+
+/// Whether `tok` matches the JSON number grammar,
+/// `-?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?`. `from_chars` is laxer:
+/// it also takes `inf`, `nan`, `.5`, `1.` and leading zeros.
+inline bool valid_number(std::string_view tok) noexcept {
+    std::size_t i = 0;
+    const auto digits = [&] {
+        const std::size_t start = i;
+        while (i < tok.size() && tok[i] >= '0' && tok[i] <= '9') ++i;
+        return i - start;
+    };
+    if (i < tok.size() && tok[i] == '-') ++i;
+    if (i < tok.size() && tok[i] == '0') {
+        ++i;
+    } else if (digits() == 0) {
+        return false;
+    }
+    if (i < tok.size() && tok[i] == '.') {
+        ++i;
+        if (digits() == 0) return false;
+    }
+    if (i < tok.size() && (tok[i] == 'e' || tok[i] == 'E')) {
+        ++i;
+        if (i < tok.size() && (tok[i] == '+' || tok[i] == '-')) ++i;
+        if (digits() == 0) return false;
+    }
+    return i == tok.size();
+}
+
+}  // namespace detail::json
+
+class json_value;
+class json_element_iterator;
+class json_field_iterator;
+
+/// A JSON document indexed for on-demand access.
+///
+/// Construction runs a single vectorised pass (AVX2 when available) that
+/// records where every token starts and validates UTF-8; nothing is
+/// materialised. Values are then reached lazily through `json_value`,
+/// skipping untouched subtrees by bracket depth, and grammar errors are
+/// reported (as `json_error`) only along the paths actually walked. The
+/// input must outlive the document and every value taken from it.
+///
+///     mo::json_document doc(text);
+///     std::int64_t id = doc.root()["user"]["id"].get_int64();
+class json_document {
+public:
+    explicit json_document(std::string_view json) : json_(json), index_(detail::json::build_index(json)) {}
+
+    json_value root() const;
+
+    std::string_view text() const noexcept { return json_; }
+    /// Offsets of structural characters, opening quotes and scalar starts.
+    std::span<const std::uint32_t> structural_index() const noexcept { return {index_.begin(), index_.size()}; }
+
+private:
+    friend class json_value;
+    friend class json_element_iterator;
+    friend class json_field_iterator;
+
+    char at(std::size_t i) const {
+        if (i >= index_.size()) throw json_error("unexpected end of document");
+        return json_[index_[i]];
+    }
+
+    /// Structural index just past the value starting at index `i`.
+    std::size_t skip(std::size_t i) const {
+        const char c = at(i);
+        if (c != '{' && c != '[') return i + 1;
+        std::size_t depth = 0;
+        for (; i < index_.size(); ++i) {
+            const char d = json_[index_[i]];
+            if (d == '{' || d == '[') {
+                ++depth;
+            } else if (d == '}' || d == ']') {
+                if (--depth == 0) return i + 1;
+            }
+        }
+        throw json_error("unclosed bracket");
+    }
+
+    void expect(std::size_t i, char c) const {
+        if (at(i) != c) throw json_error(std::string("expected '") + c + "'");
+    }
+
+    std::string_view json_;
+    detail::json::structural_index index_;
+};
+
+template <typename It>
+struct json_range {
+    It first;
+    It begin() const { return first; }
+    std::default_sentinel_t end() const noexcept { return {}; }
+};
+
+/// Cursor to one value inside a `json_document`; cheap to copy.
+class json_value {
+public:
+    json_type type() const {
+        switch (doc_->at(i_)) {
+        case '{': return json_type::object;
+        case '[': return json_type::array;
+        case '"': return json_type::string;
+        case 't': case 'f': return json_type::boolean;
+        case 'n': return json_type::null;
+        case '-': case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            return json_type::number;
+        default:
+            throw json_error("unexpected character");
+        }
+    }
+
+    /// Object member lookup; scans the keys in order and skips the values it
+    /// passes over without parsing them.
+    std::optional<json_value> find(std::string_view key) const;
+    json_value operator[](std::string_view key) const;
+    /// Array element by position.
+    json_value operator[](std::size_t n) const;
+    /// Number of array elements or object members.
+    std::size_t size() const;
+
+    /// Iterates array elements in order.
+    json_range<json_element_iterator> elements() const;
+    /// Iterates object members in order.
+    json_range<json_field_iterator> fields() const;
+
+    /// The token text as it appears in the input (quotes included for strings;
+    /// the full bracketed text for objects and arrays).
+    std::string_view raw() const {
+        const std::string_view text = doc_->json_;
+        const std::size_t begin = doc_->index_[i_];
+        const char c = text[begin];
+        if (c == '{' || c == '[') return text.substr(begin, doc_->index_[doc_->skip(i_) - 1] - begin + 1);
+        if (c == '"') return text.substr(begin, string_end(begin) + 1 - begin);
+        std::size_t end = begin;
+        while (end < text.size() && !is_delimiter(text[end])) ++end;
+        return text.substr(begin, end - begin);
+    }
+
+    /// String contents without quotes, escape sequences left as-is. Zero-copy.
+    std::string_view get_raw_string() const {
+        if (type() != json_type::string) throw json_error("not a string");
+        const std::size_t begin = doc_->index_[i_];
+        return doc_->json_.substr(begin + 1, string_end(begin) - begin - 1);
+    }
+
+    /// String contents with escapes decoded.
+    std::string get_string() const {
+        const std::string_view raw_str = get_raw_string();
+        if (raw_str.find('\\') == std::string_view::npos) return std::string(raw_str);
+        return detail::json::unescape(raw_str);
+    }
+
+    std::int64_t get_int64() const { return parse_number<std::int64_t>(); }
+    std::uint64_t get_uint64() const { return parse_number<std::uint64_t>(); }
+    double get_double() const { return parse_number<double>(); }
+
+    bool get_bool() const {
+        const std::string_view tok = raw();
+        if (tok == "true") return true;
+        if (tok == "false") return false;
+        throw json_error("not a boolean");
+    }
+
+    bool is_null() const { return doc_->at(i_) == 'n' && raw() == "null"; }
+
+private:
+    friend class json_document;
+    friend class json_element_iterator;
+    friend class json_field_iterator;
+
+    json_value(const json_document* doc, std::size_t i) noexcept : doc_(doc), i_(i) {}
+
+    static bool is_delimiter(char c) noexcept {
+        switch (c) {
+        case ' ': case '\t': case '\n': case '\r': case ',': case ':':
+        case '{': case '}': case '[': case ']': case '"':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /// Offset of the closing quote for the string opening at `begin`.
+    std::size_t string_end(std::size_t begin) const {
+        const std::string_view text = doc_->json_;
+        for (std::size_t p = begin + 1;; ++p) {
+            p = text.find_first_of("\"\\", p);
+            if (p == std::string_view::npos) throw json_error("unterminated string");
+            if (text[p] == '"') return p;
+            ++p;  // skip the escaped character
+        }
+    }
+
+    template <typename T>
+    T parse_number() const {
+        if (type() != json_type::number) throw json_error("not a number");
+        const std::string_view tok = raw();
+        if (!detail::json::valid_number(tok)) throw json_error("invalid number");
+        T v{};
+        const auto [ptr, ec] = std::from_chars(tok.data(), tok.data() + tok.size(), v);
+        if (ec == std::errc::result_out_of_range) throw json_error("number out of range");
+        if (ec != std::errc{} || ptr != tok.data() + tok.size()) throw json_error("invalid number");
+        return v;
+    }
+
+    const json_document* doc_;
+    std::size_t i_;
+};
+
+/// One object member as yielded by `json_value::fields()`.
+struct json_field {
+    std::string_view raw_key;  // escapes left as-is
+    json_value value;
+
+    bool key_equals(std::string_view key) const {
+        if (raw_key.find('\\') == std::string_view::npos) return raw_key == key;
+        return detail::json::unescape(raw_key) == key;
+    }
+};
+
+class json_element_iterator {
+public:
+    using value_type = json_value;
+    using difference_type = std::ptrdiff_t;
+
+    json_element_iterator() = default;
+    json_element_iterator(const json_document* doc, std::size_t open) : doc_(doc) {
+        doc_->expect(open, '[');
+        i_ = open + 1;
+        if (doc_->at(i_) == ']') doc_ = nullptr;
+    }
+
+    json_value operator*() const { return {doc_, i_}; }
+    json_element_iterator& operator++() {
+        const std::size_t next = doc_->skip(i_);
+        if (doc_->at(next) == ']') {
+            doc_ = nullptr;
+        } else {
+            doc_->expect(next, ',');
+            i_ = next + 1;
+        }
+        return *this;
+    }
+    void operator++(int) { ++*this; }
+    bool operator==(std::default_sentinel_t) const noexcept { return doc_ == nullptr; }
+
+private:
+    const json_document* doc_ = nullptr;
+    std::size_t i_ = 0;
+};
+
+class json_field_iterator {
+public:
+    using value_type = json_field;
+    using difference_type = std::ptrdiff_t;
+
+    json_field_iterator() = default;
+    json_field_iterator(const json_document* doc, std::size_t open) : doc_(doc) {
+        doc_->expect(open, '{');
+        if (doc_->at(open + 1) == '}')
+            doc_ = nullptr;
+        else
+            load(open + 1);
+    }
+
+    const json_field& operator*() const noexcept { return current_; }
+    const json_field* operator->() const noexcept { return &current_; }
+    json_field_iterator& operator++() {
+        const std::size_t next = doc_->skip(current_.value.i_);
+        if (doc_->at(next) == '}') {
+            doc_ = nullptr;
+        } else {
+            doc_->expect(next, ',');
+            load(next + 1);
+        }
+        return *this;
+    }
+    void operator++(int) { ++*this; }
+    bool operator==(std::default_sentinel_t) const noexcept { return doc_ == nullptr; }
+
+private:
+    void load(std::size_t key) {
+        if (doc_->at(key) != '"') throw json_error("expected object key");
+        doc_->expect(key + 1, ':');
+        current_ = json_field{json_value{doc_, key}.get_raw_string(), json_value{doc_, key + 2}};
+    }
+
+    const json_document* doc_ = nullptr;
+    json_field current_{{}, json_value{nullptr, 0}};
+};
+
+inline json_range<json_element_iterator> json_value::elements() const { return {json_element_iterator{doc_, i_}}; }
+
+inline json_range<json_field_iterator> json_value::fields() const { return {json_field_iterator{doc_, i_}}; }
+
+inline std::optional<json_value> json_value::find(std::string_view key) const {
+    for (const json_field& field : fields()) {
+        if (field.key_equals(key)) return field.value;
+    }
+    return std::nullopt;
+}
+
+inline json_value json_value::operator[](std::string_view key) const {
+    if (auto v = find(key)) return *v;
+    throw json_error("missing key '" + std::string(key) + "'");
+}
+
+inline json_value json_value::operator[](std::size_t n) const {
+    for (json_value v : elements()) {
+        if (n-- == 0) return v;
+    }
+    throw json_error("array index out of range");
+}
+
+inline std::size_t json_value::size() const {
+    std::size_t n = 0;
+    if (type() == json_type::object) {
+        for ([[maybe_unused]] const json_field& f : fields()) ++n;
+    } else {
+        for ([[maybe_unused]] json_value v : elements()) ++n;
+    }
+    return n;
+}
+
+inline json_value json_document::root() const {
+    if (skip(0) != index_.size()) throw json_error("trailing content after root value");
+    return json_value{this, 0};
+}
+
+}  // namespace mo
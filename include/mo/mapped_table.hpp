@@ -0,0 +1,508 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "mo/serialize.hpp"
+
+namespace mo {
+
+/// Thrown when a table file's footer or index is malformed. Damaged entries
+/// surface as the `deserialize_error` this derives from.
+class table_error : public deserialize_error {
+public:
+    using deserialize_error::deserialize_error;
+};
+
+struct table_options {
+    std::size_t block_size = 1024;  // entry bytes per fence key: smaller blocks scan less, index more
+    bool hash_index = true;         // add a hash index for O(1) point lookups
+};
+
+/// One key/value pair of a `mapped_table`, pointing into the mapping.
+struct table_entry {
+    std::string_view key;
+    std::string_view value;
+};
+
+namespace detail::table {
+
+// File layout, all integers little-endian:
+//
+//   entries      key and value as `binary_writer` byte strings, sorted by key
+//   index        u64 block start offsets, blocks + 1 of them (the last is the end of entries)
+//   prefixes     u64 per block: 8 bytes of its first key after the prefix all first keys share
+//                (footer.shared), big-endian and zero-padded
+//   fences       u64 offsets of each block's first key in the key bytes, blocks + 1, then the key bytes
+//   hash         u64 slots, a power of two of them (or none): tag << 40 | entry offset + 1, 0 if empty
+//   footer       see below, 80 bytes
+//
+// Sections start 8-byte aligned, so the mapped arrays are read in place.
+inline constexpr std::uint64_t magic = 0x3142415442544F4DULL;  // "MOTBTAB1"
+inline constexpr std::uint32_t version = 1;
+inline constexpr std::size_t footer_size = 80;
+inline constexpr std::uint64_t offset_bits = 40;  // entries up to 1 TiB
+inline constexpr std::uint64_t offset_mask = (std::uint64_t{1} << offset_bits) - 1;
+inline constexpr std::uint64_t max_entry_offset = offset_mask - 1;  // slots hold offset + 1
+
+struct footer {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint64_t count;
+    std::uint64_t blocks;
+    std::uint64_t index_pos;
+    std::uint64_t prefixes_pos;
+    std::uint64_t fences_pos;
+    std::uint64_t hash_pos;
+    std::uint64_t hash_slots;
+    std::uint64_t shared;
+};
+static_assert(sizeof(footer) == footer_size);
+
+/// MurmurHash64A. Part of the file format, so it must never change.
+inline std::uint64_t hash(std::string_view key) noexcept {
+    constexpr std::uint64_t m = 0xc6a4a7935bd1e995ULL;
+    constexpr int r = 47;
+    std::uint64_t h = 0x5bd1e995ULL ^ (key.size() * m);
+    const char* p = key.data();
+    const char* end = p + key.size() / 8 * 8;
+    for (; p != end; p += 8) {
+        std::uint64_t k;
+        std::memcpy(&k, p, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    if (const std::size_t tail = key.size() & 7) {
+        std::uint64_t k = 0;
+        std::memcpy(&k, p, tail);
+        h ^= k;
+        h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+inline std::uint64_t load64(const char* p) noexcept {
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+/// Orders like the key itself as far as 8 bytes from `skip` go.
+inline std::uint64_t prefix(std::string_view key, std::size_t skip) noexcept {
+    std::uint64_t v = 0;
+    if (key.size() > skip) std::memcpy(&v, key.data() + skip, std::min<std::size_t>(key.size() - skip, 8));
+    return __builtin_bswap64(v);
+}
+
+/// Hash slot for the entry at `pos`: the hash's top bits as a tag over
+/// `pos + 1`, so an empty slot is 0.
+inline std::uint64_t hash_slot(std::uint64_t h, std::uint64_t pos) noexcept {
+    return (h >> offset_bits) << offset_bits | (pos + 1);
+}
+
+inline void pad8(std::string& out, std::uint64_t file_offset) { out.append((8 - file_offset % 8) % 8, '\0'); }
+
+}  // namespace detail::table
+
+/// Read-only sorted key/value table in a memory-mapped file written by
+/// `mapped_table_builder`.
+///
+/// Opening maps the file and checks its footer and index; nothing is parsed
+/// or copied, so a multi-gigabyte table opens in microseconds and every
+/// process mapping it shares one copy in the page cache. Point lookups go
+/// through the hash index when the file has one (one probe, usually one
+/// entry decoded), otherwise through a binary search of the fence keys (the
+/// first key of every block, kept contiguous so the search stays in a few
+/// hot pages) and a scan of one block. Iteration is in key order.
+///
+/// Keys and values are views into the mapping, valid while the table lives.
+/// Malformed files throw `table_error` or `deserialize_error`, never read
+/// outside the mapping; I/O errors throw `std::system_error`.
+class mapped_table {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = table_entry;
+        using difference_type = std::ptrdiff_t;
+        using reference = table_entry;
+        using pointer = void;
+
+        iterator() = default;
+
+        table_entry operator*() const { return table_->entry_at(pos_, nullptr); }
+
+        iterator& operator++() {
+            table_->entry_at(pos_, &pos_);
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const iterator& other) const noexcept { return pos_ == other.pos_; }
+
+    private:
+        friend class mapped_table;
+        iterator(const mapped_table* table, std::uint64_t pos) noexcept : table_(table), pos_(pos) {}
+
+        const mapped_table* table_ = nullptr;
+        std::uint64_t pos_ = 0;
+    };
+
+    mapped_table() noexcept = default;
+
+    /// Maps `path`; `populate` faults every page in up front (MAP_POPULATE)
+    /// instead of on first access.
+    explicit mapped_table(const std::string& path, bool populate = false) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::system_error(errno, std::system_category(), "open " + path);
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::system_category(), "fstat " + path);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ < detail::table::footer_size) {
+            ::close(fd);
+            throw table_error("table: file too small: " + path);
+        }
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED | (populate ? MAP_POPULATE : 0), fd, 0);
+        const int error = errno;
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::system_error(error, std::system_category(), "mmap " + path);
+        data_ = static_cast<const char*>(p);
+        try {
+            validate();
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    mapped_table(mapped_table&& other) noexcept { swap(other); }
+
+    mapped_table& operator=(mapped_table&& other) noexcept {
+        mapped_table(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~mapped_table() { release(); }
+
+    void swap(mapped_table& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(footer_, other.footer_);
+        std::swap(entries_end_, other.entries_end_);
+    }
+
+    std::size_t size() const noexcept { return static_cast<std::size_t>(footer_.count); }
+    bool empty() const noexcept { return footer_.count == 0; }
+    bool has_hash_index() const noexcept { return footer_.hash_slots != 0; }
+
+    /// Bytes of the mapped file.
+    std::size_t file_size() const noexcept { return size_; }
+
+    std::optional<std::string_view> find(std::string_view key) const {
+        if (has_hash_index()) {
+            const std::uint64_t h = detail::table::hash(key), mask = footer_.hash_slots - 1;
+            const std::uint64_t tag = h >> detail::table::offset_bits;
+            // Bounded so a damaged table without an empty slot cannot loop forever.
+            for (std::uint64_t i = h & mask, probes = 0; probes <= mask; i = (i + 1) & mask, ++probes) {
+                const std::uint64_t slot = detail::table::load64(data_ + footer_.hash_pos + i * 8);
+                if (slot == 0) return std::nullopt;
+                if (slot >> detail::table::offset_bits != tag) continue;
+                const std::uint64_t pos = (slot & detail::table::offset_mask) - 1;
+                if (pos >= entries_end_) throw table_error("table: hash slot out of range");
+                const table_entry e = entry_at(pos, nullptr);
+                if (e.key == key) return e.value;
+            }
+            return std::nullopt;
+        }
+        const iterator it = lower_bound(key);
+        if (it == end()) return std::nullopt;
+        const table_entry e = *it;
+        return e.key == key ? std::optional(e.value) : std::nullopt;
+    }
+
+    bool contains(std::string_view key) const { return find(key).has_value(); }
+
+    iterator begin() const noexcept { return {this, 0}; }
+    iterator end() const noexcept { return {this, entries_end_}; }
+
+    /// First entry with a key not less than `key`.
+    iterator lower_bound(std::string_view key) const {
+        if (empty()) return end();
+        // Last block whose first key is <= key; keys before the first block's
+        // first key land at the start of block 0. The search runs on the
+        // prefix array, one cache line per step, and reads a whole fence key
+        // only on a prefix tie.
+        std::uint64_t lo = 0, hi = footer_.blocks;
+        const std::string_view shared = fence(0).substr(0, static_cast<std::size_t>(footer_.shared));
+        if (const int c = key.substr(0, shared.size()).compare(shared); c != 0) {
+            // Outside the shared prefix: before every block or in the last.
+            if (c > 0) lo = hi - 1;
+            hi = lo + 1;
+        }
+        const std::uint64_t p = detail::table::prefix(key, shared.size());
+        while (hi - lo > 1) {
+            const std::uint64_t mid = lo + (hi - lo) / 2;
+            const std::uint64_t q = detail::table::load64(data_ + footer_.prefixes_pos + mid * 8);
+            (q < p || (q == p && fence(mid) <= key) ? lo : hi) = mid;
+        }
+        std::uint64_t pos = block_start(lo);
+        const std::uint64_t stop = block_start(lo + 1);
+        while (pos < stop) {
+            std::uint64_t next;
+            if (entry_at(pos, &next).key >= key) break;
+            pos = next;
+        }
+        return {this, pos};
+    }
+
+private:
+    void release() noexcept {
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    std::uint64_t block_start(std::uint64_t b) const noexcept {
+        return detail::table::load64(data_ + footer_.index_pos + b * 8);
+    }
+
+    std::uint64_t fence_offset(std::uint64_t b) const noexcept {
+        return detail::table::load64(data_ + footer_.fences_pos + b * 8);
+    }
+
+    std::string_view fence(std::uint64_t b) const noexcept {
+        const char* keys = data_ + footer_.fences_pos + (footer_.blocks + 1) * 8;
+        return {keys + fence_offset(b), static_cast<std::size_t>(fence_offset(b + 1) - fence_offset(b))};
+    }
+
+    table_entry entry_at(std::uint64_t pos, std::uint64_t* next) const {
+        binary_reader in(std::string_view(data_ + pos, static_cast<std::size_t>(entries_end_ - pos)));
+        table_entry e;
+        e.key = in.read_bytes();
+        e.value = in.read_bytes();
+        if (next) *next = entries_end_ - in.remaining();
+        return e;
+    }
+
+    /// Checks that every section lies in the file and the index arrays are
+    /// ordered, so later reads only need the per-entry checks.
+    void validate() {
+        std::memcpy(&footer_, data_ + size_ - detail::table::footer_size, detail::table::footer_size);
+        const detail::table::footer& f = footer_;
+        if (f.magic != detail::table::magic) throw table_error("table: bad magic");
+        if (f.version != detail::table::version) throw table_error("table: unsupported version");
+        const std::uint64_t body = size_ - detail::table::footer_size;
+        const auto fits = [&](std::uint64_t pos, std::uint64_t count) {
+            return pos % 8 == 0 && pos <= body && count <= (body - pos) / 8;
+        };
+        if (f.blocks > f.count || (f.count > 0) != (f.blocks > 0) || !fits(f.index_pos, f.blocks + 1) ||
+            !fits(f.prefixes_pos, f.blocks) || !fits(f.fences_pos, f.blocks + 1) || !fits(f.hash_pos, f.hash_slots) ||
+            (f.hash_slots != 0 && (!std::has_single_bit(f.hash_slots) || f.hash_slots <= f.count)))
+            throw table_error("table: bad footer");
+        for (std::uint64_t b = 0; b < f.blocks; ++b)
+            if (block_start(b) >= block_start(b + 1) || fence_offset(b) > fence_offset(b + 1))
+                throw table_error("table: index out of order");
+        entries_end_ = block_start(f.blocks);
+        const std::uint64_t keys_pos = f.fences_pos + (f.blocks + 1) * 8;
+        if (block_start(0) != 0 || entries_end_ > f.index_pos || fence_offset(0) != 0 ||
+            fence_offset(f.blocks) > body - keys_pos)
+            throw table_error("table: index out of range");
+    }
+
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    detail::table::footer footer_{};
+    std::uint64_t entries_end_ = 0;
+};
+
+/// Writes a `mapped_table` file in one pass over keys in strictly
+/// increasing order.
+///
+/// Entries stream to a temporary file next to `path`; the index and the
+/// hash table (16 bytes of memory per key while building) follow them in
+/// `finish`, which syncs the file, renames it into place and syncs the
+/// directory, so readers never map a partial table. Destroying an unfinished
+/// builder removes the temporary file. Throws `std::system_error` on I/O
+/// errors.
+class mapped_table_builder {
+public:
+    explicit mapped_table_builder(std::string path, const table_options& options = {})
+        : path_(std::move(path)), tmp_(path_ + ".tmp"), options_(options) {
+        fd_ = ::open(tmp_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) throw std::system_error(errno, std::system_category(), "open " + tmp_);
+    }
+
+    ~mapped_table_builder() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            ::unlink(tmp_.c_str());
+        }
+    }
+
+    mapped_table_builder(const mapped_table_builder&) = delete;
+    mapped_table_builder& operator=(const mapped_table_builder&) = delete;
+
+    /// Throws `std::invalid_argument` unless `key` sorts after the previous.
+    void add(std::string_view key, std::string_view value) {
+        if (fd_ < 0) throw std::logic_error("mapped_table_builder: already finished");
+        if (count_ > 0 && key <= last_key_) throw std::invalid_argument("mapped_table_builder: keys out of order");
+        const std::uint64_t pos = offset();
+        if (pos > detail::table::max_entry_offset) throw std::invalid_argument("mapped_table_builder: table too large");
+        if (count_ == 0 || pos - block_starts_.back() >= options_.block_size) {
+            block_starts_.push_back(pos);
+            fence_offsets_.push_back(fence_keys_.size());
+            fence_keys_.append(key);
+        }
+        binary_writer out(buf_);
+        out.write_bytes(key.data(), key.size());
+        out.write_bytes(value.data(), value.size());
+        if (options_.hash_index) hashes_.push_back({detail::table::hash(key), pos});
+        last_key_.assign(key);
+        ++count_;
+        if (buf_.size() >= (std::size_t{1} << 20)) flush();
+    }
+
+    std::size_t size() const noexcept { return static_cast<std::size_t>(count_); }
+
+    /// Writes the index and footer and moves the file to `path`.
+    void finish() {
+        if (fd_ < 0) throw std::logic_error("mapped_table_builder: already finished");
+        detail::table::footer f{};
+        f.magic = detail::table::magic;
+        f.version = detail::table::version;
+        f.count = count_;
+        f.blocks = block_starts_.size();
+
+        block_starts_.push_back(offset());
+        fence_offsets_.push_back(fence_keys_.size());
+        detail::table::pad8(buf_, offset());
+        f.index_pos = offset();
+        append_array(block_starts_);
+        f.prefixes_pos = offset();
+        append_prefixes(f);
+        f.fences_pos = offset();
+        append_array(fence_offsets_);
+        buf_ += fence_keys_;
+        detail::table::pad8(buf_, offset());
+
+        f.hash_pos = offset();
+        if (options_.hash_index && count_ > 0) {
+            // Load factor at most 0.7: linear probing stays at ~2 probes for hits.
+            f.hash_slots = std::bit_ceil(count_ * 10 / 7 + 1);
+            std::vector<std::uint64_t> slots(f.hash_slots);
+            for (const auto& [h, pos] : hashes_) {
+                std::uint64_t i = h & (f.hash_slots - 1);
+                while (slots[i]) i = (i + 1) & (f.hash_slots - 1);
+                slots[i] = detail::table::hash_slot(h, pos);
+            }
+            append_array(slots);
+        }
+        buf_.append(reinterpret_cast<const char*>(&f), sizeof f);
+        flush();
+        if (::fsync(fd_) != 0) throw std::system_error(errno, std::system_category(), "fsync " + tmp_);
+        const int rc = ::close(fd_);
+        fd_ = -1;
+        if (rc != 0 || std::rename(tmp_.c_str(), path_.c_str()) != 0) {
+            const int error = errno;
+            ::unlink(tmp_.c_str());
+            throw std::system_error(error, std::system_category(), "rename " + tmp_);
+        }
+        sync_parent();
+    }
+
+private:
+    std::uint64_t offset() const noexcept { return written_ + buf_.size(); }
+
+    /// Makes the rename itself durable: it lives in the directory, not the file.
+    void sync_parent() const {
+        const std::size_t slash = path_.rfind('/');
+        const std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path_.substr(0, slash);
+        const int dfd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dfd < 0) throw std::system_error(errno, std::system_category(), "open " + dir);
+        const int rc = ::fsync(dfd);
+        const int error = errno;
+        ::close(dfd);
+        if (rc != 0) throw std::system_error(error, std::system_category(), "fsync " + dir);
+    }
+
+    /// Sorted keys share what the first and last share.
+    void append_prefixes(detail::table::footer& f) {
+        if (f.blocks == 0) return;
+        const std::string_view keys = fence_keys_;
+        const std::string_view first = keys.substr(0, fence_offsets_[1]);
+        const std::string_view last = keys.substr(fence_offsets_[f.blocks - 1]);
+        f.shared = static_cast<std::uint64_t>(std::mismatch(first.begin(), first.end(), last.begin(), last.end()).first -
+                                              first.begin());
+        for (std::uint64_t b = 0; b < f.blocks; ++b) {
+            const std::uint64_t p = detail::table::prefix(
+                keys.substr(fence_offsets_[b], fence_offsets_[b + 1] - fence_offsets_[b]), f.shared);
+            buf_.append(reinterpret_cast<const char*>(&p), 8);
+        }
+    }
+
+    void append_array(const std::vector<std::uint64_t>& v) {
+        buf_.append(reinterpret_cast<const char*>(v.data()), v.size() * 8);
+    }
+
+    void flush() {
+        for (std::size_t done = 0; done < buf_.size();) {
+            const ssize_t n = ::write(fd_, buf_.data() + done, buf_.size() - done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::system_category(), "write " + tmp_);
+            }
+            done += static_cast<std::size_t>(n);
+        }
+        written_ += buf_.size();
+        buf_.clear();
+    }
+
+    std::string path_;
+    std::string tmp_;
+    table_options options_;
+    int fd_ = -1;
+    std::string buf_;
+    std::uint64_t written_ = 0;
+    std::uint64_t count_ = 0;
+    std::string last_key_;
+    std::vector<std::uint64_t> block_starts_;
+    std::vector<std::uint64_t> fence_offsets_;
+    std::string fence_keys_;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> hashes_;  // key hash, entry offset
+};
+
+}  // namespace mo
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+namespace mo {
+
+/// Backing for a `memory_region`, from largest to smallest page.
+enum class page_kind {
+    huge_1g,           // hugetlbfs 1 GiB pages (reserved by the administrator)
+    huge_2m,           // hugetlbfs 2 MiB pages (reserved by the administrator)
+    transparent_huge,  // ordinary mapping, 2 MiB aligned, advised for THP
+    normal,
+};
+
+struct region_options {
+    /// Preferred backing. With `fallback`, smaller kinds are tried in order
+    /// until one maps; without it, failure to get this kind throws.
+    page_kind pages = page_kind::huge_2m;
+    bool fallback = true;
+    /// NUMA node to place the pages on, or -1 for the default policy.
+    int numa_node = -1;
+    /// With a node: fail allocations rather than spill to other nodes.
+    bool strict_node = true;
+    /// Fault every page in up front instead of on first touch.
+    bool populate = false;
+};
+
+/// Where the pages of a region live, as reported by the kernel.
+struct region_placement {
+    std::size_t page_bytes = 0;                // granularity of the counts below
+    std::vector<std::size_t> pages_per_node;   // indexed by node id
+    std::size_t pages_not_present = 0;         // never touched, or swapped out
+    std::size_t transparent_huge_bytes = 0;    // THP-backed bytes (AnonHugePages)
+};
+
+namespace detail::memory {
+
+inline std::size_t kind_page_bytes(page_kind kind) noexcept {
+    switch (kind) {
+    case page_kind::huge_1g: return std::size_t{1} << 30;
+    case page_kind::huge_2m:
+    case page_kind::transparent_huge: return std::size_t{1} << 21;
+    case page_kind::normal: break;
+    }
+    return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+inline std::size_t round_up(std::size_t n, std::size_t to) noexcept {
+    return (n + to - 1) / to * to;
+}
+
+inline long mbind(void* addr, std::size_t len, int mode, const unsigned long* mask, unsigned long maxnode,
+                  unsigned flags) noexcept {
+    return ::syscall(SYS_mbind, addr, len, mode, mask, maxnode, flags);
+}
+
+inline long move_pages(unsigned long count, void** pages, int* status) noexcept {
+    return ::syscall(SYS_move_pages, 0, count, pages, nullptr, status, 0);
+}
+
+}  // namespace detail::memory
+
+/// Number of NUMA nodes the kernel reports online (1 without NUMA support).
+inline int numa_node_count() {
+    std::ifstream in("/sys/devices/system/node/online");
+    std::string ranges;
+    if (!(in >> ranges)) return 1;
+    // Format is e.g. "0-3,6": the highest id plus one.
+    const auto last = ranges.find_last_of(",-");
+    return std::stoi(last == std::string::npos ? ranges : ranges.substr(last + 1)) + 1;
+}
+
+/// NUMA node of the CPU the calling thread is running on right now.
+inline int current_numa_node() noexcept {
+    unsigned cpu = 0, node = 0;
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return 0;
+    return static_cast<int>(node);
+}
+
+/// Applies a NUMA policy to [addr, addr + len) via `mbind(2)`: only `node`
+/// when `strict`, else preferring it. With `move`, pages already faulted in
+/// elsewhere migrate. Throws `std::system_error`; kernels without NUMA
+/// support accept node 0 as a no-op.
+inline void bind_to_node(void* addr, std::size_t len, int node, bool strict = true, bool move = false) {
+    constexpr std::size_t mask_bits = 1024;
+    unsigned long mask[mask_bits / (8 * sizeof(unsigned long))] = {};
+    if (node < 0 || static_cast<std::size_t>(node) >= mask_bits)
+        throw std::system_error(EINVAL, std::system_category(), "mbind node");
+    mask[static_cast<std::size_t>(node) / (8 * sizeof(unsigned long))] |=
+        1ul << (static_cast<std::size_t>(node) % (8 * sizeof(unsigned long)));
+    // The kernel reads maxnode - 1 bits.
+    if (detail::memory::mbind(addr, len, strict ? MPOL_BIND : MPOL_PREFERRED, mask, mask_bits + 1,
+                              move ? MPOL_MF_MOVE : 0) != 0) {
+        if (errno == ENOSYS && node == 0) return;
+        throw std::system_error(errno, std::system_category(), "mbind");
+    }
+}
+
+/// Anonymous memory mapping for large buffers, backed by huge pages where
+/// the system allows and optionally bound to a NUMA node.
+///
+/// Huge pages cut TLB misses on big tables; hugetlbfs pages must be reserved
+/// (`vm.nr_hugepages`), so by default the constructor falls back from the
+/// preferred `page_kind` to smaller ones and finally to 2 MiB-aligned memory
+/// advised for transparent huge pages. `kind()` reports what was obtained.
+/// The NUMA policy is applied before any page is touched, so first-touch
+/// placement never puts pages on the wrong node.
+class memory_region {
+public:
+    memory_region() noexcept = default;
+
+    explicit memory_region(std::size_t bytes, const region_options& options = {}) {
+        if (bytes == 0) throw std::system_error(EINVAL, std::system_category(), "memory_region size");
+        int error = 0;
+        for (auto kind = options.pages;; kind = static_cast<page_kind>(static_cast<int>(kind) + 1)) {
+            error = map(bytes, kind);
+            if (error == 0 || !options.fallback || kind == page_kind::normal) break;
+        }
+        if (error != 0) throw std::system_error(error, std::system_category(), "mmap memory_region");
+
+        try {
+            if (options.numa_node >= 0) bind_to_node(data_, size_, options.numa_node, options.strict_node);
+            if (options.populate) populate();
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    memory_region(memory_region&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          kind_(other.kind_) {}
+
+    memory_region& operator=(memory_region&& other) noexcept {
+        if (this != &other) {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            kind_ = other.kind_;
+        }
+        return *this;
+    }
+
+    ~memory_region() { release(); }
+
+    void* data() const noexcept { return data_; }
+    /// Usable bytes: the request rounded up to whole pages of `kind()`.
+    std::size_t size() const noexcept { return size_; }
+    page_kind kind() const noexcept { return kind_; }
+    std::size_t page_bytes() const noexcept { return detail::memory::kind_page_bytes(kind_); }
+    explicit operator bool() const noexcept { return data_ != nullptr; }
+
+    /// Faults in every page now, after any NUMA policy took effect.
+    void populate() {
+        if (::madvise(data_, size_, MADV_POPULATE_WRITE) == 0) return;
+        // EINVAL is a kernel before 5.14 not knowing the advice; anything else
+        // (ENOMEM, EFAULT, EHWPOISON) is a real failure to populate.
+        if (errno != EINVAL) throw std::system_error(errno, std::system_category(), "madvise MADV_POPULATE_WRITE");
+        // Older kernels: rewrite one byte per page, which faults it in
+        // without changing contents (do not race with other writers).
+        const std::size_t step = kind_ == page_kind::normal || kind_ == page_kind::transparent_huge
+                                     ? detail::memory::kind_page_bytes(page_kind::normal)
+                                     : page_bytes();
+        for (std::size_t off = 0; off < size_; off += step) {
+            volatile char* c = static_cast<char*>(data_) + off;
+            *c = *c;
+        }
+    }
+
+    /// Per-node page counts from `move_pages(2)` and THP coverage from
+    /// `/proc/self/smaps`. Costs a syscall per 1024 pages; meant for
+    /// diagnostics, not hot paths.
+    region_placement placement() const {
+        region_placement p;
+        p.page_bytes = kind_ == page_kind::huge_1g || kind_ == page_kind::huge_2m
+                           ? page_bytes()
+                           : detail::memory::kind_page_bytes(page_kind::normal);
+        constexpr std::size_t batch = 1024;
+        void* pages[batch];
+        int status[batch];
+        for (std::size_t off = 0; off < size_;) {
+            std::size_t n = 0;
+            for (; n < batch && off < size_; ++n, off += p.page_bytes) pages[n] = static_cast<char*>(data_) + off;
+            if (detail::memory::move_pages(n, pages, status) != 0) {
+                if (errno != ENOSYS) throw std::system_error(errno, std::system_category(), "move_pages");
+                std::fill_n(status, n, 0);  // no NUMA: everything is on node 0
+            }
+            for (std::size_t k = 0; k < n; ++k) {
+                if (status[k] < 0) {
+                    ++p.pages_not_present;
+                    continue;
+                }
+                const auto node = static_cast<std::size_t>(status[k]);
+                if (node >= p.pages_per_node.size()) p.pages_per_node.resize(node + 1);
+                ++p.pages_per_node[node];
+            }
+        }
+        p.transparent_huge_bytes = thp_bytes();
+        return p;
+    }
+
+private:
+    // Maps `bytes` as `kind`; returns 0 or the errno of the failed mmap.
+    int map(std::size_t bytes, page_kind kind) noexcept {
+        const std::size_t page = detail::memory::kind_page_bytes(kind);
+        const std::size_t size = detail::memory::round_up(bytes, page);
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        if (kind == page_kind::huge_1g) flags |= MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+        if (kind == page_kind::huge_2m) flags |= MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+        // THP only backs 2 MiB-aligned ranges; over-map and trim to align.
+        const std::size_t slack = kind == page_kind::transparent_huge ? page : 0;
+
+        void* base = ::mmap(nullptr, size + slack, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (base == MAP_FAILED) return errno;
+        char* data = static_cast<char*>(base);
+        if (slack) {
+            const auto addr = reinterpret_cast<std::uintptr_t>(base);
+            const std::size_t head = detail::memory::round_up(addr, page) - addr;
+            data += head;
+            if (head) ::munmap(base, head);
+            if (slack - head) ::munmap(data + size, slack - head);
+            ::madvise(data, size, MADV_HUGEPAGE);  // advisory; THP may be disabled
+        }
+        data_ = data;
+        size_ = size;
+        kind_ = kind;
+        return 0;
+    }
+
+    void release() noexcept {
+        if (data_) ::munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    std::size_t thp_bytes() const {
+        std::ifstream in("/proc/self/smaps");
+        const auto lo = reinterpret_cast<std::uintptr_t>(data_), hi = lo + size_;
+        std::size_t total = 0;
+        bool inside = false;
+        for (std::string line; std::getline(in, line);) {
+            unsigned long start = 0, end = 0;
+            // Mapping headers start "lo-hi "; field lines never parse as two numbers.
+            if (std::sscanf(line.c_str(), "%lx-%lx ", &start, &end) == 2) {
+                inside = start < hi && end > lo;
+            } else if (inside && line.rfind("AnonHugePages:", 0) == 0) {
+                total += std::stoul(line.substr(14)) * 1024;
+            }
+        }
+        return total;
+    }
+
+    void* data_ = nullptr;
+    std::size_t size_ = 0;
+    page_kind kind_ = page_kind::normal;
+};
+
+}  // namespace mo
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mo {
+
+/// Label name/value pairs of one time series, in output order.
+using metric_labels = std::vector<std::pair<std::string, std::string>>;
+
+namespace detail::metrics {
+
+/// Cache line of counters; shards never share one, so threads on different
+/// shards never contend.
+struct alignas(64) line {
+    std::atomic<std::uint64_t> word[8];
+};
+
+inline std::size_t shard_count() noexcept {
+    static const std::size_t n =
+        std::bit_ceil(std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, 256));
+    return n;
+}
+
+/// Stable per-thread index; threads take consecutive slots, so up to
+/// `shard_count()` threads each get a shard to themselves.
+inline std::atomic<std::size_t> next_slot{0};
+// Constant-initialized so the hot path reads TLS directly, without the
+// guard call a dynamically initialized thread_local costs.
+inline thread_local std::size_t slot_plus_one = 0;
+
+inline std::size_t thread_slot() noexcept {
+    if (slot_plus_one == 0) [[unlikely]]
+        slot_plus_one = next_slot.fetch_add(1, std::memory_order_relaxed) + 1;
+    return slot_plus_one - 1;
+}
+
+inline std::unique_ptr<line[]> make_lines(std::size_t n) {
+    auto lines = std::make_unique<line[]>(n);
+    for (std::size_t i = 0; i < n; ++i)
+        for (auto& w : lines[i].word) w.store(0, std::memory_order_relaxed);
+    return lines;
+}
+
+inline void add_double(std::atomic<std::uint64_t>& bits, double v) noexcept {
+    std::uint64_t old = bits.load(std::memory_order_relaxed);
+    while (!bits.compare_exchange_weak(old, std::bit_cast<std::uint64_t>(std::bit_cast<double>(old) + v),
+                                       std::memory_order_relaxed)) {
+    }
+}
+
+inline void append_number(std::string& out, double v) {
+    if (std::isnan(v)) {
+        out += "NaN";
+    } else if (std::isinf(v)) {
+        out += v > 0 ? "+Inf" : "-Inf";
+    } else {
+        char buf[32];
+        out.append(buf, std::to_chars(buf, buf + sizeof buf, v).ptr);
+    }
+}
+
+inline void append_number(std::string& out, std::uint64_t v) {
+    char buf[24];
+    out.append(buf, std::to_chars(buf, buf + sizeof buf, v).ptr);
+}
+
+inline void append_escaped(std::string& out, std::string_view s, bool quotes) {
+    for (char c : s) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else if (c == '"' && quotes) out += "\\\"";
+        else out += c;
+    }
+}
+
+inline bool valid_name(std::string_view name, bool colons) noexcept {
+    if (name.empty() || (name[0] >= '0' && name[0] <= '9')) return false;
+    return std::all_of(name.begin(), name.end(), [&](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' ||
+               (colons && c == ':');
+    });
+}
+
+}  // namespace detail::metrics
+
+/// Monotonic counter for hot paths: each thread increments its own
+/// cache-line shard with a relaxed add and `value()` sums the shards.
+///
+/// A single atomic incremented from many cores bounces its cache line on
+/// every add; here a thread only ever touches its own line unless more
+/// threads than shards exist, in which case some threads share one.
+class counter {
+public:
+    counter() : mask_(detail::metrics::shard_count() - 1), shards_(detail::metrics::make_lines(mask_ + 1)) {}
+
+    void inc(std::uint64_t n = 1) noexcept {
+        shards_[detail::metrics::thread_slot() & mask_].word[0].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /// Sum over shards. Concurrent increments may or may not be included.
+    std::uint64_t value() const noexcept {
+        std::uint64_t sum = 0;
+        for (std::size_t s = 0; s <= mask_; ++s) sum += shards_[s].word[0].load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    std::size_t mask_;
+    std::unique_ptr<detail::metrics::line[]> shards_;
+};
+
+/// Value that goes up and down. Set and read from one atomic word; gauges
+/// are written far less often than counters, so this is not sharded.
+class gauge {
+public:
+    void set(double v) noexcept { bits_.store(std::bit_cast<std::uint64_t>(v), std::memory_order_relaxed); }
+    void add(double v) noexcept { detail::metrics::add_double(bits_, v); }
+    void sub(double v) noexcept { add(-v); }
+    double value() const noexcept { return std::bit_cast<double>(bits_.load(std::memory_order_relaxed)); }
+
+private:
+    std::atomic<std::uint64_t> bits_{0};  // +0.0
+};
+
+/// `count` upper bounds start, start * factor, ... for `histogram`.
+inline std::vector<double> exponential_buckets(double start, double factor, std::size_t count) {
+    std::vector<double> bounds(count);
+    for (std::size_t i = 0; i < count; ++i, start *= factor) bounds[i] = start;
+    return bounds;
+}
+
+/// `count` upper bounds start, start + width, ... for `histogram`.
+inline std::vector<double> linear_buckets(double start, double width, std::size_t count) {
+    std::vector<double> bounds(count);
+    for (std::size_t i = 0; i < count; ++i) bounds[i] = start + width * static_cast<double>(i);
+    return bounds;
+}
+
+/// Distribution over fixed buckets, sharded like `counter`. Bucket `i`
+/// counts observations `v <= bounds[i]` (and above the previous bound); one
+/// implicit bucket above the last bound catches the rest.
+class histogram {
+public:
+    /// Cumulative view, as Prometheus reports it. Read shard by shard, so a
+    /// snapshot taken during updates may be off by in-flight observations.
+    struct snapshot {
+        std::vector<std::uint64_t> cumulative;  // per bound, then +Inf
+        std::uint64_t count = 0;
+        double sum = 0;
+    };
+
+    /// `bounds` must be strictly increasing.
+    explicit histogram(std::vector<double> bounds) : bounds_(std::move(bounds)) {
+        if (std::adjacent_find(bounds_.begin(), bounds_.end(), std::greater_equal<>()) != bounds_.end())
+            throw std::invalid_argument("histogram bounds must be strictly increasing");
+        // Word 0 holds the sum's bits, then one count per bucket.
+        lines_per_shard_ = (bounds_.size() + 2 + 7) / 8;
+        mask_ = detail::metrics::shard_count() - 1;
+        shards_ = detail::metrics::make_lines(lines_per_shard_ * (mask_ + 1));
+    }
+
+    void observe(double v) noexcept {
+        const auto bucket =
+            static_cast<std::size_t>(std::lower_bound(bounds_.begin(), bounds_.end(), v) - bounds_.begin());
+        detail::metrics::line* shard =
+            &shards_[(detail::metrics::thread_slot() & mask_) * lines_per_shard_];
+        word(shard, bucket + 1).fetch_add(1, std::memory_order_relaxed);
+        detail::metrics::add_double(word(shard, 0), v);
+    }
+
+    const std::vector<double>& bounds() const noexcept { return bounds_; }
+
+    snapshot read() const {
+        snapshot s;
+        s.cumulative.assign(bounds_.size() + 1, 0);
+        for (std::size_t sh = 0; sh <= mask_; ++sh) {
+            detail::metrics::line* shard = &shards_[sh * lines_per_shard_];
+            s.sum += std::bit_cast<double>(word(shard, 0).load(std::memory_order_relaxed));
+            for (std::size_t b = 0; b <= bounds_.size(); ++b)
+                s.cumulative[b] += word(shard, b + 1).load(std::memory_order_relaxed);
+        }
+        for (std::size_t b = 1; b < s.cumulative.size(); ++b) s.cumulative[b] += s.cumulative[b - 1];
+        s.count = s.cumulative.back();
+        return s;
+    }
+
+private:
+    static std::atomic<std::uint64_t>& word(detail::metrics::line* shard, std::size_t i) noexcept {
+        return shard[i / 8].word[i % 8];
+    }
+
+    std::vector<double> bounds_;
+    std::size_t lines_per_shard_ = 0;
+    std::size_t mask_ = 0;
+    std::unique_ptr<detail::metrics::line[]> shards_;
+};
+
+/// Named metrics with Prometheus text exposition (format 0.0.4).
+///
+/// Lookups take a lock and return a reference that stays valid for the
+/// registry's lifetime; fetch it once and keep it, then updates are
+/// lock-free. The same name and labels always yield the same metric.
+/// Mismatched types, bounds or invalid names throw `std::invalid_argument`.
+class metrics_registry {
+public:
+    mo::counter& counter(std::string_view name, std::string_view help, const metric_labels& labels = {}) {
+        return *find(name, help, labels, kind::counter, nullptr).counter;
+    }
+
+    mo::gauge& gauge(std::string_view name, std::string_view help, const metric_labels& labels = {}) {
+        return *find(name, help, labels, kind::gauge, nullptr).gauge;
+    }
+
+    mo::histogram& histogram(std::string_view name, std::string_view help, const std::vector<double>& bounds,
+                             const metric_labels& labels = {}) {
+        return *find(name, help, labels, kind::histogram, &bounds).histogram;
+    }
+
+    /// Every metric, families sorted by name, series in registration order.
+    std::string prometheus() const {
+        using detail::metrics::append_number;
+        std::lock_guard lock(mutex_);
+        std::string out;
+        for (const auto& [name, fam] : families_) {
+            out += "# HELP " + name + ' ';
+            detail::metrics::append_escaped(out, fam.help, false);
+            out += "\n# TYPE " + name + ' ';
+            out += fam.type == kind::counter ? "counter\n" : fam.type == kind::gauge ? "gauge\n" : "histogram\n";
+            for (const series& s : fam.members) {
+                if (s.counter) {
+                    out += name + braced(s.labels) + ' ';
+                    append_number(out, s.counter->value());
+                    out += '\n';
+                } else if (s.gauge) {
+                    out += name + braced(s.labels) + ' ';
+                    append_number(out, s.gauge->value());
+                    out += '\n';
+                } else {
+                    const mo::histogram::snapshot snap = s.histogram->read();
+                    const std::string sep = s.labels.empty() ? "" : ",";
+                    for (std::size_t b = 0; b < snap.cumulative.size(); ++b) {
+                        out += name + "_bucket{" + s.labels + sep + "le=\"";
+                        append_number(out, b < s.histogram->bounds().size() ? s.histogram->bounds()[b]
+                                                                            : std::numeric_limits<double>::infinity());
+                        out += "\"} ";
+                        append_number(out, snap.cumulative[b]);
+                        out += '\n';
+                    }
+                    out += name + "_sum" + braced(s.labels) + ' ';
+                    append_number(out, snap.sum);
+                    out += '\n' + name + "_count" + braced(s.labels) + ' ';
+                    append_number(out, snap.count);
+                    out += '\n';
+                }
+            }
+        }
+        return out;
+    }
+
+    /// Writes `prometheus()` to `path` through a temporary file and a
+    /// rename, so a scraper (e.g. the node exporter's textfile collector)
+    /// never reads a partial file. Throws `std::system_error`.
+    void write_prometheus(const std::string& path) const {
+        const std::string text = prometheus();
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+            out.flush();
+            if (!out) throw std::system_error(errno, std::system_category(), "write " + tmp);
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0)
+            throw std::system_error(errno, std::system_category(), "rename " + tmp);
+    }
+
+private:
+    enum class kind { counter, gauge, histogram };
+
+    struct series {
+        std::string labels;  // rendered `a="x",b="y"`, without braces
+        std::unique_ptr<mo::counter> counter;
+        std::unique_ptr<mo::gauge> gauge;
+        std::unique_ptr<mo::histogram> histogram;
+    };
+
+    struct family {
+        kind type;
+        std::string help;
+        std::vector<series> members;
+    };
+
+    static std::string braced(const std::string& labels) { return labels.empty() ? labels : '{' + labels + '}'; }
+
+    static std::string render(const metric_labels& labels) {
+        std::string out;
+        for (const auto& [key, value] : labels) {
+            if (!detail::metrics::valid_name(key, false) || key == "le")
+                throw std::invalid_argument("invalid metric label name: " + key);
+            if (!out.empty()) out += ',';
+            out += key + "=\"";
+            detail::metrics::append_escaped(out, value, true);
+            out += '"';
+        }
+        return out;
+    }
+
+    series& find(std::string_view name, std::string_view help, const metric_labels& labels, kind type,
+                 const std::vector<double>* bounds) {
+        if (!detail::metrics::valid_name(name, true))
+            throw std::invalid_argument("invalid metric name: " + std::string(name));
+        std::string rendered = render(labels);
+        std::lock_guard lock(mutex_);
+        auto [it, inserted] = families_.try_emplace(std::string(name), family{type, std::string(help), {}});
+        family& fam = it->second;
+        if (fam.type != type) throw std::invalid_argument("metric registered with another type: " + it->first);
+        for (series& s : fam.members) {
+            if (s.labels != rendered) continue;
+            if (bounds && s.histogram->bounds() != *bounds)
+                throw std::invalid_argument("histogram registered with other bounds: " + it->first);
+            return s;
+        }
+        // Build the metric before publishing the series: a throw (say, from
+        // bad histogram bounds) must not leave a series without one.
+        try {
+            series s;
+            s.labels = std::move(rendered);
+            switch (type) {
+            case kind::counter: s.counter = std::make_unique<mo::counter>(); break;
+            case kind::gauge: s.gauge = std::make_unique<mo::gauge>(); break;
+            case kind::histogram: s.histogram = std::make_unique<mo::histogram>(*bounds); break;
+            }
+            return fam.members.emplace_back(std::move(s));
+        } catch (...) {
+            if (inserted) families_.erase(it);
+            throw;
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::map<std::string, family, std::less<>> families_;
+};
+
+}  // namespace mo
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "mo/clock.hpp"
+
+namespace mo {
+
+namespace detail::rate {
+
+/// Default timestamp. Refills are credited per nanosecond, so the clock
+/// must resolve well below one token interval: CLOCK_MONOTONIC_COARSE
+/// advances in 1-4 ms ticks, which would cap admission at about `burst`
+/// per tick whatever the rate. CLOCK_MONOTONIC is a vDSO read of ~20 ns.
+inline std::int64_t now_ns() noexcept { return detail::clock::monotonic_ns(); }
+
+inline std::int64_t interval_ns(double per_second) {
+    if (!(per_second > 0) || !std::isfinite(per_second))
+        throw std::invalid_argument("rate must be positive and finite");
+    return std::max<std::int64_t>(1, std::llround(1e9 / per_second));
+}
+
+/// A cost above the burst could never be admitted, so a caller retrying or
+/// sleeping until it is would wait forever; reject it instead.
+inline void check_cost(std::int64_t cost_ns, std::int64_t burst_ns) {
+    if (cost_ns > burst_ns) [[unlikely]]
+        throw std::invalid_argument("rate limiter cost exceeds burst");
+}
+
+}  // namespace detail::rate
+
+/// Token bucket holding up to `burst` tokens, refilled at `per_second`.
+///
+/// State is one atomic word, the instant at which the bucket was (or will
+/// be) empty; tokens available at `now` are `(now - empty_at) / interval`,
+/// capped at `burst`. Taking tokens is one CAS, so any number of threads
+/// share a bucket without a lock. Times are nanoseconds on the monotonic
+/// clock; every call takes an explicit `now` for tests and callers that
+/// already hold a timestamp.
+///
+/// Asking `try_acquire` or `wait_time` for more than `burst` tokens throws
+/// `std::invalid_argument`: the bucket never holds that many. Use
+/// `acquire_up_to` to take a large amount piecemeal.
+class token_bucket {
+public:
+    token_bucket(double per_second, std::uint32_t burst, std::int64_t now = detail::rate::now_ns())
+        : interval_(detail::rate::interval_ns(per_second)), capacity_(interval_ * std::max(burst, 1u)),
+          empty_at_(now - capacity_) {}
+
+    /// Takes `n` tokens if all are available.
+    bool try_acquire(std::uint32_t n = 1, std::int64_t now = detail::rate::now_ns()) {
+        detail::rate::check_cost(interval_ * n, capacity_);
+        std::int64_t empty = empty_at_.load(std::memory_order_relaxed);
+        for (;;) {
+            const std::int64_t next = std::max(empty, now - capacity_) + interval_ * n;
+            if (next > now) return false;
+            if (empty_at_.compare_exchange_weak(empty, next, std::memory_order_relaxed)) return true;
+        }
+    }
+
+    /// Takes as many tokens as are available, up to `n`, and returns how
+    /// many (e.g. bytes a writer may send now).
+    std::uint32_t acquire_up_to(std::uint32_t n, std::int64_t now = detail::rate::now_ns()) noexcept {
+        std::int64_t empty = empty_at_.load(std::memory_order_relaxed);
+        for (;;) {
+            const std::int64_t start = std::max(empty, now - capacity_);
+            const auto got = static_cast<std::uint32_t>(std::min<std::int64_t>(n, (now - start) / interval_));
+            if (got == 0) return 0;
+            if (empty_at_.compare_exchange_weak(empty, start + interval_ * got, std::memory_order_relaxed))
+                return got;
+        }
+    }
+
+    /// Returns tokens taken but not used; the bucket never exceeds `burst`.
+    void refund(std::uint32_t n) noexcept { empty_at_.fetch_sub(interval_ * n, std::memory_order_relaxed); }
+
+    /// Whole tokens available at `now`.
+    std::uint32_t available(std::int64_t now = detail::rate::now_ns()) const noexcept {
+        const std::int64_t empty = empty_at_.load(std::memory_order_relaxed);
+        const std::int64_t tokens = (now - std::max(empty, now - capacity_)) / interval_;
+        return static_cast<std::uint32_t>(std::max<std::int64_t>(0, tokens));
+    }
+
+    /// Nanoseconds until `n` tokens are available (0 if they are now).
+    std::int64_t wait_time(std::uint32_t n = 1, std::int64_t now = detail::rate::now_ns()) const {
+        detail::rate::check_cost(interval_ * n, capacity_);
+        const std::int64_t next =
+            std::max(empty_at_.load(std::memory_order_relaxed), now - capacity_) + interval_ * n;
+        return std::max<std::int64_t>(0, next - now);
+    }
+
+private:
+    std::int64_t interval_;  // ns per token
+    std::int64_t capacity_;  // ns worth of burst
+    std::atomic<std::int64_t> empty_at_;
+};
+
+/// Outcome of a `gcra` check, with what HTTP rate-limit headers need.
+struct rate_decision {
+    bool allowed = false;
+    std::int64_t retry_after = 0;  // ns until the request would be allowed; 0 if allowed
+    std::int64_t reset_after = 0;  // ns until the limiter is back to a full burst
+    std::uint32_t remaining = 0;   // requests still allowed right now
+};
+
+/// Generic cell rate algorithm: `per_second` sustained, up to `burst`
+/// back to back. One atomic word holds the theoretical arrival time (TAT)
+/// of the next request; a check is a load, some arithmetic and a CAS.
+///
+/// Admits exactly what a `token_bucket` with the same parameters admits,
+/// but reports retry and reset times, and a limiter whose TAT has passed
+/// holds no state worth keeping, which `keyed_rate_limiter` uses to evict.
+/// A `cost` above `burst` throws `std::invalid_argument`.
+class gcra {
+public:
+    gcra(double per_second, std::uint32_t burst)
+        : interval_(detail::rate::interval_ns(per_second)), tolerance_(interval_ * std::max(burst, 1u)) {}
+
+    rate_decision check(std::uint32_t cost = 1, std::int64_t now = detail::rate::now_ns()) {
+        detail::rate::check_cost(interval_ * cost, tolerance_);
+        std::int64_t tat = tat_.load(std::memory_order_relaxed);
+        for (;;) {
+            const std::int64_t next = std::max(tat, now) + interval_ * cost;
+            const std::int64_t ahead = next - now;  // how far ahead of schedule this would be
+            if (ahead > tolerance_) {
+                const std::int64_t reset = std::max<std::int64_t>(0, tat - now);
+                const std::int64_t left = std::max<std::int64_t>(0, tolerance_ - reset) / interval_;
+                return {false, ahead - tolerance_, reset, static_cast<std::uint32_t>(left)};
+            }
+            if (tat_.compare_exchange_weak(tat, next, std::memory_order_relaxed))
+                return {true, 0, ahead, static_cast<std::uint32_t>((tolerance_ - ahead) / interval_)};
+        }
+    }
+
+    bool try_acquire(std::uint32_t cost = 1, std::int64_t now = detail::rate::now_ns()) {
+        return check(cost, now).allowed;
+    }
+
+    /// True once a full burst is available again: the limiter is then
+    /// indistinguishable from a new one.
+    bool idle(std::int64_t now = detail::rate::now_ns()) const noexcept {
+        return tat_.load(std::memory_order_relaxed) <= now;
+    }
+
+private:
+    std::int64_t interval_;
+    std::int64_t tolerance_;
+    std::atomic<std::int64_t> tat_{0};
+};
+
+/// One `gcra` per key (tenant, client address, API token), all with the
+/// same rate and burst.
+///
+/// Keys hash to shards guarded by reader-writer locks: checking a known
+/// key takes its shard's lock shared, then CASes the key's own word, so
+/// checks on different keys only meet on the shard lock's cache line and
+/// never wait for each other. A key's first check inserts under the
+/// exclusive lock. Call `evict_idle` periodically to drop keys that have
+/// fully refilled; since those hold no state, eviction never changes a
+/// decision.
+template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class keyed_rate_limiter {
+public:
+    keyed_rate_limiter(double per_second, std::uint32_t burst, std::size_t shards = 64)
+        : per_second_(per_second), burst_(burst), shards_(std::bit_ceil(std::max<std::size_t>(shards, 1))) {
+        detail::rate::interval_ns(per_second);  // validate up front
+    }
+
+    /// Throws `std::invalid_argument` for a `cost` above `burst`, before
+    /// touching the key's state.
+    rate_decision check(const Key& key, std::uint32_t cost = 1, std::int64_t now = detail::rate::now_ns()) {
+        detail::rate::check_cost(cost, std::max(burst_, 1u));
+        const std::size_t h = Hash{}(key);
+        shard& s = shards_[(h ^ (h >> 17)) & (shards_.size() - 1)];
+        {
+            std::shared_lock lock(s.mutex);
+            if (auto it = s.limiters.find(key); it != s.limiters.end()) return it->second.check(cost, now);
+        }
+        std::unique_lock lock(s.mutex);
+        auto it = s.limiters.try_emplace(key, per_second_, burst_).first;
+        return it->second.check(cost, now);
+    }
+
+    bool try_acquire(const Key& key, std::uint32_t cost = 1, std::int64_t now = detail::rate::now_ns()) {
+        return check(key, cost, now).allowed;
+    }
+
+    /// Removes keys whose limiter is idle at `now`; returns how many.
+    std::size_t evict_idle(std::int64_t now = detail::rate::now_ns()) {
+        std::size_t removed = 0;
+        for (shard& s : shards_) {
+            std::unique_lock lock(s.mutex);
+            removed += std::erase_if(s.limiters, [&](const auto& kv) { return kv.second.idle(now); });
+        }
+        return removed;
+    }
+
+    std::size_t size() const {
+        std::size_t n = 0;
+        for (const shard& s : shards_) {
+            std::shared_lock lock(s.mutex);
+            n += s.limiters.size();
+        }
+        return n;
+    }
+
+private:
+    struct alignas(64) shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<Key, gcra, Hash, KeyEqual> limiters;
+    };
+
+    double per_second_;
+    std::uint32_t burst_;
+    std::vector<shard> shards_;
+};
+
+}  // namespace mo
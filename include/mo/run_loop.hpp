@@ -0,0 +1,161 @@
+#pragma once
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "mo/frame_allocator.hpp"
+#include "mo/task.hpp"
+
+namespace mo {
+
+/// Single-threaded coroutine executor.
+///
+/// Coroutines queued with `post()` or `co_await loop.schedule()` are resumed
+/// by whichever thread calls `run_once()`/`run()`. `post()` is safe from any
+/// thread. The loop exposes an eventfd (`native_handle()`) that is readable
+/// whenever work is pending, so it can be registered with an existing epoll
+/// set and drained with `run_once()` when the fd fires:
+///
+///     epoll_ctl(ep, EPOLL_CTL_ADD, loop.native_handle(), &ev);
+///     ...
+///     if (events[i].data.fd == loop.native_handle()) loop.run_once();
+class run_loop {
+public:
+    run_loop() : efd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+        if (efd_ < 0) throw std::system_error(errno, std::system_category(), "eventfd");
+    }
+    ~run_loop() { ::close(efd_); }
+
+    run_loop(const run_loop&) = delete;
+    run_loop& operator=(const run_loop&) = delete;
+
+    int native_handle() const noexcept { return efd_; }
+
+    /// Queues `h` to be resumed on the loop's thread.
+    void post(std::coroutine_handle<> h) {
+        bool wake;
+        {
+            std::lock_guard lock(mutex_);
+            wake = queue_.empty() && current_loop != this;
+            queue_.push_back(h);
+        }
+        if (wake) signal();
+    }
+
+    /// Awaitable that reschedules the awaiting coroutine onto this loop.
+    auto schedule() noexcept {
+        struct awaiter {
+            run_loop* loop;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { loop->post(h); }
+            void await_resume() const noexcept {}
+        };
+        return awaiter{this};
+    }
+
+    /// Starts `t` on the loop without waiting for it. The frame is freed when
+    /// the task completes; an exception escaping `t` terminates the process.
+    /// Throws `std::logic_error` for an empty task.
+    void spawn(task<void> t) {
+        check(t);
+        post(detach(std::move(t)).handle);
+    }
+
+    /// Resumes every coroutine that was queued when the call began and returns
+    /// how many ran. Work queued during the batch is left for the next call
+    /// (and the eventfd re-armed) so I/O polling is never starved.
+    std::size_t run_once() {
+        drain_eventfd();
+        std::vector<std::coroutine_handle<>> batch = std::move(spare_);
+        {
+            std::lock_guard lock(mutex_);
+            batch.swap(queue_);
+        }
+        run_loop* const outer = std::exchange(current_loop, this);
+        for (std::coroutine_handle<> h : batch) h.resume();
+        current_loop = outer;
+
+        const std::size_t ran = batch.size();
+        batch.clear();
+        spare_ = std::move(batch);
+        bool more;
+        {
+            std::lock_guard lock(mutex_);
+            more = !queue_.empty();
+        }
+        if (more) signal();
+        return ran;
+    }
+
+    /// Runs `t` to completion on the calling thread, blocking on the eventfd
+    /// while idle, and returns its result. Throws `std::logic_error` for an
+    /// empty task.
+    template <typename T>
+    T run(task<T> t) {
+        check(t);
+        post(t.handle());
+        while (!t.done()) {
+            if (run_once() == 0 && !t.done()) wait();
+        }
+        return std::move(t).result();
+    }
+
+    /// Blocks until work is pending.
+    void wait() const {
+        pollfd pfd{efd_, POLLIN, 0};
+        while (::poll(&pfd, 1, -1) < 0 && errno == EINTR) {
+        }
+    }
+
+private:
+    struct detached {
+        struct promise_type : detail::frame_allocated {
+            detached get_return_object() noexcept {
+                return {std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            [[noreturn]] void unhandled_exception() const noexcept { std::terminate(); }
+        };
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    static detached detach(task<void> t) { co_await std::move(t); }
+
+    /// Queuing an empty task's null handle would crash the next `run_once`.
+    template <typename T>
+    static void check(const task<T>& t) {
+        if (!t.valid()) throw std::logic_error("mo::run_loop: empty (default-constructed or moved-from) task");
+    }
+
+    void signal() noexcept {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] auto n = ::write(efd_, &one, sizeof one);
+    }
+
+    void drain_eventfd() noexcept {
+        std::uint64_t value;
+        [[maybe_unused]] auto n = ::read(efd_, &value, sizeof value);
+    }
+
+    static inline thread_local run_loop* current_loop = nullptr;
+
+    int efd_;
+    std::mutex mutex_;
+    std::vector<std::coroutine_handle<>> queue_;
+    std::vector<std::coroutine_handle<>> spare_;  // recycled batch capacity
+};
+
+}  // namespace mo
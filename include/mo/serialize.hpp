@@ -0,0 +1,305 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "mo/fields.hpp"
+
+/// Declares the members serialized for a type, in wire order; see
+/// `MO_FIELDS`.
+#define MO_SERIALIZE_FIELDS(...) MO_FIELDS(__VA_ARGS__)
+
+namespace mo {
+
+static_assert(std::endian::native == std::endian::little, "serialize.hpp assumes a little-endian host");
+
+/// Thrown by `binary_reader` on truncated or malformed input.
+class deserialize_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+namespace detail::ser {
+
+using fields::fields_of;
+using fields::has_fields;
+
+template <typename T>
+concept string_like = std::same_as<T, std::string> || std::same_as<T, std::string_view>;
+
+template <typename T>
+concept byte_like = std::same_as<T, std::byte> || std::same_as<T, char> || std::same_as<T, unsigned char> ||
+                    std::same_as<T, signed char>;
+
+template <typename T>
+concept map_like = requires {
+    typename T::key_type;
+    typename T::mapped_type;
+} && requires(T& m, typename T::key_type k, typename T::mapped_type v) { m.emplace(std::move(k), std::move(v)); };
+
+template <typename T>
+concept set_like = !map_like<T> && requires(T& s, typename T::key_type k) { s.insert(std::move(k)); };
+
+template <typename T>
+concept sequence_like = !string_like<T> && requires(T& c, typename T::value_type v) {
+    c.size();
+    c.begin();
+    c.emplace_back(std::move(v));
+};
+
+template <typename T>
+concept byte_sequence = sequence_like<T> && byte_like<typename T::value_type>;
+
+template <typename T>
+struct is_std_array : std::false_type {};
+template <typename T, std::size_t N>
+struct is_std_array<std::array<T, N>> : std::true_type {};
+
+template <typename T>
+struct is_optional : std::false_type {};
+template <typename T>
+struct is_optional<std::optional<T>> : std::true_type {};
+
+template <typename T>
+struct is_tuple_like : std::false_type {};
+template <typename A, typename B>
+struct is_tuple_like<std::pair<A, B>> : std::true_type {};
+template <typename... Ts>
+struct is_tuple_like<std::tuple<Ts...>> : std::true_type {};
+
+constexpr std::uint64_t zigzag(std::int64_t v) noexcept {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+constexpr std::int64_t unzigzag(std::uint64_t v) noexcept {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+}  // namespace detail::ser
+
+/// Appends values to a byte string in the compact wire format:
+///
+/// - unsigned integers as LEB128 varints, signed ones zigzag-encoded first,
+///   enums as their underlying type, `bool` as one byte;
+/// - `float`/`double` as raw little-endian bytes;
+/// - strings and byte vectors as a varint length plus raw bytes;
+/// - containers as a varint count plus elements, maps as key/value pairs,
+///   `std::optional` as a presence byte plus value;
+/// - structs as their fields in declaration order, with no tags or names.
+///
+/// The format carries no schema, so reader and writer must agree on types.
+class binary_writer {
+public:
+    explicit binary_writer(std::string& out) noexcept : out_(out) {}
+
+    void write_varint(std::uint64_t v) {
+        char buf[10];
+        std::size_t n = 0;
+        while (v >= 0x80) {
+            buf[n++] = static_cast<char>(v | 0x80);
+            v >>= 7;
+        }
+        buf[n++] = static_cast<char>(v);
+        out_.append(buf, n);
+    }
+
+    void write_bytes(const void* data, std::size_t size) {
+        write_varint(size);
+        out_.append(static_cast<const char*>(data), size);
+    }
+
+    template <typename T>
+    void write(const T& v) {
+        using namespace detail::ser;
+        if constexpr (std::is_same_v<T, bool>) {
+            out_.push_back(v ? 1 : 0);
+        } else if constexpr (std::is_enum_v<T>) {
+            write(static_cast<std::underlying_type_t<T>>(v));
+        } else if constexpr (std::is_integral_v<T> && std::is_unsigned_v<T>) {
+            write_varint(v);
+        } else if constexpr (std::is_integral_v<T>) {
+            write_varint(zigzag(v));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            static_assert(sizeof(T) == 4 || sizeof(T) == 8, "long double is not supported");
+            out_.append(reinterpret_cast<const char*>(&v), sizeof v);
+        } else if constexpr (string_like<T>) {
+            write_bytes(v.data(), v.size());
+        } else if constexpr (is_optional<T>::value) {
+            write(v.has_value());
+            if (v) write(*v);
+        } else if constexpr (is_tuple_like<T>::value) {
+            std::apply([this](const auto&... e) { (write(e), ...); }, v);
+        } else if constexpr (is_std_array<T>::value) {
+            for (const auto& e : v) write(e);
+        } else if constexpr (byte_sequence<T>) {
+            write_bytes(v.data(), v.size());
+        } else if constexpr (map_like<T>) {
+            write_varint(v.size());
+            for (const auto& [key, value] : v) {
+                write(key);
+                write(value);
+            }
+        } else if constexpr (sequence_like<T> || set_like<T>) {
+            write_varint(v.size());
+            for (const auto& e : v) write(e);
+        } else {
+            std::apply([this](const auto&... f) { (write(f), ...); }, fields_of(v));
+        }
+    }
+
+private:
+    std::string& out_;
+};
+
+/// Decodes values written by `binary_writer`.
+///
+/// `std::string_view` (and `std::span<const std::byte>`) destinations point
+/// straight into the input buffer, so string-heavy messages decode without
+/// allocating; the input must outlive them.
+class binary_reader {
+public:
+    explicit binary_reader(std::string_view in) noexcept : pos_(in.data()), end_(in.data() + in.size()) {}
+
+    std::size_t remaining() const noexcept { return static_cast<std::size_t>(end_ - pos_); }
+    bool at_end() const noexcept { return pos_ == end_; }
+
+    std::uint64_t read_varint() {
+        std::uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (pos_ == end_) throw deserialize_error("truncated varint");
+            const auto byte = static_cast<std::uint8_t>(*pos_++);
+            // The 10th byte holds bit 63 only; anything more would be dropped.
+            if (shift == 63 && byte > 1) throw deserialize_error("varint overflows 64 bits");
+            v |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return v;
+        }
+        throw deserialize_error("varint too long");
+    }
+
+    std::string_view read_raw(std::size_t size) {
+        if (remaining() < size) throw deserialize_error("truncated input");
+        std::string_view view(pos_, size);
+        pos_ += size;
+        return view;
+    }
+
+    std::string_view read_bytes() { return read_raw(read_length()); }
+
+    template <typename T>
+    T read() {
+        T v{};
+        read(v);
+        return v;
+    }
+
+    template <typename T>
+    void read(T& v) {
+        using namespace detail::ser;
+        if constexpr (std::is_same_v<T, bool>) {
+            v = read_raw(1)[0] != 0;
+        } else if constexpr (std::is_enum_v<T>) {
+            v = static_cast<T>(read<std::underlying_type_t<T>>());
+        } else if constexpr (std::is_integral_v<T> && std::is_unsigned_v<T>) {
+            v = narrow<T>(read_varint());
+        } else if constexpr (std::is_integral_v<T>) {
+            const std::int64_t wide = unzigzag(read_varint());
+            if (wide < std::numeric_limits<T>::min() || wide > std::numeric_limits<T>::max())
+                throw deserialize_error("integer out of range");
+            v = static_cast<T>(wide);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            std::memcpy(&v, read_raw(sizeof v).data(), sizeof v);
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            v = read_bytes();
+        } else if constexpr (std::is_same_v<T, std::span<const std::byte>>) {
+            const std::string_view bytes = read_bytes();
+            v = {reinterpret_cast<const std::byte*>(bytes.data()), bytes.size()};
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            v.assign(read_bytes());
+        } else if constexpr (is_optional<T>::value) {
+            if (read<bool>())
+                read(v.emplace());
+            else
+                v.reset();
+        } else if constexpr (is_tuple_like<T>::value) {
+            std::apply([this](auto&... e) { (read(e), ...); }, v);
+        } else if constexpr (is_std_array<T>::value) {
+            for (auto& e : v) read(e);
+        } else if constexpr (byte_sequence<T>) {
+            const std::string_view bytes = read_bytes();
+            const auto* first = reinterpret_cast<const typename T::value_type*>(bytes.data());
+            v.assign(first, first + bytes.size());
+        } else if constexpr (map_like<T>) {
+            v.clear();
+            for (std::size_t n = read_length(); n > 0; --n) {
+                auto key = read<typename T::key_type>();
+                auto value = read<typename T::mapped_type>();
+                v.emplace(std::move(key), std::move(value));
+            }
+        } else if constexpr (set_like<T>) {
+            v.clear();
+            for (std::size_t n = read_length(); n > 0; --n) v.insert(read<typename T::key_type>());
+        } else if constexpr (sequence_like<T>) {
+            v.clear();
+            const std::size_t n = read_length();
+            if constexpr (requires { v.reserve(n); }) v.reserve(n);
+            for (std::size_t i = 0; i < n; ++i) read(v.emplace_back());
+        } else {
+            std::apply([this](auto&... f) { (read(f), ...); }, fields_of(v));
+        }
+    }
+
+private:
+    template <typename T>
+    static T narrow(std::uint64_t v) {
+        if (v > std::numeric_limits<T>::max()) throw deserialize_error("integer out of range");
+        return static_cast<T>(v);
+    }
+
+    /// A length or element count. Every element takes at least one byte, so
+    /// a count larger than the remaining input is malformed; rejecting it
+    /// early keeps hostile input from triggering huge reservations.
+    std::size_t read_length() {
+        const std::uint64_t n = read_varint();
+        if (n > remaining()) throw deserialize_error("length exceeds input");
+        return static_cast<std::size_t>(n);
+    }
+
+    const char* pos_;
+    const char* end_;
+};
+
+/// Appends the encoding of `value` to `out`.
+template <typename T>
+void serialize(std::string& out, const T& value) {
+    binary_writer(out).write(value);
+}
+
+template <typename T>
+std::string serialize(const T& value) {
+    std::string out;
+    serialize(out, value);
+    return out;
+}
+
+/// Decodes a `T` that must span all of `in`.
+template <typename T>
+T deserialize(std::string_view in) {
+    binary_reader reader(in);
+    T value = reader.read<T>();
+    if (!reader.at_end()) throw deserialize_error("trailing bytes after value");
+    return value;
+}
+
+}  // namespace mo
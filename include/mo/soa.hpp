@@ -0,0 +1,378 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "mo/fields.hpp"
+
+namespace mo {
+
+template <typename T>
+class soa_vector;
+
+namespace detail::soa {
+
+// Columns start on cache-line boundaries so vector loads over one column
+// never straddle into the next.
+inline constexpr std::size_t column_alignment = 64;
+
+constexpr std::size_t align_up(std::size_t n) noexcept {
+    return (n + column_alignment - 1) & ~(column_alignment - 1);
+}
+
+template <std::size_t N, typename F>
+void for_each_index(F&& f) {
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (f(std::integral_constant<std::size_t, I>{}), ...);
+    }(std::make_index_sequence<N>{});
+}
+
+}  // namespace detail::soa
+
+/// Proxy for one row of a `soa_vector`: reads and writes go straight to the
+/// column storage. Converts to `T`, assigns from `T`, and supports
+/// structured bindings (`auto [x, y] = v[i];` binds references into the
+/// columns). Assigning one proxy to another copies the row's values.
+template <typename T, bool Const>
+class soa_ref {
+    using container = std::conditional_t<Const, const soa_vector<T>, soa_vector<T>>;
+
+public:
+    soa_ref(container& v, std::size_t row) noexcept : v_(&v), row_(row) {}
+
+    operator soa_ref<T, true>() const noexcept
+        requires(!Const)
+    {
+        return {*v_, row_};
+    }
+
+    template <std::size_t I>
+    auto& get() const noexcept {
+        return v_->template column<I>()[row_];
+    }
+
+    operator T() const {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            if constexpr (std::is_aggregate_v<T> && !detail::fields::has_fields<T>) {
+                return T{get<I>()...};
+            } else {
+                T out{};
+                auto dst = detail::fields::fields_of(out);
+                ((std::get<I>(dst) = get<I>()), ...);
+                return out;
+            }
+        }(std::make_index_sequence<soa_vector<T>::field_count>{});
+    }
+
+    const soa_ref& operator=(const T& row) const
+        requires(!Const)
+    {
+        auto src = detail::fields::fields_of(row);
+        detail::soa::for_each_index<soa_vector<T>::field_count>(
+            [&](auto i) { get<i()>() = std::get<i()>(src); });
+        return *this;
+    }
+
+    const soa_ref& operator=(T&& row) const
+        requires(!Const)
+    {
+        auto src = detail::fields::fields_of(row);
+        detail::soa::for_each_index<soa_vector<T>::field_count>(
+            [&](auto i) { get<i()>() = std::move(std::get<i()>(src)); });
+        return *this;
+    }
+
+    const soa_ref& operator=(const soa_ref& other) const
+        requires(!Const)
+    {
+        detail::soa::for_each_index<soa_vector<T>::field_count>(
+            [&](auto i) { get<i()>() = other.template get<i()>(); });
+        return *this;
+    }
+
+    std::size_t index() const noexcept { return row_; }
+
+private:
+    container* v_;
+    std::size_t row_;
+};
+
+template <typename T, bool Const>
+class soa_iterator {
+    using container = std::conditional_t<Const, const soa_vector<T>, soa_vector<T>>;
+
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using reference = soa_ref<T, Const>;
+
+    soa_iterator() noexcept = default;
+    soa_iterator(container& v, std::size_t row) noexcept : v_(&v), row_(row) {}
+
+    reference operator*() const noexcept { return {*v_, row_}; }
+    reference operator[](difference_type n) const noexcept { return {*v_, row_ + static_cast<std::size_t>(n)}; }
+
+    soa_iterator& operator++() noexcept { return ++row_, *this; }
+    soa_iterator operator++(int) noexcept { return {*v_, row_++}; }
+    soa_iterator& operator--() noexcept { return --row_, *this; }
+    soa_iterator operator--(int) noexcept { return {*v_, row_--}; }
+    soa_iterator& operator+=(difference_type n) noexcept { return row_ += static_cast<std::size_t>(n), *this; }
+    soa_iterator& operator-=(difference_type n) noexcept { return row_ -= static_cast<std::size_t>(n), *this; }
+    friend soa_iterator operator+(soa_iterator it, difference_type n) noexcept { return it += n; }
+    friend soa_iterator operator-(soa_iterator it, difference_type n) noexcept { return it -= n; }
+    friend difference_type operator-(const soa_iterator& a, const soa_iterator& b) noexcept {
+        return static_cast<difference_type>(a.row_) - static_cast<difference_type>(b.row_);
+    }
+    friend bool operator==(const soa_iterator& a, const soa_iterator& b) noexcept { return a.row_ == b.row_; }
+    friend auto operator<=>(const soa_iterator& a, const soa_iterator& b) noexcept { return a.row_ <=> b.row_; }
+
+private:
+    container* v_ = nullptr;
+    std::size_t row_ = 0;
+};
+
+/// Structure-of-arrays container for rows of type `T`.
+///
+/// `T` is described by its fields, as in `serialize.hpp`: aggregates are
+/// introspected (up to 24 members), other types list theirs with
+/// `MO_FIELDS`. Each field gets its own contiguous, cache-line-aligned
+/// column in one shared allocation, so a loop over two fields streams two
+/// dense arrays instead of every row:
+///
+///     struct particle { float x, y, vx, vy; std::uint32_t id; };
+///     mo::soa_vector<particle> ps;
+///     ps.push_back({0, 0, 1, 2, 7});
+///     auto x = ps.column<0>();
+///     auto vx = ps.column<2>();
+///     for (std::size_t i = 0; i < ps.size(); ++i) x[i] += vx[i] * dt;
+///
+/// Column spans and row proxies are invalidated by anything that grows the
+/// container, as with `std::vector`. Field types must be nothrow movable.
+template <typename T>
+class soa_vector {
+    using types = detail::fields::field_types<T>;
+
+public:
+    static constexpr std::size_t field_count = std::tuple_size_v<types>;
+    template <std::size_t I>
+    using field_type = std::tuple_element_t<I, types>;
+
+    using value_type = T;
+    using size_type = std::size_t;
+    using reference = soa_ref<T, false>;
+    using const_reference = soa_ref<T, true>;
+    using iterator = soa_iterator<T, false>;
+    using const_iterator = soa_iterator<T, true>;
+
+    soa_vector() noexcept = default;
+
+    explicit soa_vector(std::size_t n) { resize(n); }
+
+    soa_vector(const soa_vector& other) {
+        reserve(other.size_);
+        std::size_t done = 0;
+        try {
+            for_each_column([&](auto i) {
+                std::uninitialized_copy_n(other.template column_ptr<i()>(), other.size_, column_ptr<i()>());
+                ++done;
+            });
+        } catch (...) {
+            destroy_columns(done, 0, other.size_);
+            ::operator delete(block_, std::align_val_t{detail::soa::column_alignment});
+            throw;
+        }
+        size_ = other.size_;
+    }
+
+    soa_vector(soa_vector&& other) noexcept
+        : block_(std::exchange(other.block_, nullptr)),
+          columns_(std::exchange(other.columns_, {})),
+          size_(std::exchange(other.size_, 0)),
+          capacity_(std::exchange(other.capacity_, 0)) {}
+
+    soa_vector& operator=(soa_vector other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~soa_vector() {
+        clear();
+        ::operator delete(block_, std::align_val_t{detail::soa::column_alignment});
+    }
+
+    void swap(soa_vector& other) noexcept {
+        std::swap(block_, other.block_);
+        std::swap(columns_, other.columns_);
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    std::size_t capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    /// Contiguous storage of field `I` for every row.
+    template <std::size_t I>
+    std::span<field_type<I>> column() noexcept {
+        return {column_ptr<I>(), size_};
+    }
+    template <std::size_t I>
+    std::span<const field_type<I>> column() const noexcept {
+        return {column_ptr<I>(), size_};
+    }
+
+    reference operator[](std::size_t row) noexcept { return {*this, row}; }
+    const_reference operator[](std::size_t row) const noexcept { return {*this, row}; }
+    reference back() noexcept { return {*this, size_ - 1}; }
+    const_reference back() const noexcept { return {*this, size_ - 1}; }
+
+    iterator begin() noexcept { return {*this, 0}; }
+    iterator end() noexcept { return {*this, size_}; }
+    const_iterator begin() const noexcept { return {*this, 0}; }
+    const_iterator end() const noexcept { return {*this, size_}; }
+
+    void reserve(std::size_t n) {
+        if (n > capacity_) reallocate(n);
+    }
+
+    void shrink_to_fit() {
+        if (size_ < capacity_) reallocate(size_);
+    }
+
+    /// Appends a row built from one argument per field, in field order.
+    template <typename... Args>
+    reference emplace_back(Args&&... fields) {
+        static_assert(sizeof...(Args) == field_count, "emplace_back takes one argument per field");
+        if (size_ == capacity_) reallocate(std::max<std::size_t>(8, capacity_ * 2));
+        construct_row(std::make_index_sequence<field_count>{}, std::forward<Args>(fields)...);
+        return {*this, size_++};
+    }
+
+    reference push_back(const T& row) {
+        return std::apply([&](const auto&... f) -> reference { return emplace_back(f...); },
+                          detail::fields::fields_of(row));
+    }
+
+    reference push_back(T&& row) {
+        return std::apply([&](auto&... f) -> reference { return emplace_back(std::move(f)...); },
+                          detail::fields::fields_of(row));
+    }
+
+    void pop_back() noexcept {
+        --size_;
+        for_each_column([&](auto i) { std::destroy_at(column_ptr<i()>() + size_); });
+    }
+
+    /// Removes row `row` in O(1) by moving the last row into its place.
+    void swap_remove(std::size_t row) noexcept {
+        if (row != size_ - 1)
+            for_each_column([&](auto i) { column_ptr<i()>()[row] = std::move(column_ptr<i()>()[size_ - 1]); });
+        pop_back();
+    }
+
+    /// Grows with value-initialised rows or destroys rows from the back.
+    void resize(std::size_t n) {
+        if (n <= size_) {
+            while (size_ > n) pop_back();
+            return;
+        }
+        reserve(n);
+        std::size_t done = 0;
+        try {
+            for_each_column([&](auto i) {
+                std::uninitialized_value_construct_n(column_ptr<i()>() + size_, n - size_);
+                ++done;
+            });
+        } catch (...) {
+            destroy_columns(done, size_, n);
+            throw;
+        }
+        size_ = n;
+    }
+
+    void clear() noexcept {
+        destroy_columns(field_count, 0, size_);
+        size_ = 0;
+    }
+
+private:
+    template <typename, bool>
+    friend class soa_ref;
+
+    template <typename F>
+    static void for_each_column(F&& f) {
+        detail::soa::for_each_index<field_count>(f);
+    }
+
+    template <std::size_t I>
+    field_type<I>* column_ptr() const noexcept {
+        return static_cast<field_type<I>*>(columns_[I]);
+    }
+
+    // Destroys rows [first, last) of the first `columns` columns.
+    void destroy_columns(std::size_t columns, std::size_t first, std::size_t last) noexcept {
+        for_each_column([&](auto i) {
+            if (i() < columns) std::destroy(column_ptr<i()>() + first, column_ptr<i()>() + last);
+        });
+    }
+
+    template <std::size_t... I, typename... Args>
+    void construct_row(std::index_sequence<I...>, Args&&... fields) {
+        std::size_t done = 0;
+        try {
+            ((std::construct_at(column_ptr<I>() + size_, std::forward<Args>(fields)), ++done), ...);
+        } catch (...) {
+            ((I < done ? std::destroy_at(column_ptr<I>() + size_) : void()), ...);
+            throw;
+        }
+    }
+
+    void reallocate(std::size_t capacity) {
+        std::array<std::size_t, field_count> offsets{};
+        std::size_t bytes = 0;
+        for_each_column([&](auto i) {
+            offsets[i()] = bytes;
+            bytes += detail::soa::align_up(capacity * sizeof(field_type<i()>));
+        });
+        void* block = bytes ? ::operator new(bytes, std::align_val_t{detail::soa::column_alignment}) : nullptr;
+
+        std::array<void*, field_count> columns{};
+        for_each_column([&](auto i) {
+            using F = field_type<i()>;
+            static_assert(std::is_nothrow_move_constructible_v<F>, "soa_vector fields must be nothrow movable");
+            columns[i()] = static_cast<std::byte*>(block) + offsets[i()];
+            std::uninitialized_move_n(column_ptr<i()>(), size_, static_cast<F*>(columns[i()]));
+            std::destroy_n(column_ptr<i()>(), size_);
+        });
+        ::operator delete(block_, std::align_val_t{detail::soa::column_alignment});
+        block_ = block;
+        columns_ = columns;
+        capacity_ = capacity;
+    }
+
+    void* block_ = nullptr;
+    std::array<void*, field_count> columns_{};
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+};
+
+}  // namespace mo
+
+template <typename T, bool Const>
+struct std::tuple_size<mo::soa_ref<T, Const>> : std::integral_constant<std::size_t, mo::soa_vector<T>::field_count> {};
+
+template <std::size_t I, typename T, bool Const>
+struct std::tuple_element<I, mo::soa_ref<T, Const>> {
+    using field = typename mo::soa_vector<T>::template field_type<I>;
+    using type = std::conditional_t<Const, const field&, field&>;
+};
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mo/thread_pool.hpp"
+
+namespace mo {
+
+/// Maps a key to an unsigned integer whose natural order matches the key's.
+///
+/// Signed integers flip the sign bit. Floating-point keys flip the sign bit
+/// of positives and every bit of negatives, which orders -inf < negatives <
+/// -0.0 < +0.0 < positives < +inf; NaNs land at either end by sign.
+template <typename K>
+constexpr auto radix_bits(K key) noexcept {
+    if constexpr (std::is_same_v<K, bool>) {
+        return static_cast<std::uint8_t>(key);
+    } else if constexpr (std::is_enum_v<K>) {
+        return radix_bits(static_cast<std::underlying_type_t<K>>(key));
+    } else if constexpr (std::is_integral_v<K> && std::is_unsigned_v<K>) {
+        return key;
+    } else if constexpr (std::is_integral_v<K>) {
+        using U = std::make_unsigned_t<K>;
+        return static_cast<U>(static_cast<U>(key) ^ (U{1} << (sizeof(K) * 8 - 1)));
+    } else {
+        static_assert(std::is_same_v<K, float> || std::is_same_v<K, double>, "unsupported radix key type");
+        using U = std::conditional_t<sizeof(K) == 4, std::uint32_t, std::uint64_t>;
+        const U bits = std::bit_cast<U>(key);
+        const U sign = U{1} << (sizeof(K) * 8 - 1);
+        return static_cast<U>(bits ^ ((bits & sign) ? ~U{0} : sign));
+    }
+}
+
+struct identity_key {
+    template <typename T>
+    constexpr const T& operator()(const T& v) const noexcept {
+        return v;
+    }
+};
+
+namespace detail::sort {
+
+inline constexpr std::size_t small_sort_threshold = 256;
+
+template <typename T, typename KeyFn>
+void key_sort(std::span<T> data, KeyFn& key) {
+    std::stable_sort(data.begin(), data.end(),
+                     [&](const T& a, const T& b) { return radix_bits(key(a)) < radix_bits(key(b)); });
+}
+
+}  // namespace detail::sort
+
+/// Stable LSD radix sort by `key(element)`, an integer, enum or floating-point
+/// value. Uses 8-bit digits, builds every digit histogram in one read pass and
+/// skips passes in which all elements share the same digit. `scratch` must
+/// hold at least `data.size()` elements.
+template <typename T, typename KeyFn = identity_key>
+void radix_sort(std::span<T> data, std::span<T> scratch, KeyFn key = {}) {
+    const std::size_t n = data.size();
+    if (n < detail::sort::small_sort_threshold) {
+        detail::sort::key_sort(data, key);
+        return;
+    }
+    using U = decltype(radix_bits(key(data[0])));
+    constexpr unsigned passes = sizeof(U);
+
+    std::vector<std::array<std::size_t, 256>> hist(passes);
+    for (const T& v : data) {
+        const U bits = radix_bits(key(v));
+        for (unsigned p = 0; p < passes; ++p) ++hist[p][(bits >> (8 * p)) & 0xFF];
+    }
+
+    T* src = data.data();
+    T* dst = scratch.data();
+    for (unsigned p = 0; p < passes; ++p) {
+        auto& h = hist[p];
+        if (h[(radix_bits(key(src[0])) >> (8 * p)) & 0xFF] == n) continue;  // digit is constant
+        std::size_t sum = 0;
+        for (std::size_t& c : h) sum += std::exchange(c, sum);
+        for (std::size_t i = 0; i < n; ++i) {
+            const unsigned digit = (radix_bits(key(src[i])) >> (8 * p)) & 0xFF;
+            dst[h[digit]++] = std::move(src[i]);
+        }
+        std::swap(src, dst);
+    }
+    if (src != data.data()) std::move(src, src + n, data.data());
+}
+
+template <typename T, typename KeyFn = identity_key>
+void radix_sort(std::span<T> data, KeyFn key = {}) {
+    if (data.size() < detail::sort::small_sort_threshold) {
+        detail::sort::key_sort(data, key);
+        return;
+    }
+    std::vector<T> scratch(data.size());
+    radix_sort(data, std::span<T>(scratch), key);
+}
+
+namespace detail::sort {
+
+template <typename T, typename KeyFn>
+void msd_string(std::span<T> data, std::span<T> scratch, KeyFn& key, std::size_t depth, std::size_t max_depth) {
+    const std::size_t n = data.size();
+    if (n < 64 || depth == max_depth) {
+        std::stable_sort(data.begin(), data.end(), [&](const T& a, const T& b) {
+            const std::string_view ka = key(a), kb = key(b);
+            return ka.substr(std::min(depth, ka.size())) < kb.substr(std::min(depth, kb.size()));
+        });
+        return;
+    }
+    // Bucket 0 holds keys that end before `depth`; byte b goes to bucket b + 1.
+    auto bucket_of = [&](const T& v) -> unsigned {
+        const std::string_view k = key(v);
+        return depth < k.size() ? static_cast<unsigned char>(k[depth]) + 1u : 0u;
+    };
+    std::array<std::size_t, 258> start{};
+    for (const T& v : data) ++start[bucket_of(v) + 1];
+    for (std::size_t b = 1; b < start.size(); ++b) start[b] += start[b - 1];
+
+    std::array<std::size_t, 257> fill;
+    std::copy(start.begin(), start.end() - 1, fill.begin());
+    for (T& v : data) scratch[fill[bucket_of(v)]++] = std::move(v);
+    std::move(scratch.begin(), scratch.begin() + n, data.begin());
+
+    for (std::size_t b = 1; b < 257; ++b) {
+        const std::size_t lo = start[b], hi = start[b + 1];
+        if (hi - lo > 1)
+            msd_string(data.subspan(lo, hi - lo), scratch.subspan(lo, hi - lo), key, depth + 1, max_depth);
+    }
+}
+
+}  // namespace detail::sort
+
+/// Stable MSD radix sort by a string key (`key(element)` converts to
+/// `std::string_view`). Radix-partitions on the first `max_depth` bytes and
+/// finishes ties beyond that prefix, and small buckets, with a comparison
+/// sort. Fixed-width or short-prefix keys (codes, symbols, ids) sort almost
+/// entirely by radix passes.
+template <typename T, typename KeyFn = identity_key>
+void string_radix_sort(std::span<T> data, KeyFn key = {}, std::size_t max_depth = 16) {
+    auto view_key = [&](const T& v) -> std::string_view { return key(v); };
+    std::vector<T> scratch(data.size());
+    detail::sort::msd_string(data, std::span<T>(scratch), view_key, 0, max_depth);
+}
+
+namespace detail::sort {
+
+/// Parallel sample sort: splitters from a regular sample route elements into
+/// buckets; blocks are classified and scattered concurrently, then buckets
+/// are sorted concurrently by `sort_bucket(std::span<T>)`.
+template <typename T, typename Less, typename SortBucket>
+void sample_sort(thread_pool& pool, std::span<T> data, Less less, SortBucket sort_bucket) {
+    const std::size_t n = data.size();
+    const std::size_t threads = pool.size() + 1;
+    const std::size_t buckets = std::min<std::size_t>(256, threads * 4);
+
+    // Regularly spaced oversample, sorted, every `oversample`-th kept.
+    constexpr std::size_t oversample = 16;
+    std::vector<T> sample;
+    sample.reserve(buckets * oversample);
+    const std::size_t stride = n / (buckets * oversample);
+    for (std::size_t i = 0; i < buckets * oversample; ++i) sample.push_back(data[i * stride + stride / 2]);
+    std::sort(sample.begin(), sample.end(), less);
+    std::vector<T> splitters;
+    for (std::size_t b = 1; b < buckets; ++b) splitters.push_back(sample[b * oversample]);
+
+    const std::size_t blocks = threads;
+    const std::size_t block_size = (n + blocks - 1) / blocks;
+    std::vector<std::uint8_t> bucket_of(n);
+    std::vector<std::vector<std::size_t>> counts(blocks, std::vector<std::size_t>(buckets, 0));
+    pool.parallel_for(blocks, [&](std::size_t blk) {
+        const std::size_t lo = blk * block_size, hi = std::min(n, lo + block_size);
+        auto& c = counts[blk];
+        for (std::size_t i = lo; i < hi; ++i) {
+            const auto b = static_cast<std::size_t>(
+                std::upper_bound(splitters.begin(), splitters.end(), data[i], less) - splitters.begin());
+            bucket_of[i] = static_cast<std::uint8_t>(b);
+            ++c[b];
+        }
+    });
+
+    // Exclusive prefix over (bucket, block) so each block scatters into its
+    // own disjoint slice of every bucket.
+    std::vector<std::size_t> bucket_start(buckets + 1, 0);
+    std::size_t sum = 0;
+    for (std::size_t b = 0; b < buckets; ++b) {
+        bucket_start[b] = sum;
+        for (std::size_t blk = 0; blk < blocks; ++blk) sum += std::exchange(counts[blk][b], sum);
+    }
+    bucket_start[buckets] = n;
+
+    std::vector<T> scratch(n);
+    pool.parallel_for(blocks, [&](std::size_t blk) {
+        const std::size_t lo = blk * block_size, hi = std::min(n, lo + block_size);
+        auto& pos = counts[blk];
+        for (std::size_t i = lo; i < hi; ++i) scratch[pos[bucket_of[i]]++] = std::move(data[i]);
+    });
+
+    pool.parallel_for(buckets, [&](std::size_t b) {
+        const std::size_t lo = bucket_start[b], hi = bucket_start[b + 1];
+        std::span<T> bucket(scratch.data() + lo, hi - lo);
+        sort_bucket(bucket);
+        std::move(bucket.begin(), bucket.end(), data.begin() + static_cast<std::ptrdiff_t>(lo));
+    });
+}
+
+inline constexpr std::size_t parallel_threshold = std::size_t{1} << 16;
+
+}  // namespace detail::sort
+
+/// Parallel comparison sort (not stable) running on `pool` plus the calling
+/// thread. Small inputs fall back to `std::sort`.
+template <typename T, typename Compare = std::less<>>
+void sample_sort(thread_pool& pool, std::span<T> data, Compare less = {}) {
+    if (data.size() < detail::sort::parallel_threshold || pool.size() == 0) {
+        std::sort(data.begin(), data.end(), less);
+        return;
+    }
+    detail::sort::sample_sort(pool, data, less,
+                              [&](std::span<T> bucket) { std::sort(bucket.begin(), bucket.end(), less); });
+}
+
+/// Stable parallel sort by a radix key: sample sort partitions by key (blocks
+/// scatter in input order) and each bucket is finished with `radix_sort`.
+template <typename T, typename KeyFn = identity_key>
+void parallel_radix_sort(thread_pool& pool, std::span<T> data, KeyFn key = {}) {
+    if (data.size() < detail::sort::parallel_threshold || pool.size() == 0) {
+        radix_sort(data, key);
+        return;
+    }
+    auto less = [&](const T& a, const T& b) { return radix_bits(key(a)) < radix_bits(key(b)); };
+    detail::sort::sample_sort(pool, data, less, [&](std::span<T> bucket) { radix_sort(bucket, key); });
+}
+
+}  // namespace mo
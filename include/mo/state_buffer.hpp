@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+namespace mo {
+
+namespace detail::state {
+
+/// Slots on separate cache lines, so the writer filling one never
+/// invalidates the line a reader is reading from.
+template <typename T>
+struct alignas(64) slot {
+    T value;
+};
+
+}  // namespace detail::state
+
+/// Latest-value exchange between one writer thread and one reader thread,
+/// wait-free on both sides: a render thread reading the newest simulation
+/// state, or a telemetry thread sampling a producer's statistics.
+///
+/// Three copies of `T` rotate between the writer's back buffer, a shared
+/// middle buffer, and the reader's front buffer. `publish` swaps back and
+/// middle, `update` swaps middle and front, each with one atomic exchange;
+/// neither side ever waits for or copies under the other. The reader sees
+/// every value at most once and skips intermediate ones it was too slow for.
+///
+/// After `publish`, `write_buffer()` is an older value, not the one just
+/// published: overwrite it whole, or use `write`.
+template <typename T>
+class triple_buffer {
+public:
+    explicit triple_buffer(const T& initial = T{}) : slots_{{initial}, {initial}, {initial}} {}
+
+    triple_buffer(const triple_buffer&) = delete;
+    triple_buffer& operator=(const triple_buffer&) = delete;
+
+    // Writer side.
+
+    T& write_buffer() noexcept { return slots_[back_].value; }
+
+    /// Makes the write buffer the newest value.
+    void publish() noexcept {
+        back_ = middle_.exchange(back_ | fresh, std::memory_order_acq_rel) & index;
+    }
+
+    template <typename U>
+    void write(U&& value) {
+        write_buffer() = std::forward<U>(value);
+        publish();
+    }
+
+    // Reader side.
+
+    /// Takes the newest published value if there is one; returns whether
+    /// `read_buffer()` changed.
+    bool update() noexcept {
+        if (!(middle_.load(std::memory_order_relaxed) & fresh)) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index;
+        return true;
+    }
+
+    /// The value taken by the last `update`, stable until the next one.
+    const T& read_buffer() const noexcept { return slots_[front_].value; }
+
+    /// `update` then `read_buffer`.
+    const T& read() noexcept {
+        update();
+        return read_buffer();
+    }
+
+private:
+    static constexpr std::uint8_t index = 3, fresh = 4;
+
+    detail::state::slot<T> slots_[3];
+    alignas(64) std::atomic<std::uint8_t> middle_{1};  // index of the middle buffer | fresh once published
+    alignas(64) std::uint8_t back_ = 0;                // writer's
+    alignas(64) std::uint8_t front_ = 2;               // reader's
+};
+
+/// Large state (a routing table, a config, a scene) read by many threads
+/// and replaced by one: the writer fills the back copy, then `publish`
+/// flips which copy readers see.
+///
+/// Readers never block and never copy. A read registers on the copy it is
+/// about to use with one atomic increment and rechecks that the copy is
+/// still current (the left-right scheme). Before handing out the old copy
+/// for writing again, `write_buffer` waits until the last reader that
+/// started before the flip has left, so keep reads short. Unlike a mutex
+/// around the state, a slow writer never delays readers, and readers on
+/// many cores only share the counter's cache line.
+///
+/// Single writer; serialize writers externally. The back copy starts out
+/// as the value published two generations ago, so write it whole or use
+/// `store`.
+template <typename T>
+class double_buffer {
+public:
+    /// Keeps a copy registered as read until destroyed.
+    class read_guard {
+    public:
+        read_guard(read_guard&& other) noexcept : owner_(std::exchange(other.owner_, nullptr)), slot_(other.slot_) {}
+        read_guard& operator=(read_guard&&) = delete;
+        ~read_guard() {
+            if (owner_) owner_->readers_[slot_].count.fetch_sub(1, std::memory_order_release);
+        }
+
+        const T& operator*() const noexcept { return owner_->slots_[slot_].value; }
+        const T* operator->() const noexcept { return &owner_->slots_[slot_].value; }
+
+    private:
+        friend class double_buffer;
+        read_guard(const double_buffer* owner, unsigned slot) noexcept : owner_(owner), slot_(slot) {}
+
+        const double_buffer* owner_;
+        unsigned slot_;
+    };
+
+    explicit double_buffer(const T& initial = T{}) : slots_{{initial}, {initial}} {}
+
+    double_buffer(const double_buffer&) = delete;
+    double_buffer& operator=(const double_buffer&) = delete;
+
+    // Readers.
+
+    read_guard acquire() const noexcept {
+        for (;;) {
+            const unsigned i = front_.load(std::memory_order_seq_cst);
+            readers_[i].count.fetch_add(1, std::memory_order_seq_cst);
+            // If the writer flipped in between, it may already have seen no
+            // reader on `i` and be writing it: back off and use the new copy.
+            if (front_.load(std::memory_order_seq_cst) == i) return read_guard(this, i);
+            readers_[i].count.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    /// Calls `f(const T&)` on the current copy and returns its result.
+    template <typename F>
+    decltype(auto) read(F&& f) const {
+        const read_guard guard = acquire();
+        return std::forward<F>(f)(*guard);
+    }
+
+    // Writer.
+
+    /// The copy readers do not see, once the last reader of it has left.
+    T& write_buffer() noexcept {
+        const unsigned back = front_.load(std::memory_order_relaxed) ^ 1;
+        // seq_cst: must not move above the store in `publish` that retired this copy.
+        while (readers_[back].count.load(std::memory_order_seq_cst) != 0) std::this_thread::yield();
+        return slots_[back].value;
+    }
+
+    /// Makes the write buffer the copy readers see.
+    void publish() noexcept { front_.store(front_.load(std::memory_order_relaxed) ^ 1, std::memory_order_seq_cst); }
+
+    template <typename U>
+    void store(U&& value) {
+        write_buffer() = std::forward<U>(value);
+        publish();
+    }
+
+private:
+    struct alignas(64) reader_count {
+        mutable std::atomic<std::uint64_t> count{0};
+    };
+
+    detail::state::slot<T> slots_[2];
+    alignas(64) std::atomic<unsigned> front_{0};
+    reader_count readers_[2];
+};
+
+}  // namespace mo
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "mo/frame_allocator.hpp"
+
+namespace mo {
+
+template <typename T = void>
+class task;
+
+namespace detail {
+
+struct task_promise_base : frame_allocated {
+    struct final_awaiter {
+        bool await_ready() const noexcept { return false; }
+
+        // Symmetric transfer: jump straight into whoever awaited us instead of
+        // returning up the stack, so long await chains run in constant stack.
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            return h.promise().continuation_;
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    final_awaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+    void rethrow_if_failed() const {
+        if (exception_) std::rethrow_exception(exception_);
+    }
+
+    std::coroutine_handle<> continuation_ = std::noop_coroutine();
+    std::exception_ptr exception_;
+};
+
+template <typename T>
+struct task_promise final : task_promise_base {
+    task<T> get_return_object() noexcept;
+
+    template <typename U = T>
+        requires std::is_convertible_v<U&&, T>
+    void return_value(U&& value) {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    T& result() & {
+        rethrow_if_failed();
+        return *value_;
+    }
+    T&& result() && {
+        rethrow_if_failed();
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template <>
+struct task_promise<void> final : task_promise_base {
+    task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void result() const { rethrow_if_failed(); }
+};
+
+}  // namespace detail
+
+/// Lazily-started coroutine producing a single `T`.
+///
+/// The body does not run until the task is awaited (or handed to a
+/// `run_loop`). Completion resumes the awaiting coroutine by symmetric
+/// transfer. Frames honour `frame_allocator_scope`.
+template <typename T>
+class [[nodiscard]] task {
+    static_assert(!std::is_reference_v<T>, "task<T&> is not supported; return a pointer");
+
+public:
+    using promise_type = detail::task_promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+    using value_type = T;
+
+    task() noexcept = default;
+    explicit task(handle_type h) noexcept : handle_(h) {}
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task() { destroy(); }
+
+    bool valid() const noexcept { return static_cast<bool>(handle_); }
+    bool done() const noexcept { return handle_ && handle_.done(); }
+
+    auto operator co_await() & noexcept { return awaiter<false>{handle_}; }
+    auto operator co_await() && noexcept { return awaiter<true>{handle_}; }
+
+    /// Result of a completed task; rethrows an exception that escaped the body.
+    decltype(auto) result() & { return promise(handle_).result(); }
+    decltype(auto) result() && { return std::move(promise(handle_)).result(); }
+
+    handle_type handle() const noexcept { return handle_; }
+    handle_type release() noexcept { return std::exchange(handle_, {}); }
+
+private:
+    template <bool Move>
+    struct awaiter {
+        handle_type h;
+
+        // An empty task is "ready" so that `await_resume` can report it.
+        bool await_ready() const noexcept { return !h || h.done(); }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            h.promise().continuation_ = awaiting;
+            return h;
+        }
+        decltype(auto) await_resume() {
+            if constexpr (Move)
+                return std::move(promise(h)).result();
+            else
+                return promise(h).result();
+        }
+    };
+
+    static promise_type& promise(handle_type h) {
+        if (!h) throw std::logic_error("mo::task: awaiting an empty (default-constructed or moved-from) task");
+        return h.promise();
+    }
+
+    void destroy() noexcept {
+        if (handle_) handle_.destroy();
+    }
+
+    handle_type handle_;
+};
+
+namespace detail {
+
+template <typename T>
+task<T> task_promise<T>::get_return_object() noexcept {
+    return task<T>{std::coroutine_handle<task_promise>::from_promise(*this)};
+}
+
+inline task<void> task_promise<void>::get_return_object() noexcept {
+    return task<void>{std::coroutine_handle<task_promise>::from_promise(*this)};
+}
+
+}  // namespace detail
+
+}  // namespace mo
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mo/function.hpp"
+
+namespace mo {
+
+/// Fixed-size pool of worker threads fed from one FIFO queue.
+///
+/// The destructor finishes every queued task before joining.
+class thread_pool {
+public:
+    explicit thread_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+        workers_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) workers_.emplace_back([this] { work(); });
+    }
+
+    ~thread_pool() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for (std::thread& t : workers_) t.join();
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    std::size_t size() const noexcept { return workers_.size(); }
+
+    /// Worker threads, e.g. for pinning or naming.
+    std::vector<std::thread>& threads() noexcept { return workers_; }
+
+    /// Queues `task` without a way to observe its completion. Captures of up
+    /// to 48 bytes are stored without allocating, and may be move-only.
+    void post(unique_function<void()> task) {
+        {
+            std::lock_guard lock(mutex_);
+            queue_.push_back(std::move(task));
+        }
+        ready_.notify_one();
+    }
+
+    /// Queues `f` and returns a future for its result.
+    template <typename F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using result = std::invoke_result_t<std::decay_t<F>>;
+        std::packaged_task<result()> task(std::forward<F>(f));
+        std::future<result> future = task.get_future();
+        post(std::move(task));
+        return future;
+    }
+
+    /// Calls `f(i)` for every `i` in [0, count), spreading indices over the
+    /// workers and the calling thread, and returns once all calls finished.
+    /// The caller keeps claiming indices itself, so this cannot deadlock when
+    /// invoked from inside a task on a busy pool. The first exception thrown by
+    /// `f` is rethrown here once every index has been processed.
+    template <typename F>
+    void parallel_for(std::size_t count, F&& f) {
+        if (count == 0) return;
+        struct shared {
+            std::atomic<std::size_t> next{0};
+            std::atomic<std::size_t> done{0};
+            std::size_t count;
+            std::remove_reference_t<F>* fn;
+            std::mutex error_mutex;
+            std::exception_ptr error;
+        };
+        auto state = std::make_shared<shared>();
+        state->count = count;
+        state->fn = &f;
+
+        // Helpers that start after every index was claimed only touch the
+        // counters, never `f`, so they may safely outlive this call.
+        auto run = [](shared& s) {
+            for (std::size_t i; (i = s.next.fetch_add(1, std::memory_order_relaxed)) < s.count;) {
+                try {
+                    (*s.fn)(i);
+                } catch (...) {
+                    std::lock_guard lock(s.error_mutex);
+                    if (!s.error) s.error = std::current_exception();
+                }
+                if (s.done.fetch_add(1, std::memory_order_acq_rel) + 1 == s.count) s.done.notify_all();
+            }
+        };
+        const std::size_t helpers = std::min(size(), count - 1);
+        for (std::size_t h = 0; h < helpers; ++h) post([state, run] { run(*state); });
+        run(*state);
+        for (std::size_t d; (d = state->done.load(std::memory_order_acquire)) != count;) state->done.wait(d);
+        if (state->error) std::rethrow_exception(state->error);
+    }
+
+private:
+    void work() {
+        for (;;) {
+            unique_function<void()> task;
+            {
+                std::unique_lock lock(mutex_);
+                ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                task = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<unique_function<void()>> queue_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace mo
@@ -0,0 +1,508 @@
+#pragma once
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "mo/compress.hpp"
+
+namespace mo {
+
+/// Thrown when a log holds a corrupt record anywhere but at its tail.
+class wal_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/// What `wal::sync` waits for.
+enum class wal_sync {
+    none,  // write to the page cache only: survives a process crash, not a machine crash
+    data,  // fdatasync: record bytes are on stable storage
+    full,  // fsync: also flushes metadata such as timestamps
+};
+
+struct wal_options {
+    std::size_t segment_size = std::size_t{64} << 20;  // a new segment file starts past this size
+    std::size_t buffer_size = std::size_t{1} << 20;    // appended bytes buffered before a write(2)
+    wal_sync sync = wal_sync::data;
+    bool preallocate = true;  // fallocate each segment up front, so appends never extend the file
+};
+
+/// One record read back from a log; `payload` is valid until the next read.
+struct wal_record {
+    std::uint64_t sequence = 0;
+    std::string_view payload;
+};
+
+namespace detail::wal {
+
+// Segment: 16-byte header (magic, version, sequence of its first record),
+// then records of [u32 length][u32 xxh32 of the payload, seeded with the
+// length][payload]. The preallocated rest of the file is zeros, and a zero
+// length with a zero checksum marks the clean end.
+inline constexpr std::uint32_t magic = 0x4C41574D;  // "MWAL"
+inline constexpr std::uint32_t version = 1;
+inline constexpr std::size_t header_size = 16;
+inline constexpr std::size_t record_header = 8;
+
+inline std::string segment_path(const std::string& dir, std::uint64_t base) {
+    char name[32];
+    std::snprintf(name, sizeof name, "%020llu.wal", static_cast<unsigned long long>(base));
+    return dir + '/' + name;
+}
+
+/// Base sequences of the segments in `dir`, ascending.
+inline std::vector<std::uint64_t> list_segments(const std::string& dir) {
+    DIR* d = ::opendir(dir.c_str());
+    if (!d) throw std::system_error(errno, std::system_category(), "opendir " + dir);
+    std::vector<std::uint64_t> out;
+    while (const dirent* e = ::readdir(d)) {
+        const std::string_view name = e->d_name;
+        if (name.size() != 24 || !name.ends_with(".wal")) continue;
+        if (!std::all_of(name.begin(), name.begin() + 20, [](char c) { return c >= '0' && c <= '9'; })) continue;
+        out.push_back(std::stoull(std::string(name.substr(0, 20))));
+    }
+    ::closedir(d);
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+inline std::uint32_t checksum(const char* payload, std::uint32_t length) noexcept {
+    return xxh32(payload, length, length);
+}
+
+inline std::uint32_t load32(const char* p) noexcept {
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline std::string read_file(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::system_error(errno, std::system_category(), "open " + path);
+    struct stat st {};
+    std::string out;
+    if (::fstat(fd, &st) == 0) out.resize(static_cast<std::size_t>(st.st_size));
+    std::size_t done = 0;
+    while (done < out.size()) {
+        const ssize_t n = ::read(fd, out.data() + done, out.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            const int error = n < 0 ? errno : 0;
+            ::close(fd);
+            if (error) throw std::system_error(error, std::system_category(), "read " + path);
+            out.resize(done);
+            return out;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    ::close(fd);
+    return out;
+}
+
+inline void write_at(int fd, const char* p, std::size_t n, std::size_t offset) {
+    while (n > 0) {
+        const ssize_t w = ::pwrite(fd, p, n, static_cast<off_t>(offset));
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::system_category(), "wal pwrite");
+        }
+        p += w, n -= static_cast<std::size_t>(w), offset += static_cast<std::size_t>(w);
+    }
+}
+
+inline void sync_fd(int fd, wal_sync mode) {
+    if (mode == wal_sync::none) return;
+    if ((mode == wal_sync::full ? ::fsync(fd) : ::fdatasync(fd)) != 0)
+        throw std::system_error(errno, std::system_category(), "wal fsync");
+}
+
+/// Makes a new or removed directory entry durable.
+inline void sync_dir(const std::string& dir, wal_sync mode) {
+    if (mode == wal_sync::none) return;
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) throw std::system_error(errno, std::system_category(), "open " + dir);
+    const int rc = ::fsync(fd);
+    const int error = errno;
+    ::close(fd);
+    if (rc != 0) throw std::system_error(error, std::system_category(), "fsync " + dir);
+}
+
+inline bool valid_header(std::string_view data, std::uint64_t base) noexcept {
+    if (data.size() < header_size) return false;
+    std::uint64_t stored;
+    std::memcpy(&stored, data.data() + 8, 8);
+    return load32(data.data()) == magic && load32(data.data() + 4) == version && stored == base;
+}
+
+enum class parse_status { record, end, corrupt };
+
+/// The record at `pos`: `end` at a clean end of the segment, `corrupt` at a
+/// torn or damaged record.
+inline parse_status parse(std::string_view data, std::size_t pos, std::string_view& payload) noexcept {
+    if (data.size() - pos < record_header) {
+        // Preallocated zeros too short for another record.
+        const bool zeros = std::all_of(data.begin() + pos, data.end(), [](char c) { return c == 0; });
+        return zeros ? parse_status::end : parse_status::corrupt;
+    }
+    const std::uint32_t length = load32(data.data() + pos), sum = load32(data.data() + pos + 4);
+    if (length == 0 && sum == 0) return parse_status::end;
+    if (data.size() - pos - record_header < length) return parse_status::corrupt;
+    payload = data.substr(pos + record_header, length);
+    return checksum(payload.data(), length) == sum ? parse_status::record : parse_status::corrupt;
+}
+
+/// Whether the log may end at `pos`, where `parse` found the end marker or
+/// a damaged record. A write torn by a crash leaves a partial record and
+/// then the preallocated zeros, so that is the only tail accepted: any
+/// nonzero byte past the record's claimed length, or any intact record
+/// after it (in case the length itself is what was damaged), means records
+/// that may have been acknowledged are corrupt.
+inline bool clean_tail(std::string_view data, std::size_t pos) noexcept {
+    std::size_t extent = data.size();
+    if (data.size() - pos >= record_header) {
+        const std::uint32_t length = load32(data.data() + pos);
+        if (data.size() - pos - record_header >= length) extent = pos + record_header + length;
+    }
+    if (!std::all_of(data.begin() + static_cast<std::ptrdiff_t>(extent), data.end(), [](char c) { return c == 0; }))
+        return false;
+    std::string_view payload;
+    for (std::size_t q = pos + 1; q + record_header <= extent; ++q) {
+        if (load32(data.data() + q) == 0 && load32(data.data() + q + 4) == 0) continue;
+        if (parse(data, q, payload) == parse_status::record) return false;
+    }
+    return true;
+}
+
+}  // namespace detail::wal
+
+/// Reads a log written by `wal` in sequence order.
+///
+/// A torn tail in the last segment, one damaged record followed only by
+/// zeros, is where the log ends: it was never acknowledged by `sync`.
+/// Damage anywhere else, including a bad record with anything after it, or
+/// a sequence gap between segments, throws `wal_error`; I/O errors throw
+/// `std::system_error`.
+class wal_reader {
+public:
+    /// Starts at record `from`, skipping whole segments below it.
+    explicit wal_reader(std::string dir, std::uint64_t from = 1)
+        : dir_(std::move(dir)), segments_(detail::wal::list_segments(dir_)), from_(from) {
+        while (segment_ + 1 < segments_.size() && segments_[segment_ + 1] <= from_) ++segment_;
+    }
+
+    std::optional<wal_record> next() {
+        using detail::wal::parse_status;
+        for (;;) {
+            if (!loaded_ && !load()) return std::nullopt;
+            std::string_view payload;
+            const std::string_view data = data_;
+            const parse_status status = detail::wal::parse(data, pos_, payload);
+            if (status == parse_status::record) {
+                pos_ += detail::wal::record_header + payload.size();
+                const std::uint64_t seq = sequence_++;
+                if (seq >= from_) return wal_record{seq, payload};
+                continue;
+            }
+            const bool last = segment_ + 1 == segments_.size();
+            if ((status == parse_status::corrupt && !last) || !detail::wal::clean_tail(data, pos_))
+                throw wal_error("wal: corrupt record in " + path() + " at offset " + std::to_string(pos_));
+            if (last) return std::nullopt;
+            if (segments_[segment_ + 1] != sequence_)
+                throw wal_error("wal: records missing before " +
+                                detail::wal::segment_path(dir_, segments_[segment_ + 1]));
+            ++segment_;
+            loaded_ = false;
+        }
+    }
+
+private:
+    std::string path() const { return detail::wal::segment_path(dir_, segments_[segment_]); }
+
+    bool load() {
+        if (segment_ >= segments_.size()) return false;
+        data_ = detail::wal::read_file(path());
+        if (!detail::wal::valid_header(data_, segments_[segment_])) {
+            // A crash right after creating the last segment leaves it blank.
+            if (segment_ + 1 == segments_.size()) return false;
+            throw wal_error("wal: bad segment header in " + path());
+        }
+        loaded_ = true;
+        pos_ = detail::wal::header_size;
+        sequence_ = segments_[segment_];
+        return true;
+    }
+
+    std::string dir_;
+    std::vector<std::uint64_t> segments_;
+    std::uint64_t from_;
+    std::size_t segment_ = 0;
+    bool loaded_ = false;
+    std::string data_;
+    std::size_t pos_ = 0;
+    std::uint64_t sequence_ = 0;
+};
+
+/// Append-only, checksummed log in a directory of segment files, for
+/// persisting events, state changes or a database's redo records.
+///
+/// `append` copies a record into a buffer under a mutex and returns its
+/// sequence number; `sync(seq)` returns once that record is on stable
+/// storage. Syncs group-commit: the first waiting thread writes every
+/// buffered record and issues one fdatasync while later ones queue behind
+/// it, and when it finishes, all records it covered are durable at once.
+/// N threads each committing a record cost one disk flush, not N, so
+/// throughput scales with concurrency instead of capping at the device's
+/// flush rate.
+///
+/// Segments are preallocated with fallocate, so a commit does not also
+/// journal a file-size change, and rolled at `segment_size`; the previous
+/// segment is synced before the next is created, so only the last can have
+/// a torn tail. Opening an existing log truncates that tail and continues
+/// after the last valid record; read it first with `wal_reader`. A log
+/// damaged anywhere else is never truncated: opening it throws `wal_error`.
+///
+/// Thread-safe. I/O errors throw `std::system_error`; after a failed write
+/// or sync the log cannot know what reached the disk, so every later call
+/// rethrows the first error.
+class wal {
+public:
+    explicit wal(std::string dir, const wal_options& options = {}) : dir_(std::move(dir)), options_(options) {
+        if (::mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST)
+            throw std::system_error(errno, std::system_category(), "mkdir " + dir_);
+        const std::vector<std::uint64_t> segments = detail::wal::list_segments(dir_);
+        if (segments.empty()) {
+            open_segment(1);
+            segment_bytes_ = detail::wal::header_size;
+        } else {
+            recover(segments.back());
+        }
+        written_ = durable_ = next_ - 1;
+    }
+
+    ~wal() {
+        try {
+            sync();
+        } catch (...) {
+        }
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    wal(const wal&) = delete;
+    wal& operator=(const wal&) = delete;
+
+    /// Buffers `payload` and returns its sequence number. Not durable until
+    /// a `sync` covering it returns.
+    std::uint64_t append(std::string_view payload) {
+        if (payload.size() > std::numeric_limits<std::uint32_t>::max())
+            throw std::invalid_argument("wal record too large");
+        std::unique_lock lock(mutex_);
+        if (failed_) std::rethrow_exception(failed_);
+        const std::size_t need = detail::wal::record_header + payload.size();
+        if (segment_bytes_ > detail::wal::header_size && segment_bytes_ + need > options_.segment_size) {
+            pending_.push_back({next_, {}});
+            segment_bytes_ = detail::wal::header_size;
+        }
+        if (pending_.empty()) pending_.push_back({0, {}});
+        std::string& buf = pending_.back().bytes;
+        const auto length = static_cast<std::uint32_t>(payload.size());
+        const std::uint32_t sum = detail::wal::checksum(payload.data(), length);
+        buf.append(reinterpret_cast<const char*>(&length), 4);
+        buf.append(reinterpret_cast<const char*>(&sum), 4);
+        buf.append(payload);
+        segment_bytes_ += need;
+        pending_bytes_ += need;
+        const std::uint64_t seq = next_++;
+        if (pending_bytes_ >= options_.buffer_size) drain(lock, seq, false);
+        return seq;
+    }
+
+    /// Waits until every record up to `seq` (default: all appended so far)
+    /// is durable under `options.sync`.
+    void sync(std::uint64_t seq = std::numeric_limits<std::uint64_t>::max()) {
+        std::unique_lock lock(mutex_);
+        drain(lock, std::min(seq, next_ - 1), true);
+    }
+
+    /// `append` then `sync` of that record.
+    std::uint64_t append_sync(std::string_view payload) {
+        const std::uint64_t seq = append(payload);
+        sync(seq);
+        return seq;
+    }
+
+    /// Writes buffered records to the OS without waiting for the disk.
+    void flush() {
+        std::unique_lock lock(mutex_);
+        drain(lock, next_ - 1, false);
+    }
+
+    /// Sequence number the next `append` returns.
+    std::uint64_t next_sequence() const {
+        std::lock_guard lock(mutex_);
+        return next_;
+    }
+
+    /// Highest sequence number known to be durable.
+    std::uint64_t durable_sequence() const {
+        std::lock_guard lock(mutex_);
+        return durable_;
+    }
+
+    /// Deletes segments holding only records below `seq`, e.g. once a
+    /// checkpoint covers them; returns how many. The current segment stays.
+    std::size_t remove_before(std::uint64_t seq) {
+        // The newest segment on disk is the one being written; older ones are
+        // synced and no longer touched.
+        const std::vector<std::uint64_t> segments = detail::wal::list_segments(dir_);
+        std::size_t removed = 0;
+        for (std::size_t i = 0; i + 1 < segments.size() && segments[i + 1] <= seq; ++i) {
+            const std::string path = detail::wal::segment_path(dir_, segments[i]);
+            if (::unlink(path.c_str()) != 0) throw std::system_error(errno, std::system_category(), "unlink " + path);
+            ++removed;
+        }
+        if (removed) detail::wal::sync_dir(dir_, options_.sync);
+        return removed;
+    }
+
+private:
+    /// Buffered records for one segment; `roll` is the base of a segment to
+    /// start before writing them, or 0.
+    struct chunk {
+        std::uint64_t roll = 0;
+        std::string bytes;
+    };
+
+    void recover(std::uint64_t base) {
+        const std::string path = detail::wal::segment_path(dir_, base);
+        const std::string data = detail::wal::read_file(path);
+        next_ = base;
+        if (!detail::wal::valid_header(data, base)) {
+            open_segment(base);
+            segment_bytes_ = detail::wal::header_size;
+            return;
+        }
+        std::size_t pos = detail::wal::header_size;
+        std::uint64_t seq = base;
+        std::string_view payload;
+        while (detail::wal::parse(data, pos, payload) == detail::wal::parse_status::record)
+            pos += detail::wal::record_header + payload.size(), ++seq;
+        // Truncating past damaged records would silently drop durable ones.
+        if (!detail::wal::clean_tail(data, pos))
+            throw wal_error("wal: corrupt record in " + path + " at offset " + std::to_string(pos));
+        fd_ = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd_ < 0) throw std::system_error(errno, std::system_category(), "open " + path);
+        // Drop the torn tail so no stale bytes follow the records appended next.
+        if (::ftruncate(fd_, static_cast<off_t>(pos)) != 0)
+            throw std::system_error(errno, std::system_category(), "ftruncate " + path);
+        preallocate();
+        file_offset_ = segment_bytes_ = pos;
+        next_ = seq;
+    }
+
+    void open_segment(std::uint64_t base) {
+        const std::string path = detail::wal::segment_path(dir_, base);
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) throw std::system_error(errno, std::system_category(), "open " + path);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = fd;
+        preallocate();
+        char header[detail::wal::header_size];
+        std::memcpy(header, &detail::wal::magic, 4);
+        std::memcpy(header + 4, &detail::wal::version, 4);
+        std::memcpy(header + 8, &base, 8);
+        detail::wal::write_at(fd_, header, sizeof header, 0);
+        detail::wal::sync_dir(dir_, options_.sync);
+        file_offset_ = detail::wal::header_size;
+    }
+
+    void preallocate() {
+        if (!options_.preallocate) return;
+        // Filesystems without fallocate just grow the file as it is written.
+        if (::fallocate(fd_, 0, 0, static_cast<off_t>(options_.segment_size)) != 0 && errno != EOPNOTSUPP &&
+            errno != ENOSYS)
+            throw std::system_error(errno, std::system_category(), "fallocate " + dir_);
+    }
+
+    /// Returns once records up to `seq` are written (and durable, if `sync`).
+    /// One thread at a time leads: it takes everything buffered, writes and
+    /// syncs it without the lock, then publishes the new watermarks.
+    void drain(std::unique_lock<std::mutex>& lock, std::uint64_t seq, bool sync) {
+        for (;;) {
+            if (failed_) std::rethrow_exception(failed_);
+            if ((sync ? durable_ : written_) >= seq) return;
+            if (leading_) {
+                idle_.wait(lock);
+                continue;
+            }
+            leading_ = true;
+            std::vector<chunk> batch;
+            batch.swap(pending_);
+            pending_bytes_ = 0;
+            const std::uint64_t last = next_ - 1;
+            lock.unlock();
+            try {
+                for (chunk& c : batch) {
+                    if (c.roll) {
+                        // The old segment must be durable before a newer one exists,
+                        // so recovery only ever finds a torn tail in the last one.
+                        detail::wal::sync_fd(fd_, options_.sync);
+                        open_segment(c.roll);
+                    }
+                    detail::wal::write_at(fd_, c.bytes.data(), c.bytes.size(), file_offset_);
+                    file_offset_ += c.bytes.size();
+                }
+                if (sync) detail::wal::sync_fd(fd_, options_.sync);
+            } catch (...) {
+                lock.lock();
+                failed_ = std::current_exception();
+                leading_ = false;
+                idle_.notify_all();
+                throw;
+            }
+            lock.lock();
+            written_ = std::max(written_, last);
+            if (sync) durable_ = std::max(durable_, last);
+            leading_ = false;
+            idle_.notify_all();
+        }
+    }
+
+    std::string dir_;
+    wal_options options_;
+    int fd_ = -1;
+
+    mutable std::mutex mutex_;
+    std::condition_variable idle_;
+    std::vector<chunk> pending_;
+    std::size_t pending_bytes_ = 0;
+    std::size_t segment_bytes_ = 0;  // size of the newest segment, buffered records included
+    std::uint64_t next_ = 1;
+    std::uint64_t written_ = 0;
+    std::uint64_t durable_ = 0;
+    bool leading_ = false;
+    std::exception_ptr failed_;
+
+    std::size_t file_offset_ = 0;  // owned by the leading thread
+};
+
+}  // namespace mo
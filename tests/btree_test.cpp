@@ -0,0 +1,277 @@
+// btree_map against std::map: random inserts, erases, bounds and iteration
+// in both directions for several key types, a bulk load erased down to
+// empty, inserts whose value constructor or node allocation throws, and
+// lookups by arguments of other types.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/btree_test.cpp -o btree_test
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <new>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.hpp"
+#include "mo/btree.hpp"
+
+namespace {
+
+/// Nodes are over-aligned, so only the aligned `operator new` below sees
+/// them; it throws once this many node allocations have succeeded.
+long node_allocs_left = -1;
+
+}  // namespace
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    if (node_allocs_left == 0) throw std::bad_alloc();
+    if (node_allocs_left > 0) --node_allocs_left;
+    if (void* p = std::aligned_alloc(static_cast<std::size_t>(align), (size + static_cast<std::size_t>(align) - 1) &
+                                                                          ~(static_cast<std::size_t>(align) - 1)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+template <typename Key, typename Compare>
+void check_same(const mo::btree_map<Key, long, Compare>& tree, const std::map<Key, long, Compare>& model) {
+    CHECK(tree.size() == model.size());
+    CHECK(tree.empty() == model.empty());
+    auto m = model.begin();
+    for (auto it = tree.begin(); it != tree.end(); ++it, ++m) {
+        CHECK(m != model.end());
+        CHECK(!(it->first < m->first) && !(m->first < it->first) && it->second == m->second);
+    }
+    CHECK(m == model.end());
+    auto r = model.rbegin();
+    for (auto it = tree.end(); it != tree.begin(); ++r) {
+        --it;
+        CHECK(r != model.rend());
+        CHECK(!(it->first < r->first) && !(r->first < it->first) && it->second == r->second);
+    }
+    CHECK(r == model.rend());
+}
+
+/// `it` and `m` name the same entry, or are both past the end.
+template <typename It, typename Key, typename Compare>
+bool same_position(It it, It end, typename std::map<Key, long, Compare>::const_iterator m,
+                   const std::map<Key, long, Compare>& model) {
+    if (m == model.end()) return it == end;
+    return it != end && !(it->first < m->first) && !(m->first < it->first) && it->second == m->second;
+}
+
+/// Random operations over a key space of `keys` values, checked against
+/// `std::map` after each one and in full every so often.
+template <typename Key, typename Compare = std::less<Key>, typename MakeKey>
+void test_random(const char* name, MakeKey make_key, std::uint64_t keys, int ops) {
+    std::mt19937_64 rng(keys);
+    mo::btree_map<Key, long, Compare> tree;
+    std::map<Key, long, Compare> model;
+    for (int op = 0; op < ops; ++op) {
+        const Key key = make_key(rng() % keys);
+        const long value = static_cast<long>(rng() % 1000);
+        switch (rng() % 8) {
+        case 0: {
+            const auto [it, inserted] = tree.try_emplace(key, value);
+            const auto [m, model_inserted] = model.try_emplace(key, value);
+            CHECK(inserted == model_inserted && it->second == m->second);
+            break;
+        }
+        case 1: {
+            const auto [it, inserted] = tree.insert({key, value});
+            CHECK(inserted == model.insert({key, value}).second && it->second == model.at(key));
+            break;
+        }
+        case 2: {
+            const auto [it, inserted] = tree.insert_or_assign(key, value);
+            CHECK(inserted == model.insert_or_assign(key, value).second && it->second == value);
+            break;
+        }
+        case 3:
+            tree[key] += value;
+            model[key] += value;
+            break;
+        case 4:
+        case 5:
+            CHECK(tree.erase(key) == model.erase(key));
+            break;
+        case 6: {
+            auto m = model.lower_bound(key);
+            auto it = tree.lower_bound(key);
+            CHECK((same_position<decltype(it), Key, Compare>(it, tree.end(), m, model)));
+            if (m == model.end()) break;
+            it = tree.erase(it);
+            m = model.erase(m);
+            CHECK((same_position<decltype(it), Key, Compare>(it, tree.end(), m, model)));
+            break;
+        }
+        default: {
+            const auto& ctree = tree;
+            CHECK((same_position<decltype(ctree.begin()), Key, Compare>(ctree.lower_bound(key), ctree.end(),
+                                                                       model.lower_bound(key), model)));
+            CHECK((same_position<decltype(ctree.begin()), Key, Compare>(ctree.upper_bound(key), ctree.end(),
+                                                                       model.upper_bound(key), model)));
+            CHECK((same_position<decltype(ctree.begin()), Key, Compare>(
+                ctree.find(key), ctree.end(), model.find(key), model)));
+            CHECK(ctree.contains(key) == (model.count(key) != 0));
+            break;
+        }
+        }
+        CHECK(tree.size() == model.size());
+        if (op % 5000 == 0) check_same(tree, model);
+    }
+    check_same(tree, model);
+    std::printf("  %-8s %zu entries, height %zu\n", name, tree.size(), tree.height());
+}
+
+/// The bulk constructor over 300k entries, then erased in random order down
+/// to an empty tree.
+void test_bulk() {
+    constexpr std::uint64_t n = 300'000;
+    std::mt19937_64 rng(7);
+    std::vector<std::uint64_t> keys(n);
+    std::vector<long> values(n);
+    std::map<std::uint64_t, long> model;
+    for (std::uint64_t i = 0; i < n; ++i) {
+        keys[i] = rng();
+        values[i] = static_cast<long>(i);
+        model.emplace(keys[i], values[i]);  // the first of a duplicate wins, as in the tree
+    }
+    mo::btree_map<std::uint64_t, long> tree(keys, values);
+    check_same(tree, model);
+
+    std::shuffle(keys.begin(), keys.end(), rng);
+    for (std::uint64_t i = 0; i < n; ++i) {
+        CHECK(tree.erase(keys[i]) == model.erase(keys[i]));
+        if (i % 50'000 == 0) check_same(tree, model);
+    }
+    CHECK(tree.empty() && tree.begin() == tree.end() && tree.height() == 0 && tree.memory_bytes() == 0);
+    CHECK(tree.try_emplace(1, 1).second && tree.size() == 1);
+}
+
+/// Throws from its constructor for the value 3.
+struct picky {
+    long value = 0;
+    picky() = default;
+    explicit picky(long v) : value(v == 3 ? throw std::runtime_error("picky") : v) {}
+};
+
+template <typename F>
+bool throws(F f) {
+    try {
+        f();
+    } catch (const std::runtime_error&) {
+        return true;
+    } catch (const std::bad_alloc&) {
+        return true;
+    }
+    return false;
+}
+
+/// A throwing value constructor leaves the tree unchanged, including when
+/// the insert would have split a leaf or created the first one.
+void test_throwing_value() {
+    mo::btree_map<std::uint64_t, picky> tree;
+    CHECK(throws([&] { tree.try_emplace(3, 3); }));
+    CHECK(tree.empty() && tree.begin() == tree.end() && tree.memory_bytes() == 0);
+
+    for (std::uint64_t k : {0, 2, 4, 6, 8}) tree.try_emplace(k, static_cast<long>(k));
+    CHECK(throws([&] { tree.try_emplace(3, 3); }));
+    CHECK(tree.size() == 5 && !tree.contains(3));
+    CHECK(tree.try_emplace(3, 5).second && tree.at(3).value == 5);
+
+    mo::btree_map<std::uint64_t, picky> full;
+    std::uint64_t k = 10;
+    while (full.height() == 0) full.try_emplace(k += 2, 1);  // the first split
+    for (int i = 0; i < 1000; ++i) {
+        const std::size_t size = full.size();
+        CHECK(throws([&] { full.try_emplace(k + 1, 3); }));
+        CHECK(full.size() == size && !full.contains(k + 1));
+        full.try_emplace(k += 2, 1);
+    }
+    std::uint64_t expect = 12;
+    for (const auto& [key, v] : full) {
+        CHECK(key == expect && v.value == 1);
+        expect += 2;
+    }
+}
+
+/// Every node allocation an insert makes fails in turn: the insert throws,
+/// the tree is unchanged, and the next insert still works. Splits come
+/// every few inserts and reach the root, so each level's allocation fails.
+void test_failed_allocation() {
+    constexpr std::uint64_t n = 20'000;
+    mo::btree_map<std::uint64_t, long> tree;
+    std::map<std::uint64_t, long> model;
+    int failures = 0;
+    for (std::uint64_t i = 0; i < n; ++i) {
+        const std::uint64_t key = i * 7919 % n;
+        for (long allowed = 0;; ++allowed) {
+            node_allocs_left = allowed;
+            bool failed = false;
+            try {
+                tree.try_emplace(key, static_cast<long>(i));
+            } catch (const std::bad_alloc&) {
+                failed = true;
+            }
+            node_allocs_left = -1;
+            if (!failed) break;
+            ++failures;
+            CHECK(tree.size() == model.size() && !tree.contains(key));
+            if (failures % 100 == 0) check_same(tree, model);
+        }
+        model.emplace(key, static_cast<long>(i));
+    }
+    check_same(tree, model);
+    CHECK(failures > static_cast<int>(n / 64));
+}
+
+/// Integer and string literals convert to the key type; a transparent
+/// comparator takes a `std::string_view` as is.
+void test_lookup_conversions() {
+    mo::btree_map<std::uint64_t, int> ids{{1, 10}, {5, 50}, {9, 90}};
+    CHECK(ids.contains(5) && !ids.contains(6) && ids.count(9) == 1 && ids.find(5)->second == 50);
+    CHECK(ids.at(1) == 10 && *ids.get(9) == 90 && ids.get(2) == nullptr);
+    CHECK(ids.lower_bound(2)->first == 5 && ids.upper_bound(5)->first == 9);
+    CHECK(std::ranges::distance(ids.range(1, 9)) == 2);
+    CHECK(ids.erase(5) == 1 && ids.erase(5) == 0 && ids.size() == 2);
+
+    mo::btree_map<std::string, int> names{{"x", 1}, {"y", 2}};
+    CHECK(names.contains("x") && names.at("y") == 2 && names.lower_bound("xa")->first == "y");
+    CHECK(names.erase("x") == 1 && !names.contains("x"));
+
+    mo::btree_map<std::string, int, std::less<>> by_view{{"alpha", 1}, {"beta", 2}};
+    const std::string_view beta = "beta";
+    CHECK(by_view.contains(beta) && by_view.at(beta) == 2 && by_view.find(beta)->second == 2);
+    CHECK(by_view.erase(beta) == 1 && by_view.size() == 1);
+}
+
+}  // namespace
+
+int main() {
+    test_random<std::uint64_t>("uint64", [](std::uint64_t x) { return x * 0x9E3779B97F4A7C15ull; }, 20'000, 200'000);
+    test_random<std::int32_t>("int32", [](std::uint64_t x) { return static_cast<std::int32_t>(x) - 5000; }, 10'000,
+                              200'000);
+    test_random<std::string>("string", [](std::uint64_t x) { return "key-" + std::to_string(x); }, 5'000, 100'000);
+    test_random<double>("double", [](std::uint64_t x) { return static_cast<double>(x) / 7.0 - 100.0; }, 10'000,
+                        200'000);
+    test_random<std::int64_t, std::greater<std::int64_t>>(
+        "greater", [](std::uint64_t x) { return static_cast<std::int64_t>(x); }, 3'000, 100'000);
+    test_bulk();
+    test_throwing_value();
+    test_failed_allocation();
+    test_lookup_conversions();
+    std::printf("btree ok\n");
+}
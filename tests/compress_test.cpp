@@ -0,0 +1,133 @@
+// LZ4 frames: round trips under each frame option, streaming in small
+// chunks, skippable frames anywhere in a stream (including at its end), and
+// truncated or damaged input.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/compress_test.cpp -o compress_test
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "check.hpp"
+#include "mo/compress.hpp"
+
+namespace {
+
+/// Repetitive text with random runs, so blocks hold both matches and
+/// literals.
+std::string sample(std::size_t size) {
+    std::mt19937 rng(static_cast<unsigned>(size));
+    std::string out;
+    while (out.size() < size) {
+        out += "line " + std::to_string(rng() % 1000) + " of the sample ";
+        for (unsigned i = rng() % 8; i > 0; --i) out += static_cast<char>('a' + rng() % 26);
+        out += '\n';
+    }
+    out.resize(size);
+    return out;
+}
+
+std::string skippable(std::uint32_t nibble, const std::string& payload) {
+    std::string out(8, '\0');
+    mo::detail::lz4::store32(out.data(), 0x184D2A50u | nibble);
+    mo::detail::lz4::store32(out.data() + 4, static_cast<std::uint32_t>(payload.size()));
+    return out + payload;
+}
+
+template <typename F>
+bool throws(F f) {
+    try {
+        f();
+    } catch (const mo::compress_error&) {
+        return true;
+    }
+    return false;
+}
+
+void test_round_trip() {
+    for (const std::size_t size : {std::size_t{0}, std::size_t{1}, std::size_t{100}, std::size_t{200'000}}) {
+        const std::string data = sample(size);
+        for (int variant = 0; variant < 4; ++variant) {
+            mo::lz4_frame_options options;
+            options.block_checksums = variant & 1;
+            options.content_checksum = variant & 2;
+            CHECK(mo::lz4_decompress(mo::lz4_compress(data, options)) == data);
+        }
+        std::string frame;
+        mo::lz4_frame_writer writer(frame);
+        writer.write(data.substr(0, size / 3));
+        writer.flush();
+        writer.write(data.substr(size / 3));
+        writer.finish();
+        CHECK(mo::lz4_decompress(frame) == data);
+    }
+}
+
+/// Fed a few bytes at a time, the reader produces the same output and
+/// reports the bytes after its frame as unused.
+void test_streaming() {
+    const std::string data = sample(150'000);
+    const std::string stream = mo::lz4_compress(data) + "tail";
+    std::string out;
+    mo::lz4_frame_reader reader(out);
+    std::size_t at = 0;
+    while (!reader.done()) {
+        const std::size_t n = std::min<std::size_t>(7, stream.size() - at);
+        const std::size_t used = reader.feed(std::string_view(stream).substr(at, n));
+        at += used;
+        if (used < n) break;
+    }
+    CHECK(reader.done() && out == data);
+    CHECK(stream.substr(at) == "tail");
+}
+
+/// Skippable frames before, between and after data frames, and on their own,
+/// decode to nothing.
+void test_skippable() {
+    const std::string a = sample(1000), b = sample(70'000);
+    const std::string fa = mo::lz4_compress(a), fb = mo::lz4_compress(b);
+    const std::string s1 = skippable(0, "metadata"), s2 = skippable(0xF, ""), s3 = skippable(3, sample(300));
+
+    CHECK(mo::lz4_decompress(fa + s1) == a);
+    CHECK(mo::lz4_decompress(s1 + fa) == a);
+    CHECK(mo::lz4_decompress(s1 + fa + s2 + fb + s3) == a + b);
+    CHECK(mo::lz4_decompress(s1).empty());
+    CHECK(mo::lz4_decompress(s1 + s2 + s3).empty());
+
+    // A skippable frame split across feeds completes the reader's frame.
+    std::string out;
+    mo::lz4_frame_reader reader(out);
+    CHECK(reader.feed(std::string_view(s3).substr(0, 5)) == 5 && !reader.done());
+    CHECK(reader.feed(std::string_view(s3).substr(5, 100)) == 100 && !reader.done());
+    CHECK(reader.feed(s3.substr(105) + "more") == s3.size() - 105);
+    CHECK(reader.done() && out.empty());
+}
+
+void test_truncated() {
+    const std::string frame = mo::lz4_compress(sample(5000));
+    for (const std::size_t keep : {std::size_t{2}, std::size_t{4}, std::size_t{10}, frame.size() / 2, frame.size() - 1})
+        CHECK(throws([&] { mo::lz4_decompress(std::string_view(frame).substr(0, keep)); }));
+    const std::string skip = skippable(1, "abcdef");
+    for (std::size_t keep = 1; keep < skip.size(); ++keep)
+        CHECK(throws([&] { mo::lz4_decompress(frame + skip.substr(0, keep)); }));
+}
+
+void test_corrupt() {
+    std::string frame = mo::lz4_compress(sample(5000));
+    frame[frame.size() / 2] ^= 0x10;
+    CHECK(throws([&] { mo::lz4_decompress(frame); }));
+    CHECK(throws([&] { mo::lz4_decompress("not an lz4 frame"); }));
+}
+
+}  // namespace
+
+int main() {
+    test_round_trip();
+    test_streaming();
+    test_skippable();
+    test_truncated();
+    test_corrupt();
+    std::printf("compress ok\n");
+}
@@ -0,0 +1,169 @@
+// Writers inserting, updating and erasing while readers look up and
+// iterate, starting from the smallest table so the map resizes repeatedly
+// underneath them, and writers growing the map while a reader sits in a
+// callback. Meant for TSan as well as ASan, which also catches a reader
+// touching a node or table reclaimed too early; a writer waiting on the
+// reader shows up as a hang, cut short by alarm().
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=thread -Iinclude tests/concurrent_map_test.cpp -o map_test -pthread
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/concurrent_map_test.cpp -o map_test -pthread
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "mo/concurrent_map.hpp"
+
+namespace {
+
+using map_type = mo::concurrent_map<std::uint64_t, std::string>;
+
+constexpr int writers = 2, readers = 2;
+constexpr std::uint64_t stable_keys = 200;  // inserted up front, never erased
+constexpr std::uint64_t keys_per_writer = 4000;
+constexpr int ops_per_writer = 60000;
+
+/// Values name their key, so a reader can tell a value from the wrong node
+/// or from freed memory.
+std::string value_for(std::uint64_t key, int version) { return std::to_string(key) + ':' + std::to_string(version); }
+
+bool names(const std::string& value, std::uint64_t key) {
+    const std::string prefix = std::to_string(key) + ':';
+    return value.compare(0, prefix.size(), prefix) == 0;
+}
+
+/// Each writer owns its own key range and keeps a model of it.
+std::map<std::uint64_t, std::string> run_writer(map_type& map, int id) {
+    std::mt19937_64 rng(id);
+    std::map<std::uint64_t, std::string> model;
+    const std::uint64_t base = stable_keys + static_cast<std::uint64_t>(id) * keys_per_writer;
+    for (int op = 0; op < ops_per_writer; ++op) {
+        const std::uint64_t key = base + rng() % keys_per_writer;
+        const bool present = model.count(key) != 0;
+        switch (rng() % 4) {
+        case 0:
+            CHECK(map.try_emplace(key, value_for(key, op)) == !present);
+            if (!present) model[key] = value_for(key, op);
+            break;
+        case 1:
+            CHECK(map.insert_or_assign(key, value_for(key, op)) == !present);
+            model[key] = value_for(key, op);
+            break;
+        case 2:
+            CHECK(map.update(key, [&](const std::string& old) {
+                CHECK(old == model[key]);
+                return value_for(key, op);
+            }) == present);
+            if (present) model[key] = value_for(key, op);
+            break;
+        default:
+            CHECK(map.erase(key) == present);
+            model.erase(key);
+            break;
+        }
+    }
+    return model;
+}
+
+void run_reader(const map_type& map, const std::atomic<bool>& done, int id) {
+    std::mt19937_64 rng(100 + id);
+    const std::uint64_t key_space = stable_keys + writers * keys_per_writer;
+    while (!done.load(std::memory_order_relaxed)) {
+        const std::uint64_t key = rng() % key_space;
+        const bool found = map.visit(key, [&](const std::string& v) { CHECK(names(v, key)); });
+        if (key < stable_keys) {
+            CHECK(found);
+            CHECK(map.get(key) == value_for(key, 0));
+        }
+    }
+}
+
+/// Every stable key exactly once per pass, whatever the resizes do.
+void run_iterator(const map_type& map, const std::atomic<bool>& done) {
+    std::vector<int> seen(stable_keys);
+    while (!done.load(std::memory_order_relaxed)) {
+        std::fill(seen.begin(), seen.end(), 0);
+        map.for_each([&](std::uint64_t key, const std::string& v) {
+            CHECK(names(v, key));
+            if (key < stable_keys) ++seen[key];
+        });
+        for (const int n : seen) CHECK(n == 1);
+    }
+}
+
+/// A reader parked inside `visit` holds its epoch pinned. Writers must still
+/// finish a resize without waiting for it; only the next resize waits.
+void test_pinned_reader() {
+    map_type map;
+    CHECK(map.try_emplace(0, value_for(0, 0)));
+    const std::size_t initial_buckets = map.bucket_count();
+    std::atomic<bool> inside{false}, release{false};
+    std::thread reader([&] {
+        map.visit(0, [&](const std::string& v) {
+            inside.store(true);
+            while (!release.load()) std::this_thread::yield();
+            CHECK(names(v, 0));
+        });
+    });
+    while (!inside.load()) std::this_thread::yield();
+
+    std::uint64_t key = 1;
+    for (; key < 20000; ++key) CHECK(map.try_emplace(key, value_for(key, 0)));
+    const std::size_t pinned_buckets = map.bucket_count();
+    CHECK(pinned_buckets > initial_buckets);
+    release.store(true);
+    reader.join();
+
+    for (; key < 40000; ++key) CHECK(map.try_emplace(key, value_for(key, 0)));
+    CHECK(map.bucket_count() > pinned_buckets);
+    for (std::uint64_t k = 0; k < key; ++k) CHECK(map.get(k) == value_for(k, 0));
+}
+
+}  // namespace
+
+int main() {
+    ::alarm(300);
+    test_pinned_reader();
+
+    map_type map;
+    for (std::uint64_t k = 0; k < stable_keys; ++k) CHECK(map.try_emplace(k, value_for(k, 0)));
+    const std::size_t initial_buckets = map.bucket_count();
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> background;
+    for (int r = 0; r < readers; ++r) background.emplace_back([&, r] { run_reader(map, done, r); });
+    background.emplace_back([&] { run_iterator(map, done); });
+
+    std::vector<std::map<std::uint64_t, std::string>> models(writers);
+    std::vector<std::thread> writing;
+    for (int w = 0; w < writers; ++w) writing.emplace_back([&, w] { models[w] = run_writer(map, w); });
+    for (std::thread& t : writing) t.join();
+    done.store(true);
+    for (std::thread& t : background) t.join();
+
+    std::size_t expected = stable_keys;
+    for (const auto& model : models) {
+        expected += model.size();
+        for (const auto& [key, value] : model) CHECK(map.get(key) == value);
+    }
+    for (int w = 0; w < writers; ++w) {
+        const std::uint64_t base = stable_keys + static_cast<std::uint64_t>(w) * keys_per_writer;
+        for (std::uint64_t key = base; key < base + keys_per_writer; ++key)
+            CHECK(map.contains(key) == (models[w].count(key) != 0));
+    }
+    CHECK(map.size() == expected);
+    std::size_t iterated = 0;
+    map.for_each([&](std::uint64_t, const std::string&) { ++iterated; });
+    CHECK(iterated == expected);
+    CHECK(map.bucket_count() > initial_buckets);
+    std::printf("concurrent_map ok: %zu entries, %zu to %zu buckets\n", expected, initial_buckets, map.bucket_count());
+}
@@ -0,0 +1,104 @@
+// from_double against the exact decimal expansion of each double, and
+// rounding of quotients near the int64 limits.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/decimal_test.cpp -o decimal_test
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+
+#include "check.hpp"
+#include "mo/decimal.hpp"
+
+namespace {
+
+/// printf prints a double's exact binary value, so parsing that text with
+/// half_up rounding is the documented "nearest, ties away from zero". 120
+/// digits are exact for |x| above 2^-68, which covers every value tested.
+template <unsigned Scale>
+mo::decimal64<Scale> exact(double x) {
+    char buf[200];
+    std::snprintf(buf, sizeof buf, "%.120f", x);
+    return mo::decimal64<Scale>::parse(buf, mo::rounding::half_up);
+}
+
+template <unsigned Scale>
+void check_from_double(double x) {
+    if (mo::decimal64<Scale>::from_double(x) != exact<Scale>(x)) {
+        std::fprintf(stderr, "from_double<%u>(%.17g) = %s, want %s\n", Scale, x,
+                     mo::decimal64<Scale>::from_double(x).to_string().c_str(), exact<Scale>(x).to_string().c_str());
+        CHECK(false);
+    }
+}
+
+/// Doubles next to decimal ties, where rounding the scaled product first
+/// decides the tie on the wrong side.
+template <unsigned Scale>
+void test_near_ties(std::uint64_t max_units) {
+    std::mt19937_64 rng(Scale);
+    const double unit = static_cast<double>(mo::decimal64<Scale>::unit);
+    for (int i = 0; i < 20000; ++i) {
+        const double tie = (static_cast<double>(rng() % max_units) + 0.5) / unit;
+        for (double x : {std::nextafter(tie, 0.0), tie, std::nextafter(tie, 1e300)}) {
+            check_from_double<Scale>(x);
+            check_from_double<Scale>(-x);
+        }
+    }
+}
+
+void test_from_double() {
+    using d3 = mo::decimal64<3>;
+    using d2 = mo::decimal64<2>;
+    CHECK(d3::from_double(0.058499999999999996).raw() == 58);
+    CHECK(d2::from_double(24047106.064999998).raw() == 2404710606);
+    CHECK(d3::from_double(-0.058499999999999996).raw() == -58);
+    CHECK(d2::from_double(0.125).raw() == 13);  // exact tie: away from zero
+    CHECK(d2::from_double(-0.125).raw() == -13);
+    CHECK(d2::from_double(0.0).raw() == 0 && d2::from_double(-0.0).raw() == 0);
+    CHECK(d3::from_double(5e-324).raw() == 0);
+    CHECK(mo::decimal64<0>::from_double(9223372036854774784.0).raw() == 9223372036854774784);
+
+    test_near_ties<3>(1'000'000'000);
+    test_near_ties<2>(10'000'000'000);
+    test_near_ties<6>(1'000'000);
+    test_near_ties<0>(std::uint64_t{1} << 53);
+
+    for (const double bad : {9223372036854775808.0, -9223372036854775808.0, 1e300,
+                             std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN()}) {
+        bool threw = false;
+        try {
+            mo::decimal64<0>::from_double(bad);
+        } catch (const mo::decimal_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+    bool threw = false;
+    try {
+        d3::from_double(1e16);
+    } catch (const mo::decimal_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+/// Remainders above 2^62 used to overflow the doubled-remainder comparison.
+void test_large_quotients() {
+    using d0 = mo::decimal64<0>;
+    constexpr std::int64_t max = std::numeric_limits<std::int64_t>::max();
+    const d0 big = d0::from_raw(max);
+    CHECK(divide(big, d0::from_raw(max - 1)).raw() == 1);
+    CHECK(divide(d0::from_raw(std::int64_t{1} << 62), big).raw() == 1);            // 0.5000000000000000001
+    CHECK(divide(d0::from_raw((std::int64_t{1} << 62) - 1), big).raw() == 0);      // just below one half
+    CHECK(divide(d0::from_raw(-(std::int64_t{1} << 62)), big).raw() == -1);
+    CHECK(divide(d0::from_raw(max / 2 + 1), big, mo::rounding::down).raw() == 0);
+}
+
+}  // namespace
+
+int main() {
+    test_from_double();
+    test_large_quotients();
+    std::printf("decimal ok\n");
+}
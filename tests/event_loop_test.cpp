@@ -0,0 +1,248 @@
+// Loopback tests for both event_loop backends.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/event_loop_test.cpp -o event_loop_test
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "mo/event_loop.hpp"
+
+namespace {
+
+int listen_loopback(int& port) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == 0);
+    CHECK(::listen(fd, 64) == 0);
+    socklen_t len = sizeof addr;
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+int connect_loopback(int port) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<std::uint16_t>(port));
+    CHECK(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == 0);
+    return fd;
+}
+
+std::span<const std::byte> bytes(const std::string& s) { return std::as_bytes(std::span(s.data(), s.size())); }
+
+template <typename Pred>
+void run_until(mo::event_loop& loop, Pred done) {
+    for (int i = 0; !done(); ++i) {
+        CHECK(i < 10000);
+        loop.run_once(1000);
+    }
+}
+
+/// Echo server on the loop, one client writing 1 MiB through it.
+void test_echo(mo::event_loop& loop) {
+    int port;
+    const int lfd = listen_loopback(port);
+    std::vector<std::unique_ptr<std::string>> pending;
+    int accepted = 0;
+    const mo::op_id acceptor = loop.accept(lfd, [&](const mo::completion& c) {
+        if (!c.more) return;
+        CHECK(c.result >= 0);
+        ++accepted;
+        const int fd = c.result;
+        loop.recv(fd, [&, fd](const mo::completion& r) {
+            if (!r.more) {
+                ::close(fd);
+                return;
+            }
+            auto& copy = *pending.emplace_back(
+                std::make_unique<std::string>(reinterpret_cast<const char*>(r.data.data()), r.data.size()));
+            loop.send(fd, bytes(copy), [](const mo::completion& s) { CHECK(s.result > 0); });
+        });
+    });
+
+    const int client = connect_loopback(port);
+    std::string payload(1 << 20, '\0');
+    for (std::size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<char>('a' + i % 26);
+    int sent = -1;
+    loop.send(client, bytes(payload), [&](const mo::completion& c) { sent = c.result; });
+    std::string echoed;
+    const mo::op_id reader = loop.recv(client, [&](const mo::completion& c) {
+        if (c.more) echoed.append(reinterpret_cast<const char*>(c.data.data()), c.data.size());
+    });
+    run_until(loop, [&] { return echoed.size() >= payload.size(); });
+    CHECK(accepted == 1);
+    CHECK(sent == static_cast<int>(payload.size()));
+    CHECK(echoed == payload);
+
+    // Registered buffers, including a bad index.
+    static char fixed[64] = "hello fixed";
+    const iovec iov{fixed, sizeof fixed};
+    loop.register_buffers({&iov, 1});
+    int fixed_sent = 0;
+    echoed.clear();
+    loop.send_fixed(client, 0, 0, 11, [&](const mo::completion& c) { fixed_sent = c.result; });
+    run_until(loop, [&] { return fixed_sent != 0 && echoed.size() >= 11; });
+    CHECK(fixed_sent == 11);
+    CHECK(echoed == "hello fixed");
+    int bad = 0;
+    loop.send_fixed(client, 3, 0, 1, [&](const mo::completion& c) { bad = c.result; });
+    run_until(loop, [&] { return bad != 0; });
+    CHECK(bad == -EINVAL);
+
+    // Cancellation delivers one final completion. `client` already has a
+    // reader, so poll a second connection.
+    const int idle = connect_loopback(port);
+    int final_result = 0;
+    bool final_seen = false;
+    const mo::op_id poller = loop.poll(idle, EPOLLOUT, [&](const mo::completion& c) {
+        if (!c.more) {
+            final_seen = true;
+            final_result = c.result;
+        }
+    });
+    loop.run_once(100);
+    loop.cancel(poller);
+    run_until(loop, [&] { return final_seen; });
+    CHECK(final_result == -ECANCELED);
+
+    loop.cancel(reader);
+    loop.cancel(acceptor);
+    ::close(client);
+    ::close(idle);
+    for (int i = 0; i < 5; ++i) loop.run_once(10);
+    ::close(lfd);
+    loop.register_buffers({});
+}
+
+/// Sending to a closed peer must fail with an error, not kill us with SIGPIPE.
+void test_closed_peer(mo::event_loop& loop) {
+    int port;
+    const int lfd = listen_loopback(port);
+    const int client = connect_loopback(port);
+    const int server = ::accept(lfd, nullptr, nullptr);
+    ::close(server);
+    ::close(lfd);
+
+    static char fixed[4096];
+    const iovec iov{fixed, sizeof fixed};
+    loop.register_buffers({&iov, 1});
+    const std::string chunk(4096, 'x');
+    int send_error = 0, fixed_error = 0;
+    // The first write after the peer's close draws an RST; later ones hit EPIPE.
+    for (int round = 0; round < 100 && (send_error == 0 || fixed_error == 0); ++round) {
+        int s = 0, f = 0;
+        loop.send(client, bytes(chunk), [&](const mo::completion& c) { s = c.result; });
+        loop.send_fixed(client, 0, 0, sizeof fixed, [&](const mo::completion& c) { f = c.result; });
+        run_until(loop, [&] { return s != 0 && f != 0; });
+        if (s < 0) send_error = s;
+        if (f < 0) fixed_error = f;
+    }
+    CHECK(send_error == -EPIPE || send_error == -ECONNRESET);
+    CHECK(fixed_error == -EPIPE || fixed_error == -ECONNRESET);
+    ::close(client);
+    loop.register_buffers({});
+}
+
+/// A failed accept is final, as documented.
+void test_accept_error(mo::event_loop& loop) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);  // never listened on
+    int calls = 0, result = 0;
+    bool more = true;
+    loop.accept(fd, [&](const mo::completion& c) {
+        ++calls;
+        result = c.result;
+        more = c.more;
+    });
+    run_until(loop, [&] { return calls > 0; });
+    for (int i = 0; i < 5; ++i) loop.run_once(10);
+    CHECK(calls == 1);
+    CHECK(!more);
+    CHECK(result < 0);
+    ::close(fd);
+}
+
+/// A second accept, recv or poll on an fd fails with -EBUSY and leaves the
+/// first armed; once the first ends, the fd takes a new one. fds handed to
+/// the loop become non-blocking.
+void test_one_reader_per_fd(mo::event_loop& loop) {
+    int port;
+    const int lfd = listen_loopback(port);
+    const int client = connect_loopback(port);
+    const int server = ::accept(lfd, nullptr, nullptr);
+    CHECK(!(::fcntl(server, F_GETFL) & O_NONBLOCK));
+
+    std::string received;
+    bool first_done = false;
+    const mo::op_id first = loop.recv(server, [&](const mo::completion& c) {
+        if (c.more)
+            received.append(reinterpret_cast<const char*>(c.data.data()), c.data.size());
+        else
+            first_done = true;
+    });
+    CHECK(::fcntl(server, F_GETFL) & O_NONBLOCK);
+    int busy_recv = 0, busy_poll = 0, busy_accept = 0;
+    bool busy_more = true;
+    loop.recv(server, [&](const mo::completion& c) {
+        busy_recv = c.result;
+        busy_more = c.more;
+    });
+    loop.poll(server, EPOLLIN, [&](const mo::completion& c) { busy_poll = c.result; });
+    const mo::op_id acceptor = loop.accept(lfd, [](const mo::completion&) {});
+    loop.accept(lfd, [&](const mo::completion& c) { busy_accept = c.result; });
+    run_until(loop, [&] { return busy_recv != 0 && busy_poll != 0 && busy_accept != 0; });
+    CHECK(busy_recv == -EBUSY && !busy_more);
+    CHECK(busy_poll == -EBUSY && busy_accept == -EBUSY);
+
+    CHECK(::write(client, "ping", 4) == 4);
+    run_until(loop, [&] { return received.size() >= 4; });
+    CHECK(received == "ping");
+
+    loop.cancel(first);
+    run_until(loop, [&] { return first_done; });
+    std::string again;
+    loop.recv(server, [&](const mo::completion& c) {
+        if (c.more) again.append(reinterpret_cast<const char*>(c.data.data()), c.data.size());
+    });
+    CHECK(::write(client, "pong", 4) == 4);
+    run_until(loop, [&] { return again.size() >= 4; });
+    CHECK(again == "pong");
+
+    loop.cancel(acceptor);
+    ::close(client);
+    run_until(loop, [&] { return loop.run_once(10) == 0; });
+    ::close(server);
+    ::close(lfd);
+}
+
+}  // namespace
+
+int main() {
+    for (const mo::event_backend backend : {mo::event_backend::epoll, mo::event_backend::io_uring}) {
+        std::unique_ptr<mo::event_loop> loop;
+        try {
+            loop = mo::make_event_loop({64, 8, 4096}, backend);
+        } catch (const std::system_error& e) {
+            std::printf("skipping io_uring: %s\n", e.what());
+            continue;
+        }
+        test_echo(*loop);
+        test_closed_peer(*loop);
+        test_accept_error(*loop);
+        test_one_reader_per_fd(*loop);
+        std::printf("%s ok\n", backend == mo::event_backend::epoll ? "epoll" : "io_uring");
+    }
+}
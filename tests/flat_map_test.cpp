@@ -0,0 +1,205 @@
+// flat_map and flat_set in both layouts against std::map and std::set, and
+// lookups by arguments that convert to the key type or, under a transparent
+// comparator, are compared without converting.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/flat_map_test.cpp -o flat_map_test
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.hpp"
+#include "mo/flat_map.hpp"
+
+namespace {
+
+using mo::flat_layout;
+
+template <typename Map, typename Model>
+void check_same(const Map& map, const Model& model) {
+    CHECK(map.size() == model.size());
+    auto m = model.begin();
+    for (auto it = map.begin(); it != map.end(); ++it, ++m) CHECK(it->first == m->first && it->second == m->second);
+    CHECK(m == model.end());
+    auto r = model.rbegin();
+    for (auto it = map.end(); it != map.begin(); ++r) {
+        --it;
+        CHECK(it->first == r->first && it->second == r->second);
+    }
+    CHECK(r == model.rend());
+}
+
+template <typename It, typename ModelIt>
+bool same_entry(It it, It end, ModelIt m, ModelIt model_end) {
+    if (m == model_end) return it == end;
+    return it != end && it->first == m->first && it->second == m->second;
+}
+
+template <flat_layout Layout>
+void test_map_against_std() {
+    std::mt19937_64 rng(static_cast<unsigned>(Layout));
+    std::vector<std::uint64_t> keys;
+    std::vector<int> values;
+    for (int i = 0; i < 500; ++i) {
+        keys.push_back(rng() % 2000);
+        values.push_back(i);
+    }
+    mo::flat_map<std::uint64_t, int, std::less<std::uint64_t>, Layout> map(keys, values);
+    std::map<std::uint64_t, int> model;
+    for (std::size_t i = 0; i < keys.size(); ++i) model.emplace(keys[i], values[i]);  // the first duplicate wins
+    check_same(map, model);
+
+    for (int op = 0; op < 20000; ++op) {
+        const std::uint64_t key = rng() % 2000;
+        const int value = static_cast<int>(rng() % 100);
+        switch (rng() % 6) {
+        case 0:
+            CHECK(map.try_emplace(key, value).second == model.try_emplace(key, value).second);
+            break;
+        case 1:
+            CHECK(map.insert_or_assign(key, value).second == model.insert_or_assign(key, value).second);
+            break;
+        case 2:
+            CHECK(map.erase(key) == model.erase(key));
+            break;
+        case 3: {
+            const auto m = model.lower_bound(key);
+            const auto it = map.lower_bound(key);
+            CHECK(same_entry(it, map.end(), m, model.end()));
+            if (m == model.end()) break;
+            const auto next = map.erase(it);
+            CHECK(same_entry(next, map.end(), model.erase(m), model.end()));
+            break;
+        }
+        default: {
+            const auto& cmap = map;
+            CHECK(same_entry(cmap.lower_bound(key), cmap.end(), model.lower_bound(key), model.end()));
+            CHECK(same_entry(cmap.upper_bound(key), cmap.end(), model.upper_bound(key), model.end()));
+            CHECK(same_entry(cmap.find(key), cmap.end(), model.find(key), model.end()));
+            const int* v = cmap.get(key);
+            CHECK(v ? model.count(key) && *v == model.at(key) : !model.count(key));
+            break;
+        }
+        }
+        if (op % 1000 == 0) check_same(map, model);
+    }
+    check_same(map, model);
+}
+
+template <flat_layout Layout>
+void test_set_against_std() {
+    std::mt19937_64 rng(10 + static_cast<unsigned>(Layout));
+    std::vector<int> keys;
+    for (int i = 0; i < 300; ++i) keys.push_back(static_cast<int>(rng() % 1000) - 500);
+    mo::flat_set<int, std::less<int>, Layout> set(keys);
+    std::set<int> model(keys.begin(), keys.end());
+    for (int op = 0; op < 10000; ++op) {
+        const int key = static_cast<int>(rng() % 1000) - 500;
+        switch (rng() % 4) {
+        case 0:
+            CHECK(set.insert(key).second == model.insert(key).second);
+            break;
+        case 1:
+            CHECK(set.erase(key) == model.erase(key));
+            break;
+        default: {
+            const auto lb = set.lower_bound(key), ub = set.upper_bound(key);
+            const auto mlb = model.lower_bound(key), mub = model.upper_bound(key);
+            CHECK(mlb == model.end() ? lb == set.end() : lb != set.end() && *lb == *mlb);
+            CHECK(mub == model.end() ? ub == set.end() : ub != set.end() && *ub == *mub);
+            CHECK(set.contains(key) == (model.count(key) != 0));
+            break;
+        }
+        }
+    }
+    CHECK(std::vector<int>(set.begin(), set.end()) == std::vector<int>(model.begin(), model.end()));
+}
+
+/// Arguments of another type convert to the key under a plain comparator:
+/// integer literals for `std::uint64_t` keys, string literals for
+/// `std::string` keys.
+template <flat_layout Layout>
+void test_converting_lookups() {
+    mo::flat_map<std::uint64_t, int, std::less<std::uint64_t>, Layout> ids{{1, 10}, {5, 50}, {9, 90}};
+    CHECK(ids.contains(5) && !ids.contains(6) && ids.count(9) == 1);
+    CHECK(ids.find(5)->second == 50 && ids.find(4) == ids.end());
+    CHECK(ids.at(1) == 10 && *ids.get(9) == 90 && ids.get(2) == nullptr);
+    CHECK(ids.lower_bound(2)->first == 5 && ids.upper_bound(5)->first == 9);
+    bool threw = false;
+    try {
+        ids.at(3);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(ids.erase(5) == 1 && ids.erase(5) == 0 && ids.size() == 2);
+
+    mo::flat_map<std::string, int, std::less<std::string>, Layout> names{{"x", 1}, {"y", 2}};
+    CHECK(names.contains("x") && !names.contains("z") && names.at("y") == 2);
+    CHECK(names.find("y")->second == 2 && names.lower_bound("xa")->first == "y");
+    CHECK(names.erase("x") == 1 && !names.contains("x"));
+
+    mo::flat_set<std::string, std::less<std::string>, Layout> tags{"b", "a", "c"};
+    CHECK(tags.contains("a") && tags.count("d") == 0 && *tags.find("c") == "c");
+    CHECK(*tags.lower_bound("aa") == "b" && *tags.upper_bound("b") == "c");
+    CHECK(tags.erase("b") == 1 && tags.size() == 2);
+
+    mo::flat_set<std::uint64_t, std::less<std::uint64_t>, Layout> small{3, 1, 2};
+    CHECK(small.contains(2) && small.erase(2) == 1 && !small.contains(2));
+}
+
+/// Under a transparent comparator, a `std::string_view` is compared with
+/// the keys directly.
+template <flat_layout Layout>
+void test_transparent_lookups() {
+    mo::flat_map<std::string, int, std::less<>, Layout> names{{"alpha", 1}, {"beta", 2}};
+    const std::string_view beta = "beta";
+    CHECK(names.contains(beta) && names.at(beta) == 2 && names.find(beta)->second == 2);
+    CHECK(names.contains("alpha") && names.contains(std::string("alpha")));
+    CHECK(names.lower_bound(std::string_view("b"))->first == "beta");
+    CHECK(names.erase(beta) == 1 && !names.contains(beta));
+
+    mo::flat_set<std::string, std::less<>, Layout> tags{"x", "y"};
+    CHECK(tags.contains(std::string_view("y")) && tags.erase(std::string_view("x")) == 1);
+}
+
+void test_constructors() {
+    bool threw = false;
+    try {
+        mo::flat_map<int, int> bad(mo::sorted_unique, {1, 1}, {0, 0});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    threw = false;
+    try {
+        mo::flat_map<int, int> bad({1, 2}, {0});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    const mo::flat_map<int, int, std::less<int>, flat_layout::eytzinger> map({3, 1, 3, 2}, {30, 10, 99, 20});
+    CHECK(map.at(3) == 30 && map.size() == 3);
+}
+
+}  // namespace
+
+int main() {
+    test_map_against_std<flat_layout::sorted>();
+    test_map_against_std<flat_layout::eytzinger>();
+    test_set_against_std<flat_layout::sorted>();
+    test_set_against_std<flat_layout::eytzinger>();
+    test_converting_lookups<flat_layout::sorted>();
+    test_converting_lookups<flat_layout::eytzinger>();
+    test_transparent_lookups<flat_layout::sorted>();
+    test_transparent_lookups<flat_layout::eytzinger>();
+    test_constructors();
+    std::printf("flat_map ok\n");
+}
@@ -0,0 +1,149 @@
+// inplace_function and unique_function: copies, moves and destruction of
+// stored callables, the heap fallback, empty callables of every kind leaving
+// the wrapper empty, and move-only tasks through thread_pool.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/function_test.cpp -o function_test -pthread
+
+#include <array>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "check.hpp"
+#include "mo/function.hpp"
+#include "mo/thread_pool.hpp"
+
+namespace {
+
+/// Counts live instances and copies, to see what the wrappers do with a
+/// callable.
+struct counted {
+    static inline int live = 0, copies = 0;
+    std::string tag;
+    explicit counted(std::string t) : tag(std::move(t)) { ++live; }
+    counted(const counted& other) : tag(other.tag) {
+        ++live;
+        ++copies;
+    }
+    counted(counted&& other) noexcept : tag(std::move(other.tag)) { ++live; }
+    ~counted() { --live; }
+    std::string operator()(const std::string& s) const { return tag + s; }
+};
+
+template <typename F>
+bool throws_bad_call(F f) {
+    try {
+        f();
+    } catch (const std::bad_function_call&) {
+        return true;
+    }
+    return false;
+}
+
+int twice(int x) { return 2 * x; }
+
+void test_inplace_copy_and_move() {
+    {
+        mo::inplace_function<std::string(const std::string&)> f = counted("a");
+        CHECK(f && f("b") == "ab" && counted::live == 1);
+        auto g = f;  // copies the callable
+        CHECK(counted::live == 2 && counted::copies == 1 && g("c") == "ac");
+        auto h = std::move(f);  // relocates it
+        CHECK(!f && counted::live == 2 && h("d") == "ad");
+        f = g;
+        CHECK(f("e") == "ae" && counted::live == 3);
+        g = nullptr;
+        CHECK(!g && counted::live == 2);
+        h.swap(g);
+        CHECK(!h && g("f") == "af");
+    }
+    CHECK(counted::live == 0);
+
+    int calls = 0;
+    mo::inplace_function<int(int)> trivial = [&calls](int x) { return x + ++calls; };
+    auto copy = trivial;
+    CHECK(trivial(1) == 2 && copy(1) == 3 && calls == 2);
+    mo::inplace_function<int(int)> empty;
+    CHECK(!empty && throws_bad_call([&] { empty(1); }));
+}
+
+/// Callables that do not fit, or may throw when moved, go to the heap and
+/// are still moved, called and freed.
+void test_unique_heap_fallback() {
+    using uf = mo::unique_function<std::size_t()>;
+    std::array<char, 200> big{};
+    big[199] = 7;
+    static_assert(!uf::fits<decltype([big] { return std::size_t{0}; })>);
+    uf f = [big, p = std::make_unique<int>(5)] { return big[199] + static_cast<std::size_t>(*p); };
+    CHECK(f() == 12);
+    uf g = std::move(f);
+    CHECK(!f && g() == 12);
+    f = std::move(g);
+    CHECK(f() == 12);
+
+    struct throwing_move {
+        std::string s = "xyz";
+        throwing_move() = default;
+        throwing_move(throwing_move&& other) : s(std::move(other.s)) {}
+        std::size_t operator()() const { return s.size(); }
+    };
+    static_assert(!uf::fits<throwing_move>);
+    uf h = throwing_move{};
+    uf moved = std::move(h);
+    CHECK(!h && moved() == 3);
+
+    mo::unique_function<std::string(const std::string&)> c = counted("q");
+    CHECK(c("r") == "qr" && counted::live == 1);
+    c = nullptr;
+    CHECK(counted::live == 0);
+}
+
+/// Null pointers and empty wrappers of any kind leave the wrapper empty, so
+/// it tests false instead of holding something that throws when called.
+void test_empty_callables() {
+    int (*null_fn)(int) = nullptr;
+    CHECK(!mo::unique_function<int(int)>(null_fn));
+    CHECK(!mo::inplace_function<int(int)>(null_fn));
+    CHECK(!mo::unique_function<int(int)>(std::function<int(int)>()));
+    CHECK(!mo::inplace_function<int(int)>(std::function<int(int)>()));
+    CHECK(!mo::unique_function<void()>(mo::inplace_function<void()>{}));
+    CHECK(!mo::unique_function<void()>(mo::inplace_function<void(), 16>{}));
+    CHECK(!(mo::unique_function<void(), 64>(mo::unique_function<void(), 16>{})));
+    mo::unique_function<void()> assigned = [] {};
+    assigned = mo::inplace_function<void()>{};
+    CHECK(!assigned);
+
+    mo::unique_function<int(int)> from_fn = &twice;
+    CHECK(from_fn && from_fn(4) == 8);
+    mo::inplace_function<int(int)> inner = &twice;
+    mo::unique_function<int(int)> wrapped = inner;
+    CHECK(wrapped && wrapped(5) == 10);
+    mo::unique_function<int(int), 64> rewrapped = std::move(wrapped);
+    CHECK(rewrapped && rewrapped(6) == 12);
+}
+
+void test_thread_pool_move_only() {
+    mo::thread_pool pool(2);
+    auto owned = std::make_unique<int>(41);
+    std::future<int> answer = pool.submit([p = std::move(owned)] { return *p + 1; });
+    std::promise<std::string> promise;
+    std::future<std::string> posted = promise.get_future();
+    pool.post([pr = std::move(promise), s = std::make_unique<std::string>("done")]() mutable { pr.set_value(*s); });
+    std::packaged_task<int()> task([] { return 3; });
+    std::future<int> packaged = task.get_future();
+    pool.post(std::move(task));
+    CHECK(answer.get() == 42 && posted.get() == "done" && packaged.get() == 3);
+}
+
+}  // namespace
+
+int main() {
+    test_inplace_copy_and_move();
+    test_unique_heap_fallback();
+    test_empty_callables();
+    test_thread_pool_move_only();
+    std::printf("function ok\n");
+}
@@ -0,0 +1,191 @@
+// Waiter/waker races for the futex primitives and parking_lot. Meant for
+// TSan as well as ASan; a lost wakeup shows up as a hang, cut short by alarm().
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=thread -Iinclude tests/futex_test.cpp -o futex_test -pthread
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/futex_test.cpp -o futex_test -pthread
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "mo/futex.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr int threads = 4;
+
+template <typename F>
+void run_threads(int n, F f) {
+    std::vector<std::thread> pool;
+    for (int i = 0; i < n; ++i) pool.emplace_back(f, i);
+    for (std::thread& t : pool) t.join();
+}
+
+/// A plain counter guarded by the mutex: TSan flags any missing ordering.
+void test_mutex() {
+    mo::futex_mutex m;
+    long counter = 0;
+    constexpr int rounds = 20000;
+    run_threads(threads, [&](int) {
+        for (int i = 0; i < rounds; ++i) {
+            if (i % 2 != 0 && m.try_lock()) {
+                ++counter;
+                m.unlock();
+                continue;
+            }
+            std::lock_guard lock(m);
+            ++counter;
+        }
+    });
+    CHECK(counter == long{threads} * rounds);
+}
+
+/// Producers and consumers, some of them timing out while releases race in:
+/// every token released is acquired exactly once.
+void test_semaphore() {
+    mo::counting_semaphore sem;
+    constexpr int per_producer = 20000;
+    std::atomic<int> acquired{0};
+    std::atomic<bool> producing{true};
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < threads; ++c) {
+        consumers.emplace_back([&, c] {
+            for (;;) {
+                const bool got = c % 2 == 0 ? sem.try_acquire_for(50us) : sem.try_acquire_for(5ms);
+                if (got) {
+                    acquired.fetch_add(1, std::memory_order_relaxed);
+                } else if (!producing.load()) {
+                    if (!sem.try_acquire()) return;
+                    acquired.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    run_threads(2, [&](int p) {
+        for (int i = 0; i < per_producer; ++i) sem.release(p == 0 ? 1 : (i % 3 == 0 ? 3 : 0));
+    });
+    producing.store(false);
+    for (std::thread& t : consumers) t.join();
+    const int released = per_producer + 3 * ((per_producer + 2) / 3);
+    CHECK(acquired.load() == released);
+    CHECK(sem.count() == 0);
+}
+
+/// Ping-pong handing a plain value back and forth: each set wakes the one
+/// waiter, and the data written before `set` is visible after `wait`.
+void test_auto_reset() {
+    mo::auto_reset_event ping, pong;
+    int value = 0;
+    constexpr int rounds = 20000;
+    std::thread other([&] {
+        for (int i = 0; i < rounds; ++i) {
+            ping.wait();
+            CHECK(value == 2 * i + 1);
+            ++value;
+            pong.set();
+        }
+    });
+    for (int i = 0; i < rounds; ++i) {
+        ++value;
+        ping.set();
+        while (!pong.wait_for(1ms)) {}
+        CHECK(value == 2 * i + 2);
+    }
+    other.join();
+    CHECK(!ping.try_wait() && !pong.try_wait());
+}
+
+/// Waiters arriving before, during and after `set` all return and see the
+/// data it publishes; timed waits that expire report the event unset.
+void test_one_shot() {
+    for (int round = 0; round < 200; ++round) {
+        mo::one_shot_event ready;
+        int payload = 0;
+        std::atomic<int> done{0};
+        std::vector<std::thread> waiters;
+        for (int w = 0; w < threads; ++w) {
+            waiters.emplace_back([&, w] {
+                if (w == 0) {
+                    while (!ready.wait_for(10us)) {}
+                } else {
+                    ready.wait();
+                }
+                CHECK(payload == round + 1);
+                done.fetch_add(1);
+            });
+        }
+        if (round % 2 != 0) std::this_thread::yield();
+        payload = round + 1;
+        ready.set();
+        for (std::thread& t : waiters) t.join();
+        CHECK(done.load() == threads);
+        CHECK(ready.wait_for(0s));
+    }
+    mo::one_shot_event never;
+    CHECK(!never.wait_for(1ms));
+}
+
+/// Threads park on one word while another bumps it and unparks them, with
+/// short deadlines so timeouts race the unparker's dequeue. A park returns
+/// true exactly when an unpark took that thread off the queue.
+void test_parking_lot() {
+    std::atomic<std::uint64_t> word{0};
+    std::atomic<bool> stop{false};
+    std::atomic<int> woken{0}, running{threads};
+    std::vector<std::thread> parked;
+    for (int p = 0; p < threads; ++p) {
+        parked.emplace_back([&, p] {
+            while (!stop.load()) {
+                const std::uint64_t seen = word.load();
+                const auto unchanged = [&] { return word.load() == seen; };
+                if (p % 2 == 0 ? mo::parking_lot::park(&word, unchanged)
+                               : mo::parking_lot::park_for(&word, unchanged, 20us))
+                    woken.fetch_add(1);
+            }
+            running.fetch_sub(1);
+        });
+    }
+    std::size_t unparked = 0;
+    for (int i = 0; i < 5000; ++i) {
+        word.fetch_add(1);
+        if (i % 2 == 0) {
+            unparked += mo::parking_lot::unpark_all(&word);
+        } else {
+            bool more = false;
+            const mo::unpark_result r =
+                mo::parking_lot::unpark_one(&word, [&](mo::unpark_result u) { more = u.have_more; });
+            CHECK(more == r.have_more);
+            unparked += r.unparked;
+        }
+    }
+    stop.store(true);
+    while (running.load() != 0) {
+        word.fetch_add(1);
+        unparked += mo::parking_lot::unpark_all(&word);
+        std::this_thread::yield();
+    }
+    for (std::thread& t : parked) t.join();
+    CHECK(woken.load() == static_cast<int>(unparked));
+    CHECK(mo::parking_lot::unpark_all(&word) == 0);
+}
+
+}  // namespace
+
+int main() {
+    ::alarm(300);
+    test_mutex();
+    test_semaphore();
+    test_auto_reset();
+    test_one_shot();
+    test_parking_lot();
+    std::printf("futex ok\n");
+}
@@ -0,0 +1,149 @@
+// Sorted-integer codecs: intersect_sorted against std::set_intersection on
+// both its merge and gallop paths (duplicates included), packed_list round
+// trips, lookups and block-skipping intersections, and StreamVByte.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/int_codec_test.cpp -o int_codec_test
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "check.hpp"
+#include "mo/int_codec.hpp"
+
+namespace {
+
+template <typename T>
+std::vector<T> reference(const std::vector<T>& a, const std::vector<T>& b) {
+    std::vector<T> out;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+    return out;
+}
+
+template <typename T>
+std::vector<T> intersect_sorted(const std::vector<T>& a, const std::vector<T>& b) {
+    std::vector<T> out(std::min(a.size(), b.size()));
+    out.resize(mo::intersect_sorted(std::span<const T>(a), std::span<const T>(b), out.data()));
+    return out;
+}
+
+/// `n` sorted values below `range`; with `unique` false, values repeat.
+template <typename T>
+std::vector<T> random_sorted(std::mt19937_64& rng, std::size_t n, std::uint64_t range, bool unique) {
+    std::vector<T> out(n);
+    for (T& v : out) v = static_cast<T>(rng() % range);
+    std::sort(out.begin(), out.end());
+    if (unique) out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+/// Both argument orders, on sizes that take the merge (close sizes) and the
+/// gallop (one side over 32 times the other) paths. `std::set_intersection`
+/// keeps a value as often as the side with fewer copies, and so must we.
+template <typename T>
+void test_intersect_sorted() {
+    std::mt19937_64 rng(sizeof(T));
+    for (int round = 0; round < 400; ++round) {
+        const bool unique = round % 2 == 0;
+        const std::uint64_t range = 1 + rng() % 3000;
+        const auto a = random_sorted<T>(rng, rng() % 60, range, unique);
+        const auto b = random_sorted<T>(rng, round % 4 < 2 ? rng() % 60 : 2000 + rng() % 4000, range, unique);
+        CHECK(intersect_sorted(a, b) == reference(a, b));
+        CHECK(intersect_sorted(b, a) == reference(a, b));
+    }
+
+    // The gallop path used to emit a value once per copy on the smaller side.
+    std::vector<T> many_sevens(130, 7), wide(201), seven{7}, two_sevens{7, 7};
+    for (std::size_t i = 0; i < wide.size(); ++i) wide[i] = static_cast<T>(i);
+    CHECK(intersect_sorted(wide, many_sevens) == std::vector<T>{7});
+    CHECK(intersect_sorted(seven, many_sevens) == std::vector<T>{7});
+    CHECK(intersect_sorted(two_sevens, wide) == std::vector<T>{7});
+    CHECK(intersect_sorted(two_sevens, many_sevens) == two_sevens);
+    std::vector<T> dense(5000);
+    for (std::size_t i = 0; i < dense.size(); ++i) dense[i] = static_cast<T>(i / 2);  // every value twice
+    CHECK(intersect_sorted(two_sevens, dense) == two_sevens);
+    const std::vector<T> three_sevens{7, 7, 7};
+    CHECK(intersect_sorted(three_sevens, dense) == two_sevens);
+}
+
+template <typename T>
+void test_packed_list() {
+    std::mt19937_64 rng(100 + sizeof(T));
+    const std::uint64_t big = sizeof(T) == 8 ? std::uint64_t{1} << 40 : std::uint64_t{1} << 31;
+    for (const std::uint64_t range : {std::uint64_t{20'000}, std::uint64_t{200'000}, big}) {
+        const auto values = random_sorted<T>(rng, 10'000, range, true);
+        const mo::packed_list<T> list{std::span<const T>(values)};
+        CHECK(list.size() == values.size() && list.decode() == values);
+        CHECK(list.front() == values.front() && list.back() == values.back());
+        for (int i = 0; i < 2000; ++i) {
+            const T v = static_cast<T>(rng() % range);
+            CHECK(list.contains(v) == std::binary_search(values.begin(), values.end(), v));
+        }
+        for (const std::size_t n : {std::size_t{1}, std::size_t{50}, std::size_t{3000}, std::size_t{20'000}}) {
+            for (const bool unique : {true, false}) {
+                const auto probe = random_sorted<T>(rng, n, range, unique);
+                CHECK(mo::intersect(std::span<const T>(probe), list) == reference(probe, values));
+                if (!unique) continue;
+                const mo::packed_list<T> other{std::span<const T>(probe)};
+                CHECK(mo::intersect(other, list) == reference(probe, values));
+                CHECK(mo::intersect(list, other) == reference(probe, values));
+            }
+        }
+    }
+
+    const mo::packed_list<T> empty{std::span<const T>()};
+    CHECK(empty.empty() && !empty.contains(0) && empty.decode().empty());
+    const std::vector<T> one{5};
+    CHECK(mo::intersect(std::span<const T>(one), empty).empty());
+
+    for (const std::vector<T>& bad : {std::vector<T>{1, 3, 2}, std::vector<T>(130, 7), std::vector<T>{1, 2, 2, 3}}) {
+        bool threw = false;
+        try {
+            mo::packed_list<T> list{std::span<const T>(bad)};
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+}
+
+void test_streamvbyte() {
+    std::mt19937_64 rng(3);
+    for (const std::size_t n : {std::size_t{0}, std::size_t{1}, std::size_t{7}, std::size_t{1000}}) {
+        std::vector<std::uint32_t> values(n);
+        for (std::uint32_t& v : values) v = static_cast<std::uint32_t>(rng() >> (rng() % 64));
+        std::vector<char> buf(mo::streamvbyte_bound(n));
+        const std::size_t size = mo::streamvbyte_encode(values, buf.data());
+        std::vector<std::uint32_t> back(n);
+        CHECK(mo::streamvbyte_decode(buf.data(), size, back) == size && back == values);
+        if (n > 0) {
+            bool threw = false;
+            try {
+                mo::streamvbyte_decode(buf.data(), size - 1, back);
+            } catch (const mo::compress_error&) {
+                threw = true;
+            }
+            CHECK(threw);
+        }
+
+        std::sort(values.begin(), values.end());
+        const std::size_t delta_size = mo::streamvbyte_encode_delta(values, buf.data(), 0);
+        CHECK(mo::streamvbyte_decode_delta(buf.data(), delta_size, back, 0) == delta_size && back == values);
+    }
+}
+
+}  // namespace
+
+int main() {
+    test_intersect_sorted<std::uint32_t>();
+    test_intersect_sorted<std::uint64_t>();
+    test_packed_list<std::uint32_t>();
+    test_packed_list<std::uint64_t>();
+    test_streamvbyte();
+    std::printf("int_codec ok\n");
+}
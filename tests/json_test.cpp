@@ -0,0 +1,83 @@
+// json_document: lookups, iteration and string decoding, and numbers held to
+// the JSON grammar — from_chars alone would take inf, nan, .5, 1. and
+// leading zeros.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/json_test.cpp -o json_test
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "check.hpp"
+#include "mo/json.hpp"
+
+namespace {
+
+template <typename F>
+bool throws(F f) {
+    try {
+        f();
+    } catch (const mo::json_error&) {
+        return true;
+    }
+    return false;
+}
+
+/// The single element of a one-element array holding `token`.
+double as_double(const std::string& token) {
+    const std::string text = "[" + token + "]";
+    const mo::json_document doc(text);
+    return doc.root()[std::size_t{0}].get_double();
+}
+
+void test_access() {
+    const std::string text = R"({"user": {"id": 42, "name": "a\"bé", "tags": ["x", "y", "z"]},
+                                "ok": true, "none": null, "px": -1.25e2, "big": 18446744073709551615})";
+    const mo::json_document doc(text);
+    const mo::json_value root = doc.root();
+    CHECK(root.type() == mo::json_type::object && root.size() == 5);
+    CHECK(root["user"]["id"].get_int64() == 42);
+    CHECK(root["user"]["name"].get_string() == "a\"b\xc3\xa9");
+    CHECK(root["user"]["name"].get_raw_string() == R"(a\"bé)");
+    CHECK(root["user"]["tags"].size() == 3 && root["user"]["tags"][std::size_t{2}].get_string() == "z");
+    std::string joined;
+    for (const mo::json_value v : root["user"]["tags"].elements()) joined += v.get_string();
+    CHECK(joined == "xyz");
+    CHECK(root["ok"].get_bool() && root["none"].is_null() && root["px"].get_double() == -125.0);
+    CHECK(root["big"].get_uint64() == std::numeric_limits<std::uint64_t>::max());
+    CHECK(!root.find("missing") && throws([&] { root["big"].get_int64(); }));
+    CHECK(throws([&] { root["ok"].get_int64(); }) && throws([&] { root["px"].get_string(); }));
+}
+
+void test_valid_numbers() {
+    CHECK(as_double("0") == 0 && as_double("-0") == 0 && as_double("7") == 7);
+    CHECK(as_double("1.5") == 1.5 && as_double("-0.25") == -0.25 && as_double("10") == 10);
+    CHECK(as_double("1e3") == 1000 && as_double("1E+2") == 100 && as_double("25e-1") == 2.5);
+    CHECK(as_double("0.5e1") == 5 && as_double("-120.0E-1") == -12);
+}
+
+/// Tokens that start like a number (so `type()` says number) but break the
+/// grammar, and tokens that cannot start a JSON value at all.
+void test_invalid_numbers() {
+    for (const char* token : {"-inf", "-nan", "-infinity", "-", "01", "-01", "00", "1.", "-1.", "1.e5", "1e", "1e+",
+                              "1E-", "0x10", "1.5.5", "1e5.5", "12a", "-.5", "0.5e1.0"})
+        CHECK(throws([&] { as_double(token); }));
+    for (const char* token : {"inf", "nan", ".5", "+1"}) CHECK(throws([&] { as_double(token); }));
+
+    const mo::json_document doc(R"([01, 1., 2])");
+    const mo::json_value root = doc.root();
+    CHECK(throws([&] { root[std::size_t{0}].get_int64(); }) && throws([&] { root[std::size_t{0}].get_uint64(); }));
+    CHECK(throws([&] { root[std::size_t{1}].get_double(); }) && root[std::size_t{2}].get_int64() == 2);
+    CHECK(throws([] { as_double("1e999"); }));
+}
+
+}  // namespace
+
+int main() {
+    test_access();
+    test_valid_numbers();
+    test_invalid_numbers();
+    std::printf("json ok\n");
+}
@@ -0,0 +1,210 @@
+// mapped_table: lookups and iteration with and without the hash index,
+// builder misuse, the largest entry offset a hash slot can hold, and
+// truncated or damaged files — table_error for a bad footer or index, and
+// never a read outside the mapping whatever byte is damaged.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/mapped_table_test.cpp -o mapped_table_test
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "mo/mapped_table.hpp"
+
+namespace {
+
+std::string key(int i) {
+    char buf[16];
+    std::snprintf(buf, sizeof buf, "key-%06d", i * 2);  // odd numbers are absent
+    return buf;
+}
+
+std::string value(int i) { return std::string(static_cast<std::size_t>(i % 37), static_cast<char>('a' + i % 26)); }
+
+std::string build(const std::string& path, int n, const mo::table_options& options = {}) {
+    mo::mapped_table_builder builder(path, options);
+    for (int i = 0; i < n; ++i) builder.add(key(i), value(i));
+    builder.finish();
+    return path;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+void write_file(const std::string& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+template <typename Error, typename F>
+bool throws(F f) {
+    try {
+        f();
+    } catch (const Error&) {
+        return true;
+    }
+    return false;
+}
+
+/// Opens the file and walks everything in it; damage may only surface as
+/// `deserialize_error` (which `table_error` derives from).
+void read_everything(const std::string& path, int n) {
+    try {
+        const mo::mapped_table table(path);
+        std::size_t seen = 0;
+        for (auto it = table.begin(); it != table.end() && seen <= table.size(); ++it, ++seen) (void)*it;
+        for (int i = 0; i < n; ++i) {
+            (void)table.find(key(i));
+            (void)table.lower_bound(key(i) + "x");
+        }
+    } catch (const mo::deserialize_error&) {
+    }
+}
+
+void test_lookups(const std::string& dir) {
+    for (const bool hash : {true, false}) {
+        for (const std::size_t block : {std::size_t{64}, std::size_t{1024}}) {
+            constexpr int n = 3000;
+            const mo::mapped_table table(build(dir + "/t", n, {block, hash}));
+            CHECK(table.size() == n && table.has_hash_index() == hash);
+            int i = 0;
+            for (const mo::table_entry e : table) {
+                CHECK(e.key == key(i) && e.value == value(i));
+                ++i;
+            }
+            CHECK(i == n);
+            for (i = 0; i < n; ++i) {
+                CHECK(table.find(key(i)) == value(i));
+                CHECK(!table.contains(key(i) + "1"));
+                const auto it = table.lower_bound(key(i) + "1");  // between key(i) and key(i + 1)
+                CHECK(i + 1 == n ? it == table.end() : (*it).key == key(i + 1));
+            }
+            CHECK((*table.lower_bound("")).key == key(0) && table.lower_bound("l") == table.end());
+        }
+    }
+    const mo::mapped_table empty(build(dir + "/e", 0));
+    CHECK(empty.empty() && empty.begin() == empty.end() && !empty.find("key"));
+}
+
+void test_builder_misuse(const std::string& dir) {
+    mo::mapped_table_builder builder(dir + "/m");
+    builder.add("b", "1");
+    CHECK(throws<std::invalid_argument>([&] { builder.add("b", "2"); }));
+    CHECK(throws<std::invalid_argument>([&] { builder.add("a", "2"); }));
+    builder.finish();
+    CHECK(throws<std::logic_error>([&] { builder.add("c", "3"); }));
+    CHECK(throws<std::logic_error>([&] { builder.finish(); }));
+}
+
+/// Slots keep `pos + 1` in the offset bits: the largest entry offset the
+/// builder accepts still leaves the tag intact, and one more would carry
+/// into it. (A table that large, 1 TiB of entries, is out of a test's reach;
+/// `add` rejects `pos > max_entry_offset`.)
+void test_slot_limit() {
+    namespace t = mo::detail::table;
+    const std::uint64_t h = ~std::uint64_t{0} << t::offset_bits | 0x1234;
+    const std::uint64_t slot = t::hash_slot(h, t::max_entry_offset);
+    CHECK(slot >> t::offset_bits == h >> t::offset_bits && (slot & t::offset_mask) - 1 == t::max_entry_offset);
+    CHECK(t::hash_slot(0, t::max_entry_offset + 1) >> t::offset_bits != 0);
+    CHECK(t::hash_slot(h, 0) != 0);
+}
+
+void test_truncated(const std::string& dir) {
+    const std::string bytes = read_file(build(dir + "/full", 500));
+    for (const std::size_t keep : {std::size_t{0}, std::size_t{1}, mo::detail::table::footer_size - 1,
+                                   mo::detail::table::footer_size, bytes.size() / 2, bytes.size() - 8,
+                                   bytes.size() - 1}) {
+        write_file(dir + "/cut", bytes.substr(0, keep));
+        CHECK(throws<mo::table_error>([&] { mo::mapped_table table(dir + "/cut"); }));
+    }
+    write_file(dir + "/long", bytes + std::string(8, '\0'));
+    CHECK(throws<mo::table_error>([&] { mo::mapped_table table(dir + "/long"); }));
+}
+
+/// Each footer field and the block index, set to values that point outside
+/// the file or break its ordering, fail the open with `table_error`.
+void test_corrupt_footer_and_index(const std::string& dir) {
+    constexpr int n = 500;
+    const std::string bytes = read_file(build(dir + "/full", n));
+    mo::detail::table::footer f;
+    std::memcpy(&f, bytes.data() + bytes.size() - sizeof f, sizeof f);
+    const auto damaged = [&](auto mutate) {
+        mo::detail::table::footer g = f;
+        std::string copy = bytes;
+        mutate(g, copy);
+        std::memcpy(copy.data() + copy.size() - sizeof g, &g, sizeof g);
+        write_file(dir + "/bad", copy);
+        return throws<mo::table_error>([&] { mo::mapped_table table(dir + "/bad"); });
+    };
+    using footer = mo::detail::table::footer;
+    CHECK(damaged([](footer& g, std::string&) { g.magic ^= 1; }));
+    CHECK(damaged([](footer& g, std::string&) { g.version = 2; }));
+    CHECK(damaged([](footer& g, std::string&) { g.count = g.blocks - 1; }));
+    CHECK(damaged([](footer& g, std::string&) { g.count = g.hash_slots; }));
+    CHECK(damaged([](footer& g, std::string&) { g.blocks = 0; }));
+    CHECK(damaged([](footer& g, std::string&) { g.blocks = g.count + 1; }));
+    CHECK(damaged([](footer& g, std::string&) { g.index_pos += 4; }));
+    CHECK(damaged([](footer& g, std::string&) { g.index_pos = ~std::uint64_t{7}; }));
+    CHECK(damaged([](footer& g, std::string&) { g.prefixes_pos = g.hash_pos + g.hash_slots * 8; }));
+    CHECK(damaged([](footer& g, std::string&) { g.fences_pos = std::uint64_t{1} << 62; }));
+    CHECK(damaged([](footer& g, std::string&) { g.hash_pos += 8; }));
+    CHECK(damaged([](footer& g, std::string&) { g.hash_slots *= 2; }));
+    CHECK(damaged([](footer& g, std::string&) { g.hash_slots -= 1; }));
+    const auto store = [](std::string& s, std::uint64_t at, std::uint64_t v) { std::memcpy(s.data() + at, &v, 8); };
+    CHECK(damaged([&](footer& g, std::string& s) { store(s, g.index_pos + 8, 0); }));        // out of order
+    CHECK(damaged([&](footer& g, std::string& s) { store(s, g.index_pos, 8); }));            // not at 0
+    CHECK(damaged([&](footer& g, std::string& s) { store(s, g.index_pos + g.blocks * 8, g.index_pos + 8); }));
+    CHECK(damaged([&](footer& g, std::string& s) { store(s, g.fences_pos + g.blocks * 8, 1 << 20); }));
+
+    // A hash slot pointing past the entries fails the lookup, not the open.
+    std::string copy = bytes;
+    for (std::uint64_t i = 0; i < f.hash_slots; ++i) {
+        std::uint64_t slot = mo::detail::table::load64(copy.data() + f.hash_pos + i * 8);
+        if (slot != 0) store(copy, f.hash_pos + i * 8, slot | mo::detail::table::offset_mask);
+    }
+    write_file(dir + "/slots", copy);
+    const mo::mapped_table table(dir + "/slots");
+    CHECK(throws<mo::table_error>([&] { (void)table.find(key(7)); }));
+    CHECK((*table.lower_bound(key(7))).value == value(7));
+}
+
+/// Every byte of a small table flipped in turn: opening, iterating and
+/// looking up either work or throw, and ASan sees no stray read.
+void test_every_byte(const std::string& dir) {
+    constexpr int n = 40;
+    const std::string bytes = read_file(build(dir + "/full", n, {64, true}));
+    for (std::size_t at = 0; at < bytes.size(); ++at) {
+        for (const unsigned char mask : {0x01, 0x80, 0xff}) {
+            std::string copy = bytes;
+            copy[at] = static_cast<char>(copy[at] ^ mask);
+            write_file(dir + "/flip", copy);
+            read_everything(dir + "/flip", n);
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    char name[] = "/tmp/mo_table_test.XXXXXX";
+    CHECK(::mkdtemp(name) != nullptr);
+    const std::string dir = name;
+    test_lookups(dir);
+    test_builder_misuse(dir);
+    test_slot_limit();
+    test_truncated(dir);
+    test_corrupt_footer_and_index(dir);
+    test_every_byte(dir);
+    std::filesystem::remove_all(dir);
+    std::printf("mapped_table ok\n");
+}
@@ -0,0 +1,105 @@
+// Sustained rates on the default clock, plus burst and cost limits on
+// explicit timestamps.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/rate_limiter_test.cpp -o rate_limiter_test
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#include "check.hpp"
+#include "mo/rate_limiter.hpp"
+
+namespace {
+
+constexpr std::int64_t ms = 1'000'000;
+
+/// Polls `try_acquire` as fast as possible for `duration` and checks the
+/// admitted count against `per_second` (plus the initial burst). The lower
+/// bound leaves room for preemption, which forfeits tokens beyond the burst.
+template <typename Limiter>
+void check_sustained(const char* name, double per_second, std::uint32_t burst, std::chrono::milliseconds duration) {
+    Limiter limiter(per_second, burst);
+    long admitted = 0;
+    const auto start = std::chrono::steady_clock::now();
+    auto now = start;
+    while (now - start < duration) {
+        admitted += limiter.try_acquire();
+        now = std::chrono::steady_clock::now();
+    }
+    const double seconds = std::chrono::duration<double>(now - start).count();
+    const double expected = per_second * seconds + burst;
+    std::printf("  %-12s %8.0f/s burst %2u: %ld admitted, %.0f expected\n", name, per_second, burst, admitted,
+                expected);
+    CHECK(admitted >= 0.9 * expected - 1);
+    CHECK(admitted <= 1.01 * expected + 1);
+}
+
+void test_sustained() {
+    using namespace std::chrono_literals;
+    check_sustained<mo::token_bucket>("token_bucket", 10000, 1, 300ms);
+    check_sustained<mo::token_bucket>("token_bucket", 10000, 10, 300ms);
+    check_sustained<mo::token_bucket>("token_bucket", 100, 1, 500ms);
+    check_sustained<mo::gcra>("gcra", 10000, 1, 300ms);
+    check_sustained<mo::gcra>("gcra", 100, 1, 500ms);
+}
+
+void test_token_bucket() {
+    const std::int64_t t0 = 1000 * ms;
+    mo::token_bucket b(1000, 5, t0);  // one token per ms
+    CHECK(b.available(t0) == 5);
+    CHECK(b.try_acquire(5, t0));
+    CHECK(!b.try_acquire(1, t0));
+    CHECK(b.wait_time(1, t0) == ms);
+    CHECK(b.try_acquire(1, t0 + ms));
+    CHECK(b.acquire_up_to(10, t0 + 4 * ms) == 3);
+    b.refund(2);
+    CHECK(b.available(t0 + 4 * ms) == 2);
+    CHECK(b.available(t0 + 100 * ms) == 5);  // capped at the burst
+    bool threw = false;
+    try {
+        b.try_acquire(6, t0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+void test_gcra() {
+    const std::int64_t t0 = 1000 * ms;
+    mo::gcra g(1000, 3);
+    for (int i = 0; i < 3; ++i) CHECK(g.check(1, t0).allowed);
+    const mo::rate_decision d = g.check(1, t0);
+    CHECK(!d.allowed && d.retry_after == ms && d.remaining == 0);
+    CHECK(d.reset_after == 3 * ms);
+    CHECK(g.check(1, t0 + ms).allowed);
+    CHECK(!g.idle(t0 + 3 * ms) && g.idle(t0 + 4 * ms));
+}
+
+void test_keyed() {
+    const std::int64_t t0 = 1000 * ms;
+    mo::keyed_rate_limiter<std::string> limiter(1000, 2);
+    CHECK(limiter.try_acquire("a", 1, t0) && limiter.try_acquire("a", 1, t0));
+    CHECK(!limiter.try_acquire("a", 1, t0));
+    CHECK(limiter.try_acquire("b", 1, t0));
+    CHECK(limiter.size() == 2);
+    bool threw = false;
+    try {
+        limiter.check("c", 3, t0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw && limiter.size() == 2);  // rejected before inserting the key
+    CHECK(limiter.evict_idle(t0 + 10 * ms) == 2);
+}
+
+}  // namespace
+
+int main() {
+    test_token_bucket();
+    test_gcra();
+    test_keyed();
+    test_sustained();
+    std::printf("rate_limiter ok\n");
+}
@@ -0,0 +1,119 @@
+// run_loop driving tasks: results, spawned tasks, posts from other threads,
+// and empty tasks.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/run_loop_test.cpp -o run_loop_test -pthread
+
+#include <chrono>
+#include <coroutine>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "check.hpp"
+#include "mo/run_loop.hpp"
+
+namespace {
+
+mo::task<int> add(mo::run_loop& loop, int a, int b) {
+    co_await loop.schedule();
+    co_return a + b;
+}
+
+mo::task<std::string> chain(mo::run_loop& loop) {
+    const int x = co_await add(loop, 1, 2);
+    const int y = co_await add(loop, x, 4);
+    co_return std::to_string(y);
+}
+
+mo::task<void> bump(mo::run_loop& loop, int& counter) {
+    co_await loop.schedule();
+    ++counter;
+}
+
+mo::task<int> fail(mo::run_loop& loop) {
+    co_await loop.schedule();
+    throw std::runtime_error("fail");
+}
+
+template <typename F>
+bool throws_logic_error(F f) {
+    try {
+        f();
+    } catch (const std::logic_error&) {
+        return true;
+    }
+    return false;
+}
+
+void test_run() {
+    mo::run_loop loop;
+    CHECK(loop.run(chain(loop)) == "7");
+    bool threw = false;
+    try {
+        loop.run(fail(loop));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+void test_spawn() {
+    mo::run_loop loop;
+    int counter = 0;
+    for (int i = 0; i < 3; ++i) loop.spawn(bump(loop, counter));
+    while (loop.run_once() != 0) {
+    }
+    CHECK(counter == 3);
+}
+
+/// Suspends and has a new thread post the coroutine back after a delay.
+struct resume_from_thread {
+    mo::run_loop& loop;
+    std::thread& thread;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) {
+        thread = std::thread([this, h] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            loop.post(h);
+        });
+    }
+    void await_resume() const noexcept {}
+};
+
+mo::task<int> remote(mo::run_loop& loop, std::thread& thread) {
+    co_await resume_from_thread{loop, thread};
+    co_return 5;
+}
+
+/// A post from another thread wakes a loop blocked in `run`.
+void test_cross_thread() {
+    mo::run_loop loop;
+    std::thread thread;
+    CHECK(loop.run(remote(loop, thread)) == 5);
+    thread.join();
+}
+
+/// Empty tasks are rejected before their null handle reaches the queue, and
+/// the loop keeps working afterwards.
+void test_empty() {
+    mo::run_loop loop;
+    CHECK(throws_logic_error([&] { loop.run(mo::task<int>{}); }));
+    CHECK(throws_logic_error([&] { loop.spawn(mo::task<void>{}); }));
+    mo::task<int> moved = add(loop, 1, 1);
+    mo::task<int> owner = std::move(moved);
+    CHECK(throws_logic_error([&] { loop.run(std::move(moved)); }));
+    CHECK(loop.run_once() == 0);
+    CHECK(loop.run(std::move(owner)) == 2);
+}
+
+}  // namespace
+
+int main() {
+    test_run();
+    test_spawn();
+    test_cross_thread();
+    test_empty();
+    std::printf("run_loop ok\n");
+}
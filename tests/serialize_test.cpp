@@ -0,0 +1,105 @@
+// binary_writer/binary_reader: round trips of integers at their limits,
+// strings, containers and structs, and malformed input — varints that are
+// truncated, too long or overflow 64 bits in their 10th byte, out-of-range
+// integers, oversized lengths and trailing bytes.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/serialize_test.cpp -o serialize_test
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.hpp"
+#include "mo/serialize.hpp"
+
+namespace {
+
+struct order {
+    std::uint64_t id = 0;
+    std::string symbol;
+    double px = 0;
+    std::optional<std::int32_t> qty;
+    std::vector<std::uint16_t> fills;
+};
+
+bool operator==(const order& a, const order& b) {
+    return a.id == b.id && a.symbol == b.symbol && a.px == b.px && a.qty == b.qty && a.fills == b.fills;
+}
+
+template <typename F>
+bool throws(F f) {
+    try {
+        f();
+    } catch (const mo::deserialize_error&) {
+        return true;
+    }
+    return false;
+}
+
+std::uint64_t varint(std::string_view bytes) {
+    mo::binary_reader reader(bytes);
+    const std::uint64_t v = reader.read_varint();
+    CHECK(reader.at_end());
+    return v;
+}
+
+void test_round_trip() {
+    for (const std::uint64_t v : {std::uint64_t{0}, std::uint64_t{127}, std::uint64_t{128}, std::uint64_t{1} << 63,
+                                  std::numeric_limits<std::uint64_t>::max()})
+        CHECK(mo::deserialize<std::uint64_t>(mo::serialize(v)) == v);
+    for (const std::int64_t v : {std::int64_t{0}, std::int64_t{-1}, std::numeric_limits<std::int64_t>::min(),
+                                 std::numeric_limits<std::int64_t>::max()})
+        CHECK(mo::deserialize<std::int64_t>(mo::serialize(v)) == v);
+    CHECK(mo::serialize(std::numeric_limits<std::uint64_t>::max()).size() == 10);
+
+    const order o{42, "MSFT", 412.25, -7, {1, 2, 65535}};
+    CHECK(mo::deserialize<order>(mo::serialize(o)) == o);
+    const std::map<std::string, std::vector<order>> book{{"a", {o, order{}}}, {"b", {}}};
+    CHECK((mo::deserialize<std::map<std::string, std::vector<order>>>(mo::serialize(book)) == book));
+
+    const std::string wire = mo::serialize(std::string("view me"));
+    CHECK(mo::deserialize<std::string_view>(wire) == "view me");
+}
+
+/// A 10th byte may only hold bit 63: 0x01 is the largest legal one, and
+/// anything above used to lose its high bits instead of failing.
+void test_varint_limits() {
+    const std::string nine(9, '\xff');
+    CHECK(varint(nine + '\x01') == std::numeric_limits<std::uint64_t>::max());
+    CHECK(varint(std::string(9, '\x80') + '\x01') == std::uint64_t{1} << 63);
+    CHECK(varint(std::string("\x80\x00", 2)) == 0);  // overlong but in range
+    for (const char last : {'\x02', '\x7f', '\x81', '\xff'})
+        CHECK(throws([&] { varint(nine + last); }));
+    CHECK(throws([&] { varint(std::string(9, '\x80') + '\x02'); }));
+    CHECK(throws([&] { varint(std::string(11, '\x80') + '\x00'); }));
+    CHECK(throws([&] { varint(nine); }));
+    CHECK(throws([] { varint(""); }));
+    CHECK(throws([&] { mo::deserialize<std::int64_t>(nine + '\x02'); }));
+}
+
+void test_malformed() {
+    CHECK(throws([] { mo::deserialize<std::uint8_t>(mo::serialize(std::uint64_t{256})); }));
+    CHECK(throws([] { mo::deserialize<std::int8_t>(mo::serialize(std::int64_t{-129})); }));
+    CHECK(throws([] { mo::deserialize<std::string>(std::string("\x05" "abc")); }));
+    CHECK(throws([] { mo::deserialize<std::vector<std::uint32_t>>(std::string("\xff\xff\xff\xff\x0f")); }));
+    CHECK(throws([] { mo::deserialize<std::uint32_t>(std::string("\x01\x02")); }));
+    CHECK(throws([] { mo::deserialize<double>(std::string("1234")); }));
+
+    const std::string wire = mo::serialize(order{1, "x", 1.5, 3, {4}});
+    for (std::size_t keep = 0; keep < wire.size(); ++keep)
+        CHECK(throws([&] { mo::deserialize<order>(std::string_view(wire).substr(0, keep)); }));
+}
+
+}  // namespace
+
+int main() {
+    test_round_trip();
+    test_varint_limits();
+    test_malformed();
+    std::printf("serialize ok\n");
+}
@@ -0,0 +1,168 @@
+// Recovery from torn tails and from damage to durable records.
+//
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -Iinclude tests/wal_test.cpp -o wal_test
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "mo/wal.hpp"
+
+namespace {
+
+constexpr int records = 100;
+constexpr std::size_t payload_size = 10;  // "record-NNN"
+
+std::string payload(int i) {
+    char buf[16];
+    std::snprintf(buf, sizeof buf, "record-%03d", i);
+    return buf;
+}
+
+std::string fresh_dir() {
+    char name[] = "/tmp/mo_wal_test.XXXXXX";
+    CHECK(::mkdtemp(name) != nullptr);
+    return name;
+}
+
+std::vector<std::string> read_all(const std::string& dir) {
+    mo::wal_reader reader(dir);
+    std::vector<std::string> out;
+    while (auto r = reader.next()) {
+        CHECK(r->sequence == out.size() + 1);
+        out.emplace_back(r->payload);
+    }
+    return out;
+}
+
+bool read_throws(const std::string& dir) {
+    try {
+        read_all(dir);
+    } catch (const mo::wal_error&) {
+        return true;
+    }
+    return false;
+}
+
+bool open_throws(const std::string& dir, const mo::wal_options& options) {
+    try {
+        mo::wal log(dir, options);
+    } catch (const mo::wal_error&) {
+        return true;
+    }
+    return false;
+}
+
+/// Offset of record `seq` in a single-segment log of `payload` records.
+std::size_t offset_of(int seq) { return 16 + static_cast<std::size_t>(seq - 1) * (8 + payload_size); }
+
+std::string segment(const std::string& dir) { return dir + "/00000000000000000001.wal"; }
+
+std::string contents(const std::string& path) {
+    const auto size = std::filesystem::file_size(path);
+    std::string out(size, '\0');
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    CHECK(::pread(fd, out.data(), size, 0) == static_cast<ssize_t>(size));
+    ::close(fd);
+    return out;
+}
+
+void write_bytes(const std::string& path, std::size_t offset, const std::string& bytes) {
+    const int fd = ::open(path.c_str(), O_WRONLY);
+    CHECK(::pwrite(fd, bytes.data(), bytes.size(), static_cast<off_t>(offset)) == static_cast<ssize_t>(bytes.size()));
+    ::close(fd);
+}
+
+std::string make_log(const mo::wal_options& options) {
+    const std::string dir = fresh_dir();
+    mo::wal log(dir, options);
+    for (int i = 1; i <= records; ++i) CHECK(log.append_sync(payload(i)) == static_cast<std::uint64_t>(i));
+    return dir;
+}
+
+/// One flipped byte in record 10, in its length, checksum or payload: the
+/// 90 durable records after it must not be dropped as a torn tail.
+void test_corrupt_middle(const mo::wal_options& options) {
+    for (const std::size_t field : {std::size_t{3}, std::size_t{5}, std::size_t{12}}) {
+        const std::string dir = make_log(options);
+        const std::string path = segment(dir);
+        const std::string before = contents(path);
+        const std::size_t at = offset_of(10) + field;
+        write_bytes(path, at, std::string(1, static_cast<char>(before[at] ^ 0x40)));
+        const std::string damaged = contents(path);
+
+        CHECK(read_throws(dir));
+        CHECK(open_throws(dir, options));
+        CHECK(contents(path) == damaged);  // nothing truncated
+
+        write_bytes(path, at, before.substr(at, 1));
+        CHECK(read_all(dir).size() == records);
+        mo::wal log(dir, options);
+        CHECK(log.next_sequence() == records + 1);
+        std::filesystem::remove_all(dir);
+    }
+}
+
+/// A zeroed record header looks like the clean end, but records follow it.
+void test_zeroed_middle(const mo::wal_options& options) {
+    const std::string dir = make_log(options);
+    write_bytes(segment(dir), offset_of(10), std::string(8, '\0'));
+    CHECK(read_throws(dir));
+    CHECK(open_throws(dir, options));
+    std::filesystem::remove_all(dir);
+}
+
+/// A partial last record is the end of the log; reopening drops it and
+/// appends after record 100.
+void test_torn_tail(const mo::wal_options& options) {
+    const std::string dir = make_log(options);
+    std::string torn(8 + 5, 'x');
+    const std::uint32_t length = 40, sum = 12345;
+    std::memcpy(torn.data(), &length, 4);
+    std::memcpy(torn.data() + 4, &sum, 4);
+    write_bytes(segment(dir), offset_of(records + 1), torn);
+
+    CHECK(read_all(dir).size() == records);
+    {
+        mo::wal log(dir, options);
+        CHECK(log.next_sequence() == records + 1);
+        CHECK(log.append_sync("after") == records + 1);
+    }
+    const std::vector<std::string> all = read_all(dir);
+    CHECK(all.size() == records + 1);
+    CHECK(all[9] == payload(10) && all.back() == "after");
+    std::filesystem::remove_all(dir);
+}
+
+/// Damage in a segment other than the last is never a tail.
+void test_corrupt_older_segment() {
+    mo::wal_options options;
+    options.segment_size = 512;
+    const std::string dir = make_log(options);
+    CHECK(mo::detail::wal::list_segments(dir).size() > 2);
+    write_bytes(segment(dir), offset_of(3) + 12, "?");
+    CHECK(read_throws(dir));
+    std::filesystem::remove_all(dir);
+}
+
+}  // namespace
+
+int main() {
+    mo::wal_options preallocated;
+    mo::wal_options grown;
+    grown.preallocate = false;
+    for (const mo::wal_options& options : {preallocated, grown}) {
+        test_corrupt_middle(options);
+        test_zeroed_middle(options);
+        test_torn_tail(options);
+    }
+    test_corrupt_older_segment();
+    std::printf("wal ok\n");
+}